@@ -8,14 +8,22 @@
 
 #pragma once
 
+#include "application_options.h"
 #include "update_loop.h"
 
+#if defined(__linux__)
+#include <pthread.h>
+#include <sched.h>
+#endif
+
 //--------------------------------------------------------------
 namespace Simple
 {
 
 //--------------------------------------------------------------
-//! An UpdateLoop which stores arguments passed to the program.
+//! An UpdateLoop which stores arguments passed to the program, and
+//! parses them into typed options (including standard options that
+//! configure the loop, eg. --fps, --uncapped and --wait-strategy).
 //--------------------------------------------------------------
 class Application : public UpdateLoop
 {
@@ -30,9 +38,16 @@ public:
     int GetArgCount() const;
     char** GetArgValues() const;
 
+    ApplicationOptions& GetOptions();
+    bool ApplyOptions();
+    int RunWithOptions();
+
+    static bool PinThreadToCpu(uint32_t a_cpu);
+
 private:
     int m_argCount = 0;
     char** m_argValues = nullptr;
+    ApplicationOptions m_options;
 };
 
 //--------------------------------------------------------------
@@ -63,4 +78,95 @@ inline char** Application::GetArgValues() const
     return m_argValues;
 }
 
+//--------------------------------------------------------------
+//! Get the options, eg. to register the application's own options
+//! before they are parsed, or to get the values of them after.
+//! \return The options of the application.
+//--------------------------------------------------------------
+inline ApplicationOptions& Application::GetOptions()
+{
+    return m_options;
+}
+
+//--------------------------------------------------------------
+//! Parse the arguments passed to the program into the options, then
+//! configure the loop with the standard options given: the target
+//! fps, whether it is capped, and the wait strategy. If a cpu is
+//! given, the calling thread (that should then run the loop) is
+//! pinned to it. Other standard options (eg. --threads, --trace) are
+//! left for the application to get from GetOptions().GetStandard().
+//! \return True if applied, false on an error (printed) or --help.
+//--------------------------------------------------------------
+inline bool Application::ApplyOptions()
+{
+    if (!m_options.Parse(m_argCount, m_argValues))
+    {
+        return false;
+    }
+
+    const ApplicationOptions::Standard& standard =
+        m_options.GetStandard();
+    if (m_options.IsSet("fps"))
+    {
+        SetTargetFPS(standard.fps);
+    }
+    if (m_options.IsSet("uncapped"))
+    {
+        SetCappedFPS(!standard.uncapped);
+    }
+    if (m_options.IsSet("wait-strategy"))
+    {
+        SetWaitStrategy(standard.waitStrategy);
+    }
+    if (m_options.IsSet("pin-cpu") && !PinThreadToCpu(standard.pinCpu))
+    {
+        return false;
+    }
+    return true;
+}
+
+//--------------------------------------------------------------
+//! Apply the options, then run the update loop in the calling thread
+//! at the target fps (given by --fps, or as already set).
+//! eg. int main(int argc, char* argv[])
+//!     { return MyApplication(argc, argv).RunWithOptions(); }
+//! \return Exit code for the program: zero if the loop ran (or help
+//!         was printed), or non-zero if the options are invalid.
+//--------------------------------------------------------------
+inline int Application::RunWithOptions()
+{
+    if (!ApplyOptions())
+    {
+        return m_options.IsHelpRequested() ? 0 : 1;
+    }
+    Run(GetTargetFPS());
+    return 0;
+}
+
+//--------------------------------------------------------------
+//! Pin the calling thread to a cpu (linux only).
+//! \param[in] a_cpu The index of the cpu to pin the thread to.
+//! \return True if pinned, false otherwise (printed).
+//--------------------------------------------------------------
+inline bool Application::PinThreadToCpu(uint32_t a_cpu)
+{
+#if defined(__linux__)
+    if (a_cpu < CPU_SETSIZE)
+    {
+        cpu_set_t cpus;
+        CPU_ZERO(&cpus);
+        CPU_SET(a_cpu, &cpus);
+        if (pthread_setaffinity_np(pthread_self(), sizeof(cpus),
+                                   &cpus) == 0)
+        {
+            return true;
+        }
+    }
+    printf("Cannot pin the thread to cpu %u.\n", a_cpu);
+#else
+    printf("Pinning threads to cpus is not supported.\n");
+#endif
+    return false;
+}
+
 } // namespace Simple
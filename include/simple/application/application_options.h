@@ -0,0 +1,483 @@
+//--------------------------------------------------------------
+// Copyright (c) David Bosnich <david.bosnich.public@gmail.com>
+//
+// This code is licensed under the MIT License, a copy of which
+// can be found in the license.txt file included at the root of
+// this distribution, or at https://opensource.org/licenses/MIT
+//--------------------------------------------------------------
+
+#pragma once
+
+#include "static_update_loop.h"
+
+#include <cerrno>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+//! @file
+
+//--------------------------------------------------------------
+//! Maximum count of options (including the standard options) that
+//! can be registered, all of which are stored without allocating.
+//--------------------------------------------------------------
+#ifndef DEFAULT_MAX_APPLICATION_OPTIONS
+#define DEFAULT_MAX_APPLICATION_OPTIONS 32u
+#endif//DEFAULT_MAX_APPLICATION_OPTIONS
+
+//--------------------------------------------------------------
+namespace Simple
+{
+
+//--------------------------------------------------------------
+//! Typed command line options, parsed in place without allocating
+//! into values registered by pointer. Options are long only, given
+//! as --name=value, --name value, or --name for flags (bools), and
+//! any arguments not starting with -- are left for the application.
+//! Strings point into the arguments, so live as long as they do.
+//!
+//! The standard options that configure the update loop and common
+//! services are registered on construction, and applications can
+//! register their own before parsing (eg. in their constructor).
+//--------------------------------------------------------------
+class ApplicationOptions
+{
+public:
+    //----------------------------------------------------------
+    //! Values of the standard options, left unchanged if not given.
+    //----------------------------------------------------------
+    struct Standard
+    {
+        uint32_t fps = 0;           //!< --fps: target fps (if set).
+        bool uncapped = false;      //!< --uncapped: do not cap fps.
+        uint32_t threads = 0;       //!< --threads: worker threads.
+        uint32_t pinCpu = 0;        //!< --pin-cpu: cpu (if set).
+        LoopPolicy::WaitStrategy waitStrategy =
+            LoopPolicy::WaitStrategy::Spin; //!< --wait-strategy.
+        const char* trace = nullptr;        //!< --trace: trace file.
+        float statsInterval = 0.0f; //!< --stats-interval: seconds.
+    };
+
+    ApplicationOptions();
+    ~ApplicationOptions() = default;
+
+    ApplicationOptions(const ApplicationOptions&) = delete;
+    ApplicationOptions& operator=(const ApplicationOptions&) = delete;
+
+    bool Add(const char* a_name, bool* o_value, const char* a_help);
+    bool Add(const char* a_name, uint32_t* o_value, const char* a_help,
+             uint32_t a_minimum = 0);
+    bool Add(const char* a_name, int32_t* o_value, const char* a_help);
+    bool Add(const char* a_name, float* o_value, const char* a_help);
+    bool Add(const char* a_name, const char** o_value, const char* a_help);
+    bool AddChoice(const char* a_name,
+                   uint8_t* o_index,
+                   const char* const* a_choices,
+                   uint8_t a_choiceCount,
+                   const char* a_help);
+
+    bool Parse(int a_argc, char* a_argv[]);
+    bool IsSet(const char* a_name) const;
+    bool IsHelpRequested() const;
+    void PrintHelp(const char* a_program) const;
+
+    const Standard& GetStandard() const;
+
+private:
+    enum class Type : uint8_t
+    {
+        Flag,
+        UInt,
+        Int,
+        Float,
+        String,
+        Choice
+    };
+
+    struct Option
+    {
+        const char* name = nullptr;
+        const char* help = nullptr;
+        void* value = nullptr;
+        const char* const* choices = nullptr;
+        uint32_t minimum = 0;
+        uint8_t choiceCount = 0;
+        Type type = Type::Flag;
+        bool set = false;
+    };
+
+    bool AddOption(const char* a_name,
+                   Type a_type,
+                   void* o_value,
+                   const char* a_help);
+    Option* FindOption(const char* a_name, size_t a_length);
+    const Option* FindOption(const char* a_name, size_t a_length) const;
+    static bool ParseValue(const Option& a_option, const char* a_text);
+
+    Option m_options[DEFAULT_MAX_APPLICATION_OPTIONS];
+    uint32_t m_optionCount = 0;
+    Standard m_standard;
+    bool m_helpRequested = false;
+};
+
+//--------------------------------------------------------------
+//! Constructor. Registers the standard options.
+//--------------------------------------------------------------
+inline ApplicationOptions::ApplicationOptions()
+{
+    static const char* const s_waitStrategies[] = { "spin", "sleep" };
+    Add("fps", &m_standard.fps, "Target frames per second.", 1);
+    Add("uncapped", &m_standard.uncapped, "Do not cap to the target fps.");
+    Add("threads", &m_standard.threads, "Count of worker threads.");
+    Add("pin-cpu", &m_standard.pinCpu, "Cpu to pin the loop thread to.");
+    AddChoice("wait-strategy", (uint8_t*)&m_standard.waitStrategy,
+              s_waitStrategies, 2, "How to wait for capped frames.");
+    Add("trace", &m_standard.trace, "File to write a trace to.");
+    Add("stats-interval", &m_standard.statsInterval,
+        "Seconds between reports of stats.");
+}
+
+//--------------------------------------------------------------
+//! Register a flag, set to true if given (or to an explicit value,
+//! eg. --name=false).
+//! @param[in] a_name The name of the option (without the --).
+//! @param[out] o_value The value to set (must outlive the options).
+//! @param[in] a_help The description printed by PrintHelp.
+//! @return True if registered, false if the name is already used
+//!         or the maximum count of options has been reached.
+//--------------------------------------------------------------
+inline bool ApplicationOptions::Add(const char* a_name,
+                                    bool* o_value,
+                                    const char* a_help)
+{
+    return AddOption(a_name, Type::Flag, o_value, a_help);
+}
+
+//--------------------------------------------------------------
+//! Register an unsigned integer option.
+//! @param[in] a_name The name of the option (without the --).
+//! @param[out] o_value The value to set (must outlive the options).
+//! @param[in] a_help The description printed by PrintHelp.
+//! @param[in] a_minimum The minimum valid value (optional).
+//! @return True if registered, false otherwise.
+//--------------------------------------------------------------
+inline bool ApplicationOptions::Add(const char* a_name,
+                                    uint32_t* o_value,
+                                    const char* a_help,
+                                    uint32_t a_minimum)
+{
+    if (!AddOption(a_name, Type::UInt, o_value, a_help))
+    {
+        return false;
+    }
+    m_options[m_optionCount - 1].minimum = a_minimum;
+    return true;
+}
+
+//--------------------------------------------------------------
+//! Register a signed integer option.
+//! @param[in] a_name The name of the option (without the --).
+//! @param[out] o_value The value to set (must outlive the options).
+//! @param[in] a_help The description printed by PrintHelp.
+//! @return True if registered, false otherwise.
+//--------------------------------------------------------------
+inline bool ApplicationOptions::Add(const char* a_name,
+                                    int32_t* o_value,
+                                    const char* a_help)
+{
+    return AddOption(a_name, Type::Int, o_value, a_help);
+}
+
+//--------------------------------------------------------------
+//! Register a floating point option.
+//! @param[in] a_name The name of the option (without the --).
+//! @param[out] o_value The value to set (must outlive the options).
+//! @param[in] a_help The description printed by PrintHelp.
+//! @return True if registered, false otherwise.
+//--------------------------------------------------------------
+inline bool ApplicationOptions::Add(const char* a_name,
+                                    float* o_value,
+                                    const char* a_help)
+{
+    return AddOption(a_name, Type::Float, o_value, a_help);
+}
+
+//--------------------------------------------------------------
+//! Register a string option, set to point into the arguments.
+//! @param[in] a_name The name of the option (without the --).
+//! @param[out] o_value The value to set (must outlive the options).
+//! @param[in] a_help The description printed by PrintHelp.
+//! @return True if registered, false otherwise.
+//--------------------------------------------------------------
+inline bool ApplicationOptions::Add(const char* a_name,
+                                    const char** o_value,
+                                    const char* a_help)
+{
+    return AddOption(a_name, Type::String, o_value, a_help);
+}
+
+//--------------------------------------------------------------
+//! Register an option that must be one of a set of choices, set to
+//! the index of the choice given (eg. for the values of an enum).
+//! @param[in] a_name The name of the option (without the --).
+//! @param[out] o_index The index to set (must outlive the options).
+//! @param[in] a_choices The names of the choices (must outlive it).
+//! @param[in] a_choiceCount The count of choices.
+//! @param[in] a_help The description printed by PrintHelp.
+//! @return True if registered, false otherwise.
+//--------------------------------------------------------------
+inline bool ApplicationOptions::AddChoice(const char* a_name,
+                                          uint8_t* o_index,
+                                          const char* const* a_choices,
+                                          uint8_t a_choiceCount,
+                                          const char* a_help)
+{
+    if (!AddOption(a_name, Type::Choice, o_index, a_help))
+    {
+        return false;
+    }
+    m_options[m_optionCount - 1].choices = a_choices;
+    m_options[m_optionCount - 1].choiceCount = a_choiceCount;
+    return true;
+}
+
+//--------------------------------------------------------------
+//! Parse the arguments passed to the program, setting the values
+//! of all options given. Stops at the first error, or at --help.
+//! @param[in] a_argc Count of arguments passed to the program.
+//! @param[in] a_argv Array of arguments passed to the program.
+//! @return True if parsed, false on an error (printed) or --help.
+//--------------------------------------------------------------
+inline bool ApplicationOptions::Parse(int a_argc, char* a_argv[])
+{
+    for (int i = 1; i < a_argc; ++i)
+    {
+        const char* arg = a_argv[i];
+        if (strncmp(arg, "--", 2) != 0)
+        {
+            continue;
+        }
+        if (strcmp(arg, "--help") == 0)
+        {
+            m_helpRequested = true;
+            PrintHelp(a_argv[0]);
+            return false;
+        }
+
+        // Split --name=value in place (without copying the name).
+        const char* name = arg + 2;
+        const char* equals = strchr(name, '=');
+        const size_t length = equals ? (size_t)(equals - name) :
+                                       strlen(name);
+        Option* option = FindOption(name, length);
+        if (!option)
+        {
+            printf("Unknown option '%s' (see --help).\n", arg);
+            return false;
+        }
+
+        const char* value = equals ? equals + 1 : nullptr;
+        if (!value && option->type != Type::Flag)
+        {
+            if (i + 1 >= a_argc)
+            {
+                printf("Option '%s' requires a value.\n", arg);
+                return false;
+            }
+            value = a_argv[++i];
+        }
+        if (!ParseValue(*option, value ? value : "true"))
+        {
+            printf("Invalid value '%s' for option '--%s'.\n",
+                   value, option->name);
+            return false;
+        }
+        option->set = true;
+    }
+    return true;
+}
+
+//--------------------------------------------------------------
+//! Check whether an option was given in the arguments parsed.
+//! @param[in] a_name The name of the option (without the --).
+//! @return True if the option was given.
+//--------------------------------------------------------------
+inline bool ApplicationOptions::IsSet(const char* a_name) const
+{
+    const Option* option = FindOption(a_name, strlen(a_name));
+    return option && option->set;
+}
+
+//--------------------------------------------------------------
+//! Check whether --help was given in the arguments parsed.
+//! @return True if --help was given.
+//--------------------------------------------------------------
+inline bool ApplicationOptions::IsHelpRequested() const
+{
+    return m_helpRequested;
+}
+
+//--------------------------------------------------------------
+//! Print the usage of the program and all options registered.
+//! @param[in] a_program The name of the program.
+//--------------------------------------------------------------
+inline void ApplicationOptions::PrintHelp(const char* a_program) const
+{
+    static const char* const s_typeNames[] = {
+        "", "=<uint>", "=<int>", "=<float>", "=<string>", "=<choice>" };
+    printf("Usage: %s [options]\n", a_program ? a_program : "");
+    for (uint32_t i = 0; i < m_optionCount; ++i)
+    {
+        const Option& option = m_options[i];
+        printf("  --%s%s\n      %s",
+               option.name,
+               s_typeNames[(int)option.type],
+               option.help ? option.help : "");
+        for (uint8_t c = 0; c < option.choiceCount; ++c)
+        {
+            printf("%s%s", c ? "|" : " (", option.choices[c]);
+        }
+        printf("%s\n", option.choiceCount ? ")" : "");
+    }
+}
+
+//--------------------------------------------------------------
+//! Get the values of the standard options.
+//! @return The values of the standard options.
+//--------------------------------------------------------------
+inline const ApplicationOptions::Standard&
+ApplicationOptions::GetStandard() const
+{
+    return m_standard;
+}
+
+//--------------------------------------------------------------
+inline bool ApplicationOptions::AddOption(const char* a_name,
+                                          Type a_type,
+                                          void* o_value,
+                                          const char* a_help)
+{
+    if (!a_name || !o_value || FindOption(a_name, strlen(a_name)))
+    {
+        printf("Option '%s' is invalid or already added.\n",
+               a_name ? a_name : "");
+        return false;
+    }
+    if (m_optionCount == DEFAULT_MAX_APPLICATION_OPTIONS)
+    {
+        printf("Too many options (DEFAULT_MAX_APPLICATION_OPTIONS).\n");
+        return false;
+    }
+    Option& option = m_options[m_optionCount++];
+    option.name = a_name;
+    option.help = a_help;
+    option.value = o_value;
+    option.type = a_type;
+    return true;
+}
+
+//--------------------------------------------------------------
+inline ApplicationOptions::Option* ApplicationOptions::FindOption(
+    const char* a_name,
+    size_t a_length)
+{
+    for (uint32_t i = 0; i < m_optionCount; ++i)
+    {
+        if (strncmp(m_options[i].name, a_name, a_length) == 0 &&
+            m_options[i].name[a_length] == '\0')
+        {
+            return &m_options[i];
+        }
+    }
+    return nullptr;
+}
+
+//--------------------------------------------------------------
+inline const ApplicationOptions::Option* ApplicationOptions::FindOption(
+    const char* a_name,
+    size_t a_length) const
+{
+    return const_cast<ApplicationOptions*>(this)->FindOption(a_name,
+                                                             a_length);
+}
+
+//--------------------------------------------------------------
+inline bool ApplicationOptions::ParseValue(const Option& a_option,
+                                           const char* a_text)
+{
+    // Numbers must be entirely valid (and finite), and are only
+    // written if so.
+    char* end = nullptr;
+    errno = 0;
+    switch (a_option.type)
+    {
+        case Type::Flag:
+        {
+            const bool isTrue = strcmp(a_text, "true") == 0 ||
+                                strcmp(a_text, "1") == 0;
+            const bool isFalse = strcmp(a_text, "false") == 0 ||
+                                 strcmp(a_text, "0") == 0;
+            if (isTrue || isFalse)
+            {
+                *(bool*)a_option.value = isTrue;
+            }
+            return isTrue || isFalse;
+        }
+        case Type::UInt:
+        {
+            const unsigned long long value = strtoull(a_text, &end, 10);
+            if (errno || end == a_text || *end != '\0' ||
+                *a_text == '-' || value > UINT32_MAX ||
+                value < a_option.minimum)
+            {
+                return false;
+            }
+            *(uint32_t*)a_option.value = (uint32_t)value;
+            return true;
+        }
+        case Type::Int:
+        {
+            const long long value = strtoll(a_text, &end, 10);
+            if (errno || end == a_text || *end != '\0' ||
+                value < INT32_MIN || value > INT32_MAX)
+            {
+                return false;
+            }
+            *(int32_t*)a_option.value = (int32_t)value;
+            return true;
+        }
+        case Type::Float:
+        {
+            const float value = strtof(a_text, &end);
+            if (errno || end == a_text || *end != '\0' ||
+                !std::isfinite(value))
+            {
+                return false;
+            }
+            *(float*)a_option.value = value;
+            return true;
+        }
+        case Type::String:
+        {
+            *(const char**)a_option.value = a_text;
+            return true;
+        }
+        case Type::Choice:
+        {
+            for (uint8_t c = 0; c < a_option.choiceCount; ++c)
+            {
+                if (strcmp(a_text, a_option.choices[c]) == 0)
+                {
+                    *(uint8_t*)a_option.value = c;
+                    return true;
+                }
+            }
+            return false;
+        }
+    }
+    return false;
+}
+
+} // namespace Simple
@@ -0,0 +1,638 @@
+//--------------------------------------------------------------
+// Copyright (c) David Bosnich <david.bosnich.public@gmail.com>
+//
+// This code is licensed under the MIT License, a copy of which
+// can be found in the license.txt file included at the root of
+// this distribution, or at https://opensource.org/licenses/MIT
+//--------------------------------------------------------------
+
+#pragma once
+
+#include "worker_pool.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+//! @file
+
+//--------------------------------------------------------------
+namespace Simple
+{
+
+//--------------------------------------------------------------
+//! Pool of equally sized memory blocks, each aligned for SIMD use.
+//! Freed blocks are kept for reuse until the pool is destroyed.
+//--------------------------------------------------------------
+class ChunkPool
+{
+public:
+    static constexpr size_t Alignment = 64;
+
+    explicit ChunkPool(size_t a_blockSize);
+    ~ChunkPool();
+
+    ChunkPool(const ChunkPool&) = delete;
+    ChunkPool& operator=(const ChunkPool&) = delete;
+
+    void* Allocate();
+    void Free(void* a_block);
+
+    size_t GetBlockSize() const;
+    size_t GetAllocatedCount() const;
+    size_t GetFreeCount() const;
+
+private:
+    const size_t m_blockSize;
+    std::vector<void*> m_allocated;  // Unaligned, as from malloc.
+    std::vector<void*> m_free;       // Aligned, as from Allocate.
+};
+
+//--------------------------------------------------------------
+//! Index of the first occurrence of a type in a pack of types.
+//--------------------------------------------------------------
+template<class Type, class... Types>
+struct TypeIndex;
+
+//--------------------------------------------------------------
+template<class Type, class... Rest>
+struct TypeIndex<Type, Type, Rest...>
+    : std::integral_constant<size_t, 0> {};
+
+//--------------------------------------------------------------
+template<class Type, class First, class... Rest>
+struct TypeIndex<Type, First, Rest...>
+    : std::integral_constant<size_t, 1 + TypeIndex<Type, Rest...>::value> {};
+
+//--------------------------------------------------------------
+//! Whether all types in a pack of types are trivially copyable.
+//--------------------------------------------------------------
+template<class... Types>
+struct AllTriviallyCopyable : std::true_type {};
+
+//--------------------------------------------------------------
+template<class First, class... Rest>
+struct AllTriviallyCopyable<First, Rest...>
+    : std::integral_constant<bool,
+                             std::is_trivially_copyable<First>::value &&
+                             AllTriviallyCopyable<Rest...>::value> {};
+
+//--------------------------------------------------------------
+//! Store of entities that each have one of every component type,
+//! held as a structure of arrays: each chunk of entities contains
+//! one SIMD aligned array per component type, so kernels can walk
+//! just the components they need, contiguously, a chunk at a time.
+//!
+//! Components must be trivially copyable, and are zero-initialized
+//! on creation. Destroying an entity moves the last entity into its
+//! place, so entities remain densely packed (only the last chunk is
+//! ever partially full) but iteration order changes.
+//--------------------------------------------------------------
+template<class... Components>
+class ComponentStore
+{
+public:
+    static_assert(sizeof...(Components) > 0, "No components");
+    static_assert(AllTriviallyCopyable<Components...>::value,
+                  "Components must be trivially copyable");
+
+    struct Entity
+    {
+        uint32_t index = UINT32_MAX;
+        uint32_t generation = 0;
+    };
+
+    explicit ComponentStore(uint32_t a_chunkCapacity = 1024);
+    ~ComponentStore();
+
+    ComponentStore(const ComponentStore&) = delete;
+    ComponentStore& operator=(const ComponentStore&) = delete;
+
+    Entity Create();
+    bool Destroy(Entity a_entity);
+    bool IsAlive(Entity a_entity) const;
+    void Reserve(uint32_t a_count);
+    void Clear();
+
+    template<class Component>
+    Component* Get(Entity a_entity);
+
+    Entity GetEntity(uint32_t a_index) const;
+    uint32_t GetCount() const;
+    uint32_t GetChunkCount() const;
+    uint32_t GetChunkCapacity() const;
+
+    template<class... Signature, class Func>
+    void ForChunk(uint32_t a_chunkIndex, Func&& a_func);
+
+    template<class... Signature, class Func>
+    void ForEachChunk(Func&& a_func);
+
+    template<class... Signature, class Func>
+    void ParallelForEachChunk(WorkerPool& a_workerPool, Func&& a_func);
+
+private:
+    static constexpr size_t ComponentCount = sizeof...(Components);
+
+    struct Slot
+    {
+        uint32_t generation = 0;
+        uint32_t denseIndex = UINT32_MAX; //!< Or next free slot.
+    };
+
+    static size_t ArraySize(size_t a_componentSize,
+                            uint32_t a_chunkCapacity);
+    static size_t ChunkSize(uint32_t a_chunkCapacity);
+
+    template<class Component>
+    Component* GetArray(uint32_t a_chunkIndex);
+
+    void MoveEntity(uint32_t a_from, uint32_t a_to);
+    void ZeroEntity(uint32_t a_denseIndex);
+    char* GetComponentData(size_t a_component, uint32_t a_denseIndex);
+
+    const uint32_t m_chunkCapacity;
+    size_t m_arrayOffsets[ComponentCount];
+    size_t m_componentSizes[ComponentCount];
+    ChunkPool m_chunkPool;
+    std::vector<char*> m_chunks;
+    std::vector<Slot> m_slots;
+    std::vector<uint32_t> m_denseToSlot;
+    uint32_t m_freeSlot = UINT32_MAX;
+    uint32_t m_count = 0;
+};
+
+//--------------------------------------------------------------
+//! Constructor.
+//! @param[in] a_blockSize The size of each block, in bytes.
+//--------------------------------------------------------------
+inline ChunkPool::ChunkPool(size_t a_blockSize)
+    : m_blockSize(a_blockSize)
+{
+}
+
+//--------------------------------------------------------------
+//! Destructor. Frees all blocks, whether or not they were freed.
+//--------------------------------------------------------------
+inline ChunkPool::~ChunkPool()
+{
+    for (void* block : m_allocated)
+    {
+        free(block);
+    }
+}
+
+//--------------------------------------------------------------
+//! Allocate a block, reusing a freed one if there are any.
+//! @return The allocated block (aligned), or null if out of memory.
+//--------------------------------------------------------------
+inline void* ChunkPool::Allocate()
+{
+    if (!m_free.empty())
+    {
+        void* block = m_free.back();
+        m_free.pop_back();
+        return block;
+    }
+
+    void* block = malloc(m_blockSize + Alignment - 1);
+    if (!block)
+    {
+        printf("ChunkPool::Allocate: out of memory\n");
+        return nullptr;
+    }
+    m_allocated.push_back(block);
+    m_free.reserve(m_allocated.size());
+
+    const uintptr_t address = (uintptr_t)block;
+    const uintptr_t mask = (uintptr_t)(Alignment - 1);
+    return (void*)((address + mask) & ~mask);
+}
+
+//--------------------------------------------------------------
+//! Free a block so it can be reused by a later allocation.
+//! @param[in] a_block A block previously returned by Allocate.
+//--------------------------------------------------------------
+inline void ChunkPool::Free(void* a_block)
+{
+    if (a_block)
+    {
+        m_free.push_back(a_block);
+    }
+}
+
+//--------------------------------------------------------------
+//! Get the size of each block.
+//! @return The size of each block, in bytes.
+//--------------------------------------------------------------
+inline size_t ChunkPool::GetBlockSize() const
+{
+    return m_blockSize;
+}
+
+//--------------------------------------------------------------
+//! Get the count of blocks allocated, whether freed or not.
+//! @return The count of blocks allocated, whether freed or not.
+//--------------------------------------------------------------
+inline size_t ChunkPool::GetAllocatedCount() const
+{
+    return m_allocated.size();
+}
+
+//--------------------------------------------------------------
+//! Get the count of blocks freed and available for reuse.
+//! @return The count of blocks freed and available for reuse.
+//--------------------------------------------------------------
+inline size_t ChunkPool::GetFreeCount() const
+{
+    return m_free.size();
+}
+
+
+//--------------------------------------------------------------
+//! Constructor.
+//! @param[in] a_chunkCapacity The count of entities in each chunk,
+//!            rounded up to a multiple of 16 (optional, def=1024).
+//--------------------------------------------------------------
+template<class... Components>
+inline ComponentStore<Components...>::ComponentStore(
+    uint32_t a_chunkCapacity)
+    : m_chunkCapacity((std::max(a_chunkCapacity, 1u) + 15u) & ~15u)
+    , m_componentSizes{ sizeof(Components)... }
+    , m_chunkPool(ChunkSize(m_chunkCapacity))
+{
+    size_t offset = 0;
+    for (size_t i = 0; i < ComponentCount; ++i)
+    {
+        m_arrayOffsets[i] = offset;
+        offset += ArraySize(m_componentSizes[i], m_chunkCapacity);
+    }
+}
+
+//--------------------------------------------------------------
+//! Destructor.
+//--------------------------------------------------------------
+template<class... Components>
+inline ComponentStore<Components...>::~ComponentStore()
+{
+    // All chunks are owned (and freed) by the chunk pool.
+}
+
+//--------------------------------------------------------------
+//! Create an entity, with all components zero-initialized.
+//! @return The entity, or an invalid entity if out of memory.
+//--------------------------------------------------------------
+template<class... Components>
+inline typename ComponentStore<Components...>::Entity
+ComponentStore<Components...>::Create()
+{
+    Entity entity;
+    if (m_count == m_chunks.size() * m_chunkCapacity)
+    {
+        char* chunk = (char*)m_chunkPool.Allocate();
+        if (!chunk)
+        {
+            return entity;
+        }
+        m_chunks.push_back(chunk);
+    }
+
+    if (m_freeSlot == UINT32_MAX)
+    {
+        m_freeSlot = (uint32_t)m_slots.size();
+        m_slots.emplace_back();
+    }
+    entity.index = m_freeSlot;
+    Slot& slot = m_slots[entity.index];
+    m_freeSlot = slot.denseIndex;
+    slot.denseIndex = m_count;
+    entity.generation = slot.generation;
+
+    m_denseToSlot.resize(m_count + 1);
+    m_denseToSlot[m_count] = entity.index;
+    ZeroEntity(m_count);
+    ++m_count;
+    return entity;
+}
+
+//--------------------------------------------------------------
+//! Destroy an entity, moving the last entity into its place.
+//! @param[in] a_entity The entity to destroy.
+//! @return True if the entity was alive, false otherwise.
+//--------------------------------------------------------------
+template<class... Components>
+inline bool ComponentStore<Components...>::Destroy(Entity a_entity)
+{
+    if (!IsAlive(a_entity))
+    {
+        return false;
+    }
+
+    Slot& slot = m_slots[a_entity.index];
+    const uint32_t denseIndex = slot.denseIndex;
+    const uint32_t lastIndex = --m_count;
+    if (denseIndex != lastIndex)
+    {
+        MoveEntity(lastIndex, denseIndex);
+        const uint32_t movedSlot = m_denseToSlot[lastIndex];
+        m_denseToSlot[denseIndex] = movedSlot;
+        m_slots[movedSlot].denseIndex = denseIndex;
+    }
+    m_denseToSlot.pop_back();
+
+    ++slot.generation;
+    slot.denseIndex = m_freeSlot;
+    m_freeSlot = a_entity.index;
+
+    // Return the last chunk to the pool once it is empty.
+    if (m_count <= (m_chunks.size() - 1) * m_chunkCapacity)
+    {
+        m_chunkPool.Free(m_chunks.back());
+        m_chunks.pop_back();
+    }
+    return true;
+}
+
+//--------------------------------------------------------------
+//! Check whether an entity is alive (created, not yet destroyed).
+//! @param[in] a_entity The entity to check.
+//! @return True if the entity is alive, false otherwise.
+//--------------------------------------------------------------
+template<class... Components>
+inline bool ComponentStore<Components...>::IsAlive(
+    Entity a_entity) const
+{
+    return a_entity.index < m_slots.size() &&
+           m_slots[a_entity.index].generation == a_entity.generation &&
+           m_slots[a_entity.index].denseIndex < m_count &&
+           m_denseToSlot[m_slots[a_entity.index].denseIndex] ==
+           a_entity.index;
+}
+
+//--------------------------------------------------------------
+//! Reserve memory for a count of entities, so creating them later
+//! does not need to allocate (other than for the chunk pointers).
+//! @param[in] a_count The count of entities to reserve memory for.
+//--------------------------------------------------------------
+template<class... Components>
+inline void ComponentStore<Components...>::Reserve(uint32_t a_count)
+{
+    const size_t chunkCount = (a_count + m_chunkCapacity - 1) /
+                              m_chunkCapacity;
+    m_chunks.reserve(chunkCount);
+    m_slots.reserve(a_count);
+    m_denseToSlot.reserve(a_count);
+
+    // Allocate then free any chunks that aren't yet in the pool.
+    std::vector<void*> chunks;
+    const size_t pooledCount = m_chunks.size() +
+                               m_chunkPool.GetFreeCount();
+    if (chunkCount > pooledCount)
+    {
+        const size_t allocateCount = chunkCount - m_chunks.size();
+        for (size_t i = 0; i < allocateCount; ++i)
+        {
+            void* chunk = m_chunkPool.Allocate();
+            if (!chunk)
+            {
+                break;
+            }
+            chunks.push_back(chunk);
+        }
+    }
+    for (void* chunk : chunks)
+    {
+        m_chunkPool.Free(chunk);
+    }
+}
+
+//--------------------------------------------------------------
+//! Destroy all entities, keeping the memory of all chunks pooled.
+//! Slots keep their generation (bumped), so old handles stay dead.
+//--------------------------------------------------------------
+template<class... Components>
+inline void ComponentStore<Components...>::Clear()
+{
+    for (char* chunk : m_chunks)
+    {
+        m_chunkPool.Free(chunk);
+    }
+    m_chunks.clear();
+    m_denseToSlot.clear();
+
+    // Free every slot, linked so the lowest indices are reused first.
+    m_freeSlot = UINT32_MAX;
+    for (size_t i = m_slots.size(); i-- > 0;)
+    {
+        Slot& slot = m_slots[i];
+        ++slot.generation;
+        slot.denseIndex = m_freeSlot;
+        m_freeSlot = (uint32_t)i;
+    }
+    m_count = 0;
+}
+
+//--------------------------------------------------------------
+//! Get a component of an entity. The pointer remains valid until
+//! an entity is destroyed (which may move this entity's data).
+//! @param[in] a_entity The entity to get the component of.
+//! @return The component, or null if the entity is not alive.
+//--------------------------------------------------------------
+template<class... Components>
+template<class Component>
+inline Component* ComponentStore<Components...>::Get(Entity a_entity)
+{
+    if (!IsAlive(a_entity))
+    {
+        return nullptr;
+    }
+    const size_t index = TypeIndex<Component, Components...>::value;
+    const uint32_t denseIndex = m_slots[a_entity.index].denseIndex;
+    return (Component*)GetComponentData(index, denseIndex);
+}
+
+//--------------------------------------------------------------
+//! Get an entity by its current position in iteration order, ie.
+//! a_index = chunk index * chunk capacity + index within the chunk.
+//! Positions change when any entity is created or destroyed.
+//! @param[in] a_index The position of the entity (< count).
+//! @return The entity at the position, or invalid if out of range.
+//--------------------------------------------------------------
+template<class... Components>
+inline typename ComponentStore<Components...>::Entity
+ComponentStore<Components...>::GetEntity(uint32_t a_index) const
+{
+    Entity entity;
+    if (a_index < m_count)
+    {
+        entity.index = m_denseToSlot[a_index];
+        entity.generation = m_slots[entity.index].generation;
+    }
+    return entity;
+}
+
+//--------------------------------------------------------------
+//! Get the count of entities that are alive.
+//! @return The count of entities that are alive.
+//--------------------------------------------------------------
+template<class... Components>
+inline uint32_t ComponentStore<Components...>::GetCount() const
+{
+    return m_count;
+}
+
+//--------------------------------------------------------------
+//! Get the count of chunks in use (all full except the last one).
+//! @return The count of chunks in use.
+//--------------------------------------------------------------
+template<class... Components>
+inline uint32_t ComponentStore<Components...>::GetChunkCount() const
+{
+    return (uint32_t)m_chunks.size();
+}
+
+//--------------------------------------------------------------
+//! Get the count of entities that fit in each chunk.
+//! @return The count of entities that fit in each chunk.
+//--------------------------------------------------------------
+template<class... Components>
+inline uint32_t ComponentStore<Components...>::GetChunkCapacity() const
+{
+    return m_chunkCapacity;
+}
+
+//--------------------------------------------------------------
+//! Call a function with the count of entities in a chunk and a (64
+//! byte aligned) array of each component in a signature, as per
+//! ForEachChunk, eg. to run several functions on each chunk in turn.
+//! @param[in] a_chunkIndex The index of the chunk (< chunk count).
+//! @param[in] a_func The function to call for the chunk.
+//--------------------------------------------------------------
+template<class... Components>
+template<class... Signature, class Func>
+inline void ComponentStore<Components...>::ForChunk(
+    uint32_t a_chunkIndex,
+    Func&& a_func)
+{
+    const uint32_t firstIndex = a_chunkIndex * m_chunkCapacity;
+    const uint32_t count = std::min(m_count - firstIndex,
+                                    m_chunkCapacity);
+    a_func(count, GetArray<Signature>(a_chunkIndex)...);
+}
+
+//--------------------------------------------------------------
+//! Call a function for each chunk with the count of entities in it
+//! and a (64 byte aligned) array of each component in a signature.
+//! eg. ForEachChunk<Position, Velocity>(
+//!         [](uint32_t a_count, Position* a_p, Velocity* a_v) {});
+//! @param[in] a_func The function to call for each chunk.
+//--------------------------------------------------------------
+template<class... Components>
+template<class... Signature, class Func>
+inline void ComponentStore<Components...>::ForEachChunk(Func&& a_func)
+{
+    for (uint32_t i = 0; i < m_chunks.size(); ++i)
+    {
+        ForChunk<Signature...>(i, a_func);
+    }
+}
+
+//--------------------------------------------------------------
+//! Call a function for each chunk, as per ForEachChunk, spreading
+//! the chunks across the threads of a pool (which includes the one
+//! calling). Entities must not be created or destroyed meanwhile.
+//! @param[in] a_workerPool The pool of threads to use.
+//! @param[in] a_func The function to call for each chunk.
+//--------------------------------------------------------------
+template<class... Components>
+template<class... Signature, class Func>
+inline void ComponentStore<Components...>::ParallelForEachChunk(
+    WorkerPool& a_workerPool,
+    Func&& a_func)
+{
+    a_workerPool.ParallelFor((uint32_t)m_chunks.size(),
+                             [this, &a_func](uint32_t a_chunkIndex)
+    {
+        ForChunk<Signature...>(a_chunkIndex, a_func);
+    });
+}
+
+//--------------------------------------------------------------
+template<class... Components>
+inline size_t ComponentStore<Components...>::ArraySize(
+    size_t a_componentSize,
+    uint32_t a_chunkCapacity)
+{
+    const size_t mask = ChunkPool::Alignment - 1;
+    return (a_componentSize * a_chunkCapacity + mask) & ~mask;
+}
+
+//--------------------------------------------------------------
+template<class... Components>
+inline size_t ComponentStore<Components...>::ChunkSize(
+    uint32_t a_chunkCapacity)
+{
+    const size_t sizes[] = { sizeof(Components)... };
+    size_t chunkSize = 0;
+    for (size_t size : sizes)
+    {
+        chunkSize += ArraySize(size, a_chunkCapacity);
+    }
+    return chunkSize;
+}
+
+//--------------------------------------------------------------
+template<class... Components>
+template<class Component>
+inline Component* ComponentStore<Components...>::GetArray(
+    uint32_t a_chunkIndex)
+{
+    const size_t index = TypeIndex<Component, Components...>::value;
+    return (Component*)(m_chunks[a_chunkIndex] + m_arrayOffsets[index]);
+}
+
+//--------------------------------------------------------------
+template<class... Components>
+inline void ComponentStore<Components...>::MoveEntity(uint32_t a_from,
+                                                      uint32_t a_to)
+{
+    for (size_t i = 0; i < ComponentCount; ++i)
+    {
+        memcpy(GetComponentData(i, a_to),
+               GetComponentData(i, a_from),
+               m_componentSizes[i]);
+    }
+}
+
+//--------------------------------------------------------------
+template<class... Components>
+inline void ComponentStore<Components...>::ZeroEntity(
+    uint32_t a_denseIndex)
+{
+    for (size_t i = 0; i < ComponentCount; ++i)
+    {
+        memset(GetComponentData(i, a_denseIndex), 0,
+               m_componentSizes[i]);
+    }
+}
+
+//--------------------------------------------------------------
+template<class... Components>
+inline char* ComponentStore<Components...>::GetComponentData(
+    size_t a_component,
+    uint32_t a_denseIndex)
+{
+    const uint32_t chunkIndex = a_denseIndex / m_chunkCapacity;
+    const uint32_t chunkRow = a_denseIndex % m_chunkCapacity;
+    return m_chunks[chunkIndex] +
+           m_arrayOffsets[a_component] +
+           m_componentSizes[a_component] * chunkRow;
+}
+
+} // namespace Simple
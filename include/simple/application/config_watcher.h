@@ -0,0 +1,769 @@
+//--------------------------------------------------------------
+// Copyright (c) David Bosnich <david.bosnich.public@gmail.com>
+//
+// This code is licensed under the MIT License, a copy of which
+// can be found in the license.txt file included at the root of
+// this distribution, or at https://opensource.org/licenses/MIT
+//--------------------------------------------------------------
+
+#pragma once
+
+#include "update_loop.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <iterator>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#if defined(__linux__)
+#include <poll.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+#define SIMPLE_CONFIG_WATCHER_SUPPORTED 1
+#endif
+
+//! @file
+
+//--------------------------------------------------------------
+//! Maximum count of reloads (and rejections) kept in the timeline.
+//--------------------------------------------------------------
+#ifndef DEFAULT_CONFIG_TIMELINE_SIZE
+#define DEFAULT_CONFIG_TIMELINE_SIZE 64u
+#endif//DEFAULT_CONFIG_TIMELINE_SIZE
+
+//--------------------------------------------------------------
+namespace Simple
+{
+
+#if SIMPLE_CONFIG_WATCHER_SUPPORTED
+//--------------------------------------------------------------
+//! A config parsed from lines of "key = value" (with blank lines
+//! and lines starting with # ignored). Standard keys configure the
+//! update loop, and are only applied if present:
+//!
+//!     fps = <n>               Target fps.
+//!     capped = <true|false>   Whether the fps is capped.
+//!     wait_strategy = <spin|sleep>
+//!     max_catch_up = <n>      Fixed updates to catch up on.
+//!     stats_interval = <s>    Seconds between stats reports.
+//!
+//! The stats interval is not a setting of the loop itself, so it is
+//! applied by ConfigWatcher::GetStatsInterval, for the application's
+//! stats reporting to read (eg. from OnFrameComplete) each time.
+//! Any other keys must be registered by the application.
+//--------------------------------------------------------------
+class Config
+{
+public:
+    uint32_t fps = 0;               //!< Zero if not present.
+    int8_t capped = -1;             //!< Negative if not present.
+    int8_t waitStrategy = -1;       //!< Negative if not present.
+    uint32_t maxCatchUp = 0;        //!< Zero if not present.
+    float statsInterval = -1.0f;    //!< Negative if not present.
+
+    const std::string* Find(const std::string& a_key) const;
+    const std::vector<std::pair<std::string, std::string>>&
+        GetEntries() const;
+
+    bool Parse(const std::string& a_text,
+               const std::vector<std::string>& a_appKeys,
+               std::string& o_error);
+
+private:
+    bool ParseStandard(const std::string& a_key,
+                       const std::string& a_value,
+                       bool& o_valid);
+
+    std::vector<std::pair<std::string, std::string>> m_entries;
+};
+
+//--------------------------------------------------------------
+//! Watches a config file (linux only) with inotify on a helper thread
+//! and hot reloads it without restarting the update loop: each time
+//! the file is written (or replaced), it is parsed and validated on
+//! the helper thread, then applied by the thread running the loop at
+//! the start of the next frame, all at once. Invalid configs are
+//! rejected (printed) and the last valid config is kept.
+//!
+//! Every reload applied or rejected is recorded in a timeline with
+//! the index of the frame it happened in, and the latency from the
+//! file changing to the config being applied.
+//!
+//! Configs are applied from a listener on the loop, so the watcher
+//! must not be created or destroyed while the loop is running (see
+//! UpdateLoop::Listener).
+//--------------------------------------------------------------
+class ConfigWatcher : public UpdateLoop::Listener
+{
+public:
+    using Clock = std::chrono::steady_clock;
+    using ValidateFunc = std::function<bool(const Config& a_config,
+                                            std::string& o_error)>;
+    using ReloadFunc = std::function<void(const Config& a_config)>;
+
+    struct ReloadEvent
+    {
+        bool applied = false;       //!< False if rejected.
+        uint64_t frameIndex = 0;    //!< Frames started before it.
+        Clock::time_point time;
+        Clock::duration latency = Clock::duration::zero();
+        std::string error;          //!< Why it was rejected.
+    };
+
+    explicit ConfigWatcher(UpdateLoop& a_loop);
+    ~ConfigWatcher() override;
+
+    ConfigWatcher(const ConfigWatcher&) = delete;
+    ConfigWatcher& operator=(const ConfigWatcher&) = delete;
+
+    void AddKey(const char* a_key);
+    void SetValidateFunc(ValidateFunc a_validateFunc);
+    void SetReloadFunc(ReloadFunc a_reloadFunc);
+
+    bool Start(const char* a_path);
+    void Stop();
+    bool Load();
+
+    bool IsWatching() const;
+    const Config* GetConfig() const;
+    uint64_t GetAppliedCount() const;
+    uint64_t GetRejectedCount() const;
+    float GetStatsInterval() const;
+    std::vector<ReloadEvent> GetTimeline() const;
+
+    void OnPhaseBegin(UpdatePhase a_phase) override;
+
+private:
+    // Allocated (and freed) off the thread running the loop, which
+    // takes it once pending to make it current, then retires it.
+    struct PendingConfig
+    {
+        Config config;
+        Clock::time_point changeTime;
+        PendingConfig* nextRetired = nullptr;
+    };
+
+    // Written only by the thread running the loop, to a ring read
+    // with a sequence lock so recording never blocks the loop.
+    struct AppliedEvent
+    {
+        std::atomic<uint64_t> frameIndex = { 0 };
+        std::atomic<Clock::rep> time = { 0 };
+        std::atomic<Clock::rep> latency = { 0 };
+    };
+
+    void WatchMain();
+    void Apply(PendingConfig* a_pending);
+    void Retire(PendingConfig* a_retired);
+    void FreeRetired();
+    void Record(const ReloadEvent& a_event);
+    void ReadApplied(std::vector<ReloadEvent>& o_events) const;
+
+    UpdateLoop& m_loop;
+    std::vector<std::string> m_appKeys;
+    ValidateFunc m_validateFunc;
+    ReloadFunc m_reloadFunc;
+    std::string m_path;
+    std::string m_fileName;
+    std::thread m_thread;
+    int m_inotifyFd = -1;
+    int m_stopFds[2] = { -1, -1 };
+
+    std::mutex m_loadMutex;
+    std::atomic<PendingConfig*> m_pending = { nullptr };
+    std::atomic<PendingConfig*> m_retired = { nullptr };
+    PendingConfig* m_current = nullptr;
+    std::atomic<uint64_t> m_frameIndex = { 0 };
+    std::atomic<uint64_t> m_appliedCount = { 0 };
+    std::atomic<uint64_t> m_rejectedCount = { 0 };
+    std::atomic<float> m_statsInterval = { -1.0f };
+
+    mutable std::mutex m_timelineMutex;
+    std::vector<ReloadEvent> m_timeline;    // Rejected only.
+
+    std::atomic<uint64_t> m_appliedSequence = { 0 };
+    AppliedEvent m_appliedEvents[DEFAULT_CONFIG_TIMELINE_SIZE];
+};
+
+//--------------------------------------------------------------
+//! Find the value of a key.
+//! @param[in] a_key The key to find the value of.
+//! @return The value of the key, or null if it is not present.
+//--------------------------------------------------------------
+inline const std::string* Config::Find(const std::string& a_key) const
+{
+    for (const auto& entry : m_entries)
+    {
+        if (entry.first == a_key)
+        {
+            return &entry.second;
+        }
+    }
+    return nullptr;
+}
+
+//--------------------------------------------------------------
+//! Get all keys and values, in the order they were parsed.
+//! @return All keys and values.
+//--------------------------------------------------------------
+inline const std::vector<std::pair<std::string, std::string>>&
+Config::GetEntries() const
+{
+    return m_entries;
+}
+
+//--------------------------------------------------------------
+//! Parse a config from text.
+//! @param[in] a_text The text to parse.
+//! @param[in] a_appKeys The keys registered by the application.
+//! @param[out] o_error Why the config is invalid.
+//! @return True if parsed, false if the config is invalid.
+//--------------------------------------------------------------
+inline bool Config::Parse(const std::string& a_text,
+                          const std::vector<std::string>& a_appKeys,
+                          std::string& o_error)
+{
+    const auto trim = [](const std::string& a_string)
+    {
+        const size_t begin = a_string.find_first_not_of(" \t\r");
+        const size_t end = a_string.find_last_not_of(" \t\r");
+        return begin == std::string::npos ?
+               std::string() : a_string.substr(begin, end - begin + 1);
+    };
+
+    size_t lineBegin = 0;
+    for (uint32_t lineNumber = 1; lineBegin <= a_text.size(); ++lineNumber)
+    {
+        size_t lineEnd = a_text.find('\n', lineBegin);
+        if (lineEnd == std::string::npos)
+        {
+            lineEnd = a_text.size();
+        }
+        const std::string line = trim(a_text.substr(lineBegin,
+                                                    lineEnd - lineBegin));
+        lineBegin = lineEnd + 1;
+        if (line.empty() || line[0] == '#')
+        {
+            continue;
+        }
+
+        const size_t equals = line.find('=');
+        const std::string key = trim(line.substr(0, equals));
+        if (equals == std::string::npos || key.empty())
+        {
+            o_error = "line " + std::to_string(lineNumber) +
+                      ": expected key = value";
+            return false;
+        }
+        const std::string value = trim(line.substr(equals + 1));
+
+        bool valid = true;
+        if (!ParseStandard(key, value, valid))
+        {
+            bool registered = false;
+            for (const std::string& appKey : a_appKeys)
+            {
+                registered = registered || appKey == key;
+            }
+            if (!registered)
+            {
+                o_error = "line " + std::to_string(lineNumber) +
+                          ": unknown key '" + key + "'";
+                return false;
+            }
+        }
+        if (!valid)
+        {
+            o_error = "line " + std::to_string(lineNumber) +
+                      ": invalid value '" + value + "' for '" + key + "'";
+            return false;
+        }
+        m_entries.emplace_back(key, value);
+    }
+    return true;
+}
+
+//--------------------------------------------------------------
+inline bool Config::ParseStandard(const std::string& a_key,
+                                  const std::string& a_value,
+                                  bool& o_valid)
+{
+    const char* text = a_value.c_str();
+    char* end = nullptr;
+    if (a_key == "fps" || a_key == "max_catch_up")
+    {
+        const unsigned long value = strtoul(text, &end, 10);
+        o_valid = end != text && *end == '\0' && text[0] != '-' &&
+                  value > 0 && value <= 100000;
+        (a_key == "fps" ? fps : maxCatchUp) = (uint32_t)value;
+        return true;
+    }
+    if (a_key == "capped")
+    {
+        o_valid = a_value == "true" || a_value == "false";
+        capped = a_value == "true" ? 1 : 0;
+        return true;
+    }
+    if (a_key == "wait_strategy")
+    {
+        o_valid = a_value == "spin" || a_value == "sleep";
+        waitStrategy = (int8_t)(a_value == "sleep" ?
+                                LoopPolicy::WaitStrategy::Sleep :
+                                LoopPolicy::WaitStrategy::Spin);
+        return true;
+    }
+    if (a_key == "stats_interval")
+    {
+        statsInterval = strtof(text, &end);
+        o_valid = end != text && *end == '\0' && statsInterval >= 0.0f;
+        return true;
+    }
+    return false;
+}
+
+//--------------------------------------------------------------
+//! Constructor. Does not watch until it is started.
+//! @param[in] a_loop The loop to configure (and listen to).
+//--------------------------------------------------------------
+inline ConfigWatcher::ConfigWatcher(UpdateLoop& a_loop)
+    : m_loop(a_loop)
+{
+    m_loop.AddListener(this);
+}
+
+//--------------------------------------------------------------
+//! Destructor. Stops watching, and drops any config not applied.
+//--------------------------------------------------------------
+inline ConfigWatcher::~ConfigWatcher()
+{
+    Stop();
+    delete m_pending.exchange(nullptr);
+    delete m_current;
+    FreeRetired();
+    m_loop.RemoveListener(this);
+}
+
+//--------------------------------------------------------------
+//! Register a key defined by the application (other keys that are
+//! not standard are rejected). Must not be called while watching.
+//! @param[in] a_key The key to register.
+//--------------------------------------------------------------
+inline void ConfigWatcher::AddKey(const char* a_key)
+{
+    m_appKeys.push_back(a_key);
+}
+
+//--------------------------------------------------------------
+//! Set a function called on the helper thread to validate each
+//! config parsed (eg. the values of the application's own keys).
+//! Must not be called while watching.
+//! @param[in] a_validateFunc The function returning false (and an
+//!                           error) if the config is invalid.
+//--------------------------------------------------------------
+inline void ConfigWatcher::SetValidateFunc(ValidateFunc a_validateFunc)
+{
+    m_validateFunc = a_validateFunc;
+}
+
+//--------------------------------------------------------------
+//! Set a function called on the thread running the loop with each
+//! config applied, after the standard keys have been applied. Must
+//! not be called while watching.
+//! @param[in] a_reloadFunc The function to call with each config.
+//--------------------------------------------------------------
+inline void ConfigWatcher::SetReloadFunc(ReloadFunc a_reloadFunc)
+{
+    m_reloadFunc = a_reloadFunc;
+}
+
+//--------------------------------------------------------------
+//! Load a config file, then watch it for changes. The file (or its
+//! directory) is watched so it can be replaced, eg. by editors.
+//! @param[in] a_path The path of the config file.
+//! @return True if the config was valid and is being watched.
+//--------------------------------------------------------------
+inline bool ConfigWatcher::Start(const char* a_path)
+{
+    Stop();
+    m_path = a_path;
+    const size_t slash = m_path.rfind('/');
+    const std::string directory = slash == std::string::npos ?
+                                  "." : m_path.substr(0, slash + 1);
+    m_fileName = slash == std::string::npos ?
+                 m_path : m_path.substr(slash + 1);
+
+    m_inotifyFd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (m_inotifyFd < 0 ||
+        inotify_add_watch(m_inotifyFd, directory.c_str(),
+                          IN_CLOSE_WRITE | IN_MOVED_TO) < 0 ||
+        pipe(m_stopFds) != 0)
+    {
+        printf("ConfigWatcher: cannot watch '%s'\n", a_path);
+        if (m_inotifyFd >= 0)
+        {
+            close(m_inotifyFd);
+            m_inotifyFd = -1;
+        }
+        return false;
+    }
+
+    const bool loaded = Load();
+    m_thread = std::thread(&ConfigWatcher::WatchMain, this);
+    return loaded;
+}
+
+//--------------------------------------------------------------
+//! Stop watching the config file.
+//--------------------------------------------------------------
+inline void ConfigWatcher::Stop()
+{
+    if (!m_thread.joinable())
+    {
+        return;
+    }
+    const char stop = 1;
+    if (write(m_stopFds[1], &stop, 1) != 1)
+    {
+        printf("ConfigWatcher: cannot stop the helper thread\n");
+    }
+    m_thread.join();
+    close(m_inotifyFd);
+    close(m_stopFds[0]);
+    close(m_stopFds[1]);
+    m_inotifyFd = -1;
+    m_stopFds[0] = -1;
+    m_stopFds[1] = -1;
+}
+
+//--------------------------------------------------------------
+//! Load the config file now (on the calling thread), to be applied
+//! at the start of the next frame if it is valid. Called on start,
+//! and on the helper thread each time the file changes.
+//! @return True if the config is valid, false if rejected.
+//--------------------------------------------------------------
+inline bool ConfigWatcher::Load()
+{
+    std::lock_guard<std::mutex> lock(m_loadMutex);
+    FreeRetired();
+    std::unique_ptr<PendingConfig> pending(new PendingConfig());
+    pending->changeTime = Clock::now();
+
+    std::string error;
+    std::ifstream file(m_path);
+    if (!file)
+    {
+        error = "cannot open '" + m_path + "'";
+    }
+    else
+    {
+        const std::string text((std::istreambuf_iterator<char>(file)),
+                               std::istreambuf_iterator<char>());
+        if (pending->config.Parse(text, m_appKeys, error) &&
+            m_validateFunc && !m_validateFunc(pending->config, error) &&
+            error.empty())
+        {
+            error = "rejected by the application";
+        }
+    }
+
+    if (!error.empty())
+    {
+        printf("ConfigWatcher: rejected '%s': %s\n",
+               m_path.c_str(), error.c_str());
+        m_rejectedCount.fetch_add(1, std::memory_order_acq_rel);
+        ReloadEvent event;
+        event.frameIndex = m_frameIndex.load(std::memory_order_acquire);
+        event.time = pending->changeTime;
+        event.error = error;
+        Record(event);
+        return false;
+    }
+
+    // Replace any config still pending (never applied, so dropped).
+    delete m_pending.exchange(pending.release(), std::memory_order_acq_rel);
+    return true;
+}
+
+//--------------------------------------------------------------
+//! Check whether the config file is being watched.
+//! @return True if the config file is being watched.
+//--------------------------------------------------------------
+inline bool ConfigWatcher::IsWatching() const
+{
+    return m_thread.joinable();
+}
+
+//--------------------------------------------------------------
+//! Get the config last applied. Must only be called on the thread
+//! running the loop (or while it is not running).
+//! @return The config last applied, or null if none has been.
+//--------------------------------------------------------------
+inline const Config* ConfigWatcher::GetConfig() const
+{
+    return m_current ? &m_current->config : nullptr;
+}
+
+//--------------------------------------------------------------
+//! Get the count of configs applied.
+//! @return The count of configs applied.
+//--------------------------------------------------------------
+inline uint64_t ConfigWatcher::GetAppliedCount() const
+{
+    return m_appliedCount.load(std::memory_order_acquire);
+}
+
+//--------------------------------------------------------------
+//! Get the count of configs rejected.
+//! @return The count of configs rejected.
+//--------------------------------------------------------------
+inline uint64_t ConfigWatcher::GetRejectedCount() const
+{
+    return m_rejectedCount.load(std::memory_order_acquire);
+}
+
+//--------------------------------------------------------------
+//! Get the seconds between stats reports, from the last config applied
+//! that had the stats_interval key (from any thread). Zero means that
+//! stats should not be reported.
+//! @return The seconds between stats reports, or negative if not set.
+//--------------------------------------------------------------
+inline float ConfigWatcher::GetStatsInterval() const
+{
+    return m_statsInterval.load(std::memory_order_acquire);
+}
+
+//--------------------------------------------------------------
+//! Get the most recent reloads applied and rejected, oldest first.
+//! @return The most recent reloads applied and rejected.
+//--------------------------------------------------------------
+inline std::vector<ConfigWatcher::ReloadEvent>
+ConfigWatcher::GetTimeline() const
+{
+    std::vector<ReloadEvent> timeline;
+    ReadApplied(timeline);
+    {
+        std::lock_guard<std::mutex> lock(m_timelineMutex);
+        timeline.insert(timeline.end(), m_timeline.begin(),
+                        m_timeline.end());
+    }
+    std::stable_sort(timeline.begin(), timeline.end(),
+                     [](const ReloadEvent& a_a, const ReloadEvent& a_b)
+    {
+        return a_a.time < a_b.time;
+    });
+    if (timeline.size() > DEFAULT_CONFIG_TIMELINE_SIZE)
+    {
+        timeline.erase(timeline.begin(), timeline.end() -
+                       DEFAULT_CONFIG_TIMELINE_SIZE);
+    }
+    return timeline;
+}
+
+//--------------------------------------------------------------
+//! Applies any config pending at the start of each frame.
+//! @param[in] a_phase The phase of the loop that is about to begin.
+//--------------------------------------------------------------
+inline void ConfigWatcher::OnPhaseBegin(UpdatePhase a_phase)
+{
+    if (a_phase != UpdatePhase::Start)
+    {
+        return;
+    }
+
+    // Never blocks (or allocates on) the loop: the pending config is
+    // swapped out, and the one it replaces is retired to be freed.
+    PendingConfig* pending = m_pending.exchange(nullptr,
+                                                std::memory_order_acq_rel);
+    if (pending)
+    {
+        Apply(pending);
+    }
+    m_frameIndex.fetch_add(1, std::memory_order_acq_rel);
+}
+
+//--------------------------------------------------------------
+inline void ConfigWatcher::WatchMain()
+{
+    pollfd fds[2] = {};
+    fds[0].fd = m_stopFds[0];
+    fds[0].events = POLLIN;
+    fds[1].fd = m_inotifyFd;
+    fds[1].events = POLLIN;
+    alignas(inotify_event) char buffer[4096];
+    while (true)
+    {
+        if (poll(fds, 2, -1) < 0)
+        {
+            continue;   // Interrupted.
+        }
+        if (fds[0].revents)
+        {
+            return;
+        }
+
+        // Reload once for all events on the file read together.
+        bool changed = false;
+        ssize_t count = 0;
+        while ((count = read(m_inotifyFd, buffer, sizeof(buffer))) > 0)
+        {
+            for (ssize_t offset = 0; offset < count;)
+            {
+                const inotify_event* event =
+                    (const inotify_event*)(buffer + offset);
+                changed = changed ||
+                          (event->len && m_fileName == event->name);
+                offset += (ssize_t)(sizeof(inotify_event) + event->len);
+            }
+        }
+        if (changed)
+        {
+            Load();
+        }
+    }
+}
+
+//--------------------------------------------------------------
+inline void ConfigWatcher::Apply(PendingConfig* a_pending)
+{
+    const Config& config = a_pending->config;
+    if (config.fps)
+    {
+        m_loop.SetTargetFPS(config.fps);
+    }
+    if (config.capped >= 0)
+    {
+        m_loop.SetCappedFPS(config.capped != 0);
+    }
+    if (config.waitStrategy >= 0)
+    {
+        m_loop.SetWaitStrategy(
+            (LoopPolicy::WaitStrategy)config.waitStrategy);
+    }
+    if (config.maxCatchUp)
+    {
+        m_loop.SetMaxCatchUp(config.maxCatchUp);
+    }
+    if (config.statsInterval >= 0.0f)
+    {
+        m_statsInterval.store(config.statsInterval,
+                              std::memory_order_release);
+    }
+    if (m_current)
+    {
+        Retire(m_current);
+    }
+    m_current = a_pending;
+    if (m_reloadFunc)
+    {
+        m_reloadFunc(config);
+    }
+
+    // Record it in the next slot of the ring (overwriting the oldest).
+    const Clock::time_point now = Clock::now();
+    const uint64_t appliedCount = m_appliedCount.load(
+        std::memory_order_relaxed);
+    AppliedEvent& event =
+        m_appliedEvents[appliedCount % DEFAULT_CONFIG_TIMELINE_SIZE];
+    const uint64_t sequence = m_appliedSequence.load(
+        std::memory_order_relaxed);
+    m_appliedSequence.store(sequence + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    event.frameIndex.store(m_frameIndex.load(std::memory_order_relaxed),
+                           std::memory_order_relaxed);
+    event.time.store(now.time_since_epoch().count(),
+                     std::memory_order_relaxed);
+    event.latency.store((now - a_pending->changeTime).count(),
+                        std::memory_order_relaxed);
+    m_appliedCount.store(appliedCount + 1, std::memory_order_relaxed);
+    m_appliedSequence.store(sequence + 2, std::memory_order_release);
+}
+
+//--------------------------------------------------------------
+inline void ConfigWatcher::Retire(PendingConfig* a_retired)
+{
+    PendingConfig* next = m_retired.load(std::memory_order_relaxed);
+    do
+    {
+        a_retired->nextRetired = next;
+    }
+    while (!m_retired.compare_exchange_weak(next, a_retired,
+                                            std::memory_order_release,
+                                            std::memory_order_relaxed));
+}
+
+//--------------------------------------------------------------
+inline void ConfigWatcher::FreeRetired()
+{
+    PendingConfig* retired = m_retired.exchange(nullptr,
+                                                std::memory_order_acquire);
+    while (retired)
+    {
+        PendingConfig* next = retired->nextRetired;
+        delete retired;
+        retired = next;
+    }
+}
+
+//--------------------------------------------------------------
+inline void ConfigWatcher::ReadApplied(
+    std::vector<ReloadEvent>& o_events) const
+{
+    uint64_t sequence = 0;
+    do
+    {
+        o_events.clear();
+        sequence = m_appliedSequence.load(std::memory_order_acquire);
+        if (sequence & 1)
+        {
+            std::this_thread::yield();
+            continue;
+        }
+        const uint64_t count = m_appliedCount.load(
+            std::memory_order_relaxed);
+        const uint64_t first = count > DEFAULT_CONFIG_TIMELINE_SIZE ?
+                               count - DEFAULT_CONFIG_TIMELINE_SIZE : 0;
+        for (uint64_t i = first; i < count; ++i)
+        {
+            const AppliedEvent& applied =
+                m_appliedEvents[i % DEFAULT_CONFIG_TIMELINE_SIZE];
+            ReloadEvent event;
+            event.applied = true;
+            event.frameIndex = applied.frameIndex.load(
+                std::memory_order_relaxed);
+            event.time = Clock::time_point(Clock::duration(
+                applied.time.load(std::memory_order_relaxed)));
+            event.latency = Clock::duration(
+                applied.latency.load(std::memory_order_relaxed));
+            o_events.push_back(event);
+        }
+        std::atomic_thread_fence(std::memory_order_acquire);
+    }
+    while ((sequence & 1) ||
+           m_appliedSequence.load(std::memory_order_relaxed) != sequence);
+}
+
+//--------------------------------------------------------------
+inline void ConfigWatcher::Record(const ReloadEvent& a_event)
+{
+    std::lock_guard<std::mutex> lock(m_timelineMutex);
+    if (m_timeline.size() == DEFAULT_CONFIG_TIMELINE_SIZE)
+    {
+        m_timeline.erase(m_timeline.begin());
+    }
+    m_timeline.push_back(a_event);
+}
+#endif//SIMPLE_CONFIG_WATCHER_SUPPORTED
+
+} // namespace Simple
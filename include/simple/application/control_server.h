@@ -0,0 +1,617 @@
+//--------------------------------------------------------------
+// Copyright (c) David Bosnich <david.bosnich.public@gmail.com>
+//
+// This code is licensed under the MIT License, a copy of which
+// can be found in the license.txt file included at the root of
+// this distribution, or at https://opensource.org/licenses/MIT
+//--------------------------------------------------------------
+
+#pragma once
+
+#include "update_loop.h"
+
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <exception>
+#include <functional>
+#include <string>
+#include <thread>
+#include <vector>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+#define SIMPLE_CONTROL_SERVER_SUPPORTED 1
+#endif
+
+//! @file
+
+//--------------------------------------------------------------
+//! Maximum count of clients connected to a control server at once.
+//--------------------------------------------------------------
+#ifndef DEFAULT_CONTROL_SERVER_MAX_CLIENTS
+#define DEFAULT_CONTROL_SERVER_MAX_CLIENTS 8u
+#endif//DEFAULT_CONTROL_SERVER_MAX_CLIENTS
+
+//--------------------------------------------------------------
+//! Maximum length of each line (command) sent to a control server.
+//--------------------------------------------------------------
+#ifndef DEFAULT_CONTROL_SERVER_MAX_LINE
+#define DEFAULT_CONTROL_SERVER_MAX_LINE 256u
+#endif//DEFAULT_CONTROL_SERVER_MAX_LINE
+
+//--------------------------------------------------------------
+namespace Simple
+{
+
+#if SIMPLE_CONTROL_SERVER_SUPPORTED
+//--------------------------------------------------------------
+//! Snapshot of the frames of an update loop, written by the thread
+//! running it and read from any other thread without blocking it.
+//--------------------------------------------------------------
+struct LoopSnapshot
+{
+    uint64_t frameCount = 0;
+    uint64_t lastFrameNs = 0;   //!< Duration of the last frame.
+    uint64_t totalFrameNs = 0;  //!< Duration of all frames this run.
+    uint32_t targetFPS = 0;
+    bool cappedFPS = false;
+};
+
+//--------------------------------------------------------------
+//! Controls an update loop at runtime from other processes (POSIX
+//! only), through a line protocol over a local (unix domain) socket:
+//!
+//!     fps <n>         Set the target fps.
+//!     cap <on|off>    Set whether the fps is capped.
+//!     restart         Request a restart.
+//!     shutdown        Request a shut down.
+//!     stats           Get a snapshot of the frame stats.
+//!     help            List all commands.
+//!
+//! Each command gets a one line reply, starting with "ok" or "error".
+//! eg. printf 'fps 30\nstats\n' | nc -U app.sock
+//!
+//! Clients are serviced by a thread of the server, which changes the
+//! loop only through its atomic setters and requests, so commands take
+//! effect by the next frame and the loop never blocks on the server.
+//! The frame stats are published by the loop (that the server adds
+//! itself to as a listener) with a sequence lock, so reading them
+//! never blocks the loop either. Applications can add commands too.
+//! So the server must not be created or destroyed while the loop is
+//! running, though it can be started and stopped at any time (see
+//! UpdateLoop::Listener).
+//--------------------------------------------------------------
+class ControlServer : public UpdateLoop::Listener
+{
+public:
+    using CommandFunc = std::function<void(const char* a_args,
+                                           std::string& o_reply)>;
+
+    explicit ControlServer(UpdateLoop& a_loop);
+    ~ControlServer() override;
+
+    ControlServer(const ControlServer&) = delete;
+    ControlServer& operator=(const ControlServer&) = delete;
+
+    bool AddCommand(const char* a_name,
+                    const char* a_help,
+                    CommandFunc a_func);
+
+    bool Start(const char* a_path);
+    void Stop();
+
+    bool IsRunning() const;
+    const std::string& GetPath() const;
+    uint64_t GetCommandCount() const;
+    LoopSnapshot GetSnapshot() const;
+
+    void OnPhaseBegin(UpdatePhase a_phase) override;
+
+private:
+    struct Command
+    {
+        std::string name;
+        std::string help;
+        CommandFunc func;
+    };
+
+    struct Client
+    {
+        int fd = -1;
+        std::string line;
+    };
+
+    static void SetNonBlocking(int a_fd);
+
+    void AddStandardCommands();
+    void ServeMain();
+    bool ReadClient(Client& io_client);
+    void HandleLine(const std::string& a_line, std::string& o_reply);
+
+    UpdateLoop& m_loop;
+    std::vector<Command> m_commands;
+    std::string m_path;
+    std::thread m_thread;
+    int m_listenFd = -1;
+    int m_stopFds[2] = { -1, -1 };
+    std::atomic<uint64_t> m_commandCount = { 0 };
+
+    // Written only by the thread running the loop.
+    std::chrono::steady_clock::time_point m_lastFrameTime;
+    LoopSnapshot m_snapshot;
+    bool m_timingFrames = false;
+
+    // Sequence lock over the published snapshot (odd while writing).
+    std::atomic<uint64_t> m_sequence = { 0 };
+    std::atomic<uint64_t> m_frameCount = { 0 };
+    std::atomic<uint64_t> m_lastFrameNs = { 0 };
+    std::atomic<uint64_t> m_totalFrameNs = { 0 };
+};
+
+//--------------------------------------------------------------
+//! Constructor. The server does not listen until it is started.
+//! @param[in] a_loop The loop to control (and listen to).
+//--------------------------------------------------------------
+inline ControlServer::ControlServer(UpdateLoop& a_loop)
+    : m_loop(a_loop)
+{
+    AddStandardCommands();
+    m_loop.AddListener(this);
+}
+
+//--------------------------------------------------------------
+//! Destructor. Stops the server if it is running.
+//--------------------------------------------------------------
+inline ControlServer::~ControlServer()
+{
+    Stop();
+    m_loop.RemoveListener(this);
+}
+
+//--------------------------------------------------------------
+//! Add a command, called on the thread of the server with the rest
+//! of the line (after the name and a space), to fill in the reply.
+//! Must not be called while the server is running.
+//! @param[in] a_name The name of the command (a single word).
+//! @param[in] a_help The description listed by the help command.
+//! @param[in] a_func The function to call for the command.
+//! @return True if added, false if running or the name is used.
+//--------------------------------------------------------------
+inline bool ControlServer::AddCommand(const char* a_name,
+                                      const char* a_help,
+                                      CommandFunc a_func)
+{
+    if (IsRunning())
+    {
+        printf("ControlServer: cannot add commands while running\n");
+        return false;
+    }
+    for (const Command& command : m_commands)
+    {
+        if (command.name == a_name)
+        {
+            printf("ControlServer: command '%s' already added\n", a_name);
+            return false;
+        }
+    }
+    Command command;
+    command.name = a_name;
+    command.help = a_help;
+    command.func = a_func;
+    m_commands.push_back(command);
+    return true;
+}
+
+//--------------------------------------------------------------
+//! Start listening on a socket at a path (replacing any socket file
+//! already there, eg. left by a process that crashed, but refusing
+//! to replace any other kind of file, eg. from a mistyped path).
+//! @param[in] a_path The path of the socket.
+//! @return True if listening, false otherwise (printed).
+//--------------------------------------------------------------
+inline bool ControlServer::Start(const char* a_path)
+{
+    Stop();
+
+    sockaddr_un address = {};
+    address.sun_family = AF_UNIX;
+    if (!a_path || strlen(a_path) >= sizeof(address.sun_path))
+    {
+        printf("ControlServer: invalid socket path\n");
+        return false;
+    }
+    strcpy(address.sun_path, a_path);
+    struct stat status = {};
+    if (lstat(a_path, &status) == 0)
+    {
+        if (!S_ISSOCK(status.st_mode))
+        {
+            printf("ControlServer: '%s' exists and is not a socket\n",
+                   a_path);
+            return false;
+        }
+        unlink(a_path);
+    }
+
+    m_listenFd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (m_listenFd < 0 ||
+        bind(m_listenFd, (const sockaddr*)&address, sizeof(address)) != 0 ||
+        listen(m_listenFd, (int)DEFAULT_CONTROL_SERVER_MAX_CLIENTS) != 0 ||
+        pipe(m_stopFds) != 0)
+    {
+        printf("ControlServer: cannot listen on '%s'\n", a_path);
+        if (m_listenFd >= 0)
+        {
+            close(m_listenFd);
+            m_listenFd = -1;
+            unlink(a_path);
+        }
+        return false;
+    }
+    SetNonBlocking(m_listenFd);
+    m_path = a_path;
+    m_thread = std::thread(&ControlServer::ServeMain, this);
+    return true;
+}
+
+//--------------------------------------------------------------
+//! Stop listening, disconnect all clients, and remove the socket.
+//--------------------------------------------------------------
+inline void ControlServer::Stop()
+{
+    if (!m_thread.joinable())
+    {
+        return;
+    }
+    const char stop = 1;
+    if (write(m_stopFds[1], &stop, 1) != 1)
+    {
+        printf("ControlServer: cannot stop the server thread\n");
+    }
+    m_thread.join();
+    close(m_listenFd);
+    close(m_stopFds[0]);
+    close(m_stopFds[1]);
+    m_listenFd = -1;
+    m_stopFds[0] = -1;
+    m_stopFds[1] = -1;
+    unlink(m_path.c_str());
+    m_path.clear();
+}
+
+//--------------------------------------------------------------
+//! Check whether the server is running (listening).
+//! @return True if the server is running.
+//--------------------------------------------------------------
+inline bool ControlServer::IsRunning() const
+{
+    return m_thread.joinable();
+}
+
+//--------------------------------------------------------------
+//! Get the path of the socket (empty if not running).
+//! @return The path of the socket.
+//--------------------------------------------------------------
+inline const std::string& ControlServer::GetPath() const
+{
+    return m_path;
+}
+
+//--------------------------------------------------------------
+//! Get the count of commands handled (including invalid commands).
+//! @return The count of commands handled.
+//--------------------------------------------------------------
+inline uint64_t ControlServer::GetCommandCount() const
+{
+    return m_commandCount.load(std::memory_order_acquire);
+}
+
+//--------------------------------------------------------------
+//! Get a consistent snapshot of the frames of the loop, from any
+//! thread, without ever blocking the loop (retrying while written).
+//! @return A snapshot of the frames of the loop.
+//--------------------------------------------------------------
+inline LoopSnapshot ControlServer::GetSnapshot() const
+{
+    LoopSnapshot snapshot;
+    uint64_t sequence = 0;
+    do
+    {
+        sequence = m_sequence.load(std::memory_order_acquire);
+        if (sequence & 1)
+        {
+            std::this_thread::yield();
+            continue;
+        }
+        snapshot.frameCount = m_frameCount.load(std::memory_order_relaxed);
+        snapshot.lastFrameNs = m_lastFrameNs.load(
+            std::memory_order_relaxed);
+        snapshot.totalFrameNs = m_totalFrameNs.load(
+            std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_acquire);
+    }
+    while ((sequence & 1) ||
+           m_sequence.load(std::memory_order_relaxed) != sequence);
+    snapshot.targetFPS = m_loop.GetTargetFPS();
+    snapshot.cappedFPS = m_loop.GetCappedFPS();
+    return snapshot;
+}
+
+//--------------------------------------------------------------
+//! Publishes a snapshot of the frames each time a frame starts.
+//! @param[in] a_phase The phase of the loop that is about to begin.
+//--------------------------------------------------------------
+inline void ControlServer::OnPhaseBegin(UpdatePhase a_phase)
+{
+    const auto now = std::chrono::steady_clock::now();
+    if (a_phase == UpdatePhase::StartUp)
+    {
+        m_snapshot = LoopSnapshot();
+        m_timingFrames = false;
+    }
+    else if (a_phase == UpdatePhase::Start)
+    {
+        if (m_timingFrames)
+        {
+            m_snapshot.lastFrameNs = (uint64_t)
+                std::chrono::duration_cast<std::chrono::nanoseconds>(
+                    now - m_lastFrameTime).count();
+            m_snapshot.totalFrameNs += m_snapshot.lastFrameNs;
+            ++m_snapshot.frameCount;
+        }
+        m_timingFrames = true;
+        m_lastFrameTime = now;
+    }
+    else
+    {
+        return;
+    }
+
+    const uint64_t sequence = m_sequence.load(std::memory_order_relaxed);
+    m_sequence.store(sequence + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    m_frameCount.store(m_snapshot.frameCount, std::memory_order_relaxed);
+    m_lastFrameNs.store(m_snapshot.lastFrameNs, std::memory_order_relaxed);
+    m_totalFrameNs.store(m_snapshot.totalFrameNs,
+                         std::memory_order_relaxed);
+    m_sequence.store(sequence + 2, std::memory_order_release);
+}
+
+//--------------------------------------------------------------
+inline void ControlServer::SetNonBlocking(int a_fd)
+{
+    fcntl(a_fd, F_SETFL, fcntl(a_fd, F_GETFL, 0) | O_NONBLOCK);
+}
+
+//--------------------------------------------------------------
+inline void ControlServer::AddStandardCommands()
+{
+    UpdateLoop& loop = m_loop;
+    AddCommand("fps", "<n> Set the target fps.",
+               [&loop](const char* a_args, std::string& o_reply)
+    {
+        char* end = nullptr;
+        const unsigned long fps = strtoul(a_args, &end, 10);
+        if (end == a_args || *end != '\0' || fps == 0 || fps > 100000)
+        {
+            o_reply = "error invalid fps";
+            return;
+        }
+        loop.SetTargetFPS((uint32_t)fps);
+    });
+    AddCommand("cap", "<on|off> Set whether the fps is capped.",
+               [&loop](const char* a_args, std::string& o_reply)
+    {
+        if (strcmp(a_args, "on") == 0 || strcmp(a_args, "off") == 0)
+        {
+            loop.SetCappedFPS(strcmp(a_args, "on") == 0);
+            return;
+        }
+        o_reply = "error expected on or off";
+    });
+    AddCommand("restart", "Request a restart.",
+               [&loop](const char*, std::string&)
+    {
+        loop.RequestRestart();
+    });
+    AddCommand("shutdown", "Request a shut down.",
+               [&loop](const char*, std::string&)
+    {
+        loop.RequestShutDown();
+    });
+    AddCommand("stats", "Get a snapshot of the frame stats.",
+               [this](const char*, std::string& o_reply)
+    {
+        const LoopSnapshot snapshot = GetSnapshot();
+        const uint64_t averageFPS = snapshot.totalFrameNs ?
+            snapshot.frameCount * 1000000000ull / snapshot.totalFrameNs :
+            0;
+        char reply[256];
+        snprintf(reply, sizeof(reply),
+                 "ok frames %llu average_fps %llu last_frame_us %llu "
+                 "target_fps %u capped %d",
+                 (unsigned long long)snapshot.frameCount,
+                 (unsigned long long)averageFPS,
+                 (unsigned long long)(snapshot.lastFrameNs / 1000),
+                 snapshot.targetFPS,
+                 snapshot.cappedFPS ? 1 : 0);
+        o_reply = reply;
+    });
+    AddCommand("help", "List all commands.",
+               [this](const char*, std::string& o_reply)
+    {
+        o_reply = "ok";
+        for (const Command& command : m_commands)
+        {
+            o_reply += " | " + command.name + " " + command.help;
+        }
+    });
+}
+
+//--------------------------------------------------------------
+inline void ControlServer::ServeMain()
+{
+    std::vector<Client> clients;
+    std::vector<pollfd> fds;
+    while (true)
+    {
+        fds.clear();
+        pollfd fd = {};
+        fd.events = POLLIN;
+        fd.fd = m_stopFds[0];
+        fds.push_back(fd);
+        fd.fd = m_listenFd;
+        fds.push_back(fd);
+        for (const Client& client : clients)
+        {
+            fd.fd = client.fd;
+            fds.push_back(fd);
+        }
+
+        if (poll(fds.data(), (nfds_t)fds.size(), -1) < 0)
+        {
+            continue;   // Interrupted.
+        }
+        if (fds[0].revents)
+        {
+            break;
+        }
+
+        // Read (and reply to) clients, disconnecting any that close.
+        for (size_t i = clients.size(); i-- > 0;)
+        {
+            if (fds[i + 2].revents && !ReadClient(clients[i]))
+            {
+                close(clients[i].fd);
+                clients.erase(clients.begin() + (std::ptrdiff_t)i);
+            }
+        }
+
+        if (fds[1].revents)
+        {
+            const int clientFd = accept(m_listenFd, nullptr, nullptr);
+            if (clientFd >= 0 &&
+                clients.size() < DEFAULT_CONTROL_SERVER_MAX_CLIENTS)
+            {
+                SetNonBlocking(clientFd);
+#ifdef SO_NOSIGPIPE
+                const int noSigPipe = 1;
+                setsockopt(clientFd, SOL_SOCKET, SO_NOSIGPIPE,
+                           &noSigPipe, sizeof(noSigPipe));
+#endif
+                Client client;
+                client.fd = clientFd;
+                clients.push_back(client);
+            }
+            else if (clientFd >= 0)
+            {
+                close(clientFd);
+            }
+        }
+    }
+
+    for (const Client& client : clients)
+    {
+        close(client.fd);
+    }
+}
+
+//--------------------------------------------------------------
+inline bool ControlServer::ReadClient(Client& io_client)
+{
+    char buffer[DEFAULT_CONTROL_SERVER_MAX_LINE];
+    const ssize_t count = read(io_client.fd, buffer, sizeof(buffer));
+    if (count <= 0)
+    {
+        return count < 0 && (errno == EAGAIN || errno == EWOULDBLOCK);
+    }
+
+    for (ssize_t i = 0; i < count; ++i)
+    {
+        if (buffer[i] != '\n')
+        {
+            if (buffer[i] != '\r')
+            {
+                io_client.line += buffer[i];
+            }
+            if (io_client.line.size() >= DEFAULT_CONTROL_SERVER_MAX_LINE)
+            {
+                return false;
+            }
+            continue;
+        }
+
+        std::string reply;
+        HandleLine(io_client.line, reply);
+        io_client.line.clear();
+        reply += '\n';
+
+        // Replies are short, so a client that does not read them (and
+        // fills its socket buffer) is disconnected rather than waited on.
+#ifdef MSG_NOSIGNAL
+        const int flags = MSG_NOSIGNAL;
+#else
+        const int flags = 0;
+#endif
+        if (send(io_client.fd, reply.data(), reply.size(), flags) !=
+            (ssize_t)reply.size())
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+//--------------------------------------------------------------
+inline void ControlServer::HandleLine(const std::string& a_line,
+                                      std::string& o_reply)
+{
+    m_commandCount.fetch_add(1, std::memory_order_acq_rel);
+    const size_t space = a_line.find(' ');
+    const std::string name = a_line.substr(0, space);
+    const char* args = space == std::string::npos ?
+                       "" : a_line.c_str() + space + 1;
+    for (const Command& command : m_commands)
+    {
+        if (command.name == name)
+        {
+            // Contain errors thrown by commands (eg. added by the app),
+            // replying with them instead of ending the server thread.
+#if SIMPLE_LOOP_EXCEPTIONS_ENABLED
+            try
+            {
+                command.func(args, o_reply);
+            }
+            catch (const std::exception& a_exception)
+            {
+                o_reply = std::string("error ") + a_exception.what();
+            }
+            catch (...)
+            {
+                o_reply = "error unknown exception";
+            }
+#else
+            command.func(args, o_reply);
+#endif//SIMPLE_LOOP_EXCEPTIONS_ENABLED
+            if (o_reply.empty())
+            {
+                o_reply = "ok";
+            }
+            return;
+        }
+    }
+    o_reply = "error unknown command '" + name + "' (see help)";
+}
+#endif//SIMPLE_CONTROL_SERVER_SUPPORTED
+
+} // namespace Simple
@@ -0,0 +1,304 @@
+//--------------------------------------------------------------
+// Copyright (c) David Bosnich <david.bosnich.public@gmail.com>
+//
+// This code is licensed under the MIT License, a copy of which
+// can be found in the license.txt file included at the root of
+// this distribution, or at https://opensource.org/licenses/MIT
+//--------------------------------------------------------------
+
+#pragma once
+
+#include "worker_pool.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+//! @file
+
+//--------------------------------------------------------------
+//! Count of elements in each chunk of deterministic parallel work.
+//! The chunks are the same no matter how many threads do the work,
+//! so must be chosen once (eg. not from the count of cores).
+//--------------------------------------------------------------
+#ifndef DEFAULT_DETERMINISTIC_CHUNK_SIZE
+#define DEFAULT_DETERMINISTIC_CHUNK_SIZE 4096u
+#endif//DEFAULT_DETERMINISTIC_CHUNK_SIZE
+
+//--------------------------------------------------------------
+namespace Simple
+{
+
+//--------------------------------------------------------------
+//! Range of elements [begin, end) in one chunk of parallel work.
+//--------------------------------------------------------------
+struct ChunkRange
+{
+    uint32_t index = 0; //!< Index of the chunk, in element order.
+    uint32_t begin = 0;
+    uint32_t end = 0;
+};
+
+uint32_t GetChunkCount(uint32_t a_count,
+                       uint32_t a_chunkSize =
+                           DEFAULT_DETERMINISTIC_CHUNK_SIZE);
+
+ChunkRange GetChunkRange(uint32_t a_chunkIndex,
+                         uint32_t a_count,
+                         uint32_t a_chunkSize =
+                             DEFAULT_DETERMINISTIC_CHUNK_SIZE);
+
+template<class Func>
+void DeterministicFor(WorkerPool* a_workerPool,
+                      uint32_t a_count,
+                      uint32_t a_chunkSize,
+                      Func&& a_func);
+
+template<class Type, class Map, class Combine>
+Type DeterministicReduce(WorkerPool* a_workerPool,
+                         uint32_t a_count,
+                         uint32_t a_chunkSize,
+                         const Type& a_identity,
+                         Map&& a_map,
+                         Combine&& a_combine);
+
+//--------------------------------------------------------------
+//! Counter-based random number stream (Philox4x32-10) that has no
+//! state shared between threads or carried between steps: numbers
+//! are a pure function of the seed, stream id (eg. a system id),
+//! step index (eg. the count of fixed updates), substream (eg. the
+//! index of a chunk or element), and position within the stream.
+//!
+//! So each parallel task can construct its own stream, and get the
+//! same numbers no matter which thread runs it, or in what order,
+//! which keeps parallel fixed updates reproducible for replays and
+//! lockstep. Not suitable for cryptography.
+//--------------------------------------------------------------
+class RandomStream
+{
+public:
+    RandomStream(uint64_t a_seed,
+                 uint32_t a_streamId,
+                 uint64_t a_stepIndex,
+                 uint32_t a_substream = 0);
+
+    uint32_t NextUInt32();
+    uint32_t NextBelow(uint32_t a_bound);
+    float NextFloat();
+
+    static void Philox(const uint32_t a_counter[4],
+                       const uint32_t a_key[2],
+                       uint32_t o_result[4]);
+
+private:
+    static uint64_t Mix(uint64_t a_value);
+
+    uint32_t m_key[2];
+    uint32_t m_counter[4];
+    uint32_t m_block[4];
+    uint32_t m_blockIndex = 4;
+};
+
+//--------------------------------------------------------------
+//! Get the count of chunks needed for a count of elements.
+//! @param[in] a_count The count of elements.
+//! @param[in] a_chunkSize The count of elements in each chunk.
+//! @return The count of chunks (the last may be partially full).
+//--------------------------------------------------------------
+inline uint32_t GetChunkCount(uint32_t a_count, uint32_t a_chunkSize)
+{
+    a_chunkSize = std::max(a_chunkSize, 1u);
+    return (uint32_t)(((uint64_t)a_count + a_chunkSize - 1) /
+                      a_chunkSize);
+}
+
+//--------------------------------------------------------------
+//! Get the range of elements in a chunk.
+//! @param[in] a_chunkIndex The index of the chunk.
+//! @param[in] a_count The count of elements.
+//! @param[in] a_chunkSize The count of elements in each chunk.
+//! @return The range of elements in the chunk.
+//--------------------------------------------------------------
+inline ChunkRange GetChunkRange(uint32_t a_chunkIndex,
+                                uint32_t a_count,
+                                uint32_t a_chunkSize)
+{
+    a_chunkSize = std::max(a_chunkSize, 1u);
+    const uint64_t begin = (uint64_t)a_chunkIndex * a_chunkSize;
+    ChunkRange range;
+    range.index = a_chunkIndex;
+    range.begin = (uint32_t)std::min<uint64_t>(begin, a_count);
+    range.end = (uint32_t)std::min<uint64_t>(begin + a_chunkSize,
+                                             a_count);
+    return range;
+}
+
+//--------------------------------------------------------------
+//! Call a function for each chunk of a count of elements, spread
+//! across the threads of a pool. Chunks depend only on the count
+//! and chunk size (never the count of threads), so work that only
+//! writes to the elements of its own chunk is reproducible.
+//! @param[in] a_workerPool The pool of threads (or null to call the
+//!                         function for each chunk, in order).
+//! @param[in] a_count The count of elements.
+//! @param[in] a_chunkSize The count of elements in each chunk.
+//! @param[in] a_func The function to call with each ChunkRange.
+//--------------------------------------------------------------
+template<class Func>
+inline void DeterministicFor(WorkerPool* a_workerPool,
+                             uint32_t a_count,
+                             uint32_t a_chunkSize,
+                             Func&& a_func)
+{
+    const uint32_t chunkCount = GetChunkCount(a_count, a_chunkSize);
+    if (!a_workerPool || chunkCount <= 1)
+    {
+        for (uint32_t i = 0; i < chunkCount; ++i)
+        {
+            a_func(GetChunkRange(i, a_count, a_chunkSize));
+        }
+        return;
+    }
+    a_workerPool->ParallelFor(chunkCount,
+                              [&a_func, a_count, a_chunkSize](uint32_t a_i)
+    {
+        a_func(GetChunkRange(a_i, a_count, a_chunkSize));
+    });
+}
+
+//--------------------------------------------------------------
+//! Reduce a count of elements in parallel, with a result that is
+//! bit exact no matter how many threads are used: each chunk is
+//! mapped to a partial result (eg. by summing its elements in order)
+//! and the partial results are then combined in chunk order, on the
+//! calling thread, starting from the identity. Floating point sums
+//! therefore always add the same values in the same order.
+//! @param[in] a_workerPool The pool of threads (or null).
+//! @param[in] a_count The count of elements.
+//! @param[in] a_chunkSize The count of elements in each chunk.
+//! @param[in] a_identity The initial value of the result.
+//! @param[in] a_map Function mapping a ChunkRange to a partial result.
+//! @param[in] a_combine Function combining two results into one.
+//! @return The result of combining the partial results in order.
+//--------------------------------------------------------------
+template<class Type, class Map, class Combine>
+inline Type DeterministicReduce(WorkerPool* a_workerPool,
+                                uint32_t a_count,
+                                uint32_t a_chunkSize,
+                                const Type& a_identity,
+                                Map&& a_map,
+                                Combine&& a_combine)
+{
+    std::vector<Type> partials(GetChunkCount(a_count, a_chunkSize),
+                               a_identity);
+    DeterministicFor(a_workerPool, a_count, a_chunkSize,
+                     [&partials, &a_map](const ChunkRange& a_range)
+    {
+        partials[a_range.index] = a_map(a_range);
+    });
+
+    Type result = a_identity;
+    for (const Type& partial : partials)
+    {
+        result = a_combine(result, partial);
+    }
+    return result;
+}
+
+//--------------------------------------------------------------
+//! Constructor.
+//! @param[in] a_seed The seed (eg. of the match or replay).
+//! @param[in] a_streamId The id of the stream (eg. of the system).
+//! @param[in] a_stepIndex The index of the step (eg. fixed update).
+//! @param[in] a_substream The substream (eg. chunk/element index).
+//--------------------------------------------------------------
+inline RandomStream::RandomStream(uint64_t a_seed,
+                                  uint32_t a_streamId,
+                                  uint64_t a_stepIndex,
+                                  uint32_t a_substream)
+{
+    const uint64_t key = Mix(a_seed ^ Mix(a_streamId));
+    m_key[0] = (uint32_t)key;
+    m_key[1] = (uint32_t)(key >> 32);
+    m_counter[0] = 0;
+    m_counter[1] = a_substream;
+    m_counter[2] = (uint32_t)a_stepIndex;
+    m_counter[3] = (uint32_t)(a_stepIndex >> 32);
+}
+
+//--------------------------------------------------------------
+//! Get the next number in the stream.
+//! @return A uniformly distributed 32 bit number.
+//--------------------------------------------------------------
+inline uint32_t RandomStream::NextUInt32()
+{
+    if (m_blockIndex == 4)
+    {
+        Philox(m_counter, m_key, m_block);
+        ++m_counter[0];
+        m_blockIndex = 0;
+    }
+    return m_block[m_blockIndex++];
+}
+
+//--------------------------------------------------------------
+//! Get the next number in the stream, scaled to a range (with a
+//! bias that is negligible for bounds much smaller than 2^32).
+//! @param[in] a_bound The exclusive upper bound of the range.
+//! @return A number in the range [0, a_bound).
+//--------------------------------------------------------------
+inline uint32_t RandomStream::NextBelow(uint32_t a_bound)
+{
+    return (uint32_t)(((uint64_t)NextUInt32() * a_bound) >> 32);
+}
+
+//--------------------------------------------------------------
+//! Get the next number in the stream, as a float.
+//! @return A uniformly distributed number in the range [0, 1).
+//--------------------------------------------------------------
+inline float RandomStream::NextFloat()
+{
+    return (float)(NextUInt32() >> 8) * (1.0f / 16777216.0f);
+}
+
+//--------------------------------------------------------------
+//! Generate the block of four numbers for a counter and key.
+//! @param[in] a_counter The counter to encrypt.
+//! @param[in] a_key The key to encrypt the counter with.
+//! @param[out] o_result The four random numbers generated.
+//--------------------------------------------------------------
+inline void RandomStream::Philox(const uint32_t a_counter[4],
+                                 const uint32_t a_key[2],
+                                 uint32_t o_result[4])
+{
+    uint32_t c0 = a_counter[0], c1 = a_counter[1];
+    uint32_t c2 = a_counter[2], c3 = a_counter[3];
+    uint32_t k0 = a_key[0], k1 = a_key[1];
+    for (int round = 0; round < 10; ++round)
+    {
+        const uint64_t product0 = (uint64_t)0xD2511F53u * c0;
+        const uint64_t product1 = (uint64_t)0xCD9E8D57u * c2;
+        c0 = (uint32_t)(product1 >> 32) ^ c1 ^ k0;
+        c1 = (uint32_t)product1;
+        c2 = (uint32_t)(product0 >> 32) ^ c3 ^ k1;
+        c3 = (uint32_t)product0;
+        k0 += 0x9E3779B9u;
+        k1 += 0xBB67AE85u;
+    }
+    o_result[0] = c0;
+    o_result[1] = c1;
+    o_result[2] = c2;
+    o_result[3] = c3;
+}
+
+//--------------------------------------------------------------
+inline uint64_t RandomStream::Mix(uint64_t a_value)
+{
+    // SplitMix64 finalizer, so similar seeds/ids give unrelated keys.
+    a_value += 0x9E3779B97F4A7C15ull;
+    a_value = (a_value ^ (a_value >> 30)) * 0xBF58476D1CE4E5B9ull;
+    a_value = (a_value ^ (a_value >> 27)) * 0x94D049BB133111EBull;
+    return a_value ^ (a_value >> 31);
+}
+
+} // namespace Simple
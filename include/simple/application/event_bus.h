@@ -0,0 +1,501 @@
+//--------------------------------------------------------------
+// Copyright (c) David Bosnich <david.bosnich.public@gmail.com>
+//
+// This code is licensed under the MIT License, a copy of which
+// can be found in the license.txt file included at the root of
+// this distribution, or at https://opensource.org/licenses/MIT
+//--------------------------------------------------------------
+
+#pragma once
+
+#include "update_loop.h"
+
+#include <cstring>
+#include <functional>
+#include <memory>
+#include <type_traits>
+
+//! @file
+
+//--------------------------------------------------------------
+namespace Simple
+{
+
+//--------------------------------------------------------------
+//! Double-buffered bus of POD events, dispatched in bulk at a set
+//! phase boundary of the update loop it is added to as a listener.
+//! Events are published without locks or allocation into buffers
+//! owned by each publishing thread, then dispatched sorted by type
+//! so each handler processes all events of its type back to back.
+//! Publishing must not race with dispatch; ie. publishers running
+//! in parallel must be joined before the phase boundary is hit.
+//!
+//! Each thread claims a buffer the first time it publishes, which is
+//! released for other threads once it has exited and the events it
+//! published have been dispatched, so threads can come and go while
+//! no more than the maximum publish between any two dispatches.
+//--------------------------------------------------------------
+class EventBus : public UpdateLoop::Listener
+{
+public:
+    enum class DispatchPoint
+    {
+        NextStart,  //!< Before the next call to UpdateStart.
+        AfterFixed, //!< After each call to UpdateFixed.
+        Manual      //!< Only when Dispatch is called explicitly.
+    };
+
+    struct Stats
+    {
+        uint64_t published = 0;
+        uint64_t dispatched = 0;
+        uint64_t dropped = 0;
+        uint64_t unhandled = 0; //!< Dispatched with no subscribers.
+        uint32_t lastDispatchCount = 0;
+    };
+
+    EventBus(DispatchPoint a_dispatchPoint = DispatchPoint::NextStart,
+             size_t a_bytesPerThread = 64 * 1024,
+             uint32_t a_maxThreads = 8);
+    ~EventBus() override = default;
+
+    EventBus(const EventBus&) = delete;
+    EventBus& operator=(const EventBus&) = delete;
+
+    template <class Event>
+    static uint32_t GetEventType();
+
+    template <class Event>
+    void Subscribe(std::function<void(const Event&)> a_handler);
+
+    template <class Event>
+    bool Publish(const Event& a_event);
+
+    void Dispatch();
+    void Clear();
+    Stats GetStats() const;
+
+    void OnPhaseBegin(UpdatePhase a_phase) override;
+    void OnPhaseEnded(UpdatePhase a_phase) override;
+
+private:
+    struct RecordHeader
+    {
+        uint32_t type;
+        uint32_t size;
+    };
+
+    struct alignas(64) ThreadBuffer
+    {
+        size_t used[2];
+        char* data[2];
+    };
+
+    enum OwnerState : uint32_t
+    {
+        Unowned,
+        Owned,
+        Exited  //!< Released once its events have been dispatched.
+    };
+
+    // The owner state of each buffer is shared with the threads that
+    // claim them, so that each can release its buffers when it exits,
+    // even if the bus has already been destroyed by then.
+    struct BufferOwners
+    {
+        explicit BufferOwners(size_t a_count) : states(a_count) {}
+        std::vector<std::atomic<uint32_t>> states;
+    };
+
+    struct ThreadClaims
+    {
+        struct Claim
+        {
+            std::shared_ptr<BufferOwners> owners;
+            size_t index;
+        };
+        ~ThreadClaims();
+        std::vector<Claim> claims;
+    };
+
+    using Handler = std::function<void(const void*)>;
+
+    static uint32_t NextEventType();
+    static uint64_t NextBusId();
+    static size_t RecordSize(size_t a_payloadSize);
+
+    ThreadBuffer* GetThreadBuffer();
+    bool Write(uint32_t a_type, const void* a_data, uint32_t a_size);
+
+    const DispatchPoint m_dispatchPoint;
+    const size_t m_bytesPerThread;
+    const uint64_t m_busId;
+    std::vector<char> m_storage;
+    std::vector<ThreadBuffer> m_threadBuffers;
+    std::shared_ptr<BufferOwners> m_owners;
+    std::vector<std::vector<Handler>> m_handlers;
+    std::vector<const RecordHeader*> m_sorted;
+    std::vector<uint32_t> m_typeCounts;
+    std::atomic<uint32_t> m_writeIndex = { 0 };
+    std::atomic<uint64_t> m_dropped = { 0 };
+    uint64_t m_dispatched = 0;
+    uint64_t m_unhandled = 0;
+    uint32_t m_lastDispatchCount = 0;
+};
+
+//--------------------------------------------------------------
+//! Constructor. All event buffers are allocated up front.
+//! @param[in] a_dispatchPoint When the loop dispatches events.
+//! @param[in] a_bytesPerThread Buffer size for each thread/frame.
+//! @param[in] a_maxThreads Maximum threads that publish events
+//!            between each dispatch (or that have not yet exited).
+//--------------------------------------------------------------
+inline EventBus::EventBus(DispatchPoint a_dispatchPoint,
+                          size_t a_bytesPerThread,
+                          uint32_t a_maxThreads)
+    : m_dispatchPoint(a_dispatchPoint)
+    , m_bytesPerThread(RecordSize(a_bytesPerThread) -
+                       sizeof(RecordHeader))
+    , m_busId(NextBusId())
+    , m_threadBuffers(a_maxThreads ? a_maxThreads : 1)
+    , m_owners(std::make_shared<BufferOwners>(m_threadBuffers.size()))
+{
+    const size_t threadCount = m_threadBuffers.size();
+    m_storage.resize(m_bytesPerThread * 2 * threadCount);
+    for (size_t i = 0; i < threadCount; ++i)
+    {
+        ThreadBuffer& buffer = m_threadBuffers[i];
+        m_owners->states[i].store(Unowned, std::memory_order_relaxed);
+        for (size_t j = 0; j < 2; ++j)
+        {
+            buffer.used[j] = 0;
+            buffer.data[j] = m_storage.data() +
+                             (m_bytesPerThread * ((i * 2) + j));
+        }
+    }
+
+    // Reserve enough to sort the smallest possible events, with
+    // twice the space since the sorted records are placed after.
+    const size_t minRecordSize = RecordSize(1);
+    m_sorted.reserve((m_bytesPerThread / minRecordSize) *
+                     threadCount * 2);
+}
+
+//--------------------------------------------------------------
+//! Get the unique (per process) type identifier of an event type.
+//! @return The unique (per process) type identifier of the event.
+//--------------------------------------------------------------
+template <class Event>
+inline uint32_t EventBus::GetEventType()
+{
+    static const uint32_t s_eventType = NextEventType();
+    return s_eventType;
+}
+
+//--------------------------------------------------------------
+//! Subscribe a handler to all events of a type. Must not be called
+//! while events are being dispatched. Handlers are called on the
+//! thread running the loop, in the order they were subscribed.
+//! @param[in] a_handler The handler called for each event.
+//--------------------------------------------------------------
+template <class Event>
+inline void EventBus::Subscribe(
+    std::function<void(const Event&)> a_handler)
+{
+    const uint32_t type = GetEventType<Event>();
+    if (type >= m_handlers.size())
+    {
+        m_handlers.resize(type + 1);
+        m_typeCounts.resize(type + 1);
+    }
+
+    std::function<void(const Event&)> handler = std::move(a_handler);
+    m_handlers[type].push_back([handler](const void* a_data)
+    {
+        // Records are only 4 byte aligned, so copy them out first.
+        using Storage = typename std::aligned_storage<
+            sizeof(Event), alignof(Event)>::type;
+        Storage storage;
+        memcpy(&storage, a_data, sizeof(Event));
+        handler(*reinterpret_cast<const Event*>(&storage));
+    });
+}
+
+//--------------------------------------------------------------
+//! Publish an event, to be dispatched at the next dispatch point.
+//! Thread safe, lock free, and allocation free, but events will
+//! be dropped if the buffer of the publishing thread is full.
+//! @param[in] a_event The event to publish (copied into buffer).
+//! @return True if published, false if the event was dropped.
+//--------------------------------------------------------------
+template <class Event>
+inline bool EventBus::Publish(const Event& a_event)
+{
+    static_assert(std::is_trivially_copyable<Event>::value,
+                  "Events must be trivially copyable (POD) types.");
+    return Write(GetEventType<Event>(), &a_event, sizeof(Event));
+}
+
+//--------------------------------------------------------------
+//! Dispatch all events published since the last dispatch, sorted
+//! by type (and otherwise in the order published by each thread).
+//! Events published by handlers are dispatched the next time.
+//--------------------------------------------------------------
+inline void EventBus::Dispatch()
+{
+    // Swap buffers so events published from now are kept apart.
+    const uint32_t readIndex = m_writeIndex.load(
+        std::memory_order_relaxed);
+    m_writeIndex.store(readIndex ^ 1, std::memory_order_release);
+
+    // Counting sort of all records by type, which is stable and
+    // does not allocate as long as the event types are known.
+    std::fill(m_typeCounts.begin(), m_typeCounts.end(), 0);
+    m_sorted.clear();
+    for (ThreadBuffer& buffer : m_threadBuffers)
+    {
+        const size_t used = buffer.used[readIndex];
+        for (size_t offset = 0; offset < used;)
+        {
+            const RecordHeader* record =
+                reinterpret_cast<const RecordHeader*>(
+                    buffer.data[readIndex] + offset);
+            if (record->type < m_typeCounts.size() &&
+                !m_handlers[record->type].empty())
+            {
+                ++m_typeCounts[record->type];
+                m_sorted.push_back(record);
+            }
+            else
+            {
+                ++m_unhandled;
+            }
+            offset += RecordSize(record->size);
+        }
+    }
+
+    const size_t recordCount = m_sorted.size();
+    uint32_t typeOffset = 0;
+    for (uint32_t& typeCount : m_typeCounts)
+    {
+        const uint32_t count = typeCount;
+        typeCount = typeOffset;
+        typeOffset += count;
+    }
+    m_sorted.resize(recordCount * 2);
+    for (size_t i = 0; i < recordCount; ++i)
+    {
+        const RecordHeader* record = m_sorted[i];
+        m_sorted[recordCount + m_typeCounts[record->type]++] = record;
+    }
+
+    // Dispatch each type in turn to all of its handlers.
+    for (size_t i = recordCount; i < recordCount * 2; ++i)
+    {
+        const RecordHeader* record = m_sorted[i];
+        const void* payload = record + 1;
+        for (const Handler& handler : m_handlers[record->type])
+        {
+            handler(payload);
+        }
+    }
+
+    // Publishing does not race with dispatch, so a thread that has
+    // exited by now has had all of the events it published dispatched.
+    for (size_t i = 0; i < m_threadBuffers.size(); ++i)
+    {
+        ThreadBuffer& buffer = m_threadBuffers[i];
+        buffer.used[readIndex] = 0;
+        std::atomic<uint32_t>& state = m_owners->states[i];
+        if (state.load(std::memory_order_acquire) == Exited)
+        {
+            buffer.used[readIndex ^ 1] = 0;
+            state.store(Unowned, std::memory_order_release);
+        }
+    }
+    m_sorted.clear();
+    m_dispatched += recordCount;
+    m_lastDispatchCount = (uint32_t)recordCount;
+}
+
+//--------------------------------------------------------------
+//! Clear all published events without dispatching them.
+//--------------------------------------------------------------
+inline void EventBus::Clear()
+{
+    for (ThreadBuffer& buffer : m_threadBuffers)
+    {
+        buffer.used[0] = 0;
+        buffer.used[1] = 0;
+    }
+}
+
+//--------------------------------------------------------------
+//! Get the stats of the bus. Should be called on the loop thread.
+//! @return The stats of the bus.
+//--------------------------------------------------------------
+inline EventBus::Stats EventBus::GetStats() const
+{
+    Stats stats;
+    stats.dispatched = m_dispatched;
+    stats.dropped = m_dropped.load(std::memory_order_relaxed);
+    stats.unhandled = m_unhandled;
+    stats.lastDispatchCount = m_lastDispatchCount;
+    stats.published = m_dispatched + stats.dropped + stats.unhandled;
+    for (const ThreadBuffer& buffer : m_threadBuffers)
+    {
+        for (size_t j = 0; j < 2; ++j)
+        {
+            for (size_t offset = 0; offset < buffer.used[j];)
+            {
+                const RecordHeader* record =
+                    reinterpret_cast<const RecordHeader*>(
+                        buffer.data[j] + offset);
+                offset += RecordSize(record->size);
+                ++stats.published;
+            }
+        }
+    }
+    return stats;
+}
+
+//--------------------------------------------------------------
+//! Dispatches events if the dispatch point is NextStart, or clears
+//! any events left over from a previous run at StartUp.
+//! @param[in] a_phase The phase of the loop that is beginning.
+//--------------------------------------------------------------
+inline void EventBus::OnPhaseBegin(UpdatePhase a_phase)
+{
+    if (a_phase == UpdatePhase::StartUp)
+    {
+        Clear();
+    }
+    else if (a_phase == UpdatePhase::Start &&
+             m_dispatchPoint == DispatchPoint::NextStart)
+    {
+        Dispatch();
+    }
+}
+
+//--------------------------------------------------------------
+//! Dispatches events if the dispatch point is AfterFixed.
+//! @param[in] a_phase The phase of the loop that has just ended.
+//--------------------------------------------------------------
+inline void EventBus::OnPhaseEnded(UpdatePhase a_phase)
+{
+    if (a_phase == UpdatePhase::Fixed &&
+        m_dispatchPoint == DispatchPoint::AfterFixed)
+    {
+        Dispatch();
+    }
+}
+
+//--------------------------------------------------------------
+inline uint32_t EventBus::NextEventType()
+{
+    static std::atomic<uint32_t> s_nextEventType = { 0 };
+    return s_nextEventType.fetch_add(1, std::memory_order_relaxed);
+}
+
+//--------------------------------------------------------------
+inline uint64_t EventBus::NextBusId()
+{
+    static std::atomic<uint64_t> s_nextBusId = { 1 };
+    return s_nextBusId.fetch_add(1, std::memory_order_relaxed);
+}
+
+//--------------------------------------------------------------
+inline size_t EventBus::RecordSize(size_t a_payloadSize)
+{
+    constexpr size_t align = alignof(RecordHeader);
+    const size_t size = sizeof(RecordHeader) + a_payloadSize;
+    return ((size + align - 1) / align) * align;
+}
+
+//--------------------------------------------------------------
+inline EventBus::ThreadBuffer* EventBus::GetThreadBuffer()
+{
+    // Cache the buffer last used by this thread, keyed by the bus
+    // id in case a bus is destroyed and another one created in its
+    // place; otherwise find or claim a buffer without any locking.
+    struct CachedBuffer
+    {
+        uint64_t busId;
+        ThreadBuffer* buffer;
+    };
+    static thread_local CachedBuffer s_cachedBuffer = { 0, nullptr };
+    static thread_local ThreadClaims s_threadClaims;
+    if (s_cachedBuffer.busId == m_busId)
+    {
+        return s_cachedBuffer.buffer;
+    }
+
+    // Forget claims on buses that have since been destroyed.
+    std::vector<ThreadClaims::Claim>& claims = s_threadClaims.claims;
+    ThreadBuffer* found = nullptr;
+    for (size_t i = claims.size(); i-- > 0;)
+    {
+        if (claims[i].owners == m_owners)
+        {
+            found = &m_threadBuffers[claims[i].index];
+        }
+        else if (claims[i].owners.use_count() == 1)
+        {
+            claims.erase(claims.begin() + i);
+        }
+    }
+
+    for (size_t i = 0; !found && i < m_threadBuffers.size(); ++i)
+    {
+        uint32_t state = Unowned;
+        if (m_owners->states[i].compare_exchange_strong(
+                state, Owned, std::memory_order_acq_rel))
+        {
+            claims.push_back({ m_owners, i });
+            found = &m_threadBuffers[i];
+        }
+    }
+
+    if (found)
+    {
+        s_cachedBuffer.busId = m_busId;
+        s_cachedBuffer.buffer = found;
+    }
+    return found;
+}
+
+//--------------------------------------------------------------
+inline EventBus::ThreadClaims::~ThreadClaims()
+{
+    for (Claim& claim : claims)
+    {
+        claim.owners->states[claim.index].store(
+            Exited, std::memory_order_release);
+    }
+}
+
+//--------------------------------------------------------------
+inline bool EventBus::Write(uint32_t a_type,
+                            const void* a_data,
+                            uint32_t a_size)
+{
+    ThreadBuffer* buffer = GetThreadBuffer();
+    const uint32_t writeIndex = m_writeIndex.load(
+        std::memory_order_acquire);
+    const size_t recordSize = RecordSize(a_size);
+    if (!buffer ||
+        buffer->used[writeIndex] + recordSize > m_bytesPerThread)
+    {
+        m_dropped.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+
+    char* record = buffer->data[writeIndex] + buffer->used[writeIndex];
+    RecordHeader header = { a_type, a_size };
+    memcpy(record, &header, sizeof(header));
+    memcpy(record + sizeof(header), a_data, a_size);
+    buffer->used[writeIndex] += recordSize;
+    return true;
+}
+
+} // namespace Simple
@@ -0,0 +1,373 @@
+//--------------------------------------------------------------
+// Copyright (c) David Bosnich <david.bosnich.public@gmail.com>
+//
+// This code is licensed under the MIT License, a copy of which
+// can be found in the license.txt file included at the root of
+// this distribution, or at https://opensource.org/licenses/MIT
+//--------------------------------------------------------------
+
+#pragma once
+
+#include "update_loop.h"
+
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+//! @file
+
+//--------------------------------------------------------------
+namespace Simple
+{
+
+//--------------------------------------------------------------
+//! Cache of values computed from keys (eg. world transforms or
+//! visibility by entity id) that is invalidated automatically at a
+//! phase boundary of the update loop it is added to as a listener,
+//! so code in any Update* method can memoize computations for the
+//! rest of the frame (or until the next fixed update) without ever
+//! seeing stale values.
+//!
+//! Values are held in an open addressing (linear probing) table
+//! allocated up front, with each slot tagged by the epoch in which
+//! it was written; invalidating just bumps the current epoch, which
+//! makes every slot empty in O(1). Once the table is 3/4 full, new
+//! values are computed but not cached (and counted as dropped).
+//!
+//! Not thread-safe: use from one thread at a time (eg. one cache
+//! per thread, or only from the thread running the loop).
+//--------------------------------------------------------------
+template<class Key, class Value, class Hash = std::hash<Key>>
+class FrameCache : public UpdateLoop::Listener
+{
+public:
+    enum class Scope
+    {
+        Frame,      //!< Invalidated after each call to UpdateEnded.
+        NextFixed,  //!< Invalidated before each call to UpdateFixed.
+        Manual      //!< Only when Invalidate is called explicitly.
+    };
+
+    struct Stats
+    {
+        uint64_t hits = 0;
+        uint64_t misses = 0;
+        uint64_t dropped = 0;       //!< Misses not cached (full).
+        uint32_t size = 0;          //!< Peak count of values cached.
+        float hitRate = 0.0f;       //!< hits / (hits + misses).
+    };
+
+    explicit FrameCache(uint32_t a_capacity = 4096,
+                        Scope a_scope = Scope::Frame);
+    ~FrameCache() override = default;
+
+    FrameCache(const FrameCache&) = delete;
+    FrameCache& operator=(const FrameCache&) = delete;
+
+    const Value* Find(const Key& a_key);
+    bool Insert(const Key& a_key, const Value& a_value);
+
+    template<class Compute>
+    Value GetOrCompute(const Key& a_key, Compute&& a_compute);
+
+    void Invalidate();
+
+    uint32_t GetCapacity() const;
+    uint32_t GetSize() const;
+    uint32_t GetEpoch() const;
+    const Stats& GetFrameStats() const;
+    const Stats& GetLastFrameStats() const;
+    const Stats& GetTotalStats() const;
+
+    void OnPhaseBegin(UpdatePhase a_phase) override;
+    void OnPhaseEnded(UpdatePhase a_phase) override;
+
+private:
+    struct Slot
+    {
+        uint32_t epoch = 0; //!< Epoch written in (0 is never used).
+        Key key = Key();
+        Value value = Value();
+    };
+
+    static uint32_t RoundUpToPowerOfTwo(uint32_t a_value);
+    Slot* FindSlot(const Key& a_key);
+    void EndFrame();
+
+    const Scope m_scope;
+    const Hash m_hash = Hash();
+    std::vector<Slot> m_slots;
+    uint32_t m_mask = 0;
+    uint32_t m_maxSize = 0;
+    uint32_t m_size = 0;
+    uint32_t m_epoch = 1;
+    Stats m_frameStats;
+    Stats m_lastFrameStats;
+    Stats m_totalStats;
+};
+
+//--------------------------------------------------------------
+//! Constructor. All slots are allocated up front.
+//! @param[in] a_capacity Slots in the table (rounded up to a power
+//!                       of two), of which 3/4 can be used.
+//! @param[in] a_scope When the loop invalidates the cache.
+//--------------------------------------------------------------
+template<class Key, class Value, class Hash>
+inline FrameCache<Key, Value, Hash>::FrameCache(uint32_t a_capacity,
+                                                Scope a_scope)
+    : m_scope(a_scope)
+{
+    const uint32_t capacity = RoundUpToPowerOfTwo(a_capacity);
+    m_slots.resize(capacity);
+    m_mask = capacity - 1;
+    m_maxSize = capacity - capacity / 4;
+}
+
+//--------------------------------------------------------------
+//! Find the value cached for a key (counting a hit or a miss).
+//! @param[in] a_key The key to find the value of.
+//! @return The value cached for the key, or null if there is none.
+//--------------------------------------------------------------
+template<class Key, class Value, class Hash>
+inline const Value* FrameCache<Key, Value, Hash>::Find(const Key& a_key)
+{
+    Slot* slot = FindSlot(a_key);
+    if (slot->epoch == m_epoch)
+    {
+        ++m_frameStats.hits;
+        return &slot->value;
+    }
+    ++m_frameStats.misses;
+    return nullptr;
+}
+
+//--------------------------------------------------------------
+//! Cache the value for a key (replacing any already cached).
+//! @param[in] a_key The key to cache the value of.
+//! @param[in] a_value The value to cache.
+//! @return True if cached, or false if the cache is full.
+//--------------------------------------------------------------
+template<class Key, class Value, class Hash>
+inline bool FrameCache<Key, Value, Hash>::Insert(const Key& a_key,
+                                                 const Value& a_value)
+{
+    Slot* slot = FindSlot(a_key);
+    if (slot->epoch != m_epoch)
+    {
+        if (m_size == m_maxSize)
+        {
+            ++m_frameStats.dropped;
+            return false;
+        }
+        slot->epoch = m_epoch;
+        slot->key = a_key;
+        ++m_size;
+        if (m_size > m_frameStats.size)
+        {
+            m_frameStats.size = m_size;
+        }
+    }
+    slot->value = a_value;
+    return true;
+}
+
+//--------------------------------------------------------------
+//! Get the value cached for a key, or compute and cache it.
+//! eg. GetOrCompute(id, [&]() { return ComputeTransform(id); });
+//! @param[in] a_key The key to get the value of.
+//! @param[in] a_compute Function returning the value for the key.
+//! @return The value for the key.
+//--------------------------------------------------------------
+template<class Key, class Value, class Hash>
+template<class Compute>
+inline Value FrameCache<Key, Value, Hash>::GetOrCompute(
+    const Key& a_key,
+    Compute&& a_compute)
+{
+    if (const Value* value = Find(a_key))
+    {
+        return *value;
+    }
+    const Value value = a_compute();
+    Insert(a_key, value);
+    return value;
+}
+
+//--------------------------------------------------------------
+//! Invalidate all values cached, in O(1) by bumping the epoch.
+//--------------------------------------------------------------
+template<class Key, class Value, class Hash>
+inline void FrameCache<Key, Value, Hash>::Invalidate()
+{
+    m_size = 0;
+    if (++m_epoch == 0)
+    {
+        // Wrapped, so slots written 2^32 epochs ago would look valid.
+        for (Slot& slot : m_slots)
+        {
+            slot.epoch = 0;
+        }
+        m_epoch = 1;
+    }
+}
+
+//--------------------------------------------------------------
+//! Get the count of slots in the table.
+//! @return The count of slots in the table.
+//--------------------------------------------------------------
+template<class Key, class Value, class Hash>
+inline uint32_t FrameCache<Key, Value, Hash>::GetCapacity() const
+{
+    return (uint32_t)m_slots.size();
+}
+
+//--------------------------------------------------------------
+//! Get the count of values currently cached.
+//! @return The count of values currently cached.
+//--------------------------------------------------------------
+template<class Key, class Value, class Hash>
+inline uint32_t FrameCache<Key, Value, Hash>::GetSize() const
+{
+    return m_size;
+}
+
+//--------------------------------------------------------------
+//! Get the current epoch (bumped each time it is invalidated).
+//! @return The current epoch.
+//--------------------------------------------------------------
+template<class Key, class Value, class Hash>
+inline uint32_t FrameCache<Key, Value, Hash>::GetEpoch() const
+{
+    return m_epoch;
+}
+
+//--------------------------------------------------------------
+//! Get the stats of the current frame so far.
+//! @return The stats of the current frame so far.
+//--------------------------------------------------------------
+template<class Key, class Value, class Hash>
+inline const typename FrameCache<Key, Value, Hash>::Stats&
+FrameCache<Key, Value, Hash>::GetFrameStats() const
+{
+    return m_frameStats;
+}
+
+//--------------------------------------------------------------
+//! Get the stats of the last frame completed (eg. to report from
+//! OnFrameComplete).
+//! @return The stats of the last frame completed.
+//--------------------------------------------------------------
+template<class Key, class Value, class Hash>
+inline const typename FrameCache<Key, Value, Hash>::Stats&
+FrameCache<Key, Value, Hash>::GetLastFrameStats() const
+{
+    return m_lastFrameStats;
+}
+
+//--------------------------------------------------------------
+//! Get the stats of all frames completed, where size is the peak.
+//! @return The stats of all frames completed.
+//--------------------------------------------------------------
+template<class Key, class Value, class Hash>
+inline const typename FrameCache<Key, Value, Hash>::Stats&
+FrameCache<Key, Value, Hash>::GetTotalStats() const
+{
+    return m_totalStats;
+}
+
+//--------------------------------------------------------------
+//! Invalidates the cache on start up, and before fixed updates if
+//! the scope is NextFixed.
+//! @param[in] a_phase The phase of the loop that is about to begin.
+//--------------------------------------------------------------
+template<class Key, class Value, class Hash>
+inline void FrameCache<Key, Value, Hash>::OnPhaseBegin(
+    UpdatePhase a_phase)
+{
+    if (a_phase == UpdatePhase::StartUp)
+    {
+        Invalidate();
+        m_frameStats = Stats();
+    }
+    else if (a_phase == UpdatePhase::Fixed &&
+             m_scope == Scope::NextFixed)
+    {
+        Invalidate();
+    }
+}
+
+//--------------------------------------------------------------
+//! Records the stats of each frame, and invalidates the cache at
+//! the end of each frame if the scope is Frame.
+//! @param[in] a_phase The phase of the loop that has just ended.
+//--------------------------------------------------------------
+template<class Key, class Value, class Hash>
+inline void FrameCache<Key, Value, Hash>::OnPhaseEnded(
+    UpdatePhase a_phase)
+{
+    if (a_phase == UpdatePhase::Ended)
+    {
+        EndFrame();
+        if (m_scope == Scope::Frame)
+        {
+            Invalidate();
+        }
+    }
+}
+
+//--------------------------------------------------------------
+template<class Key, class Value, class Hash>
+inline uint32_t FrameCache<Key, Value, Hash>::RoundUpToPowerOfTwo(
+    uint32_t a_value)
+{
+    uint32_t value = 16;
+    while (value < a_value && value < (1u << 31))
+    {
+        value <<= 1;
+    }
+    return value;
+}
+
+//--------------------------------------------------------------
+template<class Key, class Value, class Hash>
+inline typename FrameCache<Key, Value, Hash>::Slot*
+FrameCache<Key, Value, Hash>::FindSlot(const Key& a_key)
+{
+    // Nothing is ever removed within an epoch, so the first slot
+    // from a previous epoch ends the probe (the table is never full).
+    uint32_t index = (uint32_t)m_hash(a_key) & m_mask;
+    while (m_slots[index].epoch == m_epoch &&
+           !(m_slots[index].key == a_key))
+    {
+        index = (index + 1) & m_mask;
+    }
+    return &m_slots[index];
+}
+
+//--------------------------------------------------------------
+template<class Key, class Value, class Hash>
+inline void FrameCache<Key, Value, Hash>::EndFrame()
+{
+    const uint64_t lookups = m_frameStats.hits + m_frameStats.misses;
+    m_frameStats.hitRate = lookups ?
+        (float)((double)m_frameStats.hits / (double)lookups) : 0.0f;
+    m_lastFrameStats = m_frameStats;
+
+    m_totalStats.hits += m_frameStats.hits;
+    m_totalStats.misses += m_frameStats.misses;
+    m_totalStats.dropped += m_frameStats.dropped;
+    if (m_frameStats.size > m_totalStats.size)
+    {
+        m_totalStats.size = m_frameStats.size;
+    }
+    const uint64_t totalLookups = m_totalStats.hits +
+                                  m_totalStats.misses;
+    m_totalStats.hitRate = totalLookups ?
+        (float)((double)m_totalStats.hits / (double)totalLookups) :
+        0.0f;
+
+    m_frameStats = Stats();
+    m_frameStats.size = m_size;
+}
+
+} // namespace Simple
@@ -0,0 +1,348 @@
+//--------------------------------------------------------------
+// Copyright (c) David Bosnich <david.bosnich.public@gmail.com>
+//
+// This code is licensed under the MIT License, a copy of which
+// can be found in the license.txt file included at the root of
+// this distribution, or at https://opensource.org/licenses/MIT
+//--------------------------------------------------------------
+
+#pragma once
+
+#include "update_loop.h"
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <new>
+#include <thread>
+#include <vector>
+
+//! @file
+
+//--------------------------------------------------------------
+namespace Simple
+{
+
+//--------------------------------------------------------------
+//! Per-thread storage for values accumulated during a phase (eg.
+//! counters, or results collected by workers in UpdateFixed), that
+//! is merged automatically when the phase ends if added to an update
+//! loop as a listener, so the merged result is ready before the next
+//! phase begins.
+//!
+//! Each thread claims its own slot the first time it calls GetLocal,
+//! without locking, and slots are isolated on separate cache lines
+//! so threads never write to shared memory (and contend) until the
+//! merge, which runs on the thread running the loop. Writes must not
+//! race with the merge; ie. workers running in parallel must all be
+//! joined before the phase boundary is hit. The slot of a thread that
+//! exits is released (for other threads to claim) once its value has
+//! been merged, and calls that fail as every slot is claimed are
+//! counted (see GetFailedCount).
+//--------------------------------------------------------------
+template<class Type>
+class FrameLocal : public UpdateLoop::Listener
+{
+public:
+    using MergeFunc = std::function<void(Type& io_result,
+                                         const Type& a_local)>;
+
+    explicit FrameLocal(const MergeFunc& a_merge,
+                        UpdatePhase a_mergePhase = UpdatePhase::Fixed,
+                        const Type& a_identity = Type(),
+                        uint32_t a_maxThreads = 64);
+    ~FrameLocal() override;
+
+    FrameLocal(const FrameLocal&) = delete;
+    FrameLocal& operator=(const FrameLocal&) = delete;
+
+    Type* GetLocal();
+    const Type& Merge();
+
+    const Type& GetResult() const;
+    uint64_t GetMergeCount() const;
+    uint32_t GetThreadCount() const;
+    uint64_t GetFailedCount() const;
+
+    void OnPhaseEnded(UpdatePhase a_phase) override;
+
+private:
+    static constexpr size_t CacheLineSize = 64;
+
+    struct alignas(CacheLineSize) Slot
+    {
+        explicit Slot(const Type& a_value) : value(a_value) {}
+        Type value;
+    };
+
+    enum OwnerState : uint32_t
+    {
+        Unowned,
+        Owned,
+        Exited  //!< Released once its value has been merged.
+    };
+
+    // The owner state of each slot is shared with the threads that
+    // claim them, so that each can release its slot when it exits,
+    // even if the storage has already been destroyed by then.
+    struct SlotOwners
+    {
+        explicit SlotOwners(size_t a_count) : states(a_count) {}
+        std::vector<std::atomic<uint32_t>> states;
+    };
+
+    struct ThreadClaims
+    {
+        struct Claim
+        {
+            std::shared_ptr<SlotOwners> owners;
+            uint32_t index;
+        };
+        ~ThreadClaims();
+        std::vector<Claim> claims;
+    };
+
+    static uint64_t NextStorageId();
+    Slot* GetSlot(uint32_t a_index);
+
+    const MergeFunc m_merge;
+    const UpdatePhase m_mergePhase;
+    const Type m_identity;
+    const uint32_t m_maxThreads;
+    const uint64_t m_storageId;
+    std::vector<char> m_storage;
+    Slot* m_slots = nullptr;
+    std::shared_ptr<SlotOwners> m_owners;
+    Type m_result;
+    uint64_t m_mergeCount = 0;
+    std::atomic<uint64_t> m_failedCount = { 0 };
+};
+
+//--------------------------------------------------------------
+//! Constructor. All slots are allocated up front.
+//! @param[in] a_merge Function merging a thread's value into the
+//!                    result (eg. adding counters, or appending).
+//! @param[in] a_mergePhase The phase after which values are merged.
+//! @param[in] a_identity The value slots and the result reset to.
+//! @param[in] a_maxThreads Maximum threads that use the storage.
+//--------------------------------------------------------------
+template<class Type>
+inline FrameLocal<Type>::FrameLocal(const MergeFunc& a_merge,
+                                    UpdatePhase a_mergePhase,
+                                    const Type& a_identity,
+                                    uint32_t a_maxThreads)
+    : m_merge(a_merge)
+    , m_mergePhase(a_mergePhase)
+    , m_identity(a_identity)
+    , m_maxThreads(a_maxThreads)
+    , m_storageId(NextStorageId())
+    , m_storage((a_maxThreads + 1) * sizeof(Slot))
+    , m_owners(std::make_shared<SlotOwners>(a_maxThreads))
+    , m_result(a_identity)
+{
+    // Align the slots manually, as std::vector does not honour the
+    // alignment of over-aligned types (prior to c++17).
+    const uintptr_t address = (uintptr_t)m_storage.data();
+    const uintptr_t mask = (uintptr_t)(CacheLineSize - 1);
+    m_slots = (Slot*)((address + mask) & ~mask);
+    for (uint32_t i = 0; i < m_maxThreads; ++i)
+    {
+        new (GetSlot(i)) Slot(m_identity);
+        m_owners->states[i].store(Unowned, std::memory_order_relaxed);
+    }
+}
+
+//--------------------------------------------------------------
+//! Destructor.
+//--------------------------------------------------------------
+template<class Type>
+inline FrameLocal<Type>::~FrameLocal()
+{
+    for (uint32_t i = 0; i < m_maxThreads; ++i)
+    {
+        GetSlot(i)->~Slot();
+    }
+}
+
+//--------------------------------------------------------------
+//! Get the value of the calling thread, to accumulate into until
+//! the next merge. Claims a slot the first time a thread calls it.
+//! @return The value of the calling thread, or null if every slot
+//!         has already been claimed by other threads (counted).
+//--------------------------------------------------------------
+template<class Type>
+inline Type* FrameLocal<Type>::GetLocal()
+{
+    // Cache the slot last used by this thread, keyed by the storage
+    // id in case storage is destroyed and another created in its
+    // place; otherwise find or claim a slot without any locking.
+    struct CachedSlot
+    {
+        uint64_t storageId;
+        Slot* slot;
+    };
+    static thread_local CachedSlot s_cachedSlot = { 0, nullptr };
+    static thread_local ThreadClaims s_threadClaims;
+    if (s_cachedSlot.storageId == m_storageId)
+    {
+        return &s_cachedSlot.slot->value;
+    }
+
+    // Forget claims on storage that has since been destroyed.
+    std::vector<typename ThreadClaims::Claim>& claims =
+        s_threadClaims.claims;
+    Slot* found = nullptr;
+    for (size_t i = claims.size(); i-- > 0;)
+    {
+        if (claims[i].owners == m_owners)
+        {
+            found = GetSlot(claims[i].index);
+        }
+        else if (claims[i].owners.use_count() == 1)
+        {
+            claims.erase(claims.begin() + i);
+        }
+    }
+
+    for (uint32_t i = 0; !found && i < m_maxThreads; ++i)
+    {
+        uint32_t state = Unowned;
+        if (m_owners->states[i].compare_exchange_strong(
+                state, Owned, std::memory_order_acq_rel))
+        {
+            claims.push_back({ m_owners, i });
+            found = GetSlot(i);
+        }
+    }
+
+    if (!found)
+    {
+        m_failedCount.fetch_add(1, std::memory_order_relaxed);
+        return nullptr;
+    }
+    s_cachedSlot.storageId = m_storageId;
+    s_cachedSlot.slot = found;
+    return &found->value;
+}
+
+//--------------------------------------------------------------
+//! Merge the values of all threads into the result, in the order
+//! of their slots, then reset them to the identity, releasing those
+//! of threads that have exited. Called automatically after each
+//! merge phase if a listener.
+//! @return The merged result.
+//--------------------------------------------------------------
+template<class Type>
+inline const Type& FrameLocal<Type>::Merge()
+{
+    m_result = m_identity;
+    for (uint32_t i = 0; i < m_maxThreads; ++i)
+    {
+        std::atomic<uint32_t>& state = m_owners->states[i];
+        const uint32_t owner = state.load(std::memory_order_acquire);
+        if (owner == Unowned)
+        {
+            continue;
+        }
+        Slot* slot = GetSlot(i);
+        m_merge(m_result, slot->value);
+        slot->value = m_identity;
+        if (owner == Exited)
+        {
+            state.store(Unowned, std::memory_order_release);
+        }
+    }
+    ++m_mergeCount;
+    return m_result;
+}
+
+//--------------------------------------------------------------
+//! Get the result of the last merge.
+//! @return The result of the last merge.
+//--------------------------------------------------------------
+template<class Type>
+inline const Type& FrameLocal<Type>::GetResult() const
+{
+    return m_result;
+}
+
+//--------------------------------------------------------------
+//! Get the count of merges (eg. to check the result is fresh).
+//! @return The count of merges.
+//--------------------------------------------------------------
+template<class Type>
+inline uint64_t FrameLocal<Type>::GetMergeCount() const
+{
+    return m_mergeCount;
+}
+
+//--------------------------------------------------------------
+//! Get the count of threads that have claimed a slot, including
+//! any that have exited since, until their values are merged.
+//! @return The count of threads that have claimed a slot.
+//--------------------------------------------------------------
+template<class Type>
+inline uint32_t FrameLocal<Type>::GetThreadCount() const
+{
+    uint32_t count = 0;
+    for (uint32_t i = 0; i < m_maxThreads; ++i)
+    {
+        count += m_owners->states[i].load(std::memory_order_acquire) !=
+                 Unowned;
+    }
+    return count;
+}
+
+//--------------------------------------------------------------
+//! Get the count of calls to GetLocal that failed, as every slot
+//! was claimed (eg. to raise the maximum threads of the storage).
+//! @return The count of calls to GetLocal that failed.
+//--------------------------------------------------------------
+template<class Type>
+inline uint64_t FrameLocal<Type>::GetFailedCount() const
+{
+    return m_failedCount.load(std::memory_order_relaxed);
+}
+
+//--------------------------------------------------------------
+//! Merges the values of all threads after each merge phase.
+//! @param[in] a_phase The phase of the loop that has just ended.
+//--------------------------------------------------------------
+template<class Type>
+inline void FrameLocal<Type>::OnPhaseEnded(UpdatePhase a_phase)
+{
+    if (a_phase == m_mergePhase)
+    {
+        Merge();
+    }
+}
+
+//--------------------------------------------------------------
+template<class Type>
+inline FrameLocal<Type>::ThreadClaims::~ThreadClaims()
+{
+    for (Claim& claim : claims)
+    {
+        claim.owners->states[claim.index].store(
+            Exited, std::memory_order_release);
+    }
+}
+
+//--------------------------------------------------------------
+template<class Type>
+inline uint64_t FrameLocal<Type>::NextStorageId()
+{
+    static std::atomic<uint64_t> s_nextStorageId = { 1 };
+    return s_nextStorageId.fetch_add(1, std::memory_order_relaxed);
+}
+
+//--------------------------------------------------------------
+template<class Type>
+inline typename FrameLocal<Type>::Slot* FrameLocal<Type>::GetSlot(
+    uint32_t a_index)
+{
+    return m_slots + a_index;
+}
+
+} // namespace Simple
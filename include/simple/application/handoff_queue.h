@@ -0,0 +1,430 @@
+//--------------------------------------------------------------
+// Copyright (c) David Bosnich <david.bosnich.public@gmail.com>
+//
+// This code is licensed under the MIT License, a copy of which
+// can be found in the license.txt file included at the root of
+// this distribution, or at https://opensource.org/licenses/MIT
+//--------------------------------------------------------------
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <thread>
+#include <utility>
+#include <vector>
+
+//! @file
+
+//--------------------------------------------------------------
+namespace Simple
+{
+
+//--------------------------------------------------------------
+//! Bounded lock-free queue used to hand values off from a loop
+//! running on one thread (producer) to a loop running on another
+//! (consumer). When full, the producer either drops the value,
+//! coalesces it with those still pending, or blocks until there
+//! is space; and if it stays full, a load shedding hook is called.
+//!
+//! The depth and latency stats are read with GetStats from either
+//! thread (eg. from OnFrameComplete of the producer or consumer loop).
+//--------------------------------------------------------------
+template <class T>
+class HandoffQueue
+{
+public:
+    using Clock = std::chrono::steady_clock;
+    using Duration = Clock::duration;
+    using TimePoint = Clock::time_point;
+
+    enum class Overflow
+    {
+        Drop,       //!< Drop the newest value.
+        Coalesce,   //!< Merge into a pending value, sent when able.
+        Block       //!< Wait for space, unless the queue is closed.
+    };
+
+    struct Stats
+    {
+        size_t capacity = 0;
+        size_t depth = 0;
+        size_t maxDepth = 0;
+        uint64_t pushed = 0;
+        uint64_t popped = 0;
+        uint64_t dropped = 0;
+        uint64_t coalesced = 0;
+        uint64_t blocked = 0;
+        uint64_t shedCount = 0;
+        Duration latencyLast = {};
+        Duration latencyMax = {};
+        Duration latencyAvg = {};
+    };
+
+    using CoalesceFunc = std::function<void(T& io_pending,
+                                            const T& a_value)>;
+    using LoadSheddingFunc = std::function<void(const Stats&)>;
+
+    explicit HandoffQueue(size_t a_capacity,
+                          Overflow a_overflow = Overflow::Drop);
+    ~HandoffQueue() = default;
+
+    HandoffQueue(const HandoffQueue&) = delete;
+    HandoffQueue& operator=(const HandoffQueue&) = delete;
+
+    void SetCoalesce(CoalesceFunc a_coalesceFunc);
+    void SetLoadShedding(uint32_t a_fullPushes,
+                         LoadSheddingFunc a_loadSheddingFunc);
+
+    bool Push(const T& a_value);
+    bool Flush();
+    bool Pop(T& o_value);
+
+    void Close();
+    bool IsClosed() const;
+
+    size_t GetCapacity() const;
+    size_t GetDepth() const;
+    Stats GetStats() const;
+
+private:
+    struct Slot
+    {
+        T value;
+        TimePoint pushTime;
+    };
+
+    bool TryPush(const T& a_value);
+    void OnFull();
+
+    // Producer and consumer indices are kept on separate cache
+    // lines, each side caching the other's to minimise sharing.
+    alignas(64) std::atomic<size_t> m_tail = { 0 };
+    size_t m_cachedHead = 0;
+    alignas(64) std::atomic<size_t> m_head = { 0 };
+    size_t m_cachedTail = 0;
+
+    alignas(64) std::vector<Slot> m_slots;
+    const size_t m_mask;
+    const Overflow m_overflow;
+    std::atomic_bool m_closed = { false };
+
+    // Producer side state.
+    CoalesceFunc m_coalesceFunc;
+    LoadSheddingFunc m_loadSheddingFunc;
+    T m_pending = {};
+    bool m_hasPending = false;
+    uint32_t m_fullPushes = 0;
+    uint32_t m_fullPushesToShed = 0;
+
+    // Stats, each written by one side and read by either side.
+    std::atomic<size_t> m_maxDepth = { 0 };
+    std::atomic<uint64_t> m_pushed = { 0 };
+    std::atomic<uint64_t> m_popped = { 0 };
+    std::atomic<uint64_t> m_dropped = { 0 };
+    std::atomic<uint64_t> m_coalesced = { 0 };
+    std::atomic<uint64_t> m_blocked = { 0 };
+    std::atomic<uint64_t> m_shedCount = { 0 };
+    std::atomic<int64_t> m_latencyLast = { 0 };
+    std::atomic<int64_t> m_latencyMax = { 0 };
+    std::atomic<int64_t> m_latencyTotal = { 0 };
+};
+
+//--------------------------------------------------------------
+//! Constructor.
+//! @param[in] a_capacity Capacity, rounded up to a power of two.
+//! @param[in] a_overflow What Push does if the queue is full.
+//--------------------------------------------------------------
+template <class T>
+inline HandoffQueue<T>::HandoffQueue(size_t a_capacity,
+                                     Overflow a_overflow)
+    : m_slots()
+    , m_mask([a_capacity]()
+      {
+          size_t capacity = 1;
+          while (capacity < a_capacity)
+          {
+              capacity <<= 1;
+          }
+          return capacity - 1;
+      }())
+    , m_overflow(a_overflow)
+{
+    m_slots.resize(m_mask + 1);
+}
+
+//--------------------------------------------------------------
+//! Set the function used to merge a value that could not be sent
+//! into the pending value (Overflow::Coalesce). Defaults to copy.
+//! @param[in] a_coalesceFunc Merges a value into a pending value.
+//--------------------------------------------------------------
+template <class T>
+inline void HandoffQueue<T>::SetCoalesce(CoalesceFunc a_coalesceFunc)
+{
+    m_coalesceFunc = std::move(a_coalesceFunc);
+}
+
+//--------------------------------------------------------------
+//! Set the hook called (on the producer thread) each time Push is
+//! called this many consecutive times while the queue is full, so
+//! the producer's loop can shed load (eg. reduce its target fps).
+//! @param[in] a_fullPushes Consecutive full pushes before calling.
+//! @param[in] a_loadSheddingFunc The hook, called with the stats.
+//--------------------------------------------------------------
+template <class T>
+inline void HandoffQueue<T>::SetLoadShedding(
+    uint32_t a_fullPushes,
+    LoadSheddingFunc a_loadSheddingFunc)
+{
+    m_fullPushesToShed = a_fullPushes ? a_fullPushes : 1;
+    m_loadSheddingFunc = std::move(a_loadSheddingFunc);
+}
+
+//--------------------------------------------------------------
+//! Push a value (producer thread only), handling overflow if full.
+//! @param[in] a_value The value to be handed off to the consumer.
+//! @return True if the value was queued, false if it was dropped,
+//!         coalesced (but not yet queued), or the queue is closed.
+//--------------------------------------------------------------
+template <class T>
+inline bool HandoffQueue<T>::Push(const T& a_value)
+{
+    // Closed queues reject values without counting them as overflow.
+    if (IsClosed())
+    {
+        return false;
+    }
+
+    // Anything pending must be sent first to preserve ordering.
+    if (m_hasPending && !Flush())
+    {
+        m_coalesceFunc ? m_coalesceFunc(m_pending, a_value) :
+                         (void)(m_pending = a_value);
+        m_coalesced.fetch_add(1, std::memory_order_relaxed);
+        OnFull();
+        return false;
+    }
+
+    if (TryPush(a_value))
+    {
+        m_fullPushes = 0;
+        return true;
+    }
+
+    switch (m_overflow)
+    {
+    case Overflow::Drop:
+    {
+        m_dropped.fetch_add(1, std::memory_order_relaxed);
+        OnFull();
+        return false;
+    }
+    case Overflow::Coalesce:
+    {
+        m_pending = a_value;
+        m_hasPending = true;
+        m_coalesced.fetch_add(1, std::memory_order_relaxed);
+        OnFull();
+        return false;
+    }
+    case Overflow::Block:
+    {
+        m_blocked.fetch_add(1, std::memory_order_relaxed);
+        OnFull();
+        while (!IsClosed())
+        {
+            std::this_thread::yield();
+            if (TryPush(a_value))
+            {
+                m_fullPushes = 0;
+                return true;
+            }
+        }
+        m_dropped.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+    }
+    return false;
+}
+
+//--------------------------------------------------------------
+//! Try to queue any pending value (producer thread only). Useful
+//! when coalescing, if there may be no more values pushed soon.
+//! @return True if there is no value that remains pending.
+//--------------------------------------------------------------
+template <class T>
+inline bool HandoffQueue<T>::Flush()
+{
+    if (m_hasPending && TryPush(m_pending))
+    {
+        m_hasPending = false;
+        m_fullPushes = 0;
+    }
+    return !m_hasPending;
+}
+
+//--------------------------------------------------------------
+//! Pop the oldest value (consumer thread only), if there is one.
+//! @param[out] o_value The oldest value that was handed off.
+//! @return True if a value was popped, false if queue was empty.
+//--------------------------------------------------------------
+template <class T>
+inline bool HandoffQueue<T>::Pop(T& o_value)
+{
+    const size_t head = m_head.load(std::memory_order_relaxed);
+    if (head == m_cachedTail)
+    {
+        m_cachedTail = m_tail.load(std::memory_order_acquire);
+        if (head == m_cachedTail)
+        {
+            return false;
+        }
+    }
+
+    Slot& slot = m_slots[head & m_mask];
+    o_value = std::move(slot.value);
+    const int64_t latency = (Clock::now() - slot.pushTime).count();
+    m_head.store(head + 1, std::memory_order_release);
+
+    m_popped.fetch_add(1, std::memory_order_relaxed);
+    m_latencyLast.store(latency, std::memory_order_relaxed);
+    m_latencyTotal.fetch_add(latency, std::memory_order_relaxed);
+    if (latency > m_latencyMax.load(std::memory_order_relaxed))
+    {
+        m_latencyMax.store(latency, std::memory_order_relaxed);
+    }
+    return true;
+}
+
+//--------------------------------------------------------------
+//! Close the queue, releasing a producer blocked in Push (which
+//! then drops the value), and rejecting any that are pushed later
+//! (without counting them as dropped or calling load shedding).
+//--------------------------------------------------------------
+template <class T>
+inline void HandoffQueue<T>::Close()
+{
+    m_closed.store(true, std::memory_order_release);
+}
+
+//--------------------------------------------------------------
+//! Get whether the queue has been closed.
+//! @return True if the queue has been closed, false otherwise.
+//--------------------------------------------------------------
+template <class T>
+inline bool HandoffQueue<T>::IsClosed() const
+{
+    return m_closed.load(std::memory_order_acquire);
+}
+
+//--------------------------------------------------------------
+//! Get the capacity of the queue.
+//! @return The capacity of the queue.
+//--------------------------------------------------------------
+template <class T>
+inline size_t HandoffQueue<T>::GetCapacity() const
+{
+    return m_mask + 1;
+}
+
+//--------------------------------------------------------------
+//! Get the count of values queued (from either thread).
+//! @return The count of values queued.
+//--------------------------------------------------------------
+template <class T>
+inline size_t HandoffQueue<T>::GetDepth() const
+{
+    const size_t head = m_head.load(std::memory_order_acquire);
+    const size_t tail = m_tail.load(std::memory_order_acquire);
+    return (tail >= head) ? tail - head : 0;
+}
+
+//--------------------------------------------------------------
+//! Get the stats of the queue (from either thread), including the
+//! depth and the latency of values from being pushed until popped.
+//! @return The stats of the queue.
+//--------------------------------------------------------------
+template <class T>
+inline typename HandoffQueue<T>::Stats HandoffQueue<T>::GetStats() const
+{
+    Stats stats;
+    stats.capacity = GetCapacity();
+    stats.depth = GetDepth();
+    stats.maxDepth = m_maxDepth.load(std::memory_order_relaxed);
+    stats.pushed = m_pushed.load(std::memory_order_relaxed);
+    stats.popped = m_popped.load(std::memory_order_relaxed);
+    stats.dropped = m_dropped.load(std::memory_order_relaxed);
+    stats.coalesced = m_coalesced.load(std::memory_order_relaxed);
+    stats.blocked = m_blocked.load(std::memory_order_relaxed);
+    stats.shedCount = m_shedCount.load(std::memory_order_relaxed);
+    stats.latencyLast = Duration(
+        m_latencyLast.load(std::memory_order_relaxed));
+    stats.latencyMax = Duration(
+        m_latencyMax.load(std::memory_order_relaxed));
+    const int64_t total = m_latencyTotal.load(
+        std::memory_order_relaxed);
+    stats.latencyAvg = Duration(stats.popped ?
+                                total / (int64_t)stats.popped : 0);
+    return stats;
+}
+
+//--------------------------------------------------------------
+template <class T>
+inline bool HandoffQueue<T>::TryPush(const T& a_value)
+{
+    if (IsClosed())
+    {
+        return false;
+    }
+
+    const size_t tail = m_tail.load(std::memory_order_relaxed);
+    if (tail - m_cachedHead > m_mask)
+    {
+        m_cachedHead = m_head.load(std::memory_order_acquire);
+        if (tail - m_cachedHead > m_mask)
+        {
+            return false;
+        }
+    }
+
+    Slot& slot = m_slots[tail & m_mask];
+    slot.value = a_value;
+    slot.pushTime = Clock::now();
+    m_tail.store(tail + 1, std::memory_order_release);
+
+    // The cached head lags the real one, so the depth it gives is only
+    // an upper bound. It is refreshed only if that exceeds the maximum
+    // depth, so the maximum is exact without reading the head each push.
+    m_pushed.fetch_add(1, std::memory_order_relaxed);
+    const size_t maxDepth = m_maxDepth.load(std::memory_order_relaxed);
+    if ((tail + 1) - m_cachedHead > maxDepth)
+    {
+        m_cachedHead = m_head.load(std::memory_order_acquire);
+        const size_t depth = (tail + 1) - m_cachedHead;
+        if (depth > maxDepth)
+        {
+            m_maxDepth.store(depth, std::memory_order_relaxed);
+        }
+    }
+    return true;
+}
+
+//--------------------------------------------------------------
+template <class T>
+inline void HandoffQueue<T>::OnFull()
+{
+    if (!m_loadSheddingFunc)
+    {
+        return;
+    }
+
+    if (++m_fullPushes >= m_fullPushesToShed)
+    {
+        m_fullPushes = 0;
+        m_shedCount.fetch_add(1, std::memory_order_relaxed);
+        m_loadSheddingFunc(GetStats());
+    }
+}
+
+} // namespace Simple
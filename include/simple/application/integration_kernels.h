@@ -0,0 +1,660 @@
+//--------------------------------------------------------------
+// Copyright (c) David Bosnich <david.bosnich.public@gmail.com>
+//
+// This code is licensed under the MIT License, a copy of which
+// can be found in the license.txt file included at the root of
+// this distribution, or at https://opensource.org/licenses/MIT
+//--------------------------------------------------------------
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+//! @file
+
+//--------------------------------------------------------------
+//! Vectorized kernels are only supported by gcc/clang for x86, as
+//! they rely on vector extensions and per-function target options.
+//! Otherwise (eg. msvc) the scalar kernels are always used instead.
+//--------------------------------------------------------------
+#if (defined(__GNUC__) || defined(__clang__)) && \
+    (defined(__x86_64__) || defined(__i386__))
+#define SIMPLE_VECTOR_KERNELS_SUPPORTED
+#define SIMPLE_KERNEL_INLINE inline __attribute__((always_inline))
+#endif
+
+//--------------------------------------------------------------
+namespace Simple
+{
+
+//--------------------------------------------------------------
+//! Kernels that integrate structure-of-arrays float data (eg. the
+//! x, y or z arrays of positions) by the fixed delta time, to call
+//! from UpdateFixed. Each is vectorized for SSE, AVX2 and AVX-512,
+//! using whichever the CPU supports (detected at runtime), with a
+//! scalar version used for any remaining elements or other CPUs.
+//!
+//! Arrays do not need to be aligned, but must not overlap. Results
+//! may differ in the last bit between instruction sets if the
+//! compiler contracts multiplies and adds (eg. -ffp-contract=fast).
+//--------------------------------------------------------------
+namespace Kernels
+{
+
+//--------------------------------------------------------------
+//! Instruction sets the kernels are compiled for.
+//--------------------------------------------------------------
+enum class ISA : uint8_t
+{
+    Scalar,
+    SSE,        //!< 4 floats per instruction.
+    AVX2,       //!< 8 floats per instruction.
+    AVX512      //!< 16 floats per instruction.
+};
+
+bool IsSupported(ISA a_isa);
+ISA GetBestISA();
+ISA GetISA();
+bool SetISA(ISA a_isa);
+const char* GetISAName(ISA a_isa);
+
+void Euler(float* io_positions,
+           const float* a_velocities,
+           size_t a_count,
+           float a_fixedTimeSeconds);
+
+void SemiImplicitEuler(float* io_positions,
+                       float* io_velocities,
+                       const float* a_accelerations,
+                       size_t a_count,
+                       float a_fixedTimeSeconds);
+
+void DampedSpring(float* io_positions,
+                  float* io_velocities,
+                  const float* a_targets,
+                  size_t a_count,
+                  float a_stiffness,
+                  float a_damping,
+                  float a_fixedTimeSeconds);
+
+size_t CountdownTimers(float* io_timers,
+                       uint8_t* o_expired,
+                       size_t a_count,
+                       float a_fixedTimeSeconds);
+
+void ClampedAccumulate(float* io_values,
+                       const float* a_rates,
+                       size_t a_count,
+                       float a_min,
+                       float a_max,
+                       float a_fixedTimeSeconds);
+
+//--------------------------------------------------------------
+//! Pointers to each kernel compiled for one instruction set.
+//--------------------------------------------------------------
+struct KernelTable
+{
+    void (*euler)(float*, const float*, size_t, float);
+    void (*semiImplicitEuler)(float*, float*, const float*,
+                              size_t, float);
+    void (*dampedSpring)(float*, float*, const float*,
+                         size_t, float, float, float);
+    size_t (*countdownTimers)(float*, uint8_t*, size_t, float);
+    void (*clampedAccumulate)(float*, const float*,
+                              size_t, float, float, float);
+};
+
+//--------------------------------------------------------------
+//! Scalar versions of each kernel, used for the Scalar instruction
+//! set and for any elements left over by the vectorized versions.
+//--------------------------------------------------------------
+struct ScalarKernels
+{
+    static void Euler(float* io_positions,
+                      const float* a_velocities,
+                      size_t a_count,
+                      float a_dt)
+    {
+        for (size_t i = 0; i < a_count; ++i)
+        {
+            io_positions[i] += a_velocities[i] * a_dt;
+        }
+    }
+
+    static void SemiImplicitEuler(float* io_positions,
+                                  float* io_velocities,
+                                  const float* a_accelerations,
+                                  size_t a_count,
+                                  float a_dt)
+    {
+        for (size_t i = 0; i < a_count; ++i)
+        {
+            io_velocities[i] += a_accelerations[i] * a_dt;
+            io_positions[i] += io_velocities[i] * a_dt;
+        }
+    }
+
+    static void DampedSpring(float* io_positions,
+                             float* io_velocities,
+                             const float* a_targets,
+                             size_t a_count,
+                             float a_stiffness,
+                             float a_damping,
+                             float a_dt)
+    {
+        for (size_t i = 0; i < a_count; ++i)
+        {
+            const float stretch = a_targets[i] - io_positions[i];
+            const float acceleration = stretch * a_stiffness -
+                                       io_velocities[i] * a_damping;
+            io_velocities[i] += acceleration * a_dt;
+            io_positions[i] += io_velocities[i] * a_dt;
+        }
+    }
+
+    static size_t CountdownTimers(float* io_timers,
+                                  uint8_t* o_expired,
+                                  size_t a_count,
+                                  float a_dt)
+    {
+        size_t expiredCount = 0;
+        for (size_t i = 0; i < a_count; ++i)
+        {
+            const float before = io_timers[i];
+            const float after = before - a_dt;
+            io_timers[i] = after < 0.0f ? 0.0f : after;
+            o_expired[i] = (before > 0.0f && after <= 0.0f) ? 1 : 0;
+            expiredCount += o_expired[i];
+        }
+        return expiredCount;
+    }
+
+    static void ClampedAccumulate(float* io_values,
+                                  const float* a_rates,
+                                  size_t a_count,
+                                  float a_min,
+                                  float a_max,
+                                  float a_dt)
+    {
+        for (size_t i = 0; i < a_count; ++i)
+        {
+            const float value = io_values[i] + a_rates[i] * a_dt;
+            const float clamped = value < a_min ? a_min : value;
+            io_values[i] = clamped > a_max ? a_max : clamped;
+        }
+    }
+
+    static const KernelTable& GetTable()
+    {
+        static const KernelTable s_table = { Euler,
+                                             SemiImplicitEuler,
+                                             DampedSpring,
+                                             CountdownTimers,
+                                             ClampedAccumulate };
+        return s_table;
+    }
+};
+
+#ifdef SIMPLE_VECTOR_KERNELS_SUPPORTED
+
+//--------------------------------------------------------------
+//! Vectorized versions of each kernel, written once using vector
+//! extensions for any width. They are always inlined into entry
+//! points compiled with the target options of each instruction set
+//! (see SIMPLE_KERNEL_ENTRIES), so never run on unsupported CPUs.
+//--------------------------------------------------------------
+template<size_t Width>
+struct VectorTypes
+{
+    typedef float Vec __attribute__((vector_size(Width * 4)));
+    typedef uint32_t Bits __attribute__((vector_size(Width * 4)));
+    typedef uint8_t Bytes __attribute__((vector_size(Width)));
+};
+
+//--------------------------------------------------------------
+template<size_t Width>
+struct VectorKernels
+{
+    typedef typename VectorTypes<Width>::Vec Vec;
+    typedef typename VectorTypes<Width>::Bits Bits;
+    typedef typename VectorTypes<Width>::Bytes Bytes;
+
+    static SIMPLE_KERNEL_INLINE void Euler(float* io_positions,
+                                           const float* a_velocities,
+                                           size_t a_count,
+                                           float a_dt)
+    {
+        size_t i = 0;
+        for (; i + Width <= a_count; i += Width)
+        {
+            Vec position, velocity;
+            memcpy(&position, io_positions + i, sizeof(Vec));
+            memcpy(&velocity, a_velocities + i, sizeof(Vec));
+            position += velocity * a_dt;
+            memcpy(io_positions + i, &position, sizeof(Vec));
+        }
+        ScalarKernels::Euler(io_positions + i, a_velocities + i,
+                             a_count - i, a_dt);
+    }
+
+    static SIMPLE_KERNEL_INLINE void SemiImplicitEuler(
+        float* io_positions,
+        float* io_velocities,
+        const float* a_accelerations,
+        size_t a_count,
+        float a_dt)
+    {
+        size_t i = 0;
+        for (; i + Width <= a_count; i += Width)
+        {
+            Vec position, velocity, acceleration;
+            memcpy(&position, io_positions + i, sizeof(Vec));
+            memcpy(&velocity, io_velocities + i, sizeof(Vec));
+            memcpy(&acceleration, a_accelerations + i, sizeof(Vec));
+            velocity += acceleration * a_dt;
+            position += velocity * a_dt;
+            memcpy(io_velocities + i, &velocity, sizeof(Vec));
+            memcpy(io_positions + i, &position, sizeof(Vec));
+        }
+        ScalarKernels::SemiImplicitEuler(io_positions + i,
+                                         io_velocities + i,
+                                         a_accelerations + i,
+                                         a_count - i, a_dt);
+    }
+
+    static SIMPLE_KERNEL_INLINE void DampedSpring(float* io_positions,
+                                                  float* io_velocities,
+                                                  const float* a_targets,
+                                                  size_t a_count,
+                                                  float a_stiffness,
+                                                  float a_damping,
+                                                  float a_dt)
+    {
+        size_t i = 0;
+        for (; i + Width <= a_count; i += Width)
+        {
+            Vec position, velocity, target;
+            memcpy(&position, io_positions + i, sizeof(Vec));
+            memcpy(&velocity, io_velocities + i, sizeof(Vec));
+            memcpy(&target, a_targets + i, sizeof(Vec));
+            const Vec stretch = target - position;
+            const Vec acceleration = stretch * a_stiffness -
+                                     velocity * a_damping;
+            velocity += acceleration * a_dt;
+            position += velocity * a_dt;
+            memcpy(io_velocities + i, &velocity, sizeof(Vec));
+            memcpy(io_positions + i, &position, sizeof(Vec));
+        }
+        ScalarKernels::DampedSpring(io_positions + i,
+                                    io_velocities + i,
+                                    a_targets + i,
+                                    a_count - i,
+                                    a_stiffness,
+                                    a_damping,
+                                    a_dt);
+    }
+
+    static SIMPLE_KERNEL_INLINE size_t CountdownTimers(
+        float* io_timers,
+        uint8_t* o_expired,
+        size_t a_count,
+        float a_dt)
+    {
+        if (a_dt <= 0.0f)
+        {
+            return ScalarKernels::CountdownTimers(io_timers, o_expired,
+                                                  a_count, a_dt);
+        }
+
+        // A timer expires if 0 < before <= dt, which is checked using
+        // integer math on the bits of each float (positive floats are
+        // ordered the same as their bits) so no masks are needed that
+        // the compiler may not vectorize (eg. for AVX-512 mask regs).
+        uint32_t dtBits;
+        memcpy(&dtBits, &a_dt, sizeof(dtBits));
+        const Vec zero = {};
+        Bits expiredCounts = {};
+        size_t i = 0;
+        for (; i + Width <= a_count; i += Width)
+        {
+            Vec before;
+            memcpy(&before, io_timers + i, sizeof(Vec));
+            const Vec after = before - a_dt;
+            const Vec clamped = after < zero ? zero : after;
+            memcpy(io_timers + i, &clamped, sizeof(Vec));
+
+            const Bits bits = (Bits)before;
+            const Bits expired = ~((bits - 1u) | (dtBits - bits)) >> 31;
+            const Bytes flags = __builtin_convertvector(expired, Bytes);
+            memcpy(o_expired + i, &flags, sizeof(Bytes));
+            expiredCounts += expired;
+        }
+        size_t expiredCount = 0;
+        for (size_t j = 0; j < Width; ++j)
+        {
+            expiredCount += expiredCounts[j];
+        }
+        return expiredCount +
+               ScalarKernels::CountdownTimers(io_timers + i,
+                                              o_expired + i,
+                                              a_count - i, a_dt);
+    }
+
+    static SIMPLE_KERNEL_INLINE void ClampedAccumulate(
+        float* io_values,
+        const float* a_rates,
+        size_t a_count,
+        float a_min,
+        float a_max,
+        float a_dt)
+    {
+        Vec minimum = {}, maximum = {};
+        minimum += a_min;
+        maximum += a_max;
+        size_t i = 0;
+        for (; i + Width <= a_count; i += Width)
+        {
+            Vec value, rate;
+            memcpy(&value, io_values + i, sizeof(Vec));
+            memcpy(&rate, a_rates + i, sizeof(Vec));
+            value += rate * a_dt;
+            value = value < minimum ? minimum : value;
+            value = value > maximum ? maximum : value;
+            memcpy(io_values + i, &value, sizeof(Vec));
+        }
+        ScalarKernels::ClampedAccumulate(io_values + i, a_rates + i,
+                                         a_count - i, a_min, a_max,
+                                         a_dt);
+    }
+};
+
+//--------------------------------------------------------------
+//! Define entry points for each kernel, compiled with the target
+//! options of an instruction set, and a table of pointers to them.
+//--------------------------------------------------------------
+#define SIMPLE_KERNEL_ENTRIES(a_name, a_width, a_target)               \
+struct a_name                                                          \
+{                                                                      \
+    using Impl = VectorKernels<a_width>;                               \
+    __attribute__((target(a_target)))                                  \
+    static void Euler(float* p, const float* v, size_t n, float dt)    \
+    {                                                                  \
+        Impl::Euler(p, v, n, dt);                                      \
+    }                                                                  \
+    __attribute__((target(a_target)))                                  \
+    static void SemiImplicitEuler(float* p, float* v, const float* a,  \
+                                  size_t n, float dt)                  \
+    {                                                                  \
+        Impl::SemiImplicitEuler(p, v, a, n, dt);                       \
+    }                                                                  \
+    __attribute__((target(a_target)))                                  \
+    static void DampedSpring(float* p, float* v, const float* t,       \
+                             size_t n, float k, float c, float dt)     \
+    {                                                                  \
+        Impl::DampedSpring(p, v, t, n, k, c, dt);                      \
+    }                                                                  \
+    __attribute__((target(a_target)))                                  \
+    static size_t CountdownTimers(float* t, uint8_t* e,                \
+                                  size_t n, float dt)                  \
+    {                                                                  \
+        return Impl::CountdownTimers(t, e, n, dt);                     \
+    }                                                                  \
+    __attribute__((target(a_target)))                                  \
+    static void ClampedAccumulate(float* v, const float* r, size_t n,  \
+                                  float lo, float hi, float dt)        \
+    {                                                                  \
+        Impl::ClampedAccumulate(v, r, n, lo, hi, dt);                  \
+    }                                                                  \
+    static const KernelTable& GetTable()                               \
+    {                                                                  \
+        static const KernelTable s_table = { Euler,                    \
+                                             SemiImplicitEuler,        \
+                                             DampedSpring,             \
+                                             CountdownTimers,          \
+                                             ClampedAccumulate };      \
+        return s_table;                                                \
+    }                                                                  \
+};
+
+SIMPLE_KERNEL_ENTRIES(SSEKernels, 4, "sse2")
+SIMPLE_KERNEL_ENTRIES(AVX2Kernels, 8, "avx2")
+SIMPLE_KERNEL_ENTRIES(AVX512Kernels, 16, "avx512f,avx512bw")
+
+#undef SIMPLE_KERNEL_ENTRIES
+
+#endif // SIMPLE_VECTOR_KERNELS_SUPPORTED
+
+//--------------------------------------------------------------
+//! Get the table of kernels for an instruction set.
+//! @param[in] a_isa The instruction set (must be supported).
+//! @return The table of kernels for the instruction set.
+//--------------------------------------------------------------
+inline const KernelTable& GetKernelTable(ISA a_isa)
+{
+#ifdef SIMPLE_VECTOR_KERNELS_SUPPORTED
+    switch (a_isa)
+    {
+        case ISA::SSE: return SSEKernels::GetTable();
+        case ISA::AVX2: return AVX2Kernels::GetTable();
+        case ISA::AVX512: return AVX512Kernels::GetTable();
+        case ISA::Scalar: break;
+    }
+#else
+    (void)a_isa;
+#endif
+    return ScalarKernels::GetTable();
+}
+
+//--------------------------------------------------------------
+inline const KernelTable*& CurrentKernelTable()
+{
+    static const KernelTable* s_table = &GetKernelTable(GetBestISA());
+    return s_table;
+}
+
+//--------------------------------------------------------------
+inline ISA& CurrentISA()
+{
+    static ISA s_isa = GetBestISA();
+    return s_isa;
+}
+
+//--------------------------------------------------------------
+//! Check whether an instruction set is supported by the CPU (and
+//! by the compiler, which for msvc is only ever the scalar one).
+//! @param[in] a_isa The instruction set to check.
+//! @return True if the kernels can be run using the instruction set.
+//--------------------------------------------------------------
+inline bool IsSupported(ISA a_isa)
+{
+#ifdef SIMPLE_VECTOR_KERNELS_SUPPORTED
+    __builtin_cpu_init();
+    switch (a_isa)
+    {
+        case ISA::Scalar: return true;
+        case ISA::SSE: return __builtin_cpu_supports("sse2");
+        case ISA::AVX2: return __builtin_cpu_supports("avx2");
+        case ISA::AVX512: return __builtin_cpu_supports("avx512f") &&
+                                  __builtin_cpu_supports("avx512bw");
+    }
+    return false;
+#else
+    return a_isa == ISA::Scalar;
+#endif
+}
+
+//--------------------------------------------------------------
+//! Get the widest instruction set that is supported.
+//! @return The widest instruction set that is supported.
+//--------------------------------------------------------------
+inline ISA GetBestISA()
+{
+    const ISA isas[] = { ISA::AVX512, ISA::AVX2, ISA::SSE };
+    for (ISA isa : isas)
+    {
+        if (IsSupported(isa))
+        {
+            return isa;
+        }
+    }
+    return ISA::Scalar;
+}
+
+//--------------------------------------------------------------
+//! Get the instruction set the kernels are currently run using.
+//! @return The instruction set (the best supported by default).
+//--------------------------------------------------------------
+inline ISA GetISA()
+{
+    return CurrentISA();
+}
+
+//--------------------------------------------------------------
+//! Set the instruction set to run the kernels using (eg. to test
+//! or benchmark). Must not be called while any kernel is running.
+//! @param[in] a_isa The instruction set to run the kernels using.
+//! @return True if the instruction set is supported and now used.
+//--------------------------------------------------------------
+inline bool SetISA(ISA a_isa)
+{
+    if (!IsSupported(a_isa))
+    {
+        return false;
+    }
+    CurrentISA() = a_isa;
+    CurrentKernelTable() = &GetKernelTable(a_isa);
+    return true;
+}
+
+//--------------------------------------------------------------
+//! Get the name of an instruction set.
+//! @param[in] a_isa The instruction set to get the name of.
+//! @return The name of the instruction set.
+//--------------------------------------------------------------
+inline const char* GetISAName(ISA a_isa)
+{
+    switch (a_isa)
+    {
+        case ISA::Scalar: return "Scalar";
+        case ISA::SSE: return "SSE";
+        case ISA::AVX2: return "AVX2";
+        case ISA::AVX512: return "AVX512";
+    }
+    return "Unknown";
+}
+
+//--------------------------------------------------------------
+//! Integrate positions by velocities (explicit Euler).
+//! @param[in,out] io_positions The positions to integrate.
+//! @param[in] a_velocities The velocities to integrate by.
+//! @param[in] a_count The count of elements in each array.
+//! @param[in] a_fixedTimeSeconds The fixed delta time.
+//--------------------------------------------------------------
+inline void Euler(float* io_positions,
+                  const float* a_velocities,
+                  size_t a_count,
+                  float a_fixedTimeSeconds)
+{
+    CurrentKernelTable()->euler(io_positions, a_velocities,
+                                a_count, a_fixedTimeSeconds);
+}
+
+//--------------------------------------------------------------
+//! Integrate velocities by accelerations, then positions by the
+//! updated velocities (semi-implicit Euler, which is more stable).
+//! @param[in,out] io_positions The positions to integrate.
+//! @param[in,out] io_velocities The velocities to integrate.
+//! @param[in] a_accelerations The accelerations to integrate by.
+//! @param[in] a_count The count of elements in each array.
+//! @param[in] a_fixedTimeSeconds The fixed delta time.
+//--------------------------------------------------------------
+inline void SemiImplicitEuler(float* io_positions,
+                              float* io_velocities,
+                              const float* a_accelerations,
+                              size_t a_count,
+                              float a_fixedTimeSeconds)
+{
+    CurrentKernelTable()->semiImplicitEuler(io_positions,
+                                            io_velocities,
+                                            a_accelerations,
+                                            a_count,
+                                            a_fixedTimeSeconds);
+}
+
+//--------------------------------------------------------------
+//! Integrate damped springs pulling positions toward the targets
+//! (acceleration = stiffness * stretch - damping * velocity) using
+//! semi-implicit Euler.
+//! @param[in,out] io_positions The positions to integrate.
+//! @param[in,out] io_velocities The velocities to integrate.
+//! @param[in] a_targets The rest positions of the springs.
+//! @param[in] a_count The count of elements in each array.
+//! @param[in] a_stiffness The stiffness of all springs.
+//! @param[in] a_damping The damping of all springs.
+//! @param[in] a_fixedTimeSeconds The fixed delta time.
+//--------------------------------------------------------------
+inline void DampedSpring(float* io_positions,
+                         float* io_velocities,
+                         const float* a_targets,
+                         size_t a_count,
+                         float a_stiffness,
+                         float a_damping,
+                         float a_fixedTimeSeconds)
+{
+    CurrentKernelTable()->dampedSpring(io_positions,
+                                       io_velocities,
+                                       a_targets,
+                                       a_count,
+                                       a_stiffness,
+                                       a_damping,
+                                       a_fixedTimeSeconds);
+}
+
+//--------------------------------------------------------------
+//! Count down timers, stopping at zero, and flag the timers that
+//! expired (reached zero) this step. Timers at zero are inactive.
+//! @param[in,out] io_timers The timers to count down, in seconds.
+//! @param[out] o_expired Set to 1 if the timer expired, else 0.
+//! @param[in] a_count The count of elements in each array.
+//! @param[in] a_fixedTimeSeconds The fixed delta time.
+//! @return The count of timers that expired this step.
+//--------------------------------------------------------------
+inline size_t CountdownTimers(float* io_timers,
+                              uint8_t* o_expired,
+                              size_t a_count,
+                              float a_fixedTimeSeconds)
+{
+    return CurrentKernelTable()->countdownTimers(io_timers,
+                                                 o_expired,
+                                                 a_count,
+                                                 a_fixedTimeSeconds);
+}
+
+//--------------------------------------------------------------
+//! Accumulate values by rates, clamping the results to a range.
+//! @param[in,out] io_values The values to accumulate.
+//! @param[in] a_rates The rates of change, per second.
+//! @param[in] a_count The count of elements in each array.
+//! @param[in] a_min The minimum value to clamp each result to.
+//! @param[in] a_max The maximum value to clamp each result to.
+//! @param[in] a_fixedTimeSeconds The fixed delta time.
+//--------------------------------------------------------------
+inline void ClampedAccumulate(float* io_values,
+                              const float* a_rates,
+                              size_t a_count,
+                              float a_min,
+                              float a_max,
+                              float a_fixedTimeSeconds)
+{
+    CurrentKernelTable()->clampedAccumulate(io_values,
+                                            a_rates,
+                                            a_count,
+                                            a_min,
+                                            a_max,
+                                            a_fixedTimeSeconds);
+}
+
+} // namespace Kernels
+} // namespace Simple
@@ -0,0 +1,652 @@
+//--------------------------------------------------------------
+// Copyright (c) David Bosnich <david.bosnich.public@gmail.com>
+//
+// This code is licensed under the MIT License, a copy of which
+// can be found in the license.txt file included at the root of
+// this distribution, or at https://opensource.org/licenses/MIT
+//--------------------------------------------------------------
+
+#pragma once
+
+#include "control_server.h"
+#include "update_loop.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <functional>
+#include <string>
+#include <thread>
+#include <vector>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <time.h>
+#define SIMPLE_LOOP_REGISTRY_THREAD_CPU 1
+#endif
+
+#if defined(__linux__)
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+//! @file
+
+//--------------------------------------------------------------
+//! Maximum count of loops registered in the process at once.
+//--------------------------------------------------------------
+#ifndef DEFAULT_LOOP_REGISTRY_MAX_LOOPS
+#define DEFAULT_LOOP_REGISTRY_MAX_LOOPS 64u
+#endif//DEFAULT_LOOP_REGISTRY_MAX_LOOPS
+
+//--------------------------------------------------------------
+//! Maximum length of the name of a registered loop (truncated).
+//--------------------------------------------------------------
+#ifndef DEFAULT_LOOP_REGISTRY_MAX_NAME
+#define DEFAULT_LOOP_REGISTRY_MAX_NAME 31u
+#endif//DEFAULT_LOOP_REGISTRY_MAX_NAME
+
+//--------------------------------------------------------------
+//! Count of the most recent frames of a registered loop that the
+//! percentile frame times are calculated over.
+//--------------------------------------------------------------
+#ifndef DEFAULT_LOOP_REGISTRY_WINDOW
+#define DEFAULT_LOOP_REGISTRY_WINDOW 128u
+#endif//DEFAULT_LOOP_REGISTRY_WINDOW
+
+//--------------------------------------------------------------
+//! Count of frames between each time a registered loop samples the
+//! cpu time of its thread and recalculates its percentile frame time.
+//--------------------------------------------------------------
+#ifndef DEFAULT_LOOP_REGISTRY_SAMPLE_FRAMES
+#define DEFAULT_LOOP_REGISTRY_SAMPLE_FRAMES 32u
+#endif//DEFAULT_LOOP_REGISTRY_SAMPLE_FRAMES
+
+//--------------------------------------------------------------
+namespace Simple
+{
+
+//--------------------------------------------------------------
+//! The state of a loop in the registry.
+//--------------------------------------------------------------
+enum class LoopState : uint8_t
+{
+    StartingUp,     //!< Running UpdateLoop::StartUp.
+    Running,        //!< Running frames.
+    ShuttingDown    //!< Running UpdateLoop::ShutDown.
+};
+
+//--------------------------------------------------------------
+//! Get the name of a state of a loop in the registry.
+//! @param[in] a_state The state to get the name of.
+//! @return The name of the state.
+//--------------------------------------------------------------
+inline const char* GetLoopStateName(LoopState a_state)
+{
+    switch (a_state)
+    {
+        case LoopState::StartingUp: return "starting_up";
+        case LoopState::Running: return "running";
+        case LoopState::ShuttingDown: return "shutting_down";
+    }
+    return "unknown";
+}
+
+//--------------------------------------------------------------
+//! Snapshot of a loop in the registry, as last published by it.
+//--------------------------------------------------------------
+struct LoopInfo
+{
+    std::string name;
+    uint64_t threadId = 0;      //!< Id of the thread running the loop.
+    uint32_t targetFPS = 0;
+    LoopState state = LoopState::StartingUp;
+    uint64_t frameCount = 0;    //!< Frames since the loop was run.
+    uint64_t lastFrameNs = 0;   //!< Time spent updating the last frame.
+    uint64_t p99FrameNs = 0;    //!< Over the most recent frames.
+    uint64_t cpuNs = 0;         //!< Cpu time of the thread since run.
+};
+
+//--------------------------------------------------------------
+//! Aggregate of all loops in the registry.
+//--------------------------------------------------------------
+struct LoopAggregate
+{
+    uint32_t loopCount = 0;
+    uint64_t totalCpuNs = 0;        //!< Sum of the cpu time of all loops.
+    uint64_t worstP99FrameNs = 0;   //!< Worst p99 frame time of any loop.
+    std::string worstLoopName;      //!< Name of the loop with the worst.
+};
+
+//--------------------------------------------------------------
+//! Process wide registry of the update loops that opt in (through a
+//! LoopRegistration), so that exporters, control servers, and tools
+//! can list every loop in the process and aggregate their stats.
+//!
+//! Each loop joins when it starts up and leaves after it shuts down,
+//! claiming one of a fixed count of slots without locking. It then
+//! publishes its name, thread, rate, state, and frame stats to its
+//! slot with a sequence lock, so reading them from any thread never
+//! blocks the loop, and the loop never blocks on the registry.
+//--------------------------------------------------------------
+class LoopRegistry
+{
+public:
+    static LoopRegistry& Get();
+
+    LoopRegistry(const LoopRegistry&) = delete;
+    LoopRegistry& operator=(const LoopRegistry&) = delete;
+
+    void GetLoops(std::vector<LoopInfo>& o_loops) const;
+    bool GetLoop(const char* a_name, LoopInfo& o_loop) const;
+    LoopAggregate GetAggregate() const;
+    uint32_t GetLoopCount() const;
+
+#if SIMPLE_CONTROL_SERVER_SUPPORTED
+    static void AddCommands(ControlServer& a_server);
+#endif//SIMPLE_CONTROL_SERVER_SUPPORTED
+
+private:
+    friend class LoopRegistration;
+
+    static constexpr uint32_t NameWords =
+        (DEFAULT_LOOP_REGISTRY_MAX_NAME + sizeof(uint64_t)) /
+        sizeof(uint64_t);
+
+    struct Slot
+    {
+        std::atomic<bool> claimed = { false };
+
+        // Sequence lock over the published fields (odd while writing).
+        std::atomic<uint64_t> sequence = { 0 };
+        std::atomic<bool> active = { false };
+        std::atomic<uint64_t> name[NameWords] = {};
+        std::atomic<uint64_t> threadId = { 0 };
+        std::atomic<uint32_t> targetFPS = { 0 };
+        std::atomic<uint8_t> state = { 0 };
+        std::atomic<uint64_t> frameCount = { 0 };
+        std::atomic<uint64_t> lastFrameNs = { 0 };
+        std::atomic<uint64_t> p99FrameNs = { 0 };
+        std::atomic<uint64_t> cpuNs = { 0 };
+    };
+
+    LoopRegistry() = default;
+
+    Slot* Join();
+    static void Leave(Slot* a_slot);
+    static void Publish(Slot* a_slot, const LoopInfo& a_info);
+    static bool Read(const Slot& a_slot, LoopInfo& o_info);
+
+    Slot m_slots[DEFAULT_LOOP_REGISTRY_MAX_LOOPS];
+};
+
+//--------------------------------------------------------------
+//! Registers an update loop in the process wide LoopRegistry while
+//! it is running (from start up until shut down), timing its frames
+//! and publishing its stats each frame from the thread running it.
+//! Its stats are kept across restarts within the same call to Run,
+//! so they always cover every frame since the loop was run.
+//!
+//! It times frames as a listener on the loop, so it must not be
+//! created or destroyed while the loop is running (see
+//! UpdateLoop::Listener).
+//--------------------------------------------------------------
+class LoopRegistration : public UpdateLoop::Listener
+{
+public:
+    LoopRegistration(UpdateLoop& a_loop, const char* a_name);
+    ~LoopRegistration() override;
+
+    LoopRegistration(const LoopRegistration&) = delete;
+    LoopRegistration& operator=(const LoopRegistration&) = delete;
+
+    bool IsRegistered() const;
+    const std::string& GetName() const;
+
+    void OnPhaseBegin(UpdatePhase a_phase) override;
+    void OnPhaseEnded(UpdatePhase a_phase) override;
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    static uint64_t GetThreadId();
+    static uint64_t GetThreadCpuNs();
+
+    void Join();
+    void Leave();
+    void Publish(LoopState a_state);
+    void SampleFrames();
+
+    UpdateLoop& m_loop;
+    const std::string m_name;
+    std::atomic<bool> m_registered = { false };
+
+    // Written only by the thread running the loop.
+    LoopRegistry::Slot* m_slot = nullptr;
+    uint64_t m_runCount = 0;
+    LoopInfo m_info;
+    Clock::time_point m_frameBegin;
+    uint64_t m_cpuBeginNs = 0;
+    uint64_t m_window[DEFAULT_LOOP_REGISTRY_WINDOW] = {};
+    uint64_t m_sorted[DEFAULT_LOOP_REGISTRY_WINDOW] = {};
+};
+
+//--------------------------------------------------------------
+//! Get the registry of the process.
+//! @return The registry of the process.
+//--------------------------------------------------------------
+inline LoopRegistry& LoopRegistry::Get()
+{
+    static LoopRegistry s_registry;
+    return s_registry;
+}
+
+//--------------------------------------------------------------
+//! Get a snapshot of every loop in the registry, from any thread,
+//! without ever blocking the loops (retrying while each is written).
+//! @param[out] o_loops The snapshots of the loops (replaced).
+//--------------------------------------------------------------
+inline void LoopRegistry::GetLoops(std::vector<LoopInfo>& o_loops) const
+{
+    o_loops.clear();
+    LoopInfo info;
+    for (const Slot& slot : m_slots)
+    {
+        if (Read(slot, info))
+        {
+            o_loops.push_back(info);
+        }
+    }
+}
+
+//--------------------------------------------------------------
+//! Get a snapshot of a loop in the registry, from any thread.
+//! @param[in] a_name The name of the loop (the first if duplicated).
+//! @param[out] o_loop The snapshot of the loop (if found).
+//! @return True if the loop was found, false otherwise.
+//--------------------------------------------------------------
+inline bool LoopRegistry::GetLoop(const char* a_name,
+                                  LoopInfo& o_loop) const
+{
+    for (const Slot& slot : m_slots)
+    {
+        if (Read(slot, o_loop) && o_loop.name == a_name)
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+//--------------------------------------------------------------
+//! Get the aggregate of all loops in the registry, from any thread.
+//! @return The aggregate of all loops in the registry.
+//--------------------------------------------------------------
+inline LoopAggregate LoopRegistry::GetAggregate() const
+{
+    LoopAggregate aggregate;
+    LoopInfo info;
+    for (const Slot& slot : m_slots)
+    {
+        if (Read(slot, info))
+        {
+            ++aggregate.loopCount;
+            aggregate.totalCpuNs += info.cpuNs;
+            if (aggregate.worstLoopName.empty() ||
+                info.p99FrameNs > aggregate.worstP99FrameNs)
+            {
+                aggregate.worstP99FrameNs = info.p99FrameNs;
+                aggregate.worstLoopName = info.name;
+            }
+        }
+    }
+    return aggregate;
+}
+
+//--------------------------------------------------------------
+//! Get the count of loops in the registry, from any thread.
+//! @return The count of loops in the registry.
+//--------------------------------------------------------------
+inline uint32_t LoopRegistry::GetLoopCount() const
+{
+    uint32_t count = 0;
+    for (const Slot& slot : m_slots)
+    {
+        count += slot.claimed.load(std::memory_order_acquire) ? 1 : 0;
+    }
+    return count;
+}
+
+#if SIMPLE_CONTROL_SERVER_SUPPORTED
+//--------------------------------------------------------------
+//! Add the commands of the registry to a control server: 'loops' to
+//! get the aggregate of all loops, and 'loop <name>' to get one loop.
+//! Must not be called while the server is running.
+//! @param[in] a_server The control server to add the commands to.
+//--------------------------------------------------------------
+inline void LoopRegistry::AddCommands(ControlServer& a_server)
+{
+    a_server.AddCommand("loops", "Get the aggregate of all loops.",
+                        [](const char*, std::string& o_reply)
+    {
+        const LoopAggregate aggregate = Get().GetAggregate();
+        char reply[256];
+        snprintf(reply, sizeof(reply),
+                 "ok count %u cpu_ms %llu worst_p99_us %llu worst %s",
+                 aggregate.loopCount,
+                 (unsigned long long)(aggregate.totalCpuNs / 1000000),
+                 (unsigned long long)(aggregate.worstP99FrameNs / 1000),
+                 aggregate.worstLoopName.empty() ?
+                     "-" : aggregate.worstLoopName.c_str());
+        o_reply = reply;
+    });
+    a_server.AddCommand("loop", "<name> Get the stats of a loop.",
+                        [](const char* a_args, std::string& o_reply)
+    {
+        LoopInfo info;
+        if (!Get().GetLoop(a_args, info))
+        {
+            o_reply = std::string("error unknown loop '") + a_args + "'";
+            return;
+        }
+        char reply[256];
+        snprintf(reply, sizeof(reply),
+                 "ok name %s thread %llu state %s target_fps %u "
+                 "frames %llu last_frame_us %llu p99_us %llu cpu_ms %llu",
+                 info.name.c_str(),
+                 (unsigned long long)info.threadId,
+                 GetLoopStateName(info.state),
+                 info.targetFPS,
+                 (unsigned long long)info.frameCount,
+                 (unsigned long long)(info.lastFrameNs / 1000),
+                 (unsigned long long)(info.p99FrameNs / 1000),
+                 (unsigned long long)(info.cpuNs / 1000000));
+        o_reply = reply;
+    });
+}
+#endif//SIMPLE_CONTROL_SERVER_SUPPORTED
+
+//--------------------------------------------------------------
+inline LoopRegistry::Slot* LoopRegistry::Join()
+{
+    for (Slot& slot : m_slots)
+    {
+        bool claimed = false;
+        if (slot.claimed.compare_exchange_strong(claimed, true,
+                                                 std::memory_order_acq_rel))
+        {
+            return &slot;
+        }
+    }
+    return nullptr;
+}
+
+//--------------------------------------------------------------
+inline void LoopRegistry::Leave(Slot* a_slot)
+{
+    const uint64_t sequence = a_slot->sequence.load(
+        std::memory_order_relaxed);
+    a_slot->sequence.store(sequence + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    a_slot->active.store(false, std::memory_order_relaxed);
+    a_slot->sequence.store(sequence + 2, std::memory_order_release);
+    a_slot->claimed.store(false, std::memory_order_release);
+}
+
+//--------------------------------------------------------------
+inline void LoopRegistry::Publish(Slot* a_slot, const LoopInfo& a_info)
+{
+    uint64_t name[NameWords] = {};
+    memcpy(name, a_info.name.c_str(),
+           std::min<size_t>(a_info.name.size(),
+                            DEFAULT_LOOP_REGISTRY_MAX_NAME));
+
+    const uint64_t sequence = a_slot->sequence.load(
+        std::memory_order_relaxed);
+    a_slot->sequence.store(sequence + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    a_slot->active.store(true, std::memory_order_relaxed);
+    for (uint32_t i = 0; i < NameWords; ++i)
+    {
+        a_slot->name[i].store(name[i], std::memory_order_relaxed);
+    }
+    a_slot->threadId.store(a_info.threadId, std::memory_order_relaxed);
+    a_slot->targetFPS.store(a_info.targetFPS, std::memory_order_relaxed);
+    a_slot->state.store((uint8_t)a_info.state, std::memory_order_relaxed);
+    a_slot->frameCount.store(a_info.frameCount, std::memory_order_relaxed);
+    a_slot->lastFrameNs.store(a_info.lastFrameNs,
+                              std::memory_order_relaxed);
+    a_slot->p99FrameNs.store(a_info.p99FrameNs, std::memory_order_relaxed);
+    a_slot->cpuNs.store(a_info.cpuNs, std::memory_order_relaxed);
+    a_slot->sequence.store(sequence + 2, std::memory_order_release);
+}
+
+//--------------------------------------------------------------
+inline bool LoopRegistry::Read(const Slot& a_slot, LoopInfo& o_info)
+{
+    uint64_t name[NameWords + 1] = {};
+    bool active = false;
+    uint64_t sequence = 0;
+    do
+    {
+        sequence = a_slot.sequence.load(std::memory_order_acquire);
+        if (sequence & 1)
+        {
+            std::this_thread::yield();
+            continue;
+        }
+        active = a_slot.active.load(std::memory_order_relaxed);
+        for (uint32_t i = 0; i < NameWords; ++i)
+        {
+            name[i] = a_slot.name[i].load(std::memory_order_relaxed);
+        }
+        o_info.threadId = a_slot.threadId.load(std::memory_order_relaxed);
+        o_info.targetFPS = a_slot.targetFPS.load(std::memory_order_relaxed);
+        o_info.state = (LoopState)a_slot.state.load(
+            std::memory_order_relaxed);
+        o_info.frameCount = a_slot.frameCount.load(
+            std::memory_order_relaxed);
+        o_info.lastFrameNs = a_slot.lastFrameNs.load(
+            std::memory_order_relaxed);
+        o_info.p99FrameNs = a_slot.p99FrameNs.load(
+            std::memory_order_relaxed);
+        o_info.cpuNs = a_slot.cpuNs.load(std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_acquire);
+    }
+    while ((sequence & 1) ||
+           a_slot.sequence.load(std::memory_order_relaxed) != sequence);
+
+    if (active)
+    {
+        o_info.name = (const char*)name;
+    }
+    return active;
+}
+
+//--------------------------------------------------------------
+//! Constructor. The loop is not registered until it starts up.
+//! @param[in] a_loop The loop to register (and listen to).
+//! @param[in] a_name The name of the loop in the registry.
+//--------------------------------------------------------------
+inline LoopRegistration::LoopRegistration(UpdateLoop& a_loop,
+                                          const char* a_name)
+    : m_loop(a_loop)
+    , m_name(a_name, strnlen(a_name, DEFAULT_LOOP_REGISTRY_MAX_NAME))
+{
+    m_loop.AddListener(this);
+}
+
+//--------------------------------------------------------------
+//! Destructor. Leaves the registry if the loop did not shut down.
+//--------------------------------------------------------------
+inline LoopRegistration::~LoopRegistration()
+{
+    Leave();
+    m_loop.RemoveListener(this);
+}
+
+//--------------------------------------------------------------
+//! Get whether the loop is currently registered (from any thread).
+//! @return True if the loop is registered, false otherwise.
+//--------------------------------------------------------------
+inline bool LoopRegistration::IsRegistered() const
+{
+    return m_registered.load(std::memory_order_acquire);
+}
+
+//--------------------------------------------------------------
+//! Get the name of the loop in the registry.
+//! @return The name of the loop in the registry.
+//--------------------------------------------------------------
+inline const std::string& LoopRegistration::GetName() const
+{
+    return m_name;
+}
+
+//--------------------------------------------------------------
+//! Joins the registry when the loop starts up, publishes its state
+//! when it shuts down, and times each frame as it starts.
+//! @param[in] a_phase The phase of the loop that is about to begin.
+//--------------------------------------------------------------
+inline void LoopRegistration::OnPhaseBegin(UpdatePhase a_phase)
+{
+    if (a_phase == UpdatePhase::StartUp)
+    {
+        Join();
+    }
+    else if (a_phase == UpdatePhase::Start)
+    {
+        m_frameBegin = Clock::now();
+    }
+    else if (a_phase == UpdatePhase::ShutDown)
+    {
+        m_info.cpuNs = GetThreadCpuNs() - m_cpuBeginNs;
+        Publish(LoopState::ShuttingDown);
+    }
+}
+
+//--------------------------------------------------------------
+//! Publishes the stats of each frame as it ends, and leaves the
+//! registry after the loop shuts down.
+//! @param[in] a_phase The phase of the loop that has just ended.
+//--------------------------------------------------------------
+inline void LoopRegistration::OnPhaseEnded(UpdatePhase a_phase)
+{
+    if (a_phase == UpdatePhase::StartUp)
+    {
+        Publish(LoopState::Running);
+    }
+    else if (a_phase == UpdatePhase::Ended)
+    {
+        m_info.lastFrameNs = (uint64_t)
+            std::chrono::duration_cast<std::chrono::nanoseconds>(
+                Clock::now() - m_frameBegin).count();
+        m_window[m_info.frameCount % DEFAULT_LOOP_REGISTRY_WINDOW] =
+            m_info.lastFrameNs;
+        ++m_info.frameCount;
+        if (m_info.frameCount % DEFAULT_LOOP_REGISTRY_SAMPLE_FRAMES == 0)
+        {
+            SampleFrames();
+        }
+        Publish(LoopState::Running);
+    }
+    else if (a_phase == UpdatePhase::ShutDown)
+    {
+        Leave();
+    }
+}
+
+//--------------------------------------------------------------
+inline uint64_t LoopRegistration::GetThreadId()
+{
+#if defined(__linux__)
+    return (uint64_t)syscall(SYS_gettid);
+#else
+    return (uint64_t)std::hash<std::thread::id>()(
+        std::this_thread::get_id());
+#endif
+}
+
+//--------------------------------------------------------------
+inline uint64_t LoopRegistration::GetThreadCpuNs()
+{
+#if SIMPLE_LOOP_REGISTRY_THREAD_CPU
+    timespec time;
+    if (clock_gettime(CLOCK_THREAD_CPUTIME_ID, &time) == 0)
+    {
+        return (uint64_t)time.tv_sec * 1000000000ull +
+               (uint64_t)time.tv_nsec;
+    }
+#endif//SIMPLE_LOOP_REGISTRY_THREAD_CPU
+    return 0;
+}
+
+//--------------------------------------------------------------
+inline void LoopRegistration::Join()
+{
+    if (m_slot)
+    {
+        return;
+    }
+    m_slot = LoopRegistry::Get().Join();
+    if (!m_slot)
+    {
+        printf("LoopRegistration: registry full, '%s' not registered\n",
+               m_name.c_str());
+        return;
+    }
+
+    // Starting up again within the same run is a restart, so carry
+    // on with the stats (and thread cpu time) of the run so far.
+    const uint64_t runCount = m_loop.GetRunCount();
+    if (runCount != m_runCount)
+    {
+        m_runCount = runCount;
+        m_info = LoopInfo();
+        m_info.name = m_name;
+        m_info.threadId = GetThreadId();
+        m_cpuBeginNs = GetThreadCpuNs();
+    }
+    Publish(LoopState::StartingUp);
+    m_registered.store(true, std::memory_order_release);
+}
+
+//--------------------------------------------------------------
+inline void LoopRegistration::Leave()
+{
+    if (m_slot)
+    {
+        m_registered.store(false, std::memory_order_release);
+        LoopRegistry::Leave(m_slot);
+        m_slot = nullptr;
+    }
+}
+
+//--------------------------------------------------------------
+inline void LoopRegistration::Publish(LoopState a_state)
+{
+    if (m_slot)
+    {
+        m_info.state = a_state;
+        m_info.targetFPS = m_loop.GetTargetFPS();
+        LoopRegistry::Publish(m_slot, m_info);
+    }
+}
+
+//--------------------------------------------------------------
+inline void LoopRegistration::SampleFrames()
+{
+    // Amortised over the sample frames, so the loop only pays for a
+    // partial sort of the window (and a clock read) every so often.
+    const size_t count = (size_t)std::min<uint64_t>(
+        m_info.frameCount, DEFAULT_LOOP_REGISTRY_WINDOW);
+    std::copy(m_window, m_window + count, m_sorted);
+    const size_t index = (count * 99 + 99) / 100 - 1;
+    std::nth_element(m_sorted, m_sorted + index, m_sorted + count);
+    m_info.p99FrameNs = m_sorted[index];
+    m_info.cpuNs = GetThreadCpuNs() - m_cpuBeginNs;
+}
+
+} // namespace Simple
@@ -0,0 +1,600 @@
+//--------------------------------------------------------------
+// Copyright (c) David Bosnich <david.bosnich.public@gmail.com>
+//
+// This code is licensed under the MIT License, a copy of which
+// can be found in the license.txt file included at the root of
+// this distribution, or at https://opensource.org/licenses/MIT
+//--------------------------------------------------------------
+
+#pragma once
+
+#include "update_loop.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#define SIMPLE_PERSISTENT_ARENA_SUPPORTED 1
+#endif
+
+//! @file
+
+//--------------------------------------------------------------
+//! Default frames between each checkpoint of a PersistentArena.
+//--------------------------------------------------------------
+#ifndef DEFAULT_PERSISTENT_ARENA_CHECKPOINT_INTERVAL
+#define DEFAULT_PERSISTENT_ARENA_CHECKPOINT_INTERVAL 60u
+#endif
+
+//--------------------------------------------------------------
+//! Size (bytes) of each chunk of a PersistentArena that is given its
+//! own checksum, so that checkpoints only rehash the changed chunks.
+//--------------------------------------------------------------
+#ifndef DEFAULT_PERSISTENT_ARENA_CHUNK_BYTES
+#define DEFAULT_PERSISTENT_ARENA_CHUNK_BYTES (64u * 1024u)
+#endif
+
+//--------------------------------------------------------------
+namespace Simple
+{
+
+//--------------------------------------------------------------
+//! A pointer stored as an offset from itself, so it stays valid when
+//! the memory holding both it and what it points to is mapped at a
+//! different address (eg. by another process, or after a restart).
+//! Must only point within the same mapping (or be null).
+//--------------------------------------------------------------
+template<class T>
+class OffsetPtr
+{
+public:
+    OffsetPtr() = default;
+    OffsetPtr(T* a_pointer) { Set(a_pointer); }
+    OffsetPtr(const OffsetPtr& a_other) { Set(a_other.Get()); }
+
+    OffsetPtr& operator=(T* a_pointer) { Set(a_pointer); return *this; }
+    OffsetPtr& operator=(const OffsetPtr& a_other)
+    {
+        Set(a_other.Get());
+        return *this;
+    }
+
+    T* Get() const
+    {
+        // An offset of zero (ie. pointing to itself) represents null.
+        return m_offset ? reinterpret_cast<T*>(
+            reinterpret_cast<intptr_t>(this) + m_offset) : nullptr;
+    }
+
+    T* operator->() const { return Get(); }
+    T& operator*() const { return *Get(); }
+    T& operator[](size_t a_index) const { return Get()[a_index]; }
+    explicit operator bool() const { return m_offset != 0; }
+
+private:
+    void Set(T* a_pointer)
+    {
+        m_offset = a_pointer ? reinterpret_cast<intptr_t>(a_pointer) -
+                               reinterpret_cast<intptr_t>(this) : 0;
+    }
+
+    intptr_t m_offset = 0;
+};
+
+#if SIMPLE_PERSISTENT_ARENA_SUPPORTED
+//--------------------------------------------------------------
+//! An arena allocator backed by a memory mapped file (POSIX only),
+//! so that what is allocated in it (eg. large indices) survives the
+//! process exiting and can be attached to again at StartUp instead
+//! of being rebuilt. Objects allocated in it must only point to each
+//! other with OffsetPtr, must be trivially destructible (they are
+//! never destroyed), and must not have virtual functions.
+//!
+//! The arena is checkpointed at the end of every N frames, and when
+//! the loop shuts down, by storing a checksum of each chunk of its
+//! contents. If they changed after the last checkpoint (ie. the
+//! process exited without reaching another one), or were written with
+//! a different layout version, they are rejected when opened and the
+//! arena is reset to be rebuilt. The time taken to attach (including
+//! verifying every checksum) is measured to compare with rebuilding.
+//!
+//! Checkpoints are incremental, only rehashing the chunks allocated
+//! from or marked as changed since the last one, so they stay cheap
+//! however large the arena is. Objects changed after being allocated
+//! must therefore be marked with MarkChanged before the checkpoint,
+//! or the contents are rejected (and rebuilt) when next opened.
+//!
+//! Checkpoints are taken by a listener on the loop, so the arena
+//! must not be created or destroyed while the loop is running (see
+//! UpdateLoop::Listener).
+//--------------------------------------------------------------
+class PersistentArena : public UpdateLoop::Listener
+{
+public:
+    using Clock = std::chrono::steady_clock;
+
+    explicit PersistentArena(UpdateLoop& a_loop);
+    ~PersistentArena() override;
+
+    PersistentArena(const PersistentArena&) = delete;
+    PersistentArena& operator=(const PersistentArena&) = delete;
+
+    bool Open(const char* a_path, size_t a_capacity,
+              uint32_t a_layoutVersion);
+    void Close();
+    void Reset();
+    void Checkpoint();
+    void SetCheckpointInterval(uint32_t a_frames);
+    void MarkChanged(const void* a_address, size_t a_bytes);
+
+    void* Allocate(size_t a_bytes,
+                   size_t a_alignment = alignof(std::max_align_t));
+    template<class T, class... Args>
+    T* New(Args&&... a_args);
+
+    template<class T>
+    T* GetRoot() const;
+    template<class T>
+    void SetRoot(T* a_root);
+
+    bool IsOpen() const;
+    bool IsAttached() const;
+    size_t GetCapacity() const;
+    size_t GetUsed() const;
+    uint64_t GetCheckpointCount() const;
+    Clock::duration GetAttachDuration() const;
+    Clock::duration GetCheckpointDuration() const;
+
+    void OnPhaseEnded(UpdatePhase a_phase) override;
+
+private:
+    struct Header
+    {
+        static constexpr uint32_t Magic = 0x4150524Eu; // 'NRPA'
+        static constexpr uint32_t Version = 2u;
+
+        uint32_t magic;
+        uint32_t version;
+        uint32_t layoutVersion;
+        uint32_t padding;
+        uint64_t capacity;
+        uint64_t used;
+        OffsetPtr<char> root;
+        uint64_t checkpointCount;
+        uint64_t checksum;
+    };
+
+    static uint64_t Hash(uint64_t a_hash, const char* a_bytes,
+                         size_t a_count);
+
+    size_t GetChunkCount(uint64_t a_used) const;
+    uint64_t ComputeChunkChecksum(size_t a_chunk) const;
+    uint64_t ComputeChecksum() const;
+    void MarkChunks(size_t a_begin, size_t a_end);
+
+    UpdateLoop& m_loop;
+    Header* m_header = nullptr;
+    char* m_data = nullptr;
+    uint64_t* m_chunkChecksums = nullptr;
+    size_t m_mappedBytes = 0;
+    std::vector<uint8_t> m_dirtyChunks;
+    uint32_t m_checkpointInterval =
+        DEFAULT_PERSISTENT_ARENA_CHECKPOINT_INTERVAL;
+    uint32_t m_frameCount = 0;
+    bool m_attached = false;
+    Clock::duration m_attachDuration = Clock::duration::zero();
+    Clock::duration m_checkpointDuration = Clock::duration::zero();
+};
+
+//--------------------------------------------------------------
+//! Constructor. Does not map any memory until it is opened.
+//! @param[in] a_loop The loop to checkpoint at the end of frames of.
+//--------------------------------------------------------------
+inline PersistentArena::PersistentArena(UpdateLoop& a_loop)
+    : m_loop(a_loop)
+{
+    m_loop.AddListener(this);
+}
+
+//--------------------------------------------------------------
+//! Destructor. Checkpoints and closes the arena (if open).
+//--------------------------------------------------------------
+inline PersistentArena::~PersistentArena()
+{
+    Close();
+    m_loop.RemoveListener(this);
+}
+
+//--------------------------------------------------------------
+//! Open (creating if needed) the file backing the arena, and attach
+//! to its contents if they are verified, or reset it otherwise.
+//! @param[in] a_path The path of the file backing the arena.
+//! @param[in] a_capacity Capacity (bytes) of the arena.
+//! @param[in] a_layoutVersion Version of the layout of the objects
+//!            allocated (contents of other versions are rejected).
+//! @return True if opened (see IsAttached), false otherwise (printed).
+//--------------------------------------------------------------
+inline bool PersistentArena::Open(const char* a_path, size_t a_capacity,
+                                  uint32_t a_layoutVersion)
+{
+    Close();
+
+    const Clock::time_point begin = Clock::now();
+    const int fd = open(a_path, O_CREAT | O_RDWR, 0600);
+    if (fd < 0)
+    {
+        printf("PersistentArena failed to open '%s'.\n", a_path);
+        return false;
+    }
+
+    // The checksum of each chunk is stored after the contents.
+    const size_t chunkCount = (a_capacity +
+        DEFAULT_PERSISTENT_ARENA_CHUNK_BYTES - 1) /
+        DEFAULT_PERSISTENT_ARENA_CHUNK_BYTES;
+    const size_t checksumOffset = (sizeof(Header) + a_capacity +
+        alignof(uint64_t) - 1) & ~(alignof(uint64_t) - 1);
+    struct stat fileStat;
+    const size_t bytes = checksumOffset + chunkCount * sizeof(uint64_t);
+    const bool sized = (fstat(fd, &fileStat) == 0) &&
+                       ((size_t)fileStat.st_size == bytes ||
+                        ftruncate(fd, (off_t)bytes) == 0);
+    void* memory = sized ? mmap(nullptr, bytes, PROT_READ | PROT_WRITE,
+                                MAP_SHARED, fd, 0)
+                         : MAP_FAILED;
+    close(fd);
+    if (memory == MAP_FAILED)
+    {
+        printf("PersistentArena failed to map '%s'.\n", a_path);
+        return false;
+    }
+    m_header = static_cast<Header*>(memory);
+    m_data = static_cast<char*>(memory) + sizeof(Header);
+    m_chunkChecksums = reinterpret_cast<uint64_t*>(
+        static_cast<char*>(memory) + checksumOffset);
+    m_mappedBytes = bytes;
+    m_dirtyChunks.assign(chunkCount, 0);
+
+    // Attach to the contents only if they are exactly as they were
+    // at the last checkpoint, and were written with the same layout.
+    m_attached = m_header->magic == Header::Magic &&
+                 m_header->version == Header::Version &&
+                 m_header->layoutVersion == a_layoutVersion &&
+                 m_header->capacity == a_capacity &&
+                 m_header->used <= a_capacity &&
+                 m_header->checksum == ComputeChecksum();
+    for (size_t i = 0; m_attached && i < GetChunkCount(m_header->used); ++i)
+    {
+        m_attached = m_chunkChecksums[i] == ComputeChunkChecksum(i);
+    }
+    if (!m_attached)
+    {
+        m_header->magic = Header::Magic;
+        m_header->version = Header::Version;
+        m_header->layoutVersion = a_layoutVersion;
+        m_header->capacity = a_capacity;
+        m_header->checkpointCount = 0;
+        Reset();
+    }
+    m_attachDuration = Clock::now() - begin;
+    m_frameCount = 0;
+    return true;
+}
+
+//--------------------------------------------------------------
+//! Checkpoint and close the arena (if open), unmapping its memory.
+//--------------------------------------------------------------
+inline void PersistentArena::Close()
+{
+    if (m_header)
+    {
+        Checkpoint();
+        munmap(m_header, m_mappedBytes);
+    }
+    m_header = nullptr;
+    m_data = nullptr;
+    m_chunkChecksums = nullptr;
+    m_mappedBytes = 0;
+    m_dirtyChunks.clear();
+    m_attached = false;
+}
+
+//--------------------------------------------------------------
+//! Reset the arena to empty, eg. to rebuild its contents.
+//--------------------------------------------------------------
+inline void PersistentArena::Reset()
+{
+    if (m_header)
+    {
+        m_header->used = 0;
+        m_header->root = nullptr;
+        m_header->checksum = ~ComputeChecksum();
+        std::fill(m_dirtyChunks.begin(), m_dirtyChunks.end(), 0);
+    }
+}
+
+//--------------------------------------------------------------
+//! Checkpoint the contents now, so that they will be attached to if
+//! opened again without being changed. Called automatically at the
+//! end of every N frames, and when the loop shuts down. Only rehashes
+//! the chunks allocated from, or marked as changed, since the last.
+//--------------------------------------------------------------
+inline void PersistentArena::Checkpoint()
+{
+    if (!m_header)
+    {
+        return;
+    }
+
+    const Clock::time_point begin = Clock::now();
+    const size_t chunkCount = GetChunkCount(m_header->used);
+    for (size_t i = 0; i < chunkCount; ++i)
+    {
+        if (m_dirtyChunks[i])
+        {
+            m_chunkChecksums[i] = ComputeChunkChecksum(i);
+            m_dirtyChunks[i] = 0;
+        }
+    }
+    ++m_header->checkpointCount;
+    m_header->checksum = ComputeChecksum();
+    msync(m_header, m_mappedBytes, MS_ASYNC);
+    m_checkpointDuration = Clock::now() - begin;
+}
+
+//--------------------------------------------------------------
+//! Set the frames between each checkpoint.
+//! @param[in] a_frames Frames between each checkpoint (zero to only
+//!            checkpoint when the loop shuts down, or explicitly).
+//--------------------------------------------------------------
+inline void PersistentArena::SetCheckpointInterval(uint32_t a_frames)
+{
+    m_checkpointInterval = a_frames;
+}
+
+//--------------------------------------------------------------
+//! Mark memory in the arena as changed, so that it is rehashed by the
+//! next checkpoint. Must be called for every object changed after it
+//! was allocated (those allocated since the last are always rehashed).
+//! @param[in] a_address The address of the memory changed.
+//! @param[in] a_bytes The bytes changed.
+//--------------------------------------------------------------
+inline void PersistentArena::MarkChanged(const void* a_address,
+                                         size_t a_bytes)
+{
+    const char* address = static_cast<const char*>(a_address);
+    if (m_header && address >= m_data &&
+        address + a_bytes <= m_data + m_header->capacity)
+    {
+        const size_t begin = (size_t)(address - m_data);
+        MarkChunks(begin, begin + a_bytes);
+    }
+}
+
+//--------------------------------------------------------------
+//! Allocate memory from the arena (never freed, until it is reset).
+//! @param[in] a_bytes The bytes to allocate.
+//! @param[in] a_alignment The alignment (a power of two).
+//! @return The memory allocated, or null if full (printed).
+//--------------------------------------------------------------
+inline void* PersistentArena::Allocate(size_t a_bytes, size_t a_alignment)
+{
+    if (!m_header)
+    {
+        return nullptr;
+    }
+
+    // Align relative to the mapping, which is page aligned.
+    const size_t offset = (sizeof(Header) + m_header->used +
+                           a_alignment - 1) & ~(a_alignment - 1);
+    if (offset + a_bytes > sizeof(Header) + m_header->capacity)
+    {
+        printf("PersistentArena::Allocate: %zu bytes exceeds capacity\n",
+               a_bytes);
+        return nullptr;
+    }
+    MarkChunks((size_t)m_header->used, offset + a_bytes - sizeof(Header));
+    m_header->used = offset + a_bytes - sizeof(Header);
+    return reinterpret_cast<char*>(m_header) + offset;
+}
+
+//--------------------------------------------------------------
+//! Allocate and construct an object in the arena.
+//! @param[in] a_args Arguments to construct the object with.
+//! @return The object allocated, or null if full (printed).
+//--------------------------------------------------------------
+template<class T, class... Args>
+inline T* PersistentArena::New(Args&&... a_args)
+{
+    static_assert(std::is_trivially_destructible<T>::value &&
+                  !std::is_polymorphic<T>::value,
+                  "Objects in a PersistentArena are never destroyed, and "
+                  "must not point to code of the process that created them.");
+    void* memory = Allocate(sizeof(T), alignof(T));
+    return memory ? new (memory) T(std::forward<Args>(a_args)...)
+                  : nullptr;
+}
+
+//--------------------------------------------------------------
+//! Get the root object, from which all others are reachable.
+//! @return The root object (null if not set).
+//--------------------------------------------------------------
+template<class T>
+inline T* PersistentArena::GetRoot() const
+{
+    return m_header ? reinterpret_cast<T*>(m_header->root.Get()) : nullptr;
+}
+
+//--------------------------------------------------------------
+//! Set the root object, from which all others are reachable.
+//! @param[in] a_root The root object (allocated in the arena).
+//--------------------------------------------------------------
+template<class T>
+inline void PersistentArena::SetRoot(T* a_root)
+{
+    if (m_header)
+    {
+        m_header->root = reinterpret_cast<char*>(a_root);
+    }
+}
+
+//--------------------------------------------------------------
+//! Check whether the arena is open.
+//! @return True if the arena is open.
+//--------------------------------------------------------------
+inline bool PersistentArena::IsOpen() const
+{
+    return m_header != nullptr;
+}
+
+//--------------------------------------------------------------
+//! Check whether the arena attached to existing contents when opened
+//! (or was reset, and so must be rebuilt).
+//! @return True if attached to existing contents.
+//--------------------------------------------------------------
+inline bool PersistentArena::IsAttached() const
+{
+    return m_attached;
+}
+
+//--------------------------------------------------------------
+//! Get the capacity of the arena.
+//! @return The capacity (bytes) of the arena.
+//--------------------------------------------------------------
+inline size_t PersistentArena::GetCapacity() const
+{
+    return m_header ? (size_t)m_header->capacity : 0;
+}
+
+//--------------------------------------------------------------
+//! Get the bytes allocated from the arena.
+//! @return The bytes allocated from the arena (incl. alignment).
+//--------------------------------------------------------------
+inline size_t PersistentArena::GetUsed() const
+{
+    return m_header ? (size_t)m_header->used : 0;
+}
+
+//--------------------------------------------------------------
+//! Get the checkpoints since the contents were last reset.
+//! @return The checkpoints since the contents were last reset.
+//--------------------------------------------------------------
+inline uint64_t PersistentArena::GetCheckpointCount() const
+{
+    return m_header ? m_header->checkpointCount : 0;
+}
+
+//--------------------------------------------------------------
+//! Get the time taken to open the arena (mapping the file, and then
+//! verifying its contents), eg. to compare with rebuilding them.
+//! @return The time taken to open the arena.
+//--------------------------------------------------------------
+inline PersistentArena::Clock::duration
+PersistentArena::GetAttachDuration() const
+{
+    return m_attachDuration;
+}
+
+//--------------------------------------------------------------
+//! Get the time taken by the last checkpoint.
+//! @return The time taken by the last checkpoint.
+//--------------------------------------------------------------
+inline PersistentArena::Clock::duration
+PersistentArena::GetCheckpointDuration() const
+{
+    return m_checkpointDuration;
+}
+
+//--------------------------------------------------------------
+//! Checkpoints at the end of every N frames, and at shut down.
+//! @param[in] a_phase The phase of the loop that has just ended.
+//--------------------------------------------------------------
+inline void PersistentArena::OnPhaseEnded(UpdatePhase a_phase)
+{
+    if (a_phase == UpdatePhase::Ended && m_checkpointInterval &&
+        ++m_frameCount >= m_checkpointInterval)
+    {
+        m_frameCount = 0;
+        Checkpoint();
+    }
+    else if (a_phase == UpdatePhase::ShutDown)
+    {
+        Checkpoint();
+    }
+}
+
+//--------------------------------------------------------------
+inline uint64_t PersistentArena::Hash(uint64_t a_hash,
+                                      const char* a_bytes,
+                                      size_t a_count)
+{
+    // FNV-1a, a word at a time so large arenas are verified quickly.
+    size_t i = 0;
+    for (; i + sizeof(uint64_t) <= a_count; i += sizeof(uint64_t))
+    {
+        uint64_t word;
+        memcpy(&word, a_bytes + i, sizeof(word));
+        a_hash = (a_hash ^ word) * 1099511628211ull;
+    }
+    for (; i < a_count; ++i)
+    {
+        a_hash = (a_hash ^ (unsigned char)a_bytes[i]) * 1099511628211ull;
+    }
+    return a_hash;
+}
+
+//--------------------------------------------------------------
+inline size_t PersistentArena::GetChunkCount(uint64_t a_used) const
+{
+    return (size_t)std::min<uint64_t>(
+        (a_used + DEFAULT_PERSISTENT_ARENA_CHUNK_BYTES - 1) /
+        DEFAULT_PERSISTENT_ARENA_CHUNK_BYTES, m_dirtyChunks.size());
+}
+
+//--------------------------------------------------------------
+inline uint64_t PersistentArena::ComputeChunkChecksum(size_t a_chunk) const
+{
+    // Only the part of the last chunk that is used is hashed.
+    const size_t begin = a_chunk * DEFAULT_PERSISTENT_ARENA_CHUNK_BYTES;
+    const size_t end = (size_t)std::min<uint64_t>(
+        begin + DEFAULT_PERSISTENT_ARENA_CHUNK_BYTES, m_header->used);
+    return Hash(14695981039346656037ull, m_data + begin, end - begin);
+}
+
+//--------------------------------------------------------------
+inline uint64_t PersistentArena::ComputeChecksum() const
+{
+    // The header (up to the checksum) and the checksum of each chunk.
+    const size_t chunkCount = GetChunkCount(m_header->used);
+    uint64_t hash = Hash(14695981039346656037ull,
+                         reinterpret_cast<const char*>(m_header),
+                         offsetof(Header, checksum));
+    return Hash(hash, reinterpret_cast<const char*>(m_chunkChecksums),
+                chunkCount * sizeof(uint64_t));
+}
+
+//--------------------------------------------------------------
+inline void PersistentArena::MarkChunks(size_t a_begin, size_t a_end)
+{
+    const size_t chunkBytes = DEFAULT_PERSISTENT_ARENA_CHUNK_BYTES;
+    const size_t last = std::min((a_end + chunkBytes - 1) / chunkBytes,
+                                 m_dirtyChunks.size());
+    for (size_t i = a_begin / chunkBytes; i < last; ++i)
+    {
+        m_dirtyChunks[i] = 1;
+    }
+}
+#endif//SIMPLE_PERSISTENT_ARENA_SUPPORTED
+
+} // namespace Simple
@@ -0,0 +1,421 @@
+//--------------------------------------------------------------
+// Copyright (c) David Bosnich <david.bosnich.public@gmail.com>
+//
+// This code is licensed under the MIT License, a copy of which
+// can be found in the license.txt file included at the root of
+// this distribution, or at https://opensource.org/licenses/MIT
+//--------------------------------------------------------------
+
+#pragma once
+
+#include "update_loop.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <dlfcn.h>
+#include <unistd.h>
+#define SIMPLE_PLUGIN_HOST_SUPPORTED 1
+#endif
+
+//! @file
+
+//--------------------------------------------------------------
+//! Version of the PluginApi struct. Plugins built against another
+//! version are rejected, so it must change whenever the struct does.
+//--------------------------------------------------------------
+#define SIMPLE_PLUGIN_ABI_VERSION 1u
+
+//--------------------------------------------------------------
+//! Name of the function each plugin must export, returning its api.
+//! eg. SIMPLE_PLUGIN_EXPORT const Simple::PluginApi*
+//!     SimpleGetPluginApi() { static const Simple::PluginApi s_api =
+//!     { SIMPLE_PLUGIN_ABI_VERSION, ... }; return &s_api; }
+//--------------------------------------------------------------
+#define SIMPLE_PLUGIN_ENTRY_POINT "SimpleGetPluginApi"
+
+//--------------------------------------------------------------
+//! Declaration specifiers for the entry point of each plugin.
+//--------------------------------------------------------------
+#define SIMPLE_PLUGIN_EXPORT \
+    extern "C" __attribute__((visibility("default")))
+
+//--------------------------------------------------------------
+namespace Simple
+{
+
+//--------------------------------------------------------------
+//! Functions exported by a plugin (a shared object) through its
+//! entry point, with only C types so they can be called across
+//! builds. The plugin owns its state, which the host migrates to
+//! each new version loaded by saving it to bytes with the old one
+//! and loading it (given the old state version) with the new one.
+//--------------------------------------------------------------
+struct PluginApi
+{
+    uint32_t abiVersion;    //!< SIMPLE_PLUGIN_ABI_VERSION.
+    uint32_t stateVersion;  //!< Version of the saved state's layout.
+
+    //! Create a new state (when no state is being migrated).
+    void* (*create)();
+
+    //! Destroy a state created or loaded by this plugin.
+    void (*destroy)(void* a_state);
+
+    //! Save a state to a buffer, returning the bytes required (which
+    //! must be saved again if more than the capacity of the buffer).
+    size_t (*save)(const void* a_state, void* o_buffer, size_t a_capacity);
+
+    //! Load a state saved by a plugin with the given state version,
+    //! returning null if it cannot be migrated (to roll back).
+    void* (*load)(const void* a_buffer, size_t a_size, uint32_t a_version);
+
+    void (*updateStart)(void* a_state, float a_deltaTimeSeconds);
+    void (*updateFixed)(void* a_state, float a_fixedTimeSeconds);
+    void (*updateEnded)(void* a_state, float a_deltaTimeSeconds);
+};
+
+#if SIMPLE_PLUGIN_HOST_SUPPORTED
+//--------------------------------------------------------------
+//! Hosts a plugin whose Update* logic lives in a shared object that
+//! can be reloaded between frames (POSIX only), eg. to deploy logic
+//! changes without the ShutDown/StartUp cycle of restarting the loop.
+//! The application calls the host's Update* functions from its own.
+//!
+//! A reload requested from any thread is done by the thread running
+//! the loop before the next frame starts. The shared object is copied
+//! before it is opened, so it can be rebuilt in place (and opened again
+//! while the old one is still loaded). If the new version cannot be
+//! opened, or cannot load the state saved by the old one, it is rolled
+//! back (ie. the old version keeps running with its state untouched).
+//! The pause of the loop for each reload is measured.
+//!
+//! Plugins must not keep pointers into their own code or static data
+//! (eg. vtables, function pointers, or string literals) in state that
+//! outlives them, as the old version is unloaded once replaced.
+//!
+//! Reloads are done from a listener on the loop, so the host must
+//! not be created or destroyed while the loop is running (see
+//! UpdateLoop::Listener).
+//--------------------------------------------------------------
+class PluginHost : public UpdateLoop::Listener
+{
+public:
+    using Clock = std::chrono::steady_clock;
+
+    struct Stats
+    {
+        uint64_t reloadCount = 0;   //!< Reloads done (incl. failed).
+        uint64_t failedCount = 0;   //!< Reloads rolled back.
+        Clock::duration lastPause = Clock::duration::zero();
+        Clock::duration maxPause = Clock::duration::zero();
+        Clock::duration totalPause = Clock::duration::zero();
+    };
+
+    explicit PluginHost(UpdateLoop& a_loop);
+    ~PluginHost() override;
+
+    PluginHost(const PluginHost&) = delete;
+    PluginHost& operator=(const PluginHost&) = delete;
+
+    bool Load(const char* a_path);
+    bool Reload();
+    void RequestReload();
+    void Unload();
+
+    bool IsLoaded() const;
+    const std::string& GetPath() const;
+    uint32_t GetStateVersion() const;
+    void* GetState() const;
+    const Stats& GetStats() const;
+
+    void UpdateStart(float a_deltaTimeSeconds);
+    void UpdateFixed(float a_fixedTimeSeconds);
+    void UpdateEnded(float a_deltaTimeSeconds);
+
+    void OnPhaseBegin(UpdatePhase a_phase) override;
+
+private:
+    void* Open(const PluginApi*& o_api);
+
+    UpdateLoop& m_loop;
+    std::string m_path;
+    void* m_module = nullptr;
+    const PluginApi* m_api = nullptr;
+    void* m_state = nullptr;
+    std::vector<char> m_buffer;
+    uint32_t m_openCount = 0;
+    std::atomic_bool m_reloadRequested = { false };
+    Stats m_stats;
+};
+
+//--------------------------------------------------------------
+//! Constructor. Does not host a plugin until one is loaded.
+//! @param[in] a_loop The loop to reload between frames of.
+//--------------------------------------------------------------
+inline PluginHost::PluginHost(UpdateLoop& a_loop)
+    : m_loop(a_loop)
+{
+    m_loop.AddListener(this);
+}
+
+//--------------------------------------------------------------
+//! Destructor. Unloads the plugin, destroying its state.
+//--------------------------------------------------------------
+inline PluginHost::~PluginHost()
+{
+    Unload();
+    m_loop.RemoveListener(this);
+}
+
+//--------------------------------------------------------------
+//! Load a plugin (unloading any already loaded), with a new state.
+//! @param[in] a_path The path of the shared object.
+//! @return True if loaded, false otherwise (printed).
+//--------------------------------------------------------------
+inline bool PluginHost::Load(const char* a_path)
+{
+    Unload();
+    m_path = a_path;
+    m_module = Open(m_api);
+    if (!m_module)
+    {
+        m_path.clear();
+        return false;
+    }
+    m_state = m_api->create();
+    return true;
+}
+
+//--------------------------------------------------------------
+//! Reload the plugin from the same path now, migrating its state, or
+//! roll back if that fails. Must be called from the thread running
+//! the loop between phases (or while it is not running).
+//! @return True if reloaded, false if rolled back (printed).
+//--------------------------------------------------------------
+inline bool PluginHost::Reload()
+{
+    if (!m_module)
+    {
+        printf("PluginHost: no plugin is loaded\n");
+        return false;
+    }
+
+    const Clock::time_point begin = Clock::now();
+    bool reloaded = false;
+    const PluginApi* api = nullptr;
+    if (void* module = Open(api))
+    {
+        // Save with the old version, and load with the new one.
+        size_t size = m_api->save(m_state, m_buffer.data(),
+                                  m_buffer.size());
+        if (size > m_buffer.size())
+        {
+            m_buffer.resize(size);
+            size = m_api->save(m_state, m_buffer.data(), m_buffer.size());
+        }
+        void* state = api->load(m_buffer.data(), size, m_api->stateVersion);
+        if (state)
+        {
+            m_api->destroy(m_state);
+            dlclose(m_module);
+            m_module = module;
+            m_api = api;
+            m_state = state;
+            reloaded = true;
+        }
+        else
+        {
+            printf("PluginHost: '%s' cannot migrate state version %u\n",
+                   m_path.c_str(), m_api->stateVersion);
+            dlclose(module);
+        }
+    }
+
+    const Clock::duration pause = Clock::now() - begin;
+    ++m_stats.reloadCount;
+    m_stats.failedCount += reloaded ? 0 : 1;
+    m_stats.lastPause = pause;
+    m_stats.maxPause = std::max(m_stats.maxPause, pause);
+    m_stats.totalPause += pause;
+    return reloaded;
+}
+
+//--------------------------------------------------------------
+//! Request a reload, from any thread, done before the next frame.
+//--------------------------------------------------------------
+inline void PluginHost::RequestReload()
+{
+    m_reloadRequested.store(true, std::memory_order_release);
+}
+
+//--------------------------------------------------------------
+//! Unload the plugin, destroying its state.
+//--------------------------------------------------------------
+inline void PluginHost::Unload()
+{
+    if (m_module)
+    {
+        m_api->destroy(m_state);
+        dlclose(m_module);
+    }
+    m_module = nullptr;
+    m_api = nullptr;
+    m_state = nullptr;
+    m_path.clear();
+}
+
+//--------------------------------------------------------------
+//! Check whether a plugin is loaded.
+//! @return True if a plugin is loaded.
+//--------------------------------------------------------------
+inline bool PluginHost::IsLoaded() const
+{
+    return m_module != nullptr;
+}
+
+//--------------------------------------------------------------
+//! Get the path of the plugin loaded.
+//! @return The path of the plugin loaded (empty if none).
+//--------------------------------------------------------------
+inline const std::string& PluginHost::GetPath() const
+{
+    return m_path;
+}
+
+//--------------------------------------------------------------
+//! Get the state version of the plugin loaded.
+//! @return The state version of the plugin loaded (zero if none).
+//--------------------------------------------------------------
+inline uint32_t PluginHost::GetStateVersion() const
+{
+    return m_api ? m_api->stateVersion : 0;
+}
+
+//--------------------------------------------------------------
+//! Get the state of the plugin loaded (owned by the plugin), which
+//! changes each time it is reloaded.
+//! @return The state of the plugin loaded (null if none).
+//--------------------------------------------------------------
+inline void* PluginHost::GetState() const
+{
+    return m_state;
+}
+
+//--------------------------------------------------------------
+//! Get the stats of the reloads done.
+//! @return The stats of the reloads done.
+//--------------------------------------------------------------
+inline const PluginHost::Stats& PluginHost::GetStats() const
+{
+    return m_stats;
+}
+
+//--------------------------------------------------------------
+//! Call the plugin's updateStart (if a plugin is loaded).
+//! @param[in] a_deltaTimeSeconds Actual duration of last frame.
+//--------------------------------------------------------------
+inline void PluginHost::UpdateStart(float a_deltaTimeSeconds)
+{
+    if (m_api && m_api->updateStart)
+    {
+        m_api->updateStart(m_state, a_deltaTimeSeconds);
+    }
+}
+
+//--------------------------------------------------------------
+//! Call the plugin's updateFixed (if a plugin is loaded).
+//! @param[in] a_fixedTimeSeconds Target frame duration (fixed).
+//--------------------------------------------------------------
+inline void PluginHost::UpdateFixed(float a_fixedTimeSeconds)
+{
+    if (m_api && m_api->updateFixed)
+    {
+        m_api->updateFixed(m_state, a_fixedTimeSeconds);
+    }
+}
+
+//--------------------------------------------------------------
+//! Call the plugin's updateEnded (if a plugin is loaded).
+//! @param[in] a_deltaTimeSeconds Actual duration of last frame.
+//--------------------------------------------------------------
+inline void PluginHost::UpdateEnded(float a_deltaTimeSeconds)
+{
+    if (m_api && m_api->updateEnded)
+    {
+        m_api->updateEnded(m_state, a_deltaTimeSeconds);
+    }
+}
+
+//--------------------------------------------------------------
+//! Reloads the plugin before the next frame, if requested.
+//! @param[in] a_phase The phase of the loop that is about to begin.
+//--------------------------------------------------------------
+inline void PluginHost::OnPhaseBegin(UpdatePhase a_phase)
+{
+    if (a_phase == UpdatePhase::Start &&
+        m_reloadRequested.exchange(false, std::memory_order_acq_rel))
+    {
+        Reload();
+    }
+}
+
+//--------------------------------------------------------------
+inline void* PluginHost::Open(const PluginApi*& o_api)
+{
+    // Open a uniquely named copy, as opening the same path again
+    // would just return the version already loaded. The copy can be
+    // removed once opened, as it stays mapped until it is closed.
+    // A path without a slash is searched for instead of being opened.
+    std::string copyPath = m_path + "." +
+                           std::to_string((long long)getpid()) + "." +
+                           std::to_string(++m_openCount);
+    if (copyPath.find('/') == std::string::npos)
+    {
+        copyPath.insert(0, "./");
+    }
+    {
+        std::ifstream source(m_path, std::ios::binary);
+        std::ofstream copy(copyPath, std::ios::binary);
+        if (!source || !(copy << source.rdbuf()))
+        {
+            printf("PluginHost: cannot copy '%s'\n", m_path.c_str());
+            std::remove(copyPath.c_str());
+            return nullptr;
+        }
+    }
+    void* module = dlopen(copyPath.c_str(), RTLD_NOW | RTLD_LOCAL);
+    std::remove(copyPath.c_str());
+    if (!module)
+    {
+        printf("PluginHost: cannot open '%s': %s\n",
+               m_path.c_str(), dlerror());
+        return nullptr;
+    }
+
+    using EntryPoint = const PluginApi* (*)();
+    const EntryPoint entryPoint = (EntryPoint)dlsym(
+        module, SIMPLE_PLUGIN_ENTRY_POINT);
+    o_api = entryPoint ? entryPoint() : nullptr;
+    if (!o_api || o_api->abiVersion != SIMPLE_PLUGIN_ABI_VERSION ||
+        !o_api->create || !o_api->destroy || !o_api->save || !o_api->load)
+    {
+        printf("PluginHost: '%s' is not a compatible plugin\n",
+               m_path.c_str());
+        dlclose(module);
+        o_api = nullptr;
+        return nullptr;
+    }
+    return module;
+}
+#endif//SIMPLE_PLUGIN_HOST_SUPPORTED
+
+} // namespace Simple
@@ -0,0 +1,777 @@
+//--------------------------------------------------------------
+// Copyright (c) David Bosnich <david.bosnich.public@gmail.com>
+//
+// This code is licensed under the MIT License, a copy of which
+// can be found in the license.txt file included at the root of
+// this distribution, or at https://opensource.org/licenses/MIT
+//--------------------------------------------------------------
+
+#pragma once
+
+#include "update_loop.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <new>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#define SIMPLE_SHARED_MEMORY_SUPPORTED 1
+#endif
+
+//! @file
+
+//--------------------------------------------------------------
+namespace Simple
+{
+
+//--------------------------------------------------------------
+//! Header stored at the start of each fixed-size frame slot. All
+//! fields are atomic (accessed relaxed, ordered by the sequence)
+//! as readers load them while the writer may be overwriting them.
+//--------------------------------------------------------------
+struct FrameSlotHeader
+{
+    std::atomic<uint64_t> sequence;
+    std::atomic<uint64_t> frameIndex;
+    std::atomic<int64_t> startTimeNs;
+    std::atomic<int64_t> endTimeNs;
+    std::atomic<uint32_t> size;
+};
+
+//--------------------------------------------------------------
+//! Header stored at the start of the memory used by a FrameRing.
+//--------------------------------------------------------------
+struct FrameRingHeader
+{
+    static constexpr uint32_t Magic = 0x474E5246u; // 'FRNG'
+    static constexpr uint32_t Version = 1u;
+
+    uint32_t magic;
+    uint32_t version;
+    uint32_t slotCount;
+    uint32_t slotSize;
+    uint64_t slotStride;
+    alignas(64) std::atomic<uint64_t> published;
+};
+
+//--------------------------------------------------------------
+//! A view of one frame that has been published to a FrameRing.
+//! The data is read in place, so it can be overwritten at any
+//! time by the writer; use FrameRingReader::IsValid to confirm
+//! it was not overwritten while it was being read by consumers.
+//--------------------------------------------------------------
+struct FrameView
+{
+    const void* data = nullptr;
+    uint32_t size = 0;
+    uint64_t frameIndex = 0;
+    int64_t startTimeNs = 0;
+    int64_t endTimeNs = 0;
+    uint64_t sequence = 0;
+};
+
+//--------------------------------------------------------------
+//! Publishes frames to a ring of fixed-size slots that resides
+//! in memory which can be shared with other (reader) processes.
+//! Single producer; never blocks, regardless of reader progress.
+//--------------------------------------------------------------
+class FrameRingWriter
+{
+public:
+    FrameRingWriter() = default;
+    ~FrameRingWriter() = default;
+
+    FrameRingWriter(const FrameRingWriter&) = delete;
+    FrameRingWriter& operator=(const FrameRingWriter&) = delete;
+
+    static size_t RequiredBytes(uint32_t a_slotCount,
+                                uint32_t a_slotSize);
+
+    bool Initialize(void* a_memory,
+                    size_t a_bytes,
+                    uint32_t a_slotCount,
+                    uint32_t a_slotSize);
+
+    void* BeginWrite();
+    void EndWrite(uint64_t a_frameIndex,
+                  int64_t a_startTimeNs,
+                  int64_t a_endTimeNs,
+                  uint32_t a_size);
+
+    bool Publish(uint64_t a_frameIndex,
+                 int64_t a_startTimeNs,
+                 int64_t a_endTimeNs,
+                 const void* a_data,
+                 uint32_t a_size);
+
+    uint32_t GetSlotSize() const;
+    uint64_t GetPublishedCount() const;
+
+private:
+    FrameRingHeader* m_header = nullptr;
+    FrameSlotHeader* m_writeSlot = nullptr;
+    uint64_t m_writeSequence = 0;
+};
+
+//--------------------------------------------------------------
+//! Publishes every frame of an update loop (that it adds itself to
+//! as a listener) to a ring, with the index of the frame (since the
+//! loop started up) and timestamps of when it started (before
+//! UpdateStart) and ended (after UpdateEnded). The slot is begun
+//! before UpdateEnded, which can write the frame's output directly
+//! into GetFrameData then call SetFrameSize, or leave it empty so
+//! just the frame's stats are published.
+//!
+//! Listens to the loop to time and publish each frame, so it must
+//! not be created or destroyed while the loop is running (see
+//! UpdateLoop::Listener).
+//--------------------------------------------------------------
+class FrameRingPublisher : public UpdateLoop::Listener
+{
+public:
+    FrameRingPublisher(UpdateLoop& a_loop, FrameRingWriter& a_writer);
+    ~FrameRingPublisher() override;
+
+    FrameRingPublisher(const FrameRingPublisher&) = delete;
+    FrameRingPublisher& operator=(const FrameRingPublisher&) = delete;
+
+    void* GetFrameData() const;
+    void SetFrameSize(uint32_t a_size);
+    uint64_t GetFrameIndex() const;
+
+    void OnPhaseBegin(UpdatePhase a_phase) override;
+    void OnPhaseEnded(UpdatePhase a_phase) override;
+
+private:
+    static int64_t GetTimeNs();
+
+    UpdateLoop& m_loop;
+    FrameRingWriter& m_writer;
+    void* m_frameData = nullptr;
+    uint32_t m_frameSize = 0;
+    uint64_t m_frameIndex = 0;
+    int64_t m_frameStartNs = 0;
+};
+
+//--------------------------------------------------------------
+//! Reads frames in place from a ring published by a writer. One
+//! reader per consumer, each tracking their own read sequence.
+//--------------------------------------------------------------
+class FrameRingReader
+{
+public:
+    enum class Result
+    {
+        Read,       //!< A frame was read into the view.
+        Empty,      //!< No frames have been published since.
+        Overrun     //!< Frames were lost; caught up to the oldest.
+    };
+
+    FrameRingReader() = default;
+    ~FrameRingReader() = default;
+
+    FrameRingReader(const FrameRingReader&) = delete;
+    FrameRingReader& operator=(const FrameRingReader&) = delete;
+
+    bool Attach(const void* a_memory, size_t a_bytes);
+
+    Result TryRead(FrameView& o_frameView);
+    bool IsValid(const FrameView& a_frameView) const;
+
+    uint64_t GetLostCount() const;
+    uint64_t GetLagCount() const;
+
+private:
+    const FrameSlotHeader* GetSlot(uint64_t a_sequence) const;
+
+    const FrameRingHeader* m_header = nullptr;
+    uint64_t m_readSequence = 0;
+    uint64_t m_lostCount = 0;
+};
+
+#if SIMPLE_SHARED_MEMORY_SUPPORTED
+//--------------------------------------------------------------
+//! A named region of shared memory that can be mapped by other
+//! processes (POSIX only). Created read-write, opened read-only.
+//--------------------------------------------------------------
+class SharedMemory
+{
+public:
+    SharedMemory() = default;
+    ~SharedMemory();
+
+    SharedMemory(const SharedMemory&) = delete;
+    SharedMemory& operator=(const SharedMemory&) = delete;
+
+    bool Create(const char* a_name, size_t a_bytes);
+    bool Open(const char* a_name);
+    void Close();
+
+    void* GetData() const;
+    size_t GetSize() const;
+
+private:
+    bool Map(int a_fileDescriptor, size_t a_bytes, int a_prot);
+
+    void* m_data = nullptr;
+    size_t m_size = 0;
+    char m_name[256] = {};
+    bool m_owner = false;
+};
+#endif//SIMPLE_SHARED_MEMORY_SUPPORTED
+
+//--------------------------------------------------------------
+//! Get the bytes required to hold a ring with the given layout.
+//! @param[in] a_slotCount Number of slots (frames) in the ring.
+//! @param[in] a_slotSize Maximum size (bytes) of a single frame.
+//! @return Bytes of memory required to initialize a ring layout.
+//--------------------------------------------------------------
+inline size_t FrameRingWriter::RequiredBytes(uint32_t a_slotCount,
+                                             uint32_t a_slotSize)
+{
+    // Round each slot up to a cache line so that slot headers
+    // written by the producer never share with another slot.
+    constexpr size_t cacheLine = 64;
+    const size_t slotBytes = sizeof(FrameSlotHeader) + a_slotSize;
+    const size_t stride = ((slotBytes + cacheLine - 1) / cacheLine) *
+                          cacheLine;
+    return sizeof(FrameRingHeader) + (stride * a_slotCount);
+}
+
+//--------------------------------------------------------------
+//! Initialize the ring layout, clearing any existing contents.
+//! @param[in] a_memory Memory to hold the ring (64-byte aligned).
+//! @param[in] a_bytes Size of the memory, at least RequiredBytes.
+//! @param[in] a_slotCount Number of slots (frames) in the ring.
+//! @param[in] a_slotSize Maximum size (bytes) of a single frame.
+//! @return True if the ring was initialized, false otherwise.
+//--------------------------------------------------------------
+inline bool FrameRingWriter::Initialize(void* a_memory,
+                                        size_t a_bytes,
+                                        uint32_t a_slotCount,
+                                        uint32_t a_slotSize)
+{
+    const size_t required = RequiredBytes(a_slotCount, a_slotSize);
+    if (!a_memory || a_slotCount == 0 || a_bytes < required ||
+        ((uintptr_t)a_memory % alignof(FrameRingHeader)) != 0)
+    {
+        printf("FrameRingWriter invalid memory or layout.\n");
+        return false;
+    }
+
+    // Construct the ring header and all slot headers in place.
+    char* memory = static_cast<char*>(a_memory);
+    FrameRingHeader* header = new (memory) FrameRingHeader();
+    header->magic = FrameRingHeader::Magic;
+    header->version = FrameRingHeader::Version;
+    header->slotCount = a_slotCount;
+    header->slotSize = a_slotSize;
+    header->slotStride = (required - sizeof(FrameRingHeader)) /
+                         a_slotCount;
+    header->published.store(0, std::memory_order_relaxed);
+    for (uint32_t i = 0; i < a_slotCount; ++i)
+    {
+        char* slotMemory = memory + sizeof(FrameRingHeader) +
+                           (header->slotStride * i);
+        FrameSlotHeader* slot = new (slotMemory) FrameSlotHeader();
+        slot->sequence.store(0, std::memory_order_relaxed);
+        slot->frameIndex.store(0, std::memory_order_relaxed);
+        slot->startTimeNs.store(0, std::memory_order_relaxed);
+        slot->endTimeNs.store(0, std::memory_order_relaxed);
+        slot->size.store(0, std::memory_order_relaxed);
+    }
+    std::atomic_thread_fence(std::memory_order_release);
+
+    m_header = header;
+    m_writeSlot = nullptr;
+    m_writeSequence = 0;
+    return true;
+}
+
+//--------------------------------------------------------------
+//! Begin writing the next frame directly into its ring slot. The
+//! slot is invalidated for readers until EndWrite is then called.
+//! @return Pointer to GetSlotSize() bytes to write the frame into.
+//--------------------------------------------------------------
+inline void* FrameRingWriter::BeginWrite()
+{
+    if (!m_header)
+    {
+        return nullptr;
+    }
+
+    // Mark the slot as being written (odd sequence) so readers
+    // still reading the previous frame in place can detect it.
+    const uint64_t slotIndex = m_writeSequence % m_header->slotCount;
+    char* memory = reinterpret_cast<char*>(m_header);
+    m_writeSlot = reinterpret_cast<FrameSlotHeader*>(
+        memory + sizeof(FrameRingHeader) +
+        (m_header->slotStride * slotIndex));
+    m_writeSlot->sequence.store((m_writeSequence * 2) + 1,
+                                std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    return m_writeSlot + 1;
+}
+
+//--------------------------------------------------------------
+//! End writing the frame started by BeginWrite and publish it.
+//! @param[in] a_frameIndex Index of the frame that produced it.
+//! @param[in] a_startTimeNs Timestamp (ns) the frame started.
+//! @param[in] a_endTimeNs Timestamp (ns) the frame ended.
+//! @param[in] a_size Bytes written (clamped to GetSlotSize()).
+//--------------------------------------------------------------
+inline void FrameRingWriter::EndWrite(uint64_t a_frameIndex,
+                                      int64_t a_startTimeNs,
+                                      int64_t a_endTimeNs,
+                                      uint32_t a_size)
+{
+    if (!m_writeSlot)
+    {
+        return;
+    }
+
+    m_writeSlot->frameIndex.store(a_frameIndex, std::memory_order_relaxed);
+    m_writeSlot->startTimeNs.store(a_startTimeNs,
+                                   std::memory_order_relaxed);
+    m_writeSlot->endTimeNs.store(a_endTimeNs, std::memory_order_relaxed);
+    m_writeSlot->size.store((a_size < m_header->slotSize) ?
+                            a_size : m_header->slotSize,
+                            std::memory_order_relaxed);
+
+    // Commit the slot (even sequence) and only then advance the
+    // published count, so readers never observe a partial frame.
+    ++m_writeSequence;
+    m_writeSlot->sequence.store(m_writeSequence * 2,
+                                std::memory_order_release);
+    m_header->published.store(m_writeSequence,
+                              std::memory_order_release);
+    m_writeSlot = nullptr;
+}
+
+//--------------------------------------------------------------
+//! Publish a frame by copying it into the next ring slot.
+//! @param[in] a_frameIndex Index of the frame that produced it.
+//! @param[in] a_startTimeNs Timestamp (ns) the frame started.
+//! @param[in] a_endTimeNs Timestamp (ns) the frame ended.
+//! @param[in] a_data The frame data to copy into the ring slot.
+//! @param[in] a_size Size of the frame data (bytes) to publish.
+//! @return True if published, false if the data does not fit.
+//--------------------------------------------------------------
+inline bool FrameRingWriter::Publish(uint64_t a_frameIndex,
+                                     int64_t a_startTimeNs,
+                                     int64_t a_endTimeNs,
+                                     const void* a_data,
+                                     uint32_t a_size)
+{
+    if (!m_header || a_size > m_header->slotSize)
+    {
+        return false;
+    }
+
+    void* slotData = BeginWrite();
+    if (a_size)
+    {
+        memcpy(slotData, a_data, a_size);
+    }
+    EndWrite(a_frameIndex, a_startTimeNs, a_endTimeNs, a_size);
+    return true;
+}
+
+//--------------------------------------------------------------
+//! Get the maximum size (bytes) of a single frame in the ring.
+//! @return Maximum size (bytes) of a single frame in the ring.
+//--------------------------------------------------------------
+inline uint32_t FrameRingWriter::GetSlotSize() const
+{
+    return m_header ? m_header->slotSize : 0;
+}
+
+//--------------------------------------------------------------
+//! Get the count of frames published since initialization.
+//! @return Count of frames published since initialization.
+//--------------------------------------------------------------
+inline uint64_t FrameRingWriter::GetPublishedCount() const
+{
+    return m_writeSequence;
+}
+
+//--------------------------------------------------------------
+//! Constructor.
+//! @param[in] a_loop The loop to publish the frames of.
+//! @param[in] a_writer The (initialized) ring to publish them to.
+//--------------------------------------------------------------
+inline FrameRingPublisher::FrameRingPublisher(UpdateLoop& a_loop,
+                                              FrameRingWriter& a_writer)
+    : m_loop(a_loop)
+    , m_writer(a_writer)
+{
+    m_loop.AddListener(this);
+}
+
+//--------------------------------------------------------------
+//! Destructor.
+//--------------------------------------------------------------
+inline FrameRingPublisher::~FrameRingPublisher()
+{
+    m_loop.RemoveListener(this);
+}
+
+//--------------------------------------------------------------
+//! Get the slot of the frame being published, which UpdateEnded
+//! can write up to FrameRingWriter::GetSlotSize bytes of output to.
+//! @return The slot data, or null if not called from UpdateEnded.
+//--------------------------------------------------------------
+inline void* FrameRingPublisher::GetFrameData() const
+{
+    return m_frameData;
+}
+
+//--------------------------------------------------------------
+//! Set the size of the output written to GetFrameData this frame.
+//! @param[in] a_size Bytes written (clamped to the slot size).
+//--------------------------------------------------------------
+inline void FrameRingPublisher::SetFrameSize(uint32_t a_size)
+{
+    m_frameSize = a_size;
+}
+
+//--------------------------------------------------------------
+//! Get the index of the current frame since the loop started up.
+//! @return The index of the current (or next) frame published.
+//--------------------------------------------------------------
+inline uint64_t FrameRingPublisher::GetFrameIndex() const
+{
+    return m_frameIndex;
+}
+
+//--------------------------------------------------------------
+//! Times each frame, and begins its slot before UpdateEnded.
+//! @param[in] a_phase The phase of the loop that is about to begin.
+//--------------------------------------------------------------
+inline void FrameRingPublisher::OnPhaseBegin(UpdatePhase a_phase)
+{
+    if (a_phase == UpdatePhase::StartUp)
+    {
+        m_frameIndex = 0;
+    }
+    else if (a_phase == UpdatePhase::Start)
+    {
+        m_frameStartNs = GetTimeNs();
+    }
+    else if (a_phase == UpdatePhase::Ended)
+    {
+        m_frameData = m_writer.BeginWrite();
+        m_frameSize = 0;
+    }
+}
+
+//--------------------------------------------------------------
+//! Publishes each frame after UpdateEnded.
+//! @param[in] a_phase The phase of the loop that has just ended.
+//--------------------------------------------------------------
+inline void FrameRingPublisher::OnPhaseEnded(UpdatePhase a_phase)
+{
+    if (a_phase == UpdatePhase::Ended && m_frameData)
+    {
+        m_writer.EndWrite(m_frameIndex, m_frameStartNs, GetTimeNs(),
+                          m_frameSize);
+        m_frameData = nullptr;
+        ++m_frameIndex;
+    }
+}
+
+//--------------------------------------------------------------
+inline int64_t FrameRingPublisher::GetTimeNs()
+{
+    using namespace std::chrono;
+    const auto sinceEpoch = steady_clock::now().time_since_epoch();
+    return duration_cast<nanoseconds>(sinceEpoch).count();
+}
+
+//--------------------------------------------------------------
+//! Attach to a ring that has been initialized by a writer. Reads
+//! start from the oldest frame still held in the ring's slots.
+//! @param[in] a_memory Memory holding the initialized ring.
+//! @param[in] a_bytes Size of the memory holding the ring.
+//! @return True if a valid ring was attached, false otherwise.
+//--------------------------------------------------------------
+inline bool FrameRingReader::Attach(const void* a_memory,
+                                    size_t a_bytes)
+{
+    const FrameRingHeader* header =
+        static_cast<const FrameRingHeader*>(a_memory);
+    if (!header || a_bytes < sizeof(FrameRingHeader) ||
+        header->magic != FrameRingHeader::Magic ||
+        header->version != FrameRingHeader::Version ||
+        header->slotCount == 0 ||
+        a_bytes < FrameRingWriter::RequiredBytes(header->slotCount,
+                                                 header->slotSize))
+    {
+        printf("FrameRingReader invalid ring memory.\n");
+        return false;
+    }
+
+    const uint64_t published = header->published.load(
+        std::memory_order_acquire);
+    m_header = header;
+    m_readSequence = (published > header->slotCount) ?
+                     published - header->slotCount : 0;
+    m_lostCount = 0;
+    return true;
+}
+
+//--------------------------------------------------------------
+//! Try to read the next frame without blocking or copying it. If
+//! the reader has fallen behind by more than the ring can hold,
+//! the lost frames are counted and reading skips to the oldest.
+//! @param[out] o_frameView View of the frame that was read.
+//! @return Whether a frame was read, none was ready, or overrun.
+//--------------------------------------------------------------
+inline FrameRingReader::Result FrameRingReader::TryRead(
+    FrameView& o_frameView)
+{
+    if (!m_header)
+    {
+        return Result::Empty;
+    }
+
+    const uint64_t published = m_header->published.load(
+        std::memory_order_acquire);
+    if (m_readSequence >= published)
+    {
+        return Result::Empty;
+    }
+
+    // Detect a slow reader using the sequence numbers, which is
+    // the only form of back pressure; the writer never waits.
+    const uint64_t slotCount = m_header->slotCount;
+    if (published - m_readSequence > slotCount)
+    {
+        m_lostCount += (published - slotCount) - m_readSequence;
+        m_readSequence = published - slotCount;
+        return Result::Overrun;
+    }
+
+    // Copy the slot header then check that the slot still holds
+    // the expected (committed) frame, otherwise it was lapped.
+    const FrameSlotHeader* slot = GetSlot(m_readSequence);
+    const uint64_t expected = (m_readSequence + 1) * 2;
+    const uint64_t before = slot->sequence.load(
+        std::memory_order_acquire);
+    o_frameView.data = slot + 1;
+    o_frameView.size = slot->size.load(std::memory_order_relaxed);
+    o_frameView.frameIndex = slot->frameIndex.load(
+        std::memory_order_relaxed);
+    o_frameView.startTimeNs = slot->startTimeNs.load(
+        std::memory_order_relaxed);
+    o_frameView.endTimeNs = slot->endTimeNs.load(
+        std::memory_order_relaxed);
+    o_frameView.sequence = m_readSequence;
+    if (before != expected || !IsValid(o_frameView))
+    {
+        m_lostCount += 1;
+        m_readSequence += 1;
+        return Result::Overrun;
+    }
+
+    ++m_readSequence;
+    return Result::Read;
+}
+
+//--------------------------------------------------------------
+//! Check whether a frame view is still valid, meaning it has not
+//! (yet) been overwritten by the writer. Call after reading data.
+//! @param[in] a_frameView View of the frame that was read.
+//! @return True if the frame data was not overwritten by writer.
+//--------------------------------------------------------------
+inline bool FrameRingReader::IsValid(const FrameView& a_frameView) const
+{
+    if (!m_header)
+    {
+        return false;
+    }
+
+    std::atomic_thread_fence(std::memory_order_acquire);
+    const FrameSlotHeader* slot = GetSlot(a_frameView.sequence);
+    const uint64_t expected = (a_frameView.sequence + 1) * 2;
+    return slot->sequence.load(std::memory_order_relaxed) == expected;
+}
+
+//--------------------------------------------------------------
+//! Get the count of frames lost because the reader was too slow.
+//! @return Count of frames lost because the reader was too slow.
+//--------------------------------------------------------------
+inline uint64_t FrameRingReader::GetLostCount() const
+{
+    return m_lostCount;
+}
+
+//--------------------------------------------------------------
+//! Get the count of frames published but not yet read (or lost).
+//! @return Count of frames published but not yet read (or lost).
+//--------------------------------------------------------------
+inline uint64_t FrameRingReader::GetLagCount() const
+{
+    if (!m_header)
+    {
+        return 0;
+    }
+
+    const uint64_t published = m_header->published.load(
+        std::memory_order_acquire);
+    return published - m_readSequence;
+}
+
+//--------------------------------------------------------------
+inline const FrameSlotHeader* FrameRingReader::GetSlot(
+    uint64_t a_sequence) const
+{
+    const uint64_t slotIndex = a_sequence % m_header->slotCount;
+    const char* memory = reinterpret_cast<const char*>(m_header);
+    return reinterpret_cast<const FrameSlotHeader*>(
+        memory + sizeof(FrameRingHeader) +
+        (m_header->slotStride * slotIndex));
+}
+
+#if SIMPLE_SHARED_MEMORY_SUPPORTED
+//--------------------------------------------------------------
+//! Destructor. Unmaps the memory, and unlinks it if the creator.
+//--------------------------------------------------------------
+inline SharedMemory::~SharedMemory()
+{
+    Close();
+}
+
+//--------------------------------------------------------------
+//! Create a named region of shared memory, mapped read-write. It
+//! is unlinked on Close, but remains mapped by other processes.
+//! @param[in] a_name Name of the region (eg. "/my_frame_ring").
+//! @param[in] a_bytes Size (bytes) of the region to be created.
+//! @return True if the region was created, false otherwise.
+//--------------------------------------------------------------
+inline bool SharedMemory::Create(const char* a_name, size_t a_bytes)
+{
+    Close();
+
+    const int fd = shm_open(a_name, O_CREAT | O_RDWR | O_TRUNC, 0600);
+    if (fd < 0)
+    {
+        printf("SharedMemory failed to create '%s'.\n", a_name);
+        return false;
+    }
+
+    const bool mapped = (ftruncate(fd, (off_t)a_bytes) == 0) &&
+                        Map(fd, a_bytes, PROT_READ | PROT_WRITE);
+    close(fd);
+    if (!mapped)
+    {
+        printf("SharedMemory failed to map '%s'.\n", a_name);
+        shm_unlink(a_name);
+        return false;
+    }
+
+    snprintf(m_name, sizeof(m_name), "%s", a_name);
+    m_owner = true;
+    return true;
+}
+
+//--------------------------------------------------------------
+//! Open an existing named region of shared memory, read-only.
+//! @param[in] a_name Name of the region (eg. "/my_frame_ring").
+//! @return True if the region was opened, false otherwise.
+//--------------------------------------------------------------
+inline bool SharedMemory::Open(const char* a_name)
+{
+    Close();
+
+    const int fd = shm_open(a_name, O_RDONLY, 0);
+    if (fd < 0)
+    {
+        printf("SharedMemory failed to open '%s'.\n", a_name);
+        return false;
+    }
+
+    struct stat fileStat;
+    const bool mapped = (fstat(fd, &fileStat) == 0) &&
+                        Map(fd, (size_t)fileStat.st_size, PROT_READ);
+    close(fd);
+    if (!mapped)
+    {
+        printf("SharedMemory failed to map '%s'.\n", a_name);
+        return false;
+    }
+
+    snprintf(m_name, sizeof(m_name), "%s", a_name);
+    m_owner = false;
+    return true;
+}
+
+//--------------------------------------------------------------
+//! Unmap the memory, and unlink the name if this created it.
+//--------------------------------------------------------------
+inline void SharedMemory::Close()
+{
+    if (m_data)
+    {
+        munmap(m_data, m_size);
+    }
+    if (m_owner)
+    {
+        shm_unlink(m_name);
+    }
+
+    m_data = nullptr;
+    m_size = 0;
+    m_name[0] = '\0';
+    m_owner = false;
+}
+
+//--------------------------------------------------------------
+//! Get the mapped memory (page aligned) or null if not mapped.
+//! @return The mapped memory (page aligned) or null if not mapped.
+//--------------------------------------------------------------
+inline void* SharedMemory::GetData() const
+{
+    return m_data;
+}
+
+//--------------------------------------------------------------
+//! Get the size (bytes) of the mapped memory, or 0 if not mapped.
+//! @return The size (bytes) of the mapped memory, or 0 otherwise.
+//--------------------------------------------------------------
+inline size_t SharedMemory::GetSize() const
+{
+    return m_size;
+}
+
+//--------------------------------------------------------------
+inline bool SharedMemory::Map(int a_fileDescriptor,
+                              size_t a_bytes,
+                              int a_prot)
+{
+    if (a_bytes == 0)
+    {
+        return false;
+    }
+
+    void* data = mmap(nullptr, a_bytes, a_prot, MAP_SHARED,
+                      a_fileDescriptor, 0);
+    if (data == MAP_FAILED)
+    {
+        return false;
+    }
+
+    m_data = data;
+    m_size = a_bytes;
+    return true;
+}
+#endif//SIMPLE_SHARED_MEMORY_SUPPORTED
+
+} // namespace Simple
@@ -0,0 +1,376 @@
+//--------------------------------------------------------------
+// Copyright (c) David Bosnich <david.bosnich.public@gmail.com>
+//
+// This code is licensed under the MIT License, a copy of which
+// can be found in the license.txt file included at the root of
+// this distribution, or at https://opensource.org/licenses/MIT
+//--------------------------------------------------------------
+
+#pragma once
+
+#include "update_loop.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <functional>
+#include <string>
+#include <thread>
+#include <vector>
+
+//! @file
+
+//--------------------------------------------------------------
+//! Default time each stage of a ShutdownCoordinator has to drain its
+//! loops, and again to stop them, before they are forced (milliseconds).
+//--------------------------------------------------------------
+#ifndef DEFAULT_SHUTDOWN_STAGE_DEADLINE_MS
+#define DEFAULT_SHUTDOWN_STAGE_DEADLINE_MS 1000u
+#endif
+
+//--------------------------------------------------------------
+namespace Simple
+{
+
+//--------------------------------------------------------------
+//! Shuts down loops (each running in its own thread) that depend on
+//! each other in stages, so that each loop stops only after all of
+//! the loops it consumes from (its producers) have stopped, and it
+//! has drained the work they produced.
+//!
+//! Each stage first polls the drain functions of its loops (called
+//! on the coordinating thread, while the loops are still running)
+//! until they all return true, then requests the loops shut down and
+//! waits until they are no longer running. Draining and stopping each
+//! have the stage deadline to themselves, so a stage that spends all
+//! of it draining still gives its loops the chance to stop cleanly.
+//! If either deadline is reached first, the force functions of the
+//! loops not yet stopped are called (eg. to unblock or abandon them)
+//! and the next stage begins regardless, so the total time to shut
+//! down is bounded. The duration of each stage, and which loops were
+//! forced, is reported.
+//!
+//! A loop that has never started running (eg. one just started with
+//! RunInThread, whose thread has not yet called Run) is not treated
+//! as stopped, but waited on (and requested to shut down again) until
+//! it has run, or forced at the deadline, so it can't run on forever.
+//--------------------------------------------------------------
+class ShutdownCoordinator
+{
+public:
+    using Clock = std::chrono::steady_clock;
+
+    //! Return true once a loop has drained its in-flight work.
+    using DrainFunc = std::function<bool()>;
+
+    //! Called when a loop is forced to stop by the stage deadline.
+    using ForceFunc = std::function<void()>;
+
+    struct LoopReport
+    {
+        std::string name;
+        uint32_t stage = 0;
+        bool drained = false;   //!< Drained before the deadline.
+        bool stopped = false;   //!< Stopped before the deadline.
+        bool started = false;   //!< Had started running at all.
+    };
+
+    struct StageReport
+    {
+        Clock::duration drainDuration = Clock::duration::zero();
+        Clock::duration stopDuration = Clock::duration::zero();
+        bool forced = false;    //!< Any loop forced by the deadline.
+    };
+
+    struct Report
+    {
+        std::vector<StageReport> stages;
+        std::vector<LoopReport> loops;
+        Clock::duration totalDuration = Clock::duration::zero();
+        bool forced = false;    //!< Any loop forced by a deadline.
+    };
+
+    ShutdownCoordinator() = default;
+    ~ShutdownCoordinator() = default;
+
+    ShutdownCoordinator(const ShutdownCoordinator&) = delete;
+    ShutdownCoordinator& operator=(const ShutdownCoordinator&) = delete;
+
+    bool AddLoop(UpdateLoop& a_loop,
+                 const char* a_name,
+                 DrainFunc a_drainFunc = nullptr,
+                 ForceFunc a_forceFunc = nullptr);
+    bool AddDependency(const char* a_consumer, const char* a_producer);
+    void SetStageDeadline(Clock::duration a_deadline);
+
+    bool ShutDown();
+    const Report& GetReport() const;
+
+private:
+    struct Entry
+    {
+        UpdateLoop* loop;
+        std::string name;
+        DrainFunc drainFunc;
+        ForceFunc forceFunc;
+        std::vector<size_t> producers;
+    };
+
+    size_t Find(const char* a_name) const;
+    void AssignStages(std::vector<uint32_t>& o_stages) const;
+
+    std::vector<Entry> m_entries;
+    Clock::duration m_stageDeadline = std::chrono::milliseconds(
+        DEFAULT_SHUTDOWN_STAGE_DEADLINE_MS);
+    Report m_report;
+};
+
+//--------------------------------------------------------------
+//! Add a loop to shut down.
+//! @param[in] a_loop The loop to shut down (not owned).
+//! @param[in] a_name The name of the loop (unique).
+//! @param[in] a_drainFunc Polled until the loop has drained (optional).
+//! @param[in] a_forceFunc Called if the loop is forced (optional).
+//! @return True if added, false otherwise (printed).
+//--------------------------------------------------------------
+inline bool ShutdownCoordinator::AddLoop(UpdateLoop& a_loop,
+                                         const char* a_name,
+                                         DrainFunc a_drainFunc,
+                                         ForceFunc a_forceFunc)
+{
+    if (Find(a_name) != m_entries.size())
+    {
+        printf("ShutdownCoordinator::AddLoop: '%s' already added\n",
+               a_name);
+        return false;
+    }
+    m_entries.push_back({ &a_loop, a_name, std::move(a_drainFunc),
+                          std::move(a_forceFunc), {} });
+    return true;
+}
+
+//--------------------------------------------------------------
+//! Add a dependency of one loop on another, so that the consumer is
+//! only drained and stopped after the producer has stopped.
+//! @param[in] a_consumer The name of the loop that consumes.
+//! @param[in] a_producer The name of the loop that produces.
+//! @return True if added, false otherwise (printed).
+//--------------------------------------------------------------
+inline bool ShutdownCoordinator::AddDependency(const char* a_consumer,
+                                               const char* a_producer)
+{
+    const size_t consumer = Find(a_consumer);
+    const size_t producer = Find(a_producer);
+    if (consumer == m_entries.size() || producer == m_entries.size() ||
+        consumer == producer)
+    {
+        printf("ShutdownCoordinator::AddDependency: invalid loops "
+               "'%s' and '%s'\n", a_consumer, a_producer);
+        return false;
+    }
+
+    // Reject dependencies that would form a cycle.
+    std::vector<size_t> producers = m_entries[producer].producers;
+    std::vector<bool> visited(m_entries.size(), false);
+    while (!producers.empty())
+    {
+        const size_t index = producers.back();
+        producers.pop_back();
+        if (index == consumer)
+        {
+            printf("ShutdownCoordinator::AddDependency: '%s' already "
+                   "depends on '%s'\n", a_producer, a_consumer);
+            return false;
+        }
+        if (!visited[index])
+        {
+            visited[index] = true;
+            producers.insert(producers.end(),
+                             m_entries[index].producers.begin(),
+                             m_entries[index].producers.end());
+        }
+    }
+    m_entries[consumer].producers.push_back(producer);
+    return true;
+}
+
+//--------------------------------------------------------------
+//! Set the time each stage has to drain its loops, and the time it
+//! then has to stop them (so a stage takes at most twice as long).
+//! @param[in] a_deadline The time each stage has for each step.
+//--------------------------------------------------------------
+inline void ShutdownCoordinator::SetStageDeadline(
+    Clock::duration a_deadline)
+{
+    m_stageDeadline = a_deadline;
+}
+
+//--------------------------------------------------------------
+//! Shut down all loops in stages, ordered by their dependencies,
+//! blocking until all stages are done (or forced by the deadlines).
+//! Must not be called from a thread running any of the loops.
+//! @return True if all loops stopped before the deadlines.
+//--------------------------------------------------------------
+inline bool ShutdownCoordinator::ShutDown()
+{
+    const Clock::time_point begin = Clock::now();
+    std::vector<uint32_t> stages;
+    AssignStages(stages);
+    const uint32_t stageCount = stages.empty() ? 0 :
+        *std::max_element(stages.begin(), stages.end()) + 1;
+
+    m_report = Report();
+    m_report.stages.resize(stageCount);
+    m_report.loops.resize(m_entries.size());
+    for (size_t i = 0; i < m_entries.size(); ++i)
+    {
+        m_report.loops[i].name = m_entries[i].name;
+        m_report.loops[i].stage = stages[i];
+    }
+
+    constexpr std::chrono::milliseconds pollInterval(1);
+    for (uint32_t stage = 0; stage < stageCount; ++stage)
+    {
+        StageReport& stageReport = m_report.stages[stage];
+        const Clock::time_point stageBegin = Clock::now();
+        const Clock::time_point drainDeadline = stageBegin + m_stageDeadline;
+
+        // Poll until every loop of the stage has drained.
+        bool drained = false;
+        while (!drained)
+        {
+            drained = true;
+            for (size_t i = 0; i < m_entries.size(); ++i)
+            {
+                LoopReport& loopReport = m_report.loops[i];
+                if (stages[i] == stage && !loopReport.drained)
+                {
+                    const DrainFunc& drainFunc = m_entries[i].drainFunc;
+                    loopReport.drained = !drainFunc || drainFunc();
+                    drained &= loopReport.drained;
+                }
+            }
+            if (!drained)
+            {
+                if (Clock::now() >= drainDeadline)
+                {
+                    break;
+                }
+                std::this_thread::sleep_for(pollInterval);
+            }
+        }
+        const Clock::time_point drainEnd = Clock::now();
+        stageReport.drainDuration = drainEnd - stageBegin;
+
+        // Then until every loop of the stage has stopped, which has its
+        // own deadline so draining can't leave it no time. Run clears
+        // any earlier request when it starts, so the request is repeated
+        // until a loop has started, and a loop only counts as stopped
+        // once it has (the count is set after IsRunning, so read first).
+        const Clock::time_point stopDeadline = drainEnd + m_stageDeadline;
+        bool stopped = false;
+        while (!stopped)
+        {
+            stopped = true;
+            for (size_t i = 0; i < m_entries.size(); ++i)
+            {
+                LoopReport& loopReport = m_report.loops[i];
+                if (stages[i] == stage && !loopReport.stopped)
+                {
+                    UpdateLoop& loop = *m_entries[i].loop;
+                    loopReport.started = loop.GetRunCount() > 0;
+                    loopReport.stopped = loopReport.started &&
+                                         !loop.IsRunning();
+                    if (!loopReport.stopped)
+                    {
+                        loop.RequestShutDown();
+                    }
+                    stopped &= loopReport.stopped;
+                }
+            }
+            if (!stopped)
+            {
+                if (Clock::now() >= stopDeadline)
+                {
+                    break;
+                }
+                std::this_thread::sleep_for(pollInterval);
+            }
+        }
+        stageReport.stopDuration = Clock::now() - drainEnd;
+
+        // Force any loops that did not drain or stop in time.
+        for (size_t i = 0; i < m_entries.size(); ++i)
+        {
+            const LoopReport& loopReport = m_report.loops[i];
+            if (stages[i] == stage &&
+                (!loopReport.drained || !loopReport.stopped))
+            {
+                printf("ShutdownCoordinator: forcing '%s' to stop%s\n",
+                       loopReport.name.c_str(),
+                       loopReport.started ? "" : " (never started)");
+                stageReport.forced = true;
+                if (m_entries[i].forceFunc)
+                {
+                    m_entries[i].forceFunc();
+                }
+            }
+        }
+        m_report.forced |= stageReport.forced;
+    }
+
+    m_report.totalDuration = Clock::now() - begin;
+    return !m_report.forced;
+}
+
+//--------------------------------------------------------------
+//! Get the report of the last shut down.
+//! @return The report of the last shut down.
+//--------------------------------------------------------------
+inline const ShutdownCoordinator::Report&
+ShutdownCoordinator::GetReport() const
+{
+    return m_report;
+}
+
+//--------------------------------------------------------------
+inline size_t ShutdownCoordinator::Find(const char* a_name) const
+{
+    for (size_t i = 0; i < m_entries.size(); ++i)
+    {
+        if (m_entries[i].name == a_name)
+        {
+            return i;
+        }
+    }
+    return m_entries.size();
+}
+
+//--------------------------------------------------------------
+inline void ShutdownCoordinator::AssignStages(
+    std::vector<uint32_t>& o_stages) const
+{
+    // Each loop's stage is one after the last of its producers, so
+    // loops without producers are in the first stage. Dependencies
+    // never form cycles, so this settles within one pass per loop.
+    o_stages.assign(m_entries.size(), 0);
+    bool changed = true;
+    for (size_t pass = 0; changed && pass < m_entries.size(); ++pass)
+    {
+        changed = false;
+        for (size_t i = 0; i < m_entries.size(); ++i)
+        {
+            for (size_t producer : m_entries[i].producers)
+            {
+                if (o_stages[i] <= o_stages[producer])
+                {
+                    o_stages[i] = o_stages[producer] + 1;
+                    changed = true;
+                }
+            }
+        }
+    }
+}
+
+} // namespace Simple
@@ -0,0 +1,474 @@
+//--------------------------------------------------------------
+// Copyright (c) David Bosnich <david.bosnich.public@gmail.com>
+//
+// This code is licensed under the MIT License, a copy of which
+// can be found in the license.txt file included at the root of
+// this distribution, or at https://opensource.org/licenses/MIT
+//--------------------------------------------------------------
+
+#pragma once
+
+#include "update_loop.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <functional>
+#include <thread>
+
+#if defined(__linux__)
+#include <poll.h>
+#include <pthread.h>
+#include <signal.h>
+#include <sys/eventfd.h>
+#include <sys/signalfd.h>
+#include <unistd.h>
+#define SIMPLE_SIGNALFD_SUPPORTED 1
+#endif
+
+//! @file
+
+//--------------------------------------------------------------
+namespace Simple
+{
+
+#if SIMPLE_SIGNALFD_SUPPORTED
+//--------------------------------------------------------------
+//! Actions the update loop can take when a signal is received.
+//--------------------------------------------------------------
+enum class SignalAction : uint8_t
+{
+    None,       //!< Ignore the signal.
+    ShutDown,   //!< UpdateLoop::RequestShutDown.
+    Restart,    //!< UpdateLoop::RequestRestart.
+    Reload,     //!< Call the reload function (eg. to reload config).
+    DumpStats   //!< Call the dump stats function.
+};
+
+//--------------------------------------------------------------
+//! Handles SIGINT, SIGTERM, SIGHUP and SIGUSR1 for an update loop
+//! (linux only), so applications need neither a global pointer to
+//! the loop nor any async-signal-unsafe code in a signal handler.
+//!
+//! The signals are blocked, and consumed through a signalfd by a
+//! helper thread that maps them onto actions: by default, SIGINT
+//! and SIGTERM request a shut down, SIGHUP requests a restart, and
+//! SIGUSR1 dumps stats. Shut down and restart are requested from the
+//! helper thread at once, so take effect when the current frame ends.
+//! Other actions run on the thread running the loop before the next
+//! frame starts. So the latency from each signal to its action is
+//! bounded by (at most) two frames, and is measured and reported.
+//!
+//! Signal masks are inherited by new threads, so this must be
+//! constructed on the main thread before any other threads are
+//! (otherwise they could still be sent the signals directly), and
+//! destroyed on the same thread, which restores the original mask.
+//! As it acts on the loop between frames, it must not be created or
+//! destroyed while the loop is running (see UpdateLoop::Listener).
+//--------------------------------------------------------------
+class SignalHandler : public UpdateLoop::Listener
+{
+public:
+    using Clock = std::chrono::steady_clock;
+    using Duration = Clock::duration;
+    using ActionFunc = std::function<void()>;
+
+    struct Stats
+    {
+        uint64_t handledCount = 0;  //!< Actions taken (coalesced).
+        Duration lastLatency = Duration::zero();
+        Duration maxLatency = Duration::zero();
+        Duration totalLatency = Duration::zero();
+    };
+
+    explicit SignalHandler(UpdateLoop& a_loop);
+    ~SignalHandler() override;
+
+    SignalHandler(const SignalHandler&) = delete;
+    SignalHandler& operator=(const SignalHandler&) = delete;
+
+    bool SetAction(int a_signal, SignalAction a_action);
+    SignalAction GetAction(int a_signal) const;
+
+    void SetReloadFunc(ActionFunc a_reloadFunc);
+    void SetDumpStatsFunc(ActionFunc a_dumpStatsFunc);
+
+    bool IsHandling() const;
+    uint64_t GetReceivedCount() const;
+    const Stats& GetStats() const;
+
+    void OnPhaseBegin(UpdatePhase a_phase) override;
+
+private:
+    static constexpr int MaxSignal = 32;
+    static constexpr int ActionCount = 5;
+
+    static bool IsHandled(int a_signal);
+    static int64_t ToNs(Clock::time_point a_time);
+
+    void HandleMain();
+    void OnReceived(int a_signal);
+    bool TakePending(SignalAction a_action, Clock::time_point a_now);
+    void DumpStats() const;
+
+    UpdateLoop& m_loop;
+    ActionFunc m_reloadFunc;
+    ActionFunc m_dumpStatsFunc;
+    std::atomic<uint8_t> m_actions[MaxSignal];
+    std::atomic<int64_t> m_pendingTimes[ActionCount];
+    std::atomic<uint64_t> m_receivedCount = { 0 };
+    Stats m_stats;
+
+    // Frames since the loop started up, for the default stats dump.
+    // Written only by the thread running the loop.
+    Clock::time_point m_lastFrameTime;
+    Duration m_lastFrameDuration = Duration::zero();
+    Duration m_totalFrameDuration = Duration::zero();
+    uint64_t m_frameCount = 0;
+
+    sigset_t m_signals;
+    sigset_t m_previousMask;
+    int m_signalFd = -1;
+    int m_stopFd = -1;
+    std::thread m_thread;
+};
+
+//--------------------------------------------------------------
+//! Constructor. Blocks the signals on the calling thread, and
+//! starts the helper thread that consumes them.
+//! @param[in] a_loop The loop to act on (and listen to).
+//--------------------------------------------------------------
+inline SignalHandler::SignalHandler(UpdateLoop& a_loop)
+    : m_loop(a_loop)
+{
+    for (std::atomic<uint8_t>& action : m_actions)
+    {
+        action.store((uint8_t)SignalAction::None);
+    }
+    for (std::atomic<int64_t>& pendingTime : m_pendingTimes)
+    {
+        pendingTime.store(0);
+    }
+    m_actions[SIGINT].store((uint8_t)SignalAction::ShutDown);
+    m_actions[SIGTERM].store((uint8_t)SignalAction::ShutDown);
+    m_actions[SIGHUP].store((uint8_t)SignalAction::Restart);
+    m_actions[SIGUSR1].store((uint8_t)SignalAction::DumpStats);
+
+    sigemptyset(&m_signals);
+    sigaddset(&m_signals, SIGINT);
+    sigaddset(&m_signals, SIGTERM);
+    sigaddset(&m_signals, SIGHUP);
+    sigaddset(&m_signals, SIGUSR1);
+    pthread_sigmask(SIG_BLOCK, &m_signals, &m_previousMask);
+
+    m_signalFd = signalfd(-1, &m_signals, SFD_CLOEXEC);
+    m_stopFd = eventfd(0, EFD_CLOEXEC);
+    if (m_signalFd < 0 || m_stopFd < 0)
+    {
+        // Unblock the signals again, as nothing would consume them.
+        printf("SignalHandler: cannot create signalfd/eventfd\n");
+        if (m_signalFd >= 0)
+        {
+            close(m_signalFd);
+            m_signalFd = -1;
+        }
+        if (m_stopFd >= 0)
+        {
+            close(m_stopFd);
+            m_stopFd = -1;
+        }
+        pthread_sigmask(SIG_SETMASK, &m_previousMask, nullptr);
+        return;
+    }
+    m_thread = std::thread(&SignalHandler::HandleMain, this);
+    m_loop.AddListener(this);
+}
+
+//--------------------------------------------------------------
+//! Destructor. Stops the helper thread and restores the signal mask
+//! (so any signal still pending is then delivered as normal).
+//--------------------------------------------------------------
+inline SignalHandler::~SignalHandler()
+{
+    m_loop.RemoveListener(this);
+    if (!IsHandling())
+    {
+        return; // Failed to start, so already restored the mask.
+    }
+
+    const uint64_t stop = 1;
+    if (write(m_stopFd, &stop, sizeof(stop)) != sizeof(stop))
+    {
+        printf("SignalHandler: cannot stop the helper thread\n");
+    }
+    m_thread.join();
+    close(m_signalFd);
+    close(m_stopFd);
+    pthread_sigmask(SIG_SETMASK, &m_previousMask, nullptr);
+}
+
+//--------------------------------------------------------------
+//! Set the action taken when a signal is received.
+//! @param[in] a_signal SIGINT, SIGTERM, SIGHUP or SIGUSR1.
+//! @param[in] a_action The action to take when it is received.
+//! @return True if set, or false if the signal is not handled.
+//--------------------------------------------------------------
+inline bool SignalHandler::SetAction(int a_signal, SignalAction a_action)
+{
+    if (!IsHandled(a_signal))
+    {
+        printf("SignalHandler: signal %d is not handled\n", a_signal);
+        return false;
+    }
+    m_actions[a_signal].store((uint8_t)a_action,
+                              std::memory_order_relaxed);
+    return true;
+}
+
+//--------------------------------------------------------------
+//! Get the action taken when a signal is received.
+//! @param[in] a_signal The signal to get the action of.
+//! @return The action taken (or None if the signal is not handled).
+//--------------------------------------------------------------
+inline SignalAction SignalHandler::GetAction(int a_signal) const
+{
+    return IsHandled(a_signal) ?
+           (SignalAction)m_actions[a_signal].load(
+               std::memory_order_relaxed) :
+           SignalAction::None;
+}
+
+//--------------------------------------------------------------
+//! Set the function called on the thread running the loop for the
+//! Reload action. Must not be called while the loop is running,
+//! except from the thread running it.
+//! @param[in] a_reloadFunc The function to call.
+//--------------------------------------------------------------
+inline void SignalHandler::SetReloadFunc(ActionFunc a_reloadFunc)
+{
+    m_reloadFunc = a_reloadFunc;
+}
+
+//--------------------------------------------------------------
+//! Set the function called on the thread running the loop for the
+//! DumpStats action, instead of printing the frame stats of the loop
+//! (since it last started up) along with the stats of this handler.
+//! Must not be called while the loop is running, except from the
+//! thread running it.
+//! @param[in] a_dumpStatsFunc The function to call.
+//--------------------------------------------------------------
+inline void SignalHandler::SetDumpStatsFunc(ActionFunc a_dumpStatsFunc)
+{
+    m_dumpStatsFunc = a_dumpStatsFunc;
+}
+
+//--------------------------------------------------------------
+//! Check whether the helper thread is consuming signals.
+//! @return True if the helper thread is consuming signals.
+//--------------------------------------------------------------
+inline bool SignalHandler::IsHandling() const
+{
+    return m_thread.joinable();
+}
+
+//--------------------------------------------------------------
+//! Get the count of signals received (from any thread).
+//! @return The count of signals received.
+//--------------------------------------------------------------
+inline uint64_t SignalHandler::GetReceivedCount() const
+{
+    return m_receivedCount.load(std::memory_order_acquire);
+}
+
+//--------------------------------------------------------------
+//! Get the stats of the actions taken, including the latency from
+//! each signal being received to its action being taken. Must only
+//! be called from the thread running the loop (or when stopped).
+//! @return The stats of the actions taken.
+//--------------------------------------------------------------
+inline const SignalHandler::Stats& SignalHandler::GetStats() const
+{
+    return m_stats;
+}
+
+//--------------------------------------------------------------
+//! Takes the actions of signals received since the last frame, or
+//! records the latency of a shut down or restart. A shut down that
+//! is still pending when the loop starts up (eg. a signal received
+//! before Run, which clears any requests) is requested again.
+//! @param[in] a_phase The phase of the loop that is about to begin.
+//--------------------------------------------------------------
+inline void SignalHandler::OnPhaseBegin(UpdatePhase a_phase)
+{
+    const Clock::time_point now = Clock::now();
+    if (a_phase == UpdatePhase::StartUp)
+    {
+        if (m_pendingTimes[(int)SignalAction::ShutDown].load(
+                std::memory_order_acquire) != 0)
+        {
+            m_loop.RequestShutDown();
+        }
+
+        // A restart still pending is done by starting up anyway.
+        TakePending(SignalAction::Restart, now);
+        m_lastFrameDuration = Duration::zero();
+        m_totalFrameDuration = Duration::zero();
+        m_frameCount = 0;
+    }
+    else if (a_phase == UpdatePhase::Start)
+    {
+        if (m_frameCount > 0)
+        {
+            m_lastFrameDuration = now - m_lastFrameTime;
+            m_totalFrameDuration += m_lastFrameDuration;
+        }
+        m_lastFrameTime = now;
+        ++m_frameCount;
+
+        if (TakePending(SignalAction::Reload, now))
+        {
+            if (m_reloadFunc)
+            {
+                m_reloadFunc();
+            }
+            else
+            {
+                printf("SignalHandler: no reload function is set\n");
+            }
+        }
+        if (TakePending(SignalAction::DumpStats, now))
+        {
+            if (m_dumpStatsFunc)
+            {
+                m_dumpStatsFunc();
+            }
+            else
+            {
+                DumpStats();
+            }
+        }
+    }
+    else if (a_phase == UpdatePhase::ShutDown)
+    {
+        TakePending(SignalAction::ShutDown, now);
+        TakePending(SignalAction::Restart, now);
+    }
+}
+
+//--------------------------------------------------------------
+inline bool SignalHandler::IsHandled(int a_signal)
+{
+    return a_signal == SIGINT || a_signal == SIGTERM ||
+           a_signal == SIGHUP || a_signal == SIGUSR1;
+}
+
+//--------------------------------------------------------------
+inline int64_t SignalHandler::ToNs(Clock::time_point a_time)
+{
+    using namespace std::chrono;
+    return duration_cast<nanoseconds>(a_time.time_since_epoch()).count();
+}
+
+//--------------------------------------------------------------
+inline void SignalHandler::HandleMain()
+{
+    pollfd fds[2] = {};
+    fds[0].fd = m_signalFd;
+    fds[0].events = POLLIN;
+    fds[1].fd = m_stopFd;
+    fds[1].events = POLLIN;
+    while (true)
+    {
+        if (poll(fds, 2, -1) < 0)
+        {
+            continue;   // Interrupted.
+        }
+        if (fds[1].revents)
+        {
+            return;
+        }
+        signalfd_siginfo info;
+        if (fds[0].revents &&
+            read(m_signalFd, &info, sizeof(info)) == sizeof(info))
+        {
+            OnReceived((int)info.ssi_signo);
+        }
+    }
+}
+
+//--------------------------------------------------------------
+inline void SignalHandler::OnReceived(int a_signal)
+{
+    m_receivedCount.fetch_add(1, std::memory_order_acq_rel);
+    const SignalAction action = GetAction(a_signal);
+    if (action == SignalAction::None)
+    {
+        return;
+    }
+
+    // Keep the time of the first signal if already pending, so the
+    // latency reported is that of the oldest signal (when coalesced).
+    int64_t expected = 0;
+    m_pendingTimes[(int)action].compare_exchange_strong(
+        expected, ToNs(Clock::now()), std::memory_order_acq_rel);
+    if (action == SignalAction::ShutDown)
+    {
+        m_loop.RequestShutDown();
+    }
+    else if (action == SignalAction::Restart)
+    {
+        m_loop.RequestRestart();
+    }
+}
+
+//--------------------------------------------------------------
+inline bool SignalHandler::TakePending(SignalAction a_action,
+                                       Clock::time_point a_now)
+{
+    const int64_t receivedTime = m_pendingTimes[(int)a_action].exchange(
+        0, std::memory_order_acq_rel);
+    if (receivedTime == 0)
+    {
+        return false;
+    }
+    const Duration latency = std::chrono::duration_cast<Duration>(
+        std::chrono::nanoseconds(ToNs(a_now) - receivedTime));
+    ++m_stats.handledCount;
+    m_stats.lastLatency = latency;
+    m_stats.maxLatency = std::max(m_stats.maxLatency, latency);
+    m_stats.totalLatency += latency;
+    return true;
+}
+
+//--------------------------------------------------------------
+inline void SignalHandler::DumpStats() const
+{
+    // Frames are counted as they start, so the durations are of all
+    // but the current one (which has only just started).
+    using namespace std::chrono;
+    const double totalSeconds = duration<double>(
+        m_totalFrameDuration).count();
+    const double averageFPS = totalSeconds > 0.0 ?
+        (double)(m_frameCount - 1) / totalSeconds : 0.0;
+    printf("SignalHandler: frames %llu, average fps %.1f, "
+           "last frame %lld us, target fps %u, capped %d\n",
+           (unsigned long long)m_frameCount,
+           averageFPS,
+           (long long)duration_cast<microseconds>(
+               m_lastFrameDuration).count(),
+           m_loop.GetTargetFPS(),
+           m_loop.GetCappedFPS() ? 1 : 0);
+    printf("SignalHandler: received %llu, handled %llu, "
+           "latency last %lld us, max %lld us\n",
+           (unsigned long long)GetReceivedCount(),
+           (unsigned long long)m_stats.handledCount,
+           (long long)duration_cast<microseconds>(
+               m_stats.lastLatency).count(),
+           (long long)duration_cast<microseconds>(
+               m_stats.maxLatency).count());
+}
+#endif//SIMPLE_SIGNALFD_SUPPORTED
+
+} // namespace Simple
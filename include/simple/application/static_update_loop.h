@@ -0,0 +1,1116 @@
+//--------------------------------------------------------------
+// Copyright (c) David Bosnich <david.bosnich.public@gmail.com>
+//
+// This code is licensed under the MIT License, a copy of which
+// can be found in the license.txt file included at the root of
+// this distribution, or at https://opensource.org/licenses/MIT
+//--------------------------------------------------------------
+
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <exception>
+#include <thread>
+#include <type_traits>
+
+#if defined(__cpp_exceptions) || defined(__EXCEPTIONS) || defined(_CPPUNWIND)
+#define SIMPLE_LOOP_EXCEPTIONS_ENABLED 1
+#endif
+
+//! @file
+
+//--------------------------------------------------------------
+//! The target frames per second at which to run the update loop.
+//! Default value; underlying variable can be changed at runtime.
+//---------------------------------------------------------------
+#ifndef DEFAULT_TARGET_FPS
+#define DEFAULT_TARGET_FPS 60u
+#endif//DEFAULT_TARGET_FPS
+
+//--------------------------------------------------------------
+//! Whether to cap the number of frames per second to the target.
+//! Default value; underlying variable can be changed at runtime.
+//--------------------------------------------------------------
+#ifndef DEFAULT_CAPPED_FPS
+#define DEFAULT_CAPPED_FPS true
+#endif//DEFAULT_CAPPED_FPS
+
+//--------------------------------------------------------------
+//! The maximum count of fixed updates the loop can fall behind by
+//! and still catch up on (one each frame while running uncapped).
+//! Default value; underlying variable can be changed at runtime.
+//--------------------------------------------------------------
+#ifndef DEFAULT_MAX_CATCH_UP
+#define DEFAULT_MAX_CATCH_UP 1u
+#endif//DEFAULT_MAX_CATCH_UP
+
+//--------------------------------------------------------------
+//! The time to wait after the second consecutive frame with errors
+//! contained, doubling for each after that up to the maximum below.
+//! Default value; underlying variable can be changed at runtime.
+//--------------------------------------------------------------
+#ifndef DEFAULT_ERROR_BACKOFF_MS
+#define DEFAULT_ERROR_BACKOFF_MS 1u
+#endif//DEFAULT_ERROR_BACKOFF_MS
+
+//--------------------------------------------------------------
+//! The maximum time to wait after consecutive frames with errors.
+//! Default value; underlying variable can be changed at runtime.
+//--------------------------------------------------------------
+#ifndef DEFAULT_MAX_ERROR_BACKOFF_MS
+#define DEFAULT_MAX_ERROR_BACKOFF_MS 1000u
+#endif//DEFAULT_MAX_ERROR_BACKOFF_MS
+
+//--------------------------------------------------------------
+namespace Simple
+{
+
+//--------------------------------------------------------------
+//! The phases of the update loop, in the order they are called.
+//--------------------------------------------------------------
+enum class UpdatePhase : uint8_t
+{
+    StartUp,    //!< UpdateLoop::StartUp (once each run).
+    Start,      //!< UpdateLoop::UpdateStart (once each frame).
+    Fixed,      //!< UpdateLoop::UpdateFixed (at most each frame).
+    Ended,      //!< UpdateLoop::UpdateEnded (once each frame).
+    ShutDown    //!< UpdateLoop::ShutDown (once each run).
+};
+
+//--------------------------------------------------------------
+//! Get the name of a phase of the update loop (eg. for reports).
+//! @param[in] a_phase The phase to get the name of.
+//! @return The name of the phase.
+//--------------------------------------------------------------
+inline const char* GetUpdatePhaseName(UpdatePhase a_phase)
+{
+    switch (a_phase)
+    {
+        case UpdatePhase::StartUp: return "StartUp";
+        case UpdatePhase::Start: return "Start";
+        case UpdatePhase::Fixed: return "Fixed";
+        case UpdatePhase::Ended: return "Ended";
+        case UpdatePhase::ShutDown: return "ShutDown";
+    }
+    return "Unknown";
+}
+
+//--------------------------------------------------------------
+//! What the update loop does after an error (exception) is thrown
+//! from a phase and contained, in order of increasing severity.
+//--------------------------------------------------------------
+enum class FrameErrorAction : uint8_t
+{
+    Continue,   //!< Continue with the rest of the frame.
+    SkipFrame,  //!< Skip the rest of the frame, then continue.
+    Restart,    //!< Skip the rest of the frame, then restart.
+    ShutDown,   //!< Skip the rest of the frame, then shut down.
+    Rethrow     //!< As ShutDown, then rethrow it from Run.
+};
+
+//--------------------------------------------------------------
+//! An error (exception) thrown from a phase of the update loop.
+//--------------------------------------------------------------
+struct FrameError
+{
+    UpdatePhase phase;          //!< Phase the error was thrown from.
+    uint64_t frameIndex;        //!< Frames completed before the error.
+    uint32_t consecutiveCount;  //!< Consecutive frames with errors.
+    const char* what;           //!< Description of the error.
+};
+
+//--------------------------------------------------------------
+//! Policies that can be passed to StaticUpdateLoop, in any order.
+//! Each derives from the tag of its category, and the first one
+//! passed for a category replaces the default for that category.
+//--------------------------------------------------------------
+namespace LoopPolicy
+{
+
+//--------------------------------------------------------------
+//! Tags from which all policies of each category derive.
+//--------------------------------------------------------------
+struct ClockTag {};
+struct RateTag {};
+struct WaitTag {};
+struct StatsTag {};
+struct ErrorTag {};
+
+//--------------------------------------------------------------
+//! Clock policy used to measure the duration of each frame.
+//--------------------------------------------------------------
+template<class ClockType = std::chrono::steady_clock>
+struct Clock : ClockTag
+{
+    using ClockT = ClockType;
+};
+
+//--------------------------------------------------------------
+//! Rate policy (default) where the target fps and whether it is
+//! capped can be changed at any time, from any thread (atomics).
+//--------------------------------------------------------------
+class RuntimeRate : public RateTag
+{
+public:
+    void SetTargetFPS(uint32_t a_targetFPS);
+    void SetCappedFPS(bool a_cappedFPS);
+    void SetMaxCatchUp(uint32_t a_maxCatchUp);
+
+    uint32_t GetTargetFPS() const;
+    bool GetCappedFPS() const;
+    uint32_t GetMaxCatchUp() const;
+
+protected:
+    void InitTargetFPS(uint32_t a_targetFPS);
+
+private:
+    std::atomic_uint m_targetFPS = { DEFAULT_TARGET_FPS };
+    std::atomic_bool m_cappedFPS = { DEFAULT_CAPPED_FPS };
+    std::atomic_uint m_maxCatchUp = { DEFAULT_MAX_CATCH_UP };
+};
+
+//--------------------------------------------------------------
+//! Rate policy where the target fps and whether it is capped are
+//! fixed at compile time, so all frame durations are constants.
+//! The target fps passed to StaticUpdateLoop::Run is ignored.
+//--------------------------------------------------------------
+template<uint32_t TargetFPS, bool CappedFPS = true>
+class FixedRate : public RateTag
+{
+    static_assert(TargetFPS > 0, "Target fps must be at least one");
+
+public:
+    static constexpr uint32_t GetTargetFPS() { return TargetFPS; }
+    static constexpr bool GetCappedFPS() { return CappedFPS; }
+    static constexpr uint32_t GetMaxCatchUp() { return DEFAULT_MAX_CATCH_UP; }
+
+protected:
+    void InitTargetFPS(uint32_t) {}
+};
+
+//--------------------------------------------------------------
+//! Wait policy (default) that spins until the end of each capped
+//! frame, for the most accurate pacing at the cost of a core.
+//--------------------------------------------------------------
+struct SpinWait : WaitTag
+{
+    template<class ClockType>
+    static typename ClockType::time_point WaitUntil(
+        typename ClockType::time_point a_endTime);
+};
+
+//--------------------------------------------------------------
+//! Wait policy that sleeps until shortly before the end of each
+//! capped frame and then spins, trading accuracy for idle time.
+//--------------------------------------------------------------
+struct SleepWait : WaitTag
+{
+    template<class ClockType>
+    static typename ClockType::time_point WaitUntil(
+        typename ClockType::time_point a_endTime);
+};
+
+//--------------------------------------------------------------
+//! Strategies selectable at runtime by the RuntimeWait policy.
+//--------------------------------------------------------------
+enum class WaitStrategy : uint8_t
+{
+    Spin,   //!< As SpinWait.
+    Sleep   //!< As SleepWait.
+};
+
+//--------------------------------------------------------------
+//! Wait policy where the strategy can be changed at any time, from
+//! any thread (atomic), eg. from command line options. Spins until
+//! it is changed, like the default SpinWait.
+//--------------------------------------------------------------
+class RuntimeWait : public WaitTag
+{
+public:
+    void SetWaitStrategy(WaitStrategy a_waitStrategy);
+    WaitStrategy GetWaitStrategy() const;
+
+    template<class ClockType>
+    typename ClockType::time_point WaitUntil(
+        typename ClockType::time_point a_endTime) const;
+
+private:
+    std::atomic<uint8_t> m_waitStrategy = {
+        (uint8_t)WaitStrategy::Spin };
+};
+
+//--------------------------------------------------------------
+//! Stats policy (default) that fills all of the frame stats.
+//--------------------------------------------------------------
+struct FullStats : StatsTag
+{
+    static constexpr bool Enabled = true;
+    static constexpr bool AverageFPS = true;
+};
+
+//--------------------------------------------------------------
+//! Stats policy that fills all of the frame stats except for the
+//! average fps, which requires a division each frame to compute.
+//--------------------------------------------------------------
+struct BasicStats : StatsTag
+{
+    static constexpr bool Enabled = true;
+    static constexpr bool AverageFPS = false;
+};
+
+//--------------------------------------------------------------
+//! Stats policy that never fills the frame stats, so the derived
+//! class's OnFrameComplete (if declared) is never called either.
+//--------------------------------------------------------------
+struct NoStats : StatsTag
+{
+    static constexpr bool Enabled = false;
+    static constexpr bool AverageFPS = false;
+};
+
+//--------------------------------------------------------------
+//! Error policy (default) where errors (exceptions) thrown from any
+//! phase are not caught, so propagate out of Run immediately.
+//--------------------------------------------------------------
+struct PropagateErrors : ErrorTag
+{
+    static constexpr bool Enabled = false;
+};
+
+//--------------------------------------------------------------
+//! Error policy where errors (exceptions) thrown from each phase are
+//! caught and counted (including those thrown from the OnPhaseBegin/
+//! OnPhaseEnded hooks around it, and from OnFrameComplete, which is
+//! counted as the Ended phase), then passed to the derived class's
+//! OnFrameError
+//! (if declared) which returns the action to take, by default the one
+//! set at any time from any thread (atomic). After consecutive frames
+//! with errors, the loop waits for an exponentially increasing time
+//! before continuing (or restarting) to avoid spinning on failures,
+//! unless (or until) a shut down is requested while it is waiting.
+//--------------------------------------------------------------
+class ContainErrors : public ErrorTag
+{
+public:
+    static constexpr bool Enabled = true;
+
+    void SetFrameErrorAction(FrameErrorAction a_action);
+    void SetErrorBackoff(std::chrono::milliseconds a_backoff,
+                         std::chrono::milliseconds a_maxBackoff);
+
+    FrameErrorAction GetFrameErrorAction() const;
+    uint64_t GetErrorCount(UpdatePhase a_phase) const;
+    uint64_t GetErrorCount() const;
+
+protected:
+    void CountError(UpdatePhase a_phase);
+    std::chrono::milliseconds GetErrorBackoff(
+        uint32_t a_consecutiveCount) const;
+
+private:
+    std::atomic<uint8_t> m_action = {
+        (uint8_t)FrameErrorAction::Rethrow };
+    std::atomic_uint m_backoffMs = { DEFAULT_ERROR_BACKOFF_MS };
+    std::atomic_uint m_maxBackoffMs = { DEFAULT_MAX_ERROR_BACKOFF_MS };
+    std::atomic<uint64_t> m_errorCounts[5] = {}; // Each UpdatePhase.
+};
+
+//--------------------------------------------------------------
+//! Select the first policy in a pack that derives from the tag,
+//! or the default policy if none of them do.
+//--------------------------------------------------------------
+template<class Tag, class Default, class... Policies>
+struct Select
+{
+    using Type = Default;
+};
+
+//--------------------------------------------------------------
+template<class Tag, class Default, class First, class... Rest>
+struct Select<Tag, Default, First, Rest...>
+{
+    using Type = typename std::conditional<
+        std::is_base_of<Tag, First>::value,
+        First,
+        typename Select<Tag, Default, Rest...>::Type>::type;
+};
+
+} // namespace LoopPolicy
+
+//--------------------------------------------------------------
+//! Update loop that calls the hooks of the class deriving from it
+//! (CRTP) directly instead of through virtual functions, so small
+//! phases can be inlined when running at very high frame rates.
+//!
+//! Runs with the same lifecycle as UpdateLoop, which is itself the
+//! default instantiation. Any hook not declared by the derived class
+//! is an empty inline function, and frame stats are only gathered if
+//! it declares OnFrameComplete. Optional OnPhaseBegin/OnPhaseEnded
+//! hooks are called with the UpdatePhase before/after each phase.
+//! The derived class must either declare its hooks public, or make
+//! this class a friend (eg. friend class StaticUpdateLoop<MyLoop>).
+//!
+//! Policies select the clock (LoopPolicy::Clock), the rate (eg.
+//! LoopPolicy::FixedRate), the wait strategy used to cap frames (eg.
+//! LoopPolicy::SleepWait), the stats (eg. LoopPolicy::NoStats), and
+//! whether errors are contained (eg. LoopPolicy::ContainErrors). The
+//! rate, wait and error policies are bases, so any runtime setters
+//! they have (eg. SetTargetFPS, SetWaitStrategy) are part of the loop.
+//--------------------------------------------------------------
+template<class Derived, class... Policies>
+class StaticUpdateLoop : public LoopPolicy::Select<LoopPolicy::RateTag,
+                                                   LoopPolicy::RuntimeRate,
+                                                   Policies...>::Type
+                       , public LoopPolicy::Select<LoopPolicy::WaitTag,
+                                                   LoopPolicy::SpinWait,
+                                                   Policies...>::Type
+                       , public LoopPolicy::Select<LoopPolicy::ErrorTag,
+                                                   LoopPolicy::PropagateErrors,
+                                                   Policies...>::Type
+{
+public:
+    using ClockPolicy = typename LoopPolicy::Select<
+        LoopPolicy::ClockTag, LoopPolicy::Clock<>, Policies...>::Type;
+    using RatePolicy = typename LoopPolicy::Select<
+        LoopPolicy::RateTag, LoopPolicy::RuntimeRate, Policies...>::Type;
+    using WaitPolicy = typename LoopPolicy::Select<
+        LoopPolicy::WaitTag, LoopPolicy::SpinWait, Policies...>::Type;
+    using StatsPolicy = typename LoopPolicy::Select<
+        LoopPolicy::StatsTag, LoopPolicy::FullStats, Policies...>::Type;
+    using ErrorPolicy = typename LoopPolicy::Select<
+        LoopPolicy::ErrorTag, LoopPolicy::PropagateErrors,
+        Policies...>::Type;
+
+    using Clock = typename ClockPolicy::ClockT;
+    using Duration = typename Clock::duration;
+    using TimePoint = typename Clock::time_point;
+
+    StaticUpdateLoop() = default;
+    ~StaticUpdateLoop() = default;
+
+    StaticUpdateLoop(const StaticUpdateLoop&) = delete;
+    StaticUpdateLoop& operator=(const StaticUpdateLoop&) = delete;
+
+    void Run(uint32_t a_targetFPS = DEFAULT_TARGET_FPS);
+    std::thread RunInThread(uint32_t a_targetFPS = 60u);
+
+    void RequestShutDown();
+    void RequestRestart();
+    bool IsRunning() const;
+    uint64_t GetRunCount() const;
+
+protected:
+    void StartUp() {}
+    void ShutDown() {}
+
+    void UpdateStart(float) {}
+    void UpdateFixed(float) {}
+    void UpdateEnded(float) {}
+
+    void OnPhaseBegin(UpdatePhase) {}
+    void OnPhaseEnded(UpdatePhase) {}
+
+    struct FrameStats
+    {
+        uint64_t frameCount = 0;
+        uint32_t averageFPS = 0;
+        uint32_t targetFPS = 0;
+        Duration actualDur = {};
+        Duration targetDur = {};
+        Duration excessDur = {};
+        Duration totalDur = {};
+    };
+    void OnFrameComplete(const FrameStats&) {}
+
+    FrameErrorAction OnFrameError(const FrameError&)
+    {
+        return this->GetFrameErrorAction();
+    }
+
+private:
+    struct ErrorState
+    {
+        uint64_t frameIndex = 0;
+        uint32_t consecutiveCount = 0;
+        bool thrown = false;
+        FrameErrorAction action = FrameErrorAction::Continue;
+        std::exception_ptr exception;
+    };
+
+    // Only contain errors thrown from phases if the policy does.
+    using ContainsErrors = std::integral_constant<bool,
+        ErrorPolicy::Enabled>;
+
+    Derived& GetDerived();
+    template<class Call>
+    bool CallPhase(UpdatePhase a_phase, ErrorState& io_errorState,
+                   Call a_call, std::true_type);
+    template<class Call>
+    bool CallPhase(UpdatePhase, ErrorState&, Call a_call, std::false_type)
+    {
+        a_call();
+        return true;
+    }
+    template<class Call>
+    bool RunPhase(UpdatePhase a_phase, ErrorState& io_errorState,
+                  Call a_call);
+    bool ContainError(UpdatePhase a_phase, ErrorState& io_errorState,
+                      const char* a_what);
+    void EndPhases(ErrorState& io_errorState, bool a_frameEnded,
+                   std::true_type);
+    void EndPhases(ErrorState&, bool, std::false_type) {}
+
+    void CompleteFrame(FrameStats& a_frameStats,
+                       ErrorState& io_errorState,
+                       uint32_t a_targetFPS,
+                       Duration a_lastDuration,
+                       Duration a_targetDuration,
+                       Duration a_accumulatedDuration,
+                       std::true_type);
+    void CompleteFrame(FrameStats&, ErrorState&, uint32_t,
+                       Duration, Duration, Duration,
+                       std::false_type) {}
+
+    std::atomic_bool m_shutDownRequested = { false };
+    std::atomic_bool m_restartRequested = { false };
+    std::atomic_bool m_runningInThread = { false };
+    std::atomic_bool m_running = { false };
+    std::atomic<uint64_t> m_runCount = { 0 };
+};
+
+//--------------------------------------------------------------
+//! Run the update loop at the target fps, in the current thread.
+//! @param[in] a_targetFPS The target fps (optional, default=60).
+//--------------------------------------------------------------
+template<class Derived, class... Policies>
+inline void StaticUpdateLoop<Derived, Policies...>::Run(
+    uint32_t a_targetFPS)
+{
+    // Only gather frame stats if the derived class will use them.
+    // Evaluated here (not in the class) where Derived is complete.
+    using HasOnFrameComplete = std::integral_constant<bool,
+        StatsPolicy::Enabled &&
+        !std::is_same<decltype(&Derived::OnFrameComplete),
+                      void (StaticUpdateLoop::*)(const FrameStats&)>
+        ::value>;
+
+    ErrorState errorState;
+
+    // Running until Run returns, including by an error propagating.
+    struct RunningScope
+    {
+        std::atomic_bool& running;
+        ~RunningScope() { running.store(false, std::memory_order_release); }
+    } runningScope = { m_running };
+    m_running.store(true, std::memory_order_release);
+    m_runCount.fetch_add(1, std::memory_order_release);
+
+    // Set the target frames per second.
+    this->InitTargetFPS(a_targetFPS);
+
+    do
+    {
+        // Clear any shut down or restart requests.
+        m_shutDownRequested = false;
+        m_restartRequested = false;
+
+        // Start the application.
+        RunPhase(UpdatePhase::StartUp, errorState,
+                 [this]() { GetDerived().StartUp(); });
+        EndPhases(errorState, false, ContainsErrors());
+
+        // Initialize accumulated frame duration with the target
+        // duration to ensure a fixed update on the first frame.
+        constexpr intmax_t oneSecond = Duration::period::den /
+                                       Duration::period::num;
+        Duration accumulatedDuration(oneSecond /
+                                     this->GetTargetFPS());
+
+        // Initialize other values used to track frame duration.
+        Duration lastDuration = Duration::zero();
+        TimePoint lastEndTime = Clock::now();
+        FrameStats frameStats = {};
+
+        // Loop until a shut down or restart is requested.
+        while (!m_shutDownRequested && !m_restartRequested)
+        {
+            // Target frame duration is fixed but depends on
+            // the target fps that can change between frames
+            // (unless it is fixed at compile time by policy).
+            const uint32_t targetFPS = this->GetTargetFPS();
+            const Duration targetDuration(oneSecond / targetFPS);
+            const float fixedTime = 1.0f / (float)targetFPS;
+
+            // Update at the start of each frame with a variable
+            // delta time, derived using the last frame duration,
+            // for non-deterministic systems requiring an update
+            // each frame prior to any fixed updates (eg. input).
+            // Cap in case the app is running slower than target.
+            constexpr float oneSecondFloat = (float)oneSecond;
+            const float durationF = (float)lastDuration.count();
+            const float deltaTime = durationF / oneSecondFloat;
+            const float deltaTimeCapped = std::min(deltaTime,
+                                                   fixedTime);
+            // The rest of a frame is skipped if an error thrown
+            // from a phase is contained with any action other than
+            // continue (which is always the case if not contained).
+            bool continueFrame = RunPhase(UpdatePhase::Start,
+                errorState,
+                [this, deltaTimeCapped]()
+                { GetDerived().UpdateStart(deltaTimeCapped); });
+
+            // Check if accumulated duration has reached target.
+            if (continueFrame && accumulatedDuration >= targetDuration)
+            {
+                // Update with a fixed delta time, derived from
+                // the target frame duration, for deterministic
+                // systems requiring fixed deltas (eg. physics).
+                continueFrame = RunPhase(UpdatePhase::Fixed,
+                    errorState,
+                    [this, fixedTime]()
+                    { GetDerived().UpdateFixed(fixedTime); });
+
+                // Reduce accumulated duration by the amount
+                // 'consumed' by the update. Clamp remainder
+                // so it does not increase indefinitely when
+                // app is running slower than the target fps.
+                accumulatedDuration -= targetDuration;
+                const Duration maxCatchUpDuration = targetDuration *
+                    (intmax_t)this->GetMaxCatchUp();
+                if (accumulatedDuration > maxCatchUpDuration)
+                {
+                    accumulatedDuration = maxCatchUpDuration;
+                }
+            }
+
+            // Update at the end of each frame with the same
+            // variable delta time for any non-deterministic
+            // systems requiring updates at the end of every
+            // frame after any fixed updates (eg. rendering).
+            if (continueFrame)
+            {
+                RunPhase(UpdatePhase::Ended, errorState,
+                         [this, deltaTimeCapped]()
+                         { GetDerived().UpdateEnded(deltaTimeCapped); });
+            }
+
+            // Calculate time elapsed since the last frame ended,
+            // and if capped wait until reaching target duration.
+            TimePoint endTime = Clock::now();
+            if (this->GetCappedFPS() &&
+                endTime - lastEndTime < targetDuration)
+            {
+                endTime = WaitPolicy::template WaitUntil<Clock>(
+                    lastEndTime + targetDuration);
+            }
+            lastDuration = endTime - lastEndTime;
+            accumulatedDuration += lastDuration;
+            lastEndTime = endTime;
+
+            // Send frame stat values (if they will be used).
+            CompleteFrame(frameStats,
+                          errorState,
+                          targetFPS,
+                          lastDuration,
+                          targetDuration,
+                          accumulatedDuration,
+                          HasOnFrameComplete());
+
+            // Act on any errors contained during the frame.
+            EndPhases(errorState, true, ContainsErrors());
+        }
+
+        // Stop the application.
+        RunPhase(UpdatePhase::ShutDown, errorState,
+                 [this]() { GetDerived().ShutDown(); });
+        EndPhases(errorState, false, ContainsErrors());
+    }
+    // Return if shut down was requested, loop if restart was.
+    while (!m_shutDownRequested && m_restartRequested);
+
+#if SIMPLE_LOOP_EXCEPTIONS_ENABLED
+    // Rethrow the first error contained with that action (if any).
+    if (errorState.exception)
+    {
+        std::rethrow_exception(errorState.exception);
+    }
+#endif//SIMPLE_LOOP_EXCEPTIONS_ENABLED
+}
+
+//--------------------------------------------------------------
+//! Run the update loop at the target fps, spawning a new thread.
+//! @param[in] a_targetFPS The target fps (optional, default=60).
+//! @return The thread which was spawned to run the update loop.
+//--------------------------------------------------------------
+template<class Derived, class... Policies>
+inline std::thread StaticUpdateLoop<Derived, Policies...>::RunInThread(
+    uint32_t a_targetFPS)
+{
+    std::thread runThread([this, a_targetFPS]()
+    {
+        bool expected = false;
+        if (m_runningInThread.compare_exchange_strong(expected,
+                                                      true))
+        {
+            Run(a_targetFPS);
+            m_runningInThread.store(false,
+                                    std::memory_order_release);
+        }
+        else
+        {
+            printf("UpdateLoop already running in thread.\n");
+        }
+    });
+    return runThread;
+}
+
+//--------------------------------------------------------------
+//! Request termination of the update loop.
+//--------------------------------------------------------------
+template<class Derived, class... Policies>
+inline void StaticUpdateLoop<Derived, Policies...>::RequestShutDown()
+{
+    m_shutDownRequested = true;
+}
+
+//--------------------------------------------------------------
+//! Request a restart of the update loop.
+//--------------------------------------------------------------
+template<class Derived, class... Policies>
+inline void StaticUpdateLoop<Derived, Policies...>::RequestRestart()
+{
+    m_restartRequested = true;
+}
+
+//--------------------------------------------------------------
+//! Check whether the update loop is running (in any thread), which
+//! it is from the start of Run until after the final ShutDown.
+//! @return True if the update loop is running.
+//--------------------------------------------------------------
+template<class Derived, class... Policies>
+inline bool StaticUpdateLoop<Derived, Policies...>::IsRunning() const
+{
+    return m_running.load(std::memory_order_acquire);
+}
+
+//--------------------------------------------------------------
+//! Get the number of times Run has been called, counted once it
+//! is running, so a loop that has not yet started returns zero
+//! (eg. just after RunInThread, before its thread calls Run).
+//! @return The number of times the update loop has been run.
+//--------------------------------------------------------------
+template<class Derived, class... Policies>
+inline uint64_t StaticUpdateLoop<Derived, Policies...>::GetRunCount() const
+{
+    return m_runCount.load(std::memory_order_acquire);
+}
+
+//--------------------------------------------------------------
+template<class Derived, class... Policies>
+inline Derived& StaticUpdateLoop<Derived, Policies...>::GetDerived()
+{
+    return *static_cast<Derived*>(this);
+}
+
+//--------------------------------------------------------------
+template<class Derived, class... Policies>
+template<class Call>
+inline bool StaticUpdateLoop<Derived, Policies...>::CallPhase(
+    UpdatePhase a_phase,
+    ErrorState& io_errorState,
+    Call a_call,
+    std::true_type)
+{
+#if SIMPLE_LOOP_EXCEPTIONS_ENABLED
+    try
+    {
+        a_call();
+    }
+    catch (const std::exception& a_exception)
+    {
+        return ContainError(a_phase, io_errorState, a_exception.what());
+    }
+    catch (...)
+    {
+        return ContainError(a_phase, io_errorState, "unknown exception");
+    }
+#else
+    (void)a_phase;
+    (void)io_errorState;
+    a_call();
+#endif//SIMPLE_LOOP_EXCEPTIONS_ENABLED
+    return true;
+}
+
+//--------------------------------------------------------------
+template<class Derived, class... Policies>
+template<class Call>
+inline bool StaticUpdateLoop<Derived, Policies...>::RunPhase(
+    UpdatePhase a_phase,
+    ErrorState& io_errorState,
+    Call a_call)
+{
+    // The hooks around a phase are contained as part of it, and the
+    // end hook is always called (eg. so listeners stay balanced) but
+    // the phase itself is skipped if the begin hook skips the frame.
+    Derived& derived = GetDerived();
+    bool continuePhase = CallPhase(a_phase, io_errorState,
+        [&derived, a_phase]() { derived.OnPhaseBegin(a_phase); },
+        ContainsErrors());
+    if (continuePhase)
+    {
+        continuePhase = CallPhase(a_phase, io_errorState, a_call,
+                                  ContainsErrors());
+    }
+    const bool continueEnded = CallPhase(a_phase, io_errorState,
+        [&derived, a_phase]() { derived.OnPhaseEnded(a_phase); },
+        ContainsErrors());
+    return continuePhase && continueEnded;
+}
+
+//--------------------------------------------------------------
+template<class Derived, class... Policies>
+inline bool StaticUpdateLoop<Derived, Policies...>::ContainError(
+    UpdatePhase a_phase,
+    ErrorState& io_errorState,
+    const char* a_what)
+{
+    // Count each frame with errors once, however many it has.
+    if (!io_errorState.thrown)
+    {
+        io_errorState.thrown = true;
+        ++io_errorState.consecutiveCount;
+    }
+    this->CountError(a_phase);
+
+    FrameError frameError;
+    frameError.phase = a_phase;
+    frameError.frameIndex = io_errorState.frameIndex;
+    frameError.consecutiveCount = io_errorState.consecutiveCount;
+    frameError.what = a_what;
+    const FrameErrorAction action = GetDerived().OnFrameError(frameError);
+
+    // Called while handling the exception, so it can be captured.
+    if (action == FrameErrorAction::Rethrow && !io_errorState.exception)
+    {
+        io_errorState.exception = std::current_exception();
+    }
+    io_errorState.action = std::max(io_errorState.action, action);
+    return action == FrameErrorAction::Continue;
+}
+
+//--------------------------------------------------------------
+template<class Derived, class... Policies>
+inline void StaticUpdateLoop<Derived, Policies...>::EndPhases(
+    ErrorState& io_errorState,
+    bool a_frameEnded,
+    std::true_type)
+{
+    // Consecutive errors are only reset by a frame without any, so
+    // that errors thrown from each start up (ie. when restarting)
+    // are also counted as consecutive.
+    if (a_frameEnded)
+    {
+        ++io_errorState.frameIndex;
+    }
+    if (!io_errorState.thrown)
+    {
+        if (a_frameEnded)
+        {
+            io_errorState.consecutiveCount = 0;
+        }
+        return;
+    }
+
+    switch (io_errorState.action)
+    {
+        case FrameErrorAction::Continue:
+        case FrameErrorAction::SkipFrame:
+        case FrameErrorAction::Restart:
+        {
+            if (io_errorState.action == FrameErrorAction::Restart)
+            {
+                m_restartRequested = true;
+            }
+            // Sleep in short slices, so a shut down requested while
+            // waiting is seen promptly instead of after the backoff.
+            constexpr std::chrono::milliseconds slice(1);
+            const std::chrono::milliseconds backoff =
+                this->GetErrorBackoff(io_errorState.consecutiveCount);
+            const std::chrono::steady_clock::time_point endTime =
+                std::chrono::steady_clock::now() + backoff;
+            std::chrono::steady_clock::time_point now =
+                std::chrono::steady_clock::now();
+            while (now < endTime && !m_shutDownRequested)
+            {
+                std::this_thread::sleep_for(std::min<
+                    std::chrono::steady_clock::duration>(endTime - now,
+                                                         slice));
+                now = std::chrono::steady_clock::now();
+            }
+        }
+        break;
+        case FrameErrorAction::ShutDown:
+        case FrameErrorAction::Rethrow:
+        {
+            m_shutDownRequested = true;
+        }
+        break;
+    }
+    io_errorState.thrown = false;
+    io_errorState.action = FrameErrorAction::Continue;
+}
+
+//--------------------------------------------------------------
+template<class Derived, class... Policies>
+inline void StaticUpdateLoop<Derived, Policies...>::CompleteFrame(
+    FrameStats& a_frameStats,
+    ErrorState& io_errorState,
+    uint32_t a_targetFPS,
+    Duration a_lastDuration,
+    Duration a_targetDuration,
+    Duration a_accumulatedDuration,
+    std::true_type)
+{
+    const intmax_t frameCount = ++a_frameStats.frameCount;
+    a_frameStats.totalDur += a_lastDuration;
+    a_frameStats.targetFPS = a_targetFPS;
+    a_frameStats.actualDur = a_lastDuration;
+    a_frameStats.targetDur = a_targetDuration;
+    a_frameStats.excessDur = a_accumulatedDuration;
+    if (StatsPolicy::AverageFPS)
+    {
+        constexpr intmax_t oneSecond = Duration::period::den /
+                                       Duration::period::num;
+        const intmax_t fpsNum = frameCount * oneSecond;
+        const intmax_t fpsDen = a_frameStats.totalDur.count();
+        a_frameStats.averageFPS = fpsDen ?
+                                  (uint32_t)(fpsNum / fpsDen) : 0;
+    }
+    CallPhase(UpdatePhase::Ended, io_errorState,
+              [this, &a_frameStats]()
+              { GetDerived().OnFrameComplete(a_frameStats); },
+              ContainsErrors());
+}
+
+//--------------------------------------------------------------
+//! Set the target fps. If the update loop is not yet running it
+//! will be overridden by the target fps sent to the Run function.
+//! @param[in] a_targetFPS The target fps to run the update loop.
+//--------------------------------------------------------------
+inline void LoopPolicy::RuntimeRate::SetTargetFPS(uint32_t a_targetFPS)
+{
+    // Must always target at least one frame per second.
+    m_targetFPS = a_targetFPS ? a_targetFPS : 1;
+}
+
+//--------------------------------------------------------------
+//! Set whether the update loop is run capped to the target fps.
+//! @param[in] a_cappedFPS Should the update loop be run capped?
+//--------------------------------------------------------------
+inline void LoopPolicy::RuntimeRate::SetCappedFPS(bool a_cappedFPS)
+{
+    m_cappedFPS = a_cappedFPS;
+}
+
+//--------------------------------------------------------------
+//! Set the maximum count of fixed updates the update loop can fall
+//! behind by and catch up on, one each frame while running uncapped.
+//! @param[in] a_maxCatchUp Count of fixed updates (at least one).
+//--------------------------------------------------------------
+inline void LoopPolicy::RuntimeRate::SetMaxCatchUp(uint32_t a_maxCatchUp)
+{
+    m_maxCatchUp = a_maxCatchUp ? a_maxCatchUp : 1;
+}
+
+//--------------------------------------------------------------
+//! Get the target fps that the update loop has been set to run.
+//! @return Target fps that the update loop has been set to run.
+//--------------------------------------------------------------
+inline uint32_t LoopPolicy::RuntimeRate::GetTargetFPS() const
+{
+    return m_targetFPS;
+}
+
+//--------------------------------------------------------------
+//! Get whether the update loop is run capped to the target fps.
+//! @return True if update loop is run capped to the target fps.
+//--------------------------------------------------------------
+inline bool LoopPolicy::RuntimeRate::GetCappedFPS() const
+{
+    return m_cappedFPS;
+}
+
+//--------------------------------------------------------------
+//! Get the maximum count of fixed updates to catch up on.
+//! @return The maximum count of fixed updates to catch up on.
+//--------------------------------------------------------------
+inline uint32_t LoopPolicy::RuntimeRate::GetMaxCatchUp() const
+{
+    return m_maxCatchUp;
+}
+
+//--------------------------------------------------------------
+inline void LoopPolicy::RuntimeRate::InitTargetFPS(uint32_t a_targetFPS)
+{
+    SetTargetFPS(a_targetFPS);
+}
+
+//--------------------------------------------------------------
+//! Set the action to take after an error is contained, unless one is
+//! returned by the derived class's OnFrameError (if declared).
+//! @param[in] a_action The action to take after an error.
+//--------------------------------------------------------------
+inline void LoopPolicy::ContainErrors::SetFrameErrorAction(
+    FrameErrorAction a_action)
+{
+    m_action.store((uint8_t)a_action, std::memory_order_relaxed);
+}
+
+//--------------------------------------------------------------
+//! Set the time to wait after consecutive frames with errors.
+//! @param[in] a_backoff The time to wait after the second, which
+//!            doubles for each after that (zero to never wait).
+//! @param[in] a_maxBackoff The maximum time to wait.
+//--------------------------------------------------------------
+inline void LoopPolicy::ContainErrors::SetErrorBackoff(
+    std::chrono::milliseconds a_backoff,
+    std::chrono::milliseconds a_maxBackoff)
+{
+    m_backoffMs = (uint32_t)std::max<int64_t>(a_backoff.count(), 0);
+    m_maxBackoffMs = (uint32_t)std::max<int64_t>(a_maxBackoff.count(), 0);
+}
+
+//--------------------------------------------------------------
+//! Get the action to take after an error is contained.
+//! @return The action to take after an error.
+//--------------------------------------------------------------
+inline FrameErrorAction
+LoopPolicy::ContainErrors::GetFrameErrorAction() const
+{
+    return (FrameErrorAction)m_action.load(std::memory_order_relaxed);
+}
+
+//--------------------------------------------------------------
+//! Get the count of errors contained from a phase.
+//! @param[in] a_phase The phase to get the count of errors from.
+//! @return The count of errors contained from the phase.
+//--------------------------------------------------------------
+inline uint64_t LoopPolicy::ContainErrors::GetErrorCount(
+    UpdatePhase a_phase) const
+{
+    return m_errorCounts[(size_t)a_phase].load(std::memory_order_relaxed);
+}
+
+//--------------------------------------------------------------
+//! Get the count of errors contained from all phases.
+//! @return The count of errors contained from all phases.
+//--------------------------------------------------------------
+inline uint64_t LoopPolicy::ContainErrors::GetErrorCount() const
+{
+    uint64_t errorCount = 0;
+    for (const std::atomic<uint64_t>& count : m_errorCounts)
+    {
+        errorCount += count.load(std::memory_order_relaxed);
+    }
+    return errorCount;
+}
+
+//--------------------------------------------------------------
+inline void LoopPolicy::ContainErrors::CountError(UpdatePhase a_phase)
+{
+    m_errorCounts[(size_t)a_phase].fetch_add(1, std::memory_order_relaxed);
+}
+
+//--------------------------------------------------------------
+inline std::chrono::milliseconds LoopPolicy::ContainErrors::GetErrorBackoff(
+    uint32_t a_consecutiveCount) const
+{
+    // No wait after the first, then double up to the maximum.
+    const uint64_t maxBackoffMs = m_maxBackoffMs;
+    if (a_consecutiveCount < 2)
+    {
+        return std::chrono::milliseconds(0);
+    }
+    const uint32_t doublings = std::min(a_consecutiveCount - 2, 32u);
+    const uint64_t backoffMs = (uint64_t)m_backoffMs << doublings;
+    return std::chrono::milliseconds(std::min(backoffMs, maxBackoffMs));
+}
+
+//--------------------------------------------------------------
+//! Spin until the given time.
+//! @param[in] a_endTime The time to wait until.
+//! @return The time after waiting (not before the given time).
+//--------------------------------------------------------------
+template<class ClockType>
+inline typename ClockType::time_point LoopPolicy::SpinWait::WaitUntil(
+    typename ClockType::time_point a_endTime)
+{
+    typename ClockType::time_point now;
+    do
+    {
+        now = ClockType::now();
+    }
+    while (now < a_endTime);
+    return now;
+}
+
+//--------------------------------------------------------------
+//! Sleep until shortly before the given time, then spin until it.
+//! @param[in] a_endTime The time to wait until.
+//! @return The time after waiting (not before the given time).
+//--------------------------------------------------------------
+template<class ClockType>
+inline typename ClockType::time_point LoopPolicy::SleepWait::WaitUntil(
+    typename ClockType::time_point a_endTime)
+{
+    // Wake early to allow for the usual oversleep of the scheduler.
+    constexpr std::chrono::microseconds margin(1000);
+    typename ClockType::time_point now = ClockType::now();
+    if (a_endTime - now > margin)
+    {
+        std::this_thread::sleep_for(a_endTime - now - margin);
+    }
+    return SpinWait::WaitUntil<ClockType>(a_endTime);
+}
+
+//--------------------------------------------------------------
+//! Set the strategy used to wait until the end of capped frames.
+//! @param[in] a_waitStrategy The strategy used to wait.
+//--------------------------------------------------------------
+inline void LoopPolicy::RuntimeWait::SetWaitStrategy(
+    WaitStrategy a_waitStrategy)
+{
+    m_waitStrategy.store((uint8_t)a_waitStrategy,
+                         std::memory_order_relaxed);
+}
+
+//--------------------------------------------------------------
+//! Get the strategy used to wait until the end of capped frames.
+//! @return The strategy used to wait.
+//--------------------------------------------------------------
+inline LoopPolicy::WaitStrategy
+LoopPolicy::RuntimeWait::GetWaitStrategy() const
+{
+    return (WaitStrategy)m_waitStrategy.load(std::memory_order_relaxed);
+}
+
+//--------------------------------------------------------------
+//! Wait until the given time, using the current strategy.
+//! @param[in] a_endTime The time to wait until.
+//! @return The time after waiting (not before the given time).
+//--------------------------------------------------------------
+template<class ClockType>
+inline typename ClockType::time_point LoopPolicy::RuntimeWait::WaitUntil(
+    typename ClockType::time_point a_endTime) const
+{
+    return GetWaitStrategy() == WaitStrategy::Sleep ?
+           SleepWait::WaitUntil<ClockType>(a_endTime) :
+           SpinWait::WaitUntil<ClockType>(a_endTime);
+}
+
+} // namespace Simple
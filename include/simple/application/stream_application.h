@@ -0,0 +1,622 @@
+//--------------------------------------------------------------
+// Copyright (c) David Bosnich <david.bosnich.public@gmail.com>
+//
+// This code is licensed under the MIT License, a copy of which
+// can be found in the license.txt file included at the root of
+// this distribution, or at https://opensource.org/licenses/MIT
+//--------------------------------------------------------------
+
+#pragma once
+
+#include "application.h"
+
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <vector>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#define SIMPLE_RECORD_STREAM_SUPPORTED 1
+#endif
+
+//! @file
+
+#if SIMPLE_RECORD_STREAM_SUPPORTED
+
+//--------------------------------------------------------------
+namespace Simple
+{
+
+//--------------------------------------------------------------
+//! A batch of whole records pulled from a RecordStream. The data
+//! is only valid until the next batch is pulled from the stream.
+//--------------------------------------------------------------
+struct StreamBatch
+{
+    const char* data = nullptr;
+    size_t size = 0;
+    uint32_t recordCount = 0;
+    const uint32_t* recordOffsets = nullptr;
+    int delimiter = -1;
+
+    const char* GetRecord(uint32_t a_index, size_t& o_size) const;
+};
+
+//--------------------------------------------------------------
+//! Pulls bounded batches of records from a file or pipe. Regular
+//! files are memory mapped and batched in place, while pipes are
+//! read (without blocking) into a buffer that is reused. Records
+//! are separated by a delimiter, or are of a fixed size if set.
+//--------------------------------------------------------------
+class RecordStream
+{
+public:
+    RecordStream() = default;
+    ~RecordStream();
+
+    RecordStream(const RecordStream&) = delete;
+    RecordStream& operator=(const RecordStream&) = delete;
+
+    bool Open(const char* a_path);
+    bool Open(int a_fileDescriptor);
+    void Close();
+
+    void SetRecordDelimiter(char a_delimiter);
+    void SetRecordSize(uint32_t a_recordSize);
+    void SetMaxBytes(size_t a_maxBytes);
+
+    bool Pull(uint32_t a_maxRecords, StreamBatch& o_batch);
+    bool IsOpen() const;
+    bool IsEnded() const;
+    bool IsMapped() const;
+
+private:
+    void Read();
+    size_t Split(const char* a_data,
+                 size_t a_size,
+                 uint32_t a_maxRecords,
+                 bool a_final);
+
+    std::vector<char> m_buffer;
+    std::vector<uint32_t> m_recordOffsets;
+    const char* m_mapped = nullptr;
+    size_t m_mappedSize = 0;
+    size_t m_position = 0;
+    size_t m_buffered = 0;
+    size_t m_maxBytes = 64 * 1024;
+    uint32_t m_recordSize = 0;
+    int m_fileDescriptor = -1;
+    char m_delimiter = '\n';
+    bool m_ownsDescriptor = false;
+    bool m_readEnded = false;
+    bool m_ended = false;
+};
+
+//--------------------------------------------------------------
+//! An Application that processes one bounded batch of records of
+//! an input stream on each fixed update, adapting the batch size
+//! to hit a target duration, and shutting down at end of stream.
+//--------------------------------------------------------------
+class StreamApplication : public Application
+{
+public:
+    StreamApplication() = default;
+    StreamApplication(int a_argc, char* a_argv[]);
+    ~StreamApplication() override = default;
+
+    StreamApplication(const StreamApplication&) = delete;
+    StreamApplication& operator=(const StreamApplication&) = delete;
+
+    RecordStream& GetStream();
+
+    void SetBatchLimits(uint32_t a_maxRecords, size_t a_maxBytes);
+    void SetTargetBatchDuration(Duration a_targetDuration);
+    uint32_t GetBatchRecordLimit() const;
+
+protected:
+    virtual void UpdateBatch(const StreamBatch& a_batch,
+                             float a_fixedTimeSeconds) = 0;
+
+    struct StreamStats : FrameStats
+    {
+        uint32_t batchRecords = 0;
+        uint32_t batchRecordLimit = 0;
+        size_t batchBytes = 0;
+        Duration batchDur = {};
+        uint64_t totalRecords = 0;
+        uint64_t totalBytes = 0;
+        uint64_t recordsPerSecond = 0;
+        uint64_t bytesPerSecond = 0;
+    };
+    virtual void OnStreamComplete(const StreamStats& a_streamStats);
+
+    void UpdateFixed(float a_fixedTimeSeconds) final;
+    void OnFrameComplete(const FrameStats& a_frameStats) final;
+
+private:
+    void AdaptBatchLimit(uint32_t a_batchRecords,
+                         Duration a_batchDuration);
+
+    RecordStream m_stream;
+    StreamStats m_streamStats;
+    Duration m_targetBatchDur = Duration::zero();
+    uint32_t m_maxRecords = 1024;
+    uint32_t m_recordLimit = 1024;
+};
+
+//--------------------------------------------------------------
+//! Get one record of the batch, excluding any delimiter.
+//! @param[in] a_index Index of the record, less than recordCount.
+//! @param[out] o_size Size (bytes) of the record, no delimiter.
+//! @return Pointer to the start of the record within the batch.
+//--------------------------------------------------------------
+inline const char* StreamBatch::GetRecord(uint32_t a_index,
+                                          size_t& o_size) const
+{
+    const uint32_t begin = recordOffsets[a_index];
+    const uint32_t end = recordOffsets[a_index + 1];
+    o_size = end - begin;
+    if (o_size && delimiter >= 0 &&
+        data[end - 1] == (char)delimiter)
+    {
+        --o_size;
+    }
+    return data + begin;
+}
+
+//--------------------------------------------------------------
+//! Destructor. Closes the stream if it is still open.
+//--------------------------------------------------------------
+inline RecordStream::~RecordStream()
+{
+    Close();
+}
+
+//--------------------------------------------------------------
+//! Open a stream of records from a file, or stdin if "-". Files
+//! that are regular (not pipes) are memory mapped to batch them.
+//! @param[in] a_path Path of the file to open, or "-" for stdin.
+//! @return True if the stream was opened, false otherwise.
+//--------------------------------------------------------------
+inline bool RecordStream::Open(const char* a_path)
+{
+    if (!a_path || strcmp(a_path, "-") == 0)
+    {
+        return Open(STDIN_FILENO);
+    }
+
+    const int fd = open(a_path, O_RDONLY);
+    if (fd < 0)
+    {
+        printf("RecordStream failed to open '%s'.\n", a_path);
+        return false;
+    }
+
+    const bool opened = Open(fd);
+    m_ownsDescriptor = opened;
+    if (!opened)
+    {
+        close(fd);
+    }
+    return opened;
+}
+
+//--------------------------------------------------------------
+//! Open a stream of records from a file descriptor (not owned).
+//! @param[in] a_fileDescriptor Descriptor of an open file or pipe.
+//! @return True if the stream was opened, false otherwise.
+//--------------------------------------------------------------
+inline bool RecordStream::Open(int a_fileDescriptor)
+{
+    Close();
+
+    struct stat fileStat;
+    if (a_fileDescriptor < 0 || fstat(a_fileDescriptor, &fileStat))
+    {
+        printf("RecordStream invalid file descriptor.\n");
+        return false;
+    }
+
+    // Map regular files so that batches can reference records in
+    // place, avoiding any copies; anything else is read instead.
+    if (S_ISREG(fileStat.st_mode) && fileStat.st_size > 0)
+    {
+        const size_t size = (size_t)fileStat.st_size;
+        void* mapped = mmap(nullptr, size, PROT_READ, MAP_PRIVATE,
+                            a_fileDescriptor, 0);
+        if (mapped != MAP_FAILED)
+        {
+            madvise(mapped, size, MADV_SEQUENTIAL);
+            m_mapped = static_cast<const char*>(mapped);
+            m_mappedSize = size;
+        }
+    }
+
+    m_fileDescriptor = a_fileDescriptor;
+    m_ownsDescriptor = false;
+    m_position = 0;
+    m_buffered = 0;
+    m_readEnded = S_ISREG(fileStat.st_mode) && !fileStat.st_size;
+    m_ended = false;
+    return true;
+}
+
+//--------------------------------------------------------------
+//! Close the stream, releasing any mapping or owned descriptor.
+//--------------------------------------------------------------
+inline void RecordStream::Close()
+{
+    if (m_mapped)
+    {
+        munmap(const_cast<char*>(m_mapped), m_mappedSize);
+    }
+    if (m_ownsDescriptor)
+    {
+        close(m_fileDescriptor);
+    }
+
+    m_mapped = nullptr;
+    m_mappedSize = 0;
+    m_fileDescriptor = -1;
+    m_ownsDescriptor = false;
+    m_ended = false;
+}
+
+//--------------------------------------------------------------
+//! Set the character that separates records (default newline).
+//! @param[in] a_delimiter The character that separates records.
+//--------------------------------------------------------------
+inline void RecordStream::SetRecordDelimiter(char a_delimiter)
+{
+    m_delimiter = a_delimiter;
+    m_recordSize = 0;
+}
+
+//--------------------------------------------------------------
+//! Set a fixed record size (bytes), used instead of a delimiter.
+//! @param[in] a_recordSize Size of each record, or 0 to delimit.
+//--------------------------------------------------------------
+inline void RecordStream::SetRecordSize(uint32_t a_recordSize)
+{
+    m_recordSize = a_recordSize;
+}
+
+//--------------------------------------------------------------
+//! Set the maximum size (bytes) of each batch that is pulled. A
+//! record larger than this is split in order to make progress.
+//! @param[in] a_maxBytes The maximum size (bytes) of each batch.
+//--------------------------------------------------------------
+inline void RecordStream::SetMaxBytes(size_t a_maxBytes)
+{
+    m_maxBytes = a_maxBytes ? a_maxBytes : 1;
+}
+
+//--------------------------------------------------------------
+//! Pull the next batch of whole records without blocking, which
+//! may be empty if none are available yet (eg. an idle pipe).
+//! @param[in] a_maxRecords Maximum records to pull in the batch.
+//! @param[out] o_batch The batch, valid until the next pull.
+//! @return True if the stream has not ended, false once it has.
+//--------------------------------------------------------------
+inline bool RecordStream::Pull(uint32_t a_maxRecords,
+                               StreamBatch& o_batch)
+{
+    o_batch = StreamBatch();
+    o_batch.delimiter = m_recordSize ? -1 : (unsigned char)m_delimiter;
+    if (m_fileDescriptor < 0 || m_ended)
+    {
+        return false;
+    }
+
+    const char* data = nullptr;
+    size_t available = 0;
+    if (m_mapped)
+    {
+        data = m_mapped + m_position;
+        available = std::min(m_mappedSize - m_position, m_maxBytes);
+        m_readEnded = (m_position + available == m_mappedSize);
+    }
+    else
+    {
+        // Drop what the last batch consumed, then read more.
+        Read();
+        data = m_buffer.data();
+        available = m_buffered;
+    }
+
+    const size_t size = Split(data, available, a_maxRecords,
+                              m_readEnded);
+    o_batch.data = data;
+    o_batch.size = size;
+    o_batch.recordCount = (uint32_t)(m_recordOffsets.size() - 1);
+    o_batch.recordOffsets = m_recordOffsets.data();
+
+    m_position += size;
+    m_ended = m_readEnded && (size == available);
+    return !m_ended || o_batch.recordCount;
+}
+
+//--------------------------------------------------------------
+//! Get whether the stream is open.
+//! @return True if the stream is open, false otherwise.
+//--------------------------------------------------------------
+inline bool RecordStream::IsOpen() const
+{
+    return m_fileDescriptor >= 0;
+}
+
+//--------------------------------------------------------------
+//! Get whether every record of the stream has been pulled.
+//! @return True if every record of the stream has been pulled.
+//--------------------------------------------------------------
+inline bool RecordStream::IsEnded() const
+{
+    return m_ended;
+}
+
+//--------------------------------------------------------------
+//! Get whether the stream is memory mapped (a regular file).
+//! @return True if the stream is memory mapped, false otherwise.
+//--------------------------------------------------------------
+inline bool RecordStream::IsMapped() const
+{
+    return m_mapped != nullptr;
+}
+
+//--------------------------------------------------------------
+inline void RecordStream::Read()
+{
+    // Move any bytes left over from the last batch to the front.
+    const size_t consumed = m_position;
+    if (consumed)
+    {
+        m_buffered -= consumed;
+        memmove(m_buffer.data(), m_buffer.data() + consumed,
+                m_buffered);
+        m_position = 0;
+    }
+
+    if (m_buffer.size() < m_maxBytes)
+    {
+        m_buffer.resize(m_maxBytes);
+    }
+
+    // Read whatever is available without blocking, until either
+    // the buffer is full, the pipe is empty, or the stream ends.
+    while (!m_readEnded && m_buffered < m_maxBytes)
+    {
+        pollfd pollFd = { m_fileDescriptor, POLLIN, 0 };
+        if (poll(&pollFd, 1, 0) <= 0)
+        {
+            break;
+        }
+
+        const ssize_t bytesRead = read(m_fileDescriptor,
+                                       m_buffer.data() + m_buffered,
+                                       m_maxBytes - m_buffered);
+        if (bytesRead > 0)
+        {
+            m_buffered += (size_t)bytesRead;
+        }
+        else if (bytesRead < 0 && (errno == EAGAIN ||
+                                   errno == EWOULDBLOCK))
+        {
+            break;  // Nothing more yet (non-blocking), try next frame.
+        }
+        else if (bytesRead == 0 || errno != EINTR)
+        {
+            m_readEnded = true;
+        }
+    }
+}
+
+//--------------------------------------------------------------
+inline size_t RecordStream::Split(const char* a_data,
+                                  size_t a_size,
+                                  uint32_t a_maxRecords,
+                                  bool a_final)
+{
+    m_recordOffsets.clear();
+    m_recordOffsets.push_back(0);
+
+    size_t end = 0;
+    while (m_recordOffsets.size() <= a_maxRecords && end < a_size)
+    {
+        size_t next = 0;
+        if (m_recordSize)
+        {
+            next = end + m_recordSize;
+            next = (next <= a_size) ? next : 0;
+        }
+        else
+        {
+            const void* found = memchr(a_data + end, m_delimiter,
+                                       a_size - end);
+            next = found ? (static_cast<const char*>(found) -
+                            a_data) + 1 : 0;
+        }
+
+        if (!next)
+        {
+            // The last record is incomplete. Take it anyway if the
+            // stream has ended, or if it alone fills the batch.
+            const bool full = (end == 0 && a_size == m_maxBytes);
+            if (!a_final && !full)
+            {
+                break;
+            }
+            next = a_size;
+        }
+
+        end = next;
+        m_recordOffsets.push_back((uint32_t)end);
+    }
+    return end;
+}
+
+//--------------------------------------------------------------
+//! Constructor.
+//! \param[in] a_argc Count of arguments passed to the program.
+//! \param[in] a_argv Array of arguments passed to the program.
+//--------------------------------------------------------------
+inline StreamApplication::StreamApplication(int a_argc,
+                                            char* a_argv[])
+    : Application(a_argc, a_argv)
+{
+}
+
+//--------------------------------------------------------------
+//! Get the stream of records that is batched each fixed update.
+//! @return The stream of records batched each fixed update.
+//--------------------------------------------------------------
+inline RecordStream& StreamApplication::GetStream()
+{
+    return m_stream;
+}
+
+//--------------------------------------------------------------
+//! Set the limits of each batch; if adapting to a target batch
+//! duration the record limit will be adjusted up to the maximum.
+//! @param[in] a_maxRecords Maximum records in a single batch.
+//! @param[in] a_maxBytes Maximum bytes in a single batch.
+//--------------------------------------------------------------
+inline void StreamApplication::SetBatchLimits(uint32_t a_maxRecords,
+                                              size_t a_maxBytes)
+{
+    m_maxRecords = a_maxRecords ? a_maxRecords : 1;
+    m_recordLimit = m_maxRecords;
+    m_stream.SetMaxBytes(a_maxBytes);
+}
+
+//--------------------------------------------------------------
+//! Set the duration each batch should take to process, adapting
+//! the record limit of each batch to hit it (zero to disable).
+//! @param[in] a_targetDuration Target duration of each batch.
+//--------------------------------------------------------------
+inline void StreamApplication::SetTargetBatchDuration(
+    Duration a_targetDuration)
+{
+    m_targetBatchDur = a_targetDuration;
+    m_recordLimit = m_maxRecords;
+}
+
+//--------------------------------------------------------------
+//! Get the record limit of the next batch.
+//! @return The record limit of the next batch.
+//--------------------------------------------------------------
+inline uint32_t StreamApplication::GetBatchRecordLimit() const
+{
+    return m_recordLimit;
+}
+
+//--------------------------------------------------------------
+//! Called once at the completion of each frame with some stats,
+//! extended with the throughput of the batch and of the stream.
+//! Should only be used for debug/diagnostic/profiling purposes.
+//! @param[in] a_streamStats Stats related to the completed frame.
+//--------------------------------------------------------------
+inline void StreamApplication::OnStreamComplete(const StreamStats&)
+{
+}
+
+//--------------------------------------------------------------
+//! Pulls the next batch from the stream and passes it on to the
+//! UpdateBatch method, requesting shut down at end of stream.
+//! @param[in] a_fixedTimeSeconds Target frame duration (fixed).
+//--------------------------------------------------------------
+inline void StreamApplication::UpdateFixed(float a_fixedTimeSeconds)
+{
+    StreamBatch batch;
+    const TimePoint batchStart = Clock::now();
+    const bool more = m_stream.Pull(m_recordLimit, batch);
+    if (batch.recordCount)
+    {
+        UpdateBatch(batch, a_fixedTimeSeconds);
+    }
+    const Duration batchDuration = Clock::now() - batchStart;
+
+    m_streamStats.batchRecords += batch.recordCount;
+    m_streamStats.batchBytes += batch.size;
+    m_streamStats.batchDur += batchDuration;
+    AdaptBatchLimit(batch.recordCount, batchDuration);
+
+    if (!more || m_stream.IsEnded())
+    {
+        RequestShutDown();
+    }
+}
+
+//--------------------------------------------------------------
+//! Adds stream throughput to the frame stats then forwards them.
+//! @param[in] a_frameStats Stats related to the completed frame.
+//--------------------------------------------------------------
+inline void StreamApplication::OnFrameComplete(
+    const FrameStats& a_frameStats)
+{
+    // Restart the stream totals along with the frame stats.
+    if (a_frameStats.frameCount == 1)
+    {
+        m_streamStats.totalRecords = 0;
+        m_streamStats.totalBytes = 0;
+    }
+
+    static_cast<FrameStats&>(m_streamStats) = a_frameStats;
+    m_streamStats.batchRecordLimit = m_recordLimit;
+    m_streamStats.totalRecords += m_streamStats.batchRecords;
+    m_streamStats.totalBytes += m_streamStats.batchBytes;
+
+    // In floating point, as the totals scaled to the clock's period
+    // would overflow 64 bits within a long run (eg. ~18GB in ns).
+    const double totalSeconds =
+        std::chrono::duration<double>(a_frameStats.totalDur).count();
+    if (totalSeconds > 0.0)
+    {
+        m_streamStats.recordsPerSecond = (uint64_t)(
+            (double)m_streamStats.totalRecords / totalSeconds);
+        m_streamStats.bytesPerSecond = (uint64_t)(
+            (double)m_streamStats.totalBytes / totalSeconds);
+    }
+    OnStreamComplete(m_streamStats);
+
+    m_streamStats.batchRecords = 0;
+    m_streamStats.batchBytes = 0;
+    m_streamStats.batchDur = Duration::zero();
+}
+
+//--------------------------------------------------------------
+inline void StreamApplication::AdaptBatchLimit(
+    uint32_t a_batchRecords,
+    Duration a_batchDuration)
+{
+    if (m_targetBatchDur <= Duration::zero() || !a_batchRecords)
+    {
+        return;
+    }
+
+    // Scale the limit in proportion to how far the batch was from
+    // the target duration, but no more than double or half each
+    // time. Only grow the limit if the last batch actually hit it.
+    const intmax_t target = m_targetBatchDur.count();
+    const intmax_t actual = std::max<intmax_t>(
+        a_batchDuration.count(), 1);
+    const uint64_t scaled = ((uint64_t)a_batchRecords * target) /
+                            actual;
+    uint64_t limit = std::min<uint64_t>(scaled,
+                                        (uint64_t)m_recordLimit * 2);
+    limit = std::max<uint64_t>(limit, m_recordLimit / 2);
+    if (limit > m_recordLimit && a_batchRecords < m_recordLimit)
+    {
+        return;
+    }
+    m_recordLimit = (uint32_t)std::min<uint64_t>(
+        std::max<uint64_t>(limit, 1), m_maxRecords);
+}
+
+} // namespace Simple
+
+#endif//SIMPLE_RECORD_STREAM_SUPPORTED
@@ -0,0 +1,481 @@
+//--------------------------------------------------------------
+// Copyright (c) David Bosnich <david.bosnich.public@gmail.com>
+//
+// This code is licensed under the MIT License, a copy of which
+// can be found in the license.txt file included at the root of
+// this distribution, or at https://opensource.org/licenses/MIT
+//--------------------------------------------------------------
+
+#pragma once
+
+#include "update_loop.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <exception>
+#include <functional>
+#include <new>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <signal.h>
+#include <sys/mman.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#define SIMPLE_SUPERVISOR_SUPPORTED 1
+#endif
+
+//! @file
+
+//--------------------------------------------------------------
+//! Default capacity (bytes) of each checkpoint of a Supervisor.
+//--------------------------------------------------------------
+#ifndef DEFAULT_SUPERVISOR_CHECKPOINT_BYTES
+#define DEFAULT_SUPERVISOR_CHECKPOINT_BYTES (64u * 1024u)
+#endif
+
+//--------------------------------------------------------------
+//! Default frames between each checkpoint of a Supervisor.
+//--------------------------------------------------------------
+#ifndef DEFAULT_SUPERVISOR_CHECKPOINT_INTERVAL
+#define DEFAULT_SUPERVISOR_CHECKPOINT_INTERVAL 60u
+#endif
+
+//--------------------------------------------------------------
+//! Default restarts of a Supervisor before it gives up.
+//--------------------------------------------------------------
+#ifndef DEFAULT_SUPERVISOR_MAX_RESTARTS
+#define DEFAULT_SUPERVISOR_MAX_RESTARTS 8u
+#endif
+
+//--------------------------------------------------------------
+namespace Simple
+{
+
+#if SIMPLE_SUPERVISOR_SUPPORTED
+//--------------------------------------------------------------
+//! Runs an update loop in a forked child process (POSIX only), so a
+//! crash in any Update* function kills only the child, and replaces
+//! it with a new child (forked from the same pristine parent) that
+//! resumes from the last checkpoint of the crashed one.
+//!
+//! The child checkpoints state with the save function at the end of
+//! every N frames (and before it shuts down) into memory shared with
+//! the parent, alternating between two slots so that a crash while
+//! saving never corrupts the last complete checkpoint. The next child
+//! restores it with the restore function after StartUp. The time to
+//! recover (from the parent detecting a crash to the first frame of
+//! the replacement starting) is measured, and is usually dominated
+//! by StartUp and restoring the state, as forking is cheap.
+//!
+//! Run must be called from the only thread of the parent process (as
+//! other threads do not exist in children, and any locks they hold
+//! will never be released), and before any threads are spawned by
+//! the loop (eg. in StartUp), which are then only in each child.
+//! Checkpoints are taken by a listener on the loop in each child, so
+//! the supervisor must not be created or destroyed while the loop is
+//! running (see UpdateLoop::Listener).
+//--------------------------------------------------------------
+class Supervisor : public UpdateLoop::Listener
+{
+public:
+    using Clock = std::chrono::steady_clock;
+
+    //! Save state to a buffer, returning the bytes saved (or more than
+    //! the capacity of the buffer if it is too small to checkpoint).
+    using SaveFunc = std::function<size_t(void* o_buffer,
+                                          size_t a_capacity)>;
+
+    //! Restore state saved at the end of the given frame (index).
+    using RestoreFunc = std::function<void(const void* a_buffer,
+                                           size_t a_size,
+                                           uint64_t a_frameIndex)>;
+
+    struct Stats
+    {
+        uint32_t crashCount = 0;      //!< Children that crashed.
+        uint32_t restartCount = 0;    //!< Children forked to replace.
+        int lastSignal = 0;           //!< Signal of last crash (if any).
+        uint64_t checkpointCount = 0; //!< Checkpoints of all children.
+        Clock::duration lastRecovery = Clock::duration::zero();
+        Clock::duration maxRecovery = Clock::duration::zero();
+    };
+
+    explicit Supervisor(UpdateLoop& a_loop,
+        size_t a_checkpointBytes = DEFAULT_SUPERVISOR_CHECKPOINT_BYTES);
+    ~Supervisor() override;
+
+    Supervisor(const Supervisor&) = delete;
+    Supervisor& operator=(const Supervisor&) = delete;
+
+    void SetSaveFunc(SaveFunc a_saveFunc);
+    void SetRestoreFunc(RestoreFunc a_restoreFunc);
+    void SetCheckpointInterval(uint32_t a_frames);
+    void SetMaxRestarts(uint32_t a_maxRestarts);
+
+    int Run(uint32_t a_targetFPS = DEFAULT_TARGET_FPS);
+
+    bool IsChild() const;
+    Stats GetStats() const;
+    size_t GetCheckpoint(void* o_buffer, size_t a_capacity,
+                         uint64_t* o_frameIndex = nullptr) const;
+
+    void OnPhaseBegin(UpdatePhase a_phase) override;
+    void OnPhaseEnded(UpdatePhase a_phase) override;
+
+private:
+    struct Shared
+    {
+        std::atomic<uint64_t> checkpointCount;
+        uint64_t frameIndex[2];
+        size_t size[2];
+        std::atomic<int64_t> crashTimeNs;
+        std::atomic<int64_t> lastRecoveryNs;
+        std::atomic<int64_t> maxRecoveryNs;
+    };
+
+    void Checkpoint();
+    char* GetSlot(uint64_t a_index) const;
+    static int64_t GetTimeNs();
+
+    UpdateLoop& m_loop;
+    SaveFunc m_saveFunc;
+    RestoreFunc m_restoreFunc;
+    Shared* m_shared = nullptr;
+    size_t m_checkpointBytes = 0;
+    size_t m_mappedBytes = 0;
+    uint32_t m_checkpointInterval = DEFAULT_SUPERVISOR_CHECKPOINT_INTERVAL;
+    uint32_t m_maxRestarts = DEFAULT_SUPERVISOR_MAX_RESTARTS;
+    uint64_t m_frameIndex = 0;
+    bool m_isChild = false;
+    bool m_restorePending = false;
+    bool m_recoveryPending = false;
+    bool m_saveFailed = false;
+    Stats m_stats;
+};
+
+//--------------------------------------------------------------
+//! Constructor. Maps the memory shared with each child.
+//! @param[in] a_loop The loop to run in each child (and listen to).
+//! @param[in] a_checkpointBytes Capacity (bytes) of each checkpoint.
+//--------------------------------------------------------------
+inline Supervisor::Supervisor(UpdateLoop& a_loop, size_t a_checkpointBytes)
+    : m_loop(a_loop)
+    , m_checkpointBytes(a_checkpointBytes)
+{
+    // Anonymous shared memory is inherited by each child, and stays
+    // mapped in the parent when they crash (holding the checkpoint).
+    m_mappedBytes = sizeof(Shared) + (a_checkpointBytes * 2);
+    void* memory = mmap(nullptr, m_mappedBytes, PROT_READ | PROT_WRITE,
+                        MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+    if (memory == MAP_FAILED)
+    {
+        printf("Supervisor: cannot map %zu bytes: %s\n",
+               m_mappedBytes, strerror(errno));
+        m_mappedBytes = 0;
+    }
+    else
+    {
+        m_shared = new (memory) Shared();
+    }
+    m_loop.AddListener(this);
+}
+
+//--------------------------------------------------------------
+//! Destructor. Unmaps the memory shared with each child.
+//--------------------------------------------------------------
+inline Supervisor::~Supervisor()
+{
+    m_loop.RemoveListener(this);
+    if (m_shared)
+    {
+        munmap(m_shared, m_mappedBytes);
+    }
+}
+
+//--------------------------------------------------------------
+//! Set the function that saves each checkpoint (in each child).
+//! @param[in] a_saveFunc The function to save state with.
+//--------------------------------------------------------------
+inline void Supervisor::SetSaveFunc(SaveFunc a_saveFunc)
+{
+    m_saveFunc = std::move(a_saveFunc);
+}
+
+//--------------------------------------------------------------
+//! Set the function that restores the last checkpoint (in each child
+//! that replaces a crashed one, after StartUp).
+//! @param[in] a_restoreFunc The function to restore state with.
+//--------------------------------------------------------------
+inline void Supervisor::SetRestoreFunc(RestoreFunc a_restoreFunc)
+{
+    m_restoreFunc = std::move(a_restoreFunc);
+}
+
+//--------------------------------------------------------------
+//! Set the frames between each checkpoint.
+//! @param[in] a_frames Frames between each checkpoint (minimum one).
+//--------------------------------------------------------------
+inline void Supervisor::SetCheckpointInterval(uint32_t a_frames)
+{
+    m_checkpointInterval = std::max(a_frames, 1u);
+}
+
+//--------------------------------------------------------------
+//! Set the restarts before giving up on a child that keeps crashing.
+//! @param[in] a_maxRestarts Maximum children forked to replace.
+//--------------------------------------------------------------
+inline void Supervisor::SetMaxRestarts(uint32_t a_maxRestarts)
+{
+    m_maxRestarts = a_maxRestarts;
+}
+
+//--------------------------------------------------------------
+//! Run the loop in a child process until it shuts down, replacing it
+//! each time it crashes (ie. is killed by a signal, or exits with a
+//! non-zero code) until the maximum restarts is reached. Only ever
+//! returns in the parent; each child exits once the loop returns, or
+//! with EXIT_FAILURE (a crash) if an error is rethrown from the loop.
+//! @param[in] a_targetFPS The target fps of the loop.
+//! @return Zero if the loop shut down, or non-zero if the maximum
+//!         restarts is reached (or a child cannot be forked).
+//--------------------------------------------------------------
+inline int Supervisor::Run(uint32_t a_targetFPS)
+{
+    if (!m_shared)
+    {
+        printf("Supervisor: no memory is shared with children\n");
+        return 1;
+    }
+
+    for (;;)
+    {
+        // Flush output so it is not written again by the child.
+        fflush(stdout);
+        fflush(stderr);
+        const pid_t pid = fork();
+        if (pid < 0)
+        {
+            printf("Supervisor: cannot fork: %s\n", strerror(errno));
+            return 1;
+        }
+        if (pid == 0)
+        {
+            m_isChild = true;
+            m_restorePending = m_shared->checkpointCount.load() != 0;
+            m_recoveryPending = m_shared->crashTimeNs.load() != 0;
+#if SIMPLE_LOOP_EXCEPTIONS_ENABLED
+            // An error rethrown from the loop must never unwind out of
+            // the child (into the caller), so is treated as a crash.
+            try
+            {
+                m_loop.Run(a_targetFPS);
+            }
+            catch (const std::exception& a_exception)
+            {
+                printf("Supervisor: child threw: %s\n", a_exception.what());
+                fflush(stdout);
+                fflush(stderr);
+                _exit(EXIT_FAILURE);
+            }
+            catch (...)
+            {
+                printf("Supervisor: child threw\n");
+                fflush(stdout);
+                fflush(stderr);
+                _exit(EXIT_FAILURE);
+            }
+#else
+            m_loop.Run(a_targetFPS);
+#endif//SIMPLE_LOOP_EXCEPTIONS_ENABLED
+            fflush(stdout);
+            fflush(stderr);
+            _exit(0);
+        }
+
+        int status = 0;
+        while (waitpid(pid, &status, 0) < 0)
+        {
+            if (errno != EINTR)
+            {
+                printf("Supervisor: cannot wait: %s\n", strerror(errno));
+                return 1;
+            }
+        }
+        if (WIFEXITED(status) && WEXITSTATUS(status) == 0)
+        {
+            return 0;
+        }
+
+        m_shared->crashTimeNs.store(GetTimeNs());
+        ++m_stats.crashCount;
+        m_stats.lastSignal = WIFSIGNALED(status) ? WTERMSIG(status) : 0;
+        if (m_stats.restartCount >= m_maxRestarts)
+        {
+            printf("Supervisor: giving up after %u restarts\n",
+                   m_stats.restartCount);
+            return WIFEXITED(status) ? WEXITSTATUS(status)
+                                     : 128 + WTERMSIG(status);
+        }
+        ++m_stats.restartCount;
+    }
+}
+
+//--------------------------------------------------------------
+//! Check whether this is a child (ie. running the loop).
+//! @return True if this is a child, false if it is the parent.
+//--------------------------------------------------------------
+inline bool Supervisor::IsChild() const
+{
+    return m_isChild;
+}
+
+//--------------------------------------------------------------
+//! Get the stats of the children, eg. once Run returns.
+//! @return The stats of the children.
+//--------------------------------------------------------------
+inline Supervisor::Stats Supervisor::GetStats() const
+{
+    Stats stats = m_stats;
+    if (m_shared)
+    {
+        stats.checkpointCount = m_shared->checkpointCount.load();
+        stats.lastRecovery = std::chrono::duration_cast<Clock::duration>(
+            std::chrono::nanoseconds(m_shared->lastRecoveryNs.load()));
+        stats.maxRecovery = std::chrono::duration_cast<Clock::duration>(
+            std::chrono::nanoseconds(m_shared->maxRecoveryNs.load()));
+    }
+    return stats;
+}
+
+//--------------------------------------------------------------
+//! Copy the last checkpoint, eg. to get the final state of the loop
+//! once Run returns (as the state of the parent is never changed).
+//! @param[out] o_buffer The buffer to copy the checkpoint to.
+//! @param[in] a_capacity Capacity (bytes) of the buffer.
+//! @param[out] o_frameIndex The frame the checkpoint was saved at.
+//! @return The bytes of the checkpoint (not copied if more than the
+//!         capacity of the buffer), or zero if there is none.
+//--------------------------------------------------------------
+inline size_t Supervisor::GetCheckpoint(void* o_buffer, size_t a_capacity,
+                                        uint64_t* o_frameIndex) const
+{
+    const uint64_t count = m_shared ? m_shared->checkpointCount.load() : 0;
+    if (count == 0)
+    {
+        return 0;
+    }
+    const uint64_t slot = count & 1;
+    const size_t size = m_shared->size[slot];
+    if (size <= a_capacity)
+    {
+        memcpy(o_buffer, GetSlot(slot), size);
+    }
+    if (o_frameIndex)
+    {
+        *o_frameIndex = m_shared->frameIndex[slot];
+    }
+    return size;
+}
+
+//--------------------------------------------------------------
+//! Measures the recovery time when the first frame of a child that
+//! replaced a crashed one begins.
+//! @param[in] a_phase The phase of the loop that is about to begin.
+//--------------------------------------------------------------
+inline void Supervisor::OnPhaseBegin(UpdatePhase a_phase)
+{
+    if (a_phase == UpdatePhase::Start && m_recoveryPending)
+    {
+        m_recoveryPending = false;
+        const int64_t recoveryNs = GetTimeNs() -
+                                   m_shared->crashTimeNs.load();
+        m_shared->lastRecoveryNs.store(recoveryNs);
+        if (recoveryNs > m_shared->maxRecoveryNs.load())
+        {
+            m_shared->maxRecoveryNs.store(recoveryNs);
+        }
+    }
+    else if (a_phase == UpdatePhase::ShutDown && m_isChild)
+    {
+        Checkpoint();
+    }
+}
+
+//--------------------------------------------------------------
+//! Restores the last checkpoint after StartUp (of a child replacing
+//! a crashed one), and checkpoints at the end of every N frames.
+//! @param[in] a_phase The phase of the loop that has just ended.
+//--------------------------------------------------------------
+inline void Supervisor::OnPhaseEnded(UpdatePhase a_phase)
+{
+    if (a_phase == UpdatePhase::StartUp && m_restorePending)
+    {
+        m_restorePending = false;
+        const uint64_t slot = m_shared->checkpointCount.load() & 1;
+        m_frameIndex = m_shared->frameIndex[slot];
+        if (m_restoreFunc)
+        {
+            m_restoreFunc(GetSlot(slot), m_shared->size[slot],
+                          m_frameIndex);
+        }
+    }
+    else if (a_phase == UpdatePhase::Ended && m_isChild &&
+             ++m_frameIndex % m_checkpointInterval == 0)
+    {
+        Checkpoint();
+    }
+}
+
+//--------------------------------------------------------------
+inline void Supervisor::Checkpoint()
+{
+    if (!m_saveFunc)
+    {
+        return;
+    }
+
+    // Save to the slot not holding the last checkpoint, then publish.
+    const uint64_t count = m_shared->checkpointCount.load(
+        std::memory_order_relaxed) + 1;
+    const uint64_t slot = count & 1;
+    const size_t size = m_saveFunc(GetSlot(slot), m_checkpointBytes);
+    if (size > m_checkpointBytes)
+    {
+        if (!m_saveFailed)
+        {
+            printf("Supervisor: checkpoint of %zu bytes exceeds %zu\n",
+                   size, m_checkpointBytes);
+            m_saveFailed = true;
+        }
+        return;
+    }
+    m_shared->frameIndex[slot] = m_frameIndex;
+    m_shared->size[slot] = size;
+    m_shared->checkpointCount.store(count, std::memory_order_release);
+}
+
+//--------------------------------------------------------------
+inline char* Supervisor::GetSlot(uint64_t a_index) const
+{
+    return reinterpret_cast<char*>(m_shared + 1) +
+           (a_index * m_checkpointBytes);
+}
+
+//--------------------------------------------------------------
+inline int64_t Supervisor::GetTimeNs()
+{
+    // The steady clock is monotonic system wide, so can be compared
+    // between the parent and each child.
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        Clock::now().time_since_epoch()).count();
+}
+#endif//SIMPLE_SUPERVISOR_SUPPORTED
+
+} // namespace Simple
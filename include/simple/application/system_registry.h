@@ -0,0 +1,736 @@
+//--------------------------------------------------------------
+// Copyright (c) David Bosnich <david.bosnich.public@gmail.com>
+//
+// This code is licensed under the MIT License, a copy of which
+// can be found in the license.txt file included at the root of
+// this distribution, or at https://opensource.org/licenses/MIT
+//--------------------------------------------------------------
+
+#pragma once
+
+#include "update_loop.h"
+#include "worker_pool.h"
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <vector>
+
+//! @file
+
+//--------------------------------------------------------------
+//! Whether to run systems that would be skipped as unchanged, to
+//! verify they do not mark any of the resources they write to as
+//! changed. Default value; can be changed at runtime per registry.
+//--------------------------------------------------------------
+#ifndef DEFAULT_VERIFY_SKIPPED_SYSTEMS
+#define DEFAULT_VERIFY_SKIPPED_SYSTEMS false
+#endif//DEFAULT_VERIFY_SKIPPED_SYSTEMS
+
+//--------------------------------------------------------------
+namespace Simple
+{
+
+//--------------------------------------------------------------
+//! Systems registered against the Start, Fixed or Ended phase of
+//! an update loop, each declaring the resources it reads/writes.
+//! Systems of a phase that conflict (one writes what the other
+//! reads or writes) run in the order registered, while all others
+//! may run in parallel on a worker pool when the phase is updated.
+//!
+//! Each resource has a version that systems bump by calling the
+//! MarkChanged function after writing to it, so a system set to
+//! skip when unchanged is only run if one of its inputs changed.
+//!
+//! If a system throws while running in parallel, the systems not yet
+//! started are not run, and the exception is rethrown from Update on
+//! the calling thread once all running systems have completed.
+//--------------------------------------------------------------
+class SystemRegistry
+{
+public:
+    using Clock = std::chrono::steady_clock;
+    using Duration = Clock::duration;
+    using TimePoint = Clock::time_point;
+
+    using ResourceId = uint32_t;
+    using SystemId = uint32_t;
+    using SystemFunc = std::function<void(float a_seconds)>;
+    static constexpr uint32_t InvalidId = UINT32_MAX;
+
+    struct SystemStats
+    {
+        uint64_t runCount = 0;
+        uint64_t skipCount = 0;
+        uint64_t verifyFailCount = 0;
+        float skipRate = 0.0f;   //!< skipCount / all updates.
+        Duration lastStart = {}; //!< Offset from the phase start.
+        Duration lastDur = {};
+        Duration maxDur = {};
+        bool onCriticalPath = false;
+    };
+
+    struct PhaseStats
+    {
+        uint64_t updateCount = 0;
+        uint32_t systemCount = 0;
+        uint32_t skipCount = 0;  //!< Systems skipped last update.
+        uint64_t totalRunCount = 0;
+        uint64_t totalSkipCount = 0;
+        float skipRate = 0.0f;   //!< totalSkip / (totalRun + Skip)
+        Duration wallDur = {};      //!< Elapsed time of the phase.
+        Duration workDur = {};      //!< Sum of all system times.
+        Duration criticalDur = {};  //!< Longest dependency chain.
+    };
+
+    explicit SystemRegistry(WorkerPool* a_workerPool = nullptr);
+    ~SystemRegistry() = default;
+
+    SystemRegistry(const SystemRegistry&) = delete;
+    SystemRegistry& operator=(const SystemRegistry&) = delete;
+
+    void SetWorkerPool(WorkerPool* a_workerPool);
+    void SetVerifySkips(bool a_verifySkips);
+    bool GetVerifySkips() const;
+
+    ResourceId AddResource(const char* a_name);
+    SystemId AddSystem(const char* a_name,
+                       UpdatePhase a_phase,
+                       const std::vector<ResourceId>& a_reads,
+                       const std::vector<ResourceId>& a_writes,
+                       const SystemFunc& a_func);
+
+    void SetSkipWhenUnchanged(SystemId a_systemId, bool a_skip);
+    void MarkChanged(ResourceId a_resourceId);
+    uint64_t GetVersion(ResourceId a_resourceId) const;
+
+    void Update(UpdatePhase a_phase, float a_seconds);
+
+    uint32_t GetSystemCount() const;
+    const char* GetSystemName(SystemId a_systemId) const;
+    const char* GetResourceName(ResourceId a_resourceId) const;
+    const std::vector<SystemId>& GetDependencies(SystemId a_systemId);
+    const SystemStats& GetSystemStats(SystemId a_systemId) const;
+    const PhaseStats& GetPhaseStats(UpdatePhase a_phase) const;
+    const std::vector<SystemId>& GetCriticalPath(
+        UpdatePhase a_phase) const;
+
+private:
+    static constexpr uint32_t PhaseCount = 5;
+
+    struct System
+    {
+        std::string name;
+        UpdatePhase phase = UpdatePhase::Fixed;
+        std::vector<ResourceId> reads;
+        std::vector<ResourceId> writes;
+        std::vector<SystemId> dependencies;
+        std::vector<SystemId> dependents;
+        std::vector<uint64_t> readVersions;
+        std::vector<uint64_t> writeVersions;
+        SystemFunc func;
+        SystemStats stats;
+        bool skipWhenUnchanged = false;
+        bool skipped = false;
+    };
+
+    struct Phase
+    {
+        std::vector<SystemId> systems;
+        std::vector<SystemId> roots;
+        std::vector<SystemId> criticalPath;
+        PhaseStats stats;
+        bool dirty = false;
+    };
+
+    static bool Intersects(const std::vector<ResourceId>& a_lhs,
+                           const std::vector<ResourceId>& a_rhs);
+    static bool Conflicts(const System& a_lhs, const System& a_rhs);
+
+    void Build(Phase& a_phase);
+    bool IsUnchanged(const System& a_system) const;
+    void RunSystem(SystemId a_systemId, float a_seconds);
+    void VerifySystem(System& a_system, float a_seconds);
+    void RunLane(float a_seconds);
+    void UpdateCriticalPath(Phase& a_phase);
+
+    std::vector<System> m_systems;
+    std::vector<std::string> m_resources;
+    std::vector<uint64_t> m_versions;
+    Phase m_phases[PhaseCount];
+    WorkerPool* m_workerPool = nullptr;
+    bool m_verifySkips = DEFAULT_VERIFY_SKIPPED_SYSTEMS;
+
+    // Scheduling state, only used while a phase is updating.
+    std::mutex m_mutex;
+    std::condition_variable m_condition;
+    std::vector<SystemId> m_ready;
+    std::vector<uint32_t> m_pending;
+    std::vector<Duration> m_finish;
+    std::vector<SystemId> m_previous;
+    uint32_t m_remaining = 0;
+    std::exception_ptr m_exception;
+    TimePoint m_phaseStart;
+};
+
+//--------------------------------------------------------------
+//! Constructor.
+//! @param[in] a_workerPool Pool used to run systems in parallel.
+//!            If null, all systems are run on the calling thread.
+//--------------------------------------------------------------
+inline SystemRegistry::SystemRegistry(WorkerPool* a_workerPool)
+    : m_workerPool(a_workerPool)
+{
+}
+
+//--------------------------------------------------------------
+//! Set the pool used to run systems in parallel (null for none).
+//! @param[in] a_workerPool Pool used to run systems in parallel.
+//--------------------------------------------------------------
+inline void SystemRegistry::SetWorkerPool(WorkerPool* a_workerPool)
+{
+    m_workerPool = a_workerPool;
+}
+
+//--------------------------------------------------------------
+//! Set whether to verify systems that are skipped as unchanged,
+//! by running them anyway and reporting any that mark a resource
+//! as changed (which means they should not have been skipped).
+//! @param[in] a_verifySkips Whether to verify skipped systems.
+//--------------------------------------------------------------
+inline void SystemRegistry::SetVerifySkips(bool a_verifySkips)
+{
+    m_verifySkips = a_verifySkips;
+}
+
+//--------------------------------------------------------------
+//! Get whether to verify systems that are skipped as unchanged.
+//! @return Whether to verify systems that are skipped.
+//--------------------------------------------------------------
+inline bool SystemRegistry::GetVerifySkips() const
+{
+    return m_verifySkips;
+}
+
+//--------------------------------------------------------------
+//! Add a resource that systems can declare they read or write.
+//! @param[in] a_name The name of the resource (used for debug).
+//! @return The id of the resource, to pass when adding systems.
+//--------------------------------------------------------------
+inline SystemRegistry::ResourceId SystemRegistry::AddResource(
+    const char* a_name)
+{
+    m_resources.emplace_back(a_name ? a_name : "");
+    m_versions.push_back(0);
+    return (ResourceId)(m_resources.size() - 1);
+}
+
+//--------------------------------------------------------------
+//! Add a system to be run each time its phase is updated. Must not
+//! be called while any phase of this registry is being updated.
+//! @param[in] a_name The name of the system (used for debug).
+//! @param[in] a_phase The phase (Start, Fixed or Ended) to run in.
+//! @param[in] a_reads The resources the system reads from.
+//! @param[in] a_writes The resources the system writes to.
+//! @param[in] a_func The function to call when the system is run.
+//! @return The id of the system, or InvalidId if it is invalid.
+//--------------------------------------------------------------
+inline SystemRegistry::SystemId SystemRegistry::AddSystem(
+    const char* a_name,
+    UpdatePhase a_phase,
+    const std::vector<ResourceId>& a_reads,
+    const std::vector<ResourceId>& a_writes,
+    const SystemFunc& a_func)
+{
+    if (a_phase != UpdatePhase::Start &&
+        a_phase != UpdatePhase::Fixed &&
+        a_phase != UpdatePhase::Ended)
+    {
+        printf("SystemRegistry::AddSystem: invalid phase\n");
+        return InvalidId;
+    }
+    if (!a_func)
+    {
+        printf("SystemRegistry::AddSystem: invalid function\n");
+        return InvalidId;
+    }
+
+    System system;
+    system.name = a_name ? a_name : "";
+    system.phase = a_phase;
+    system.reads = a_reads;
+    system.writes = a_writes;
+    system.func = a_func;
+    for (std::vector<ResourceId>* ids : { &system.reads,
+                                          &system.writes })
+    {
+        for (ResourceId id : *ids)
+        {
+            if (id >= m_resources.size())
+            {
+                printf("SystemRegistry::AddSystem: invalid resource"
+                       " %u for system %s\n", id, system.name.c_str());
+                return InvalidId;
+            }
+        }
+        std::sort(ids->begin(), ids->end());
+        ids->erase(std::unique(ids->begin(), ids->end()), ids->end());
+    }
+    system.readVersions.assign(system.reads.size(), 0);
+    system.writeVersions.assign(system.writes.size(), 0);
+
+    const SystemId systemId = (SystemId)m_systems.size();
+    m_systems.push_back(std::move(system));
+    m_pending.push_back(0);
+    m_finish.push_back(Duration::zero());
+    m_previous.push_back(0);
+
+    Phase& phase = m_phases[(uint32_t)a_phase];
+    phase.systems.push_back(systemId);
+    phase.dirty = true;
+    return systemId;
+}
+
+//--------------------------------------------------------------
+//! Set whether a system is skipped when none of the resources it
+//! reads from have changed since it last ran. Systems that do not
+//! read any resources are always run, whether this is set or not.
+//! @param[in] a_systemId The id returned when adding the system.
+//! @param[in] a_skip Whether to skip the system when unchanged.
+//--------------------------------------------------------------
+inline void SystemRegistry::SetSkipWhenUnchanged(SystemId a_systemId,
+                                                 bool a_skip)
+{
+    m_systems[a_systemId].skipWhenUnchanged = a_skip;
+}
+
+//--------------------------------------------------------------
+//! Mark a resource as changed, so systems that read it will run.
+//! Only call from a system that declared it writes the resource.
+//! @param[in] a_resourceId The id returned when adding resource.
+//--------------------------------------------------------------
+inline void SystemRegistry::MarkChanged(ResourceId a_resourceId)
+{
+    ++m_versions[a_resourceId];
+}
+
+//--------------------------------------------------------------
+//! Get the version of a resource (the count of times changed).
+//! @param[in] a_resourceId The id returned when adding resource.
+//! @return The version of the resource.
+//--------------------------------------------------------------
+inline uint64_t SystemRegistry::GetVersion(
+    ResourceId a_resourceId) const
+{
+    return m_versions[a_resourceId];
+}
+
+//--------------------------------------------------------------
+//! Run all systems registered against a phase, returning once they
+//! have all completed. Call from the matching UpdateLoop method.
+//! Rethrows the first exception thrown by any system of the phase.
+//! @param[in] a_phase The phase (Start, Fixed or Ended) to update.
+//! @param[in] a_seconds The delta/fixed time to pass each system.
+//--------------------------------------------------------------
+inline void SystemRegistry::Update(UpdatePhase a_phase,
+                                   float a_seconds)
+{
+    Phase& phase = m_phases[(uint32_t)a_phase];
+    if (phase.dirty)
+    {
+        Build(phase);
+    }
+
+    const uint32_t systemCount = (uint32_t)phase.systems.size();
+    const uint32_t threadCount = m_workerPool ?
+                                 m_workerPool->GetThreadCount() : 1;
+    m_phaseStart = Clock::now();
+    if (threadCount <= 1 || systemCount <= 1)
+    {
+        // Registration order is always a valid topological order.
+        for (SystemId systemId : phase.systems)
+        {
+            RunSystem(systemId, a_seconds);
+        }
+    }
+    else
+    {
+        m_ready = phase.roots;
+        for (SystemId systemId : phase.systems)
+        {
+            m_pending[systemId] = (uint32_t)
+                m_systems[systemId].dependencies.size();
+        }
+        m_remaining = systemCount;
+
+        const uint32_t laneCount = std::min(threadCount, systemCount);
+        m_workerPool->ParallelFor(laneCount, [this, a_seconds](uint32_t)
+        {
+            RunLane(a_seconds);
+        });
+        if (m_exception)
+        {
+            std::exception_ptr exception;
+            std::swap(exception, m_exception);
+            std::rethrow_exception(exception);
+        }
+    }
+
+    PhaseStats& stats = phase.stats;
+    stats.wallDur = Clock::now() - m_phaseStart;
+    stats.systemCount = systemCount;
+    stats.skipCount = 0;
+    for (SystemId systemId : phase.systems)
+    {
+        stats.skipCount += m_systems[systemId].skipped;
+    }
+    stats.totalSkipCount += stats.skipCount;
+    stats.totalRunCount += systemCount - stats.skipCount;
+    const uint64_t totalCount = stats.totalRunCount +
+                                stats.totalSkipCount;
+    stats.skipRate = totalCount ?
+                     (float)stats.totalSkipCount / totalCount : 0.0f;
+    ++stats.updateCount;
+    UpdateCriticalPath(phase);
+}
+
+//--------------------------------------------------------------
+//! Get the count of systems registered against all phases.
+//! @return The count of systems registered against all phases.
+//--------------------------------------------------------------
+inline uint32_t SystemRegistry::GetSystemCount() const
+{
+    return (uint32_t)m_systems.size();
+}
+
+//--------------------------------------------------------------
+//! Get the name of a system.
+//! @param[in] a_systemId The id returned when adding the system.
+//! @return The name of the system.
+//--------------------------------------------------------------
+inline const char* SystemRegistry::GetSystemName(
+    SystemId a_systemId) const
+{
+    return m_systems[a_systemId].name.c_str();
+}
+
+//--------------------------------------------------------------
+//! Get the name of a resource.
+//! @param[in] a_resourceId The id returned when adding resource.
+//! @return The name of the resource.
+//--------------------------------------------------------------
+inline const char* SystemRegistry::GetResourceName(
+    ResourceId a_resourceId) const
+{
+    return m_resources[a_resourceId].c_str();
+}
+
+//--------------------------------------------------------------
+//! Get the systems that must complete before a system can run.
+//! @param[in] a_systemId The id returned when adding the system.
+//! @return The ids of all earlier conflicting systems in a phase.
+//--------------------------------------------------------------
+inline const std::vector<SystemRegistry::SystemId>&
+SystemRegistry::GetDependencies(SystemId a_systemId)
+{
+    const System& system = m_systems[a_systemId];
+    Phase& phase = m_phases[(uint32_t)system.phase];
+    if (phase.dirty)
+    {
+        Build(phase);
+    }
+    return system.dependencies;
+}
+
+//--------------------------------------------------------------
+//! Get the timings of a system, updated each time it is run.
+//! @param[in] a_systemId The id returned when adding the system.
+//! @return The timings of the system as of its last phase update.
+//--------------------------------------------------------------
+inline const SystemRegistry::SystemStats&
+SystemRegistry::GetSystemStats(SystemId a_systemId) const
+{
+    return m_systems[a_systemId].stats;
+}
+
+//--------------------------------------------------------------
+//! Get the timings of a phase, updated each time it is updated.
+//! @param[in] a_phase The phase (Start, Fixed or Ended) to get.
+//! @return The timings of the phase as of its last update.
+//--------------------------------------------------------------
+inline const SystemRegistry::PhaseStats&
+SystemRegistry::GetPhaseStats(UpdatePhase a_phase) const
+{
+    return m_phases[(uint32_t)a_phase].stats;
+}
+
+//--------------------------------------------------------------
+//! Get the chain of dependent systems that took the longest time
+//! to run in the last update of a phase, which bounds how quickly
+//! the phase can complete no matter how many threads are used.
+//! @param[in] a_phase The phase (Start, Fixed or Ended) to get.
+//! @return The ids of the systems on the path, in the run order.
+//--------------------------------------------------------------
+inline const std::vector<SystemRegistry::SystemId>&
+SystemRegistry::GetCriticalPath(UpdatePhase a_phase) const
+{
+    return m_phases[(uint32_t)a_phase].criticalPath;
+}
+
+//--------------------------------------------------------------
+inline bool SystemRegistry::Intersects(
+    const std::vector<ResourceId>& a_lhs,
+    const std::vector<ResourceId>& a_rhs)
+{
+    std::vector<ResourceId>::const_iterator lhs = a_lhs.begin();
+    std::vector<ResourceId>::const_iterator rhs = a_rhs.begin();
+    while (lhs != a_lhs.end() && rhs != a_rhs.end())
+    {
+        if (*lhs == *rhs)
+        {
+            return true;
+        }
+        if (*lhs < *rhs)
+        {
+            ++lhs;
+        }
+        else
+        {
+            ++rhs;
+        }
+    }
+    return false;
+}
+
+//--------------------------------------------------------------
+inline bool SystemRegistry::Conflicts(const System& a_lhs,
+                                      const System& a_rhs)
+{
+    return Intersects(a_lhs.writes, a_rhs.writes) ||
+           Intersects(a_lhs.writes, a_rhs.reads) ||
+           Intersects(a_lhs.reads, a_rhs.writes);
+}
+
+//--------------------------------------------------------------
+inline void SystemRegistry::Build(Phase& a_phase)
+{
+    for (SystemId systemId : a_phase.systems)
+    {
+        m_systems[systemId].dependencies.clear();
+        m_systems[systemId].dependents.clear();
+    }
+
+    // Each system depends on all earlier conflicting systems, so
+    // the graph is acyclic and respects the registration order.
+    a_phase.roots.clear();
+    for (size_t j = 0; j < a_phase.systems.size(); ++j)
+    {
+        System& system = m_systems[a_phase.systems[j]];
+        for (size_t i = 0; i < j; ++i)
+        {
+            System& earlier = m_systems[a_phase.systems[i]];
+            if (Conflicts(earlier, system))
+            {
+                system.dependencies.push_back(a_phase.systems[i]);
+                earlier.dependents.push_back(a_phase.systems[j]);
+            }
+        }
+        if (system.dependencies.empty())
+        {
+            a_phase.roots.push_back(a_phase.systems[j]);
+        }
+    }
+
+    a_phase.criticalPath.reserve(a_phase.systems.size());
+    m_ready.reserve(a_phase.systems.size());
+    a_phase.dirty = false;
+}
+
+//--------------------------------------------------------------
+inline void SystemRegistry::RunSystem(SystemId a_systemId,
+                                      float a_seconds)
+{
+    System& system = m_systems[a_systemId];
+    SystemStats& stats = system.stats;
+    const TimePoint startTime = Clock::now();
+    stats.lastStart = startTime - m_phaseStart;
+
+    system.skipped = IsUnchanged(system);
+    if (system.skipped)
+    {
+        if (m_verifySkips)
+        {
+            VerifySystem(system, a_seconds);
+        }
+        stats.lastDur = Duration::zero();
+        ++stats.skipCount;
+    }
+    else
+    {
+        system.func(a_seconds);
+        stats.lastDur = Clock::now() - startTime;
+        stats.maxDur = std::max(stats.maxDur, stats.lastDur);
+        ++stats.runCount;
+
+        // Conflicting systems can't run at the same time, so the
+        // versions read here only include changes made before now.
+        for (size_t i = 0; i < system.reads.size(); ++i)
+        {
+            system.readVersions[i] = m_versions[system.reads[i]];
+        }
+    }
+
+    const uint64_t totalCount = stats.runCount + stats.skipCount;
+    stats.skipRate = (float)stats.skipCount / totalCount;
+}
+
+//--------------------------------------------------------------
+inline bool SystemRegistry::IsUnchanged(const System& a_system) const
+{
+    if (!a_system.skipWhenUnchanged ||
+        a_system.reads.empty() ||
+        a_system.stats.runCount == 0)
+    {
+        return false;
+    }
+    for (size_t i = 0; i < a_system.reads.size(); ++i)
+    {
+        if (a_system.readVersions[i] != m_versions[a_system.reads[i]])
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+//--------------------------------------------------------------
+inline void SystemRegistry::VerifySystem(System& a_system,
+                                         float a_seconds)
+{
+    for (size_t i = 0; i < a_system.writes.size(); ++i)
+    {
+        a_system.writeVersions[i] = m_versions[a_system.writes[i]];
+    }
+    a_system.func(a_seconds);
+    for (size_t i = 0; i < a_system.writes.size(); ++i)
+    {
+        const ResourceId resourceId = a_system.writes[i];
+        if (a_system.writeVersions[i] != m_versions[resourceId])
+        {
+            printf("SystemRegistry: system %s was skipped but changed"
+                   " resource %s\n", a_system.name.c_str(),
+                   m_resources[resourceId].c_str());
+            ++a_system.stats.verifyFailCount;
+        }
+    }
+}
+
+//--------------------------------------------------------------
+inline void SystemRegistry::RunLane(float a_seconds)
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+    while (true)
+    {
+        m_condition.wait(lock, [this]()
+        {
+            return !m_ready.empty() || m_remaining == 0;
+        });
+        if (m_remaining == 0)
+        {
+            break;
+        }
+
+        // Once any system has thrown, count down the rest unrun, so
+        // that every lane still finishes and the phase completes.
+        const SystemId systemId = m_ready.back();
+        m_ready.pop_back();
+        std::exception_ptr exception;
+        if (!m_exception)
+        {
+            lock.unlock();
+            try
+            {
+                RunSystem(systemId, a_seconds);
+            }
+            catch (...)
+            {
+                exception = std::current_exception();
+            }
+            lock.lock();
+        }
+        if (exception && !m_exception)
+        {
+            m_exception = exception;
+        }
+
+        // Release each dependent once its last dependency is done.
+        bool notify = (--m_remaining == 0);
+        for (SystemId dependent : m_systems[systemId].dependents)
+        {
+            if (--m_pending[dependent] == 0)
+            {
+                m_ready.push_back(dependent);
+                notify = true;
+            }
+        }
+        if (notify)
+        {
+            m_condition.notify_all();
+        }
+    }
+}
+
+//--------------------------------------------------------------
+inline void SystemRegistry::UpdateCriticalPath(Phase& a_phase)
+{
+    // Longest path through the graph weighted by the time each
+    // system took, visiting the systems in topological order.
+    Duration workDur = Duration::zero();
+    Duration criticalDur = Duration::zero();
+    SystemId criticalEnd = InvalidId;
+    for (SystemId systemId : a_phase.systems)
+    {
+        System& system = m_systems[systemId];
+        Duration longestDependency = Duration::zero();
+        m_previous[systemId] = InvalidId;
+        for (SystemId dependency : system.dependencies)
+        {
+            if (m_previous[systemId] == InvalidId ||
+                m_finish[dependency] > longestDependency)
+            {
+                longestDependency = m_finish[dependency];
+                m_previous[systemId] = dependency;
+            }
+        }
+        m_finish[systemId] = longestDependency + system.stats.lastDur;
+        workDur += system.stats.lastDur;
+        system.stats.onCriticalPath = false;
+        if (criticalEnd == InvalidId ||
+            m_finish[systemId] > criticalDur)
+        {
+            criticalDur = m_finish[systemId];
+            criticalEnd = systemId;
+        }
+    }
+
+    a_phase.criticalPath.clear();
+    for (SystemId systemId = criticalEnd; systemId != InvalidId;
+         systemId = m_previous[systemId])
+    {
+        m_systems[systemId].stats.onCriticalPath = true;
+        a_phase.criticalPath.push_back(systemId);
+    }
+    std::reverse(a_phase.criticalPath.begin(),
+                 a_phase.criticalPath.end());
+
+    a_phase.stats.workDur = workDur;
+    a_phase.stats.criticalDur = criticalDur;
+}
+
+} // namespace Simple
@@ -8,28 +8,21 @@
 
 #pragma once
 
-#include <atomic>
+#include "static_update_loop.h"
+
 #include <chrono>
 #include <cstdio>
-#include <thread>
+#include <vector>
 
 //! @file
 
 //--------------------------------------------------------------
-//! The target frames per second at which to run the update loop.
-//! Default value; underlying variable can be changed at runtime.
-//---------------------------------------------------------------
-#ifndef DEFAULT_TARGET_FPS
-#define DEFAULT_TARGET_FPS 60u
-#endif//DEFAULT_TARGET_FPS
-
-//--------------------------------------------------------------
-//! Whether to cap the number of frames per second to the target.
-//! Default value; underlying variable can be changed at runtime.
+//! Minimum time between errors printed by UpdateLoop::OnFrameError
+//! (milliseconds); any contained in between are only counted.
 //--------------------------------------------------------------
-#ifndef DEFAULT_CAPPED_FPS
-#define DEFAULT_CAPPED_FPS true
-#endif//DEFAULT_CAPPED_FPS
+#ifndef DEFAULT_FRAME_ERROR_PRINT_INTERVAL_MS
+#define DEFAULT_FRAME_ERROR_PRINT_INTERVAL_MS 1000u
+#endif//DEFAULT_FRAME_ERROR_PRINT_INTERVAL_MS
 
 //--------------------------------------------------------------
 namespace Simple
@@ -37,13 +30,34 @@ namespace Simple
 
 //--------------------------------------------------------------
 //! Base class for process that starts, runs a loop, then stops.
+//! The default instantiation of StaticUpdateLoop, which dispatches
+//! to virtual functions so it can be used as a runtime interface,
+//! and whose wait strategy can also be changed at runtime. Errors
+//! thrown from each phase are contained, and by default rethrown
+//! from Run once the loop has shut down (see SetFrameErrorAction).
 //--------------------------------------------------------------
-class UpdateLoop
+class UpdateLoop : public StaticUpdateLoop<UpdateLoop,
+                                           LoopPolicy::RuntimeWait,
+                                           LoopPolicy::ContainErrors>
 {
 public:
-    using Clock = std::chrono::steady_clock;
-    using Duration = Clock::duration;
-    using TimePoint = Clock::time_point;
+    //----------------------------------------------------------
+    //! Interface for framework services that must act at phase
+    //! boundaries of the update loop they are added to. Called
+    //! on the thread running the loop, before/after each phase.
+    //!
+    //! Services usually add themselves to the loop when created,
+    //! and remove themselves when destroyed, so like AddListener
+    //! and RemoveListener they must not be created or destroyed
+    //! while the loop is running (except in StartUp/ShutDown).
+    //----------------------------------------------------------
+    class Listener
+    {
+    public:
+        virtual ~Listener() = default;
+        virtual void OnPhaseBegin(UpdatePhase a_phase);
+        virtual void OnPhaseEnded(UpdatePhase a_phase);
+    };
 
     UpdateLoop() = default;
     virtual ~UpdateLoop() = default;
@@ -51,17 +65,8 @@ public:
     UpdateLoop(const UpdateLoop&) = delete;
     UpdateLoop& operator=(const UpdateLoop&) = delete;
 
-    void Run(uint32_t a_targetFPS = DEFAULT_TARGET_FPS);
-    std::thread RunInThread(uint32_t a_targetFPS = 60u);
-
-    void SetTargetFPS(uint32_t a_targetFPS);
-    void SetCappedFPS(bool a_cappedFPS);
-
-    uint32_t GetTargetFPS() const;
-    bool GetCappedFPS() const;
-
-    void RequestShutDown();
-    void RequestRestart();
+    void AddListener(Listener* a_listener);
+    void RemoveListener(Listener* a_listener);
 
 protected:
     virtual void StartUp() = 0;
@@ -71,212 +76,51 @@ protected:
     virtual void UpdateFixed(float a_fixedTimeSeconds) = 0;
     virtual void UpdateEnded(float a_deltaTimeSeconds) = 0;
 
-    struct FrameStats
-    {
-        uint64_t frameCount = 0;
-        uint32_t averageFPS = 0;
-        uint32_t targetFPS = 0;
-        Duration actualDur = {};
-        Duration targetDur = {};
-        Duration excessDur = {};
-        Duration totalDur = {};
-    };
     virtual void OnFrameComplete(const FrameStats& a_frameStats);
+    virtual FrameErrorAction OnFrameError(const FrameError& a_frameError);
 
 private:
-    std::atomic_uint m_targetFPS = { DEFAULT_TARGET_FPS };
-    std::atomic_bool m_cappedFPS = { DEFAULT_CAPPED_FPS };
-    std::atomic_bool m_shutDownRequested = { false };
-    std::atomic_bool m_restartRequested = { false };
-    std::atomic_bool m_runningInThread = { false };
+    friend class StaticUpdateLoop<UpdateLoop,
+                                  LoopPolicy::RuntimeWait,
+                                  LoopPolicy::ContainErrors>;
+
+    void OnPhaseBegin(UpdatePhase a_phase);
+    void OnPhaseEnded(UpdatePhase a_phase);
+
+    std::vector<Listener*> m_listeners;
+    TimePoint m_lastErrorPrintTime = {};
+    uint64_t m_unprintedErrorCount = 0;
 };
 
 //--------------------------------------------------------------
-//! Run the update loop at the target fps, in the current thread.
-//! @param[in] a_targetFPS The target fps (optional, default=60).
+//! Add a listener to be notified at each phase boundary. Must not
+//! be called while running, except from within StartUp/ShutDown.
+//! @param[in] a_listener The listener to add (not owned).
 //--------------------------------------------------------------
-inline void UpdateLoop::Run(uint32_t a_targetFPS)
+inline void UpdateLoop::AddListener(Listener* a_listener)
 {
-    // Set the target frames per second.
-    SetTargetFPS(a_targetFPS);
-
-    do
+    if (a_listener)
     {
-        // Clear any shut down or restart requests.
-        m_shutDownRequested = false;
-        m_restartRequested = false;
-
-        // Start the application.
-        StartUp();
-
-        // Initialize accumulated frame duration with the target
-        // duration to ensure a fixed update on the first frame.
-        constexpr intmax_t oneSecond = Clock::period().den;
-        Duration accumulatedDuration(oneSecond / m_targetFPS);
-
-        // Initialize other values used to track frame duration.
-        Duration lastDuration = Duration::zero();
-        TimePoint lastEndTime = Clock::now();
-        FrameStats frameStats = {};
-
-        // Loop until a shut down or restart is requested.
-        while (!m_shutDownRequested && !m_restartRequested)
-        {
-            // Target frame duration is fixed but depends on
-            // the target fps that can change between frames.
-            // Note that m_targetFPS is an atomic_uint value.
-            const uint32_t targetFPS = m_targetFPS;
-            const Duration targetDuration(oneSecond / targetFPS);
-            const float fixedTime = 1.0f / (float)targetFPS;
-
-            // Update at the start of each frame with a variable
-            // delta time, derived using the last frame duration,
-            // for non-deterministic systems requiring an update
-            // each frame prior to any fixed updates (eg. input).
-            // Cap in case the app is running slower than target.
-            constexpr float oneSecondFloat = (float)oneSecond;
-            const float durationF = (float)lastDuration.count();
-            const float deltaTime = durationF / oneSecondFloat;
-            const float deltaTimeCapped = std::min(deltaTime,
-                                                   fixedTime);
-            UpdateStart(deltaTimeCapped);
-
-            // Check if accumulated duration has reached target.
-            if (accumulatedDuration >= targetDuration)
-            {
-                // Update with a fixed delta time, derived from
-                // the target frame duration, for deterministic
-                // systems requiring fixed deltas (eg. physics).
-                UpdateFixed(fixedTime);
-
-                // Reduce accumulated duration by the amount
-                // 'consumed' by the update. Clamp remainder
-                // so it does not increase indefinitely when
-                // app is running slower than the target fps.
-                accumulatedDuration -= targetDuration;
-                if (accumulatedDuration > targetDuration)
-                {
-                    accumulatedDuration = targetDuration;
-                }
-            }
-
-            // Update at the end of each frame with the same
-            // variable delta time for any non-deterministic
-            // systems requiring updates at the end of every
-            // frame after any fixed updates (eg. rendering).
-            UpdateEnded(deltaTimeCapped);
-
-            // Calculate time elapsed since the last frame ended,
-            // and if capped wait until reaching target duration.
-            // Note that m_cappedFPS is an atomic_bool value.
-            const bool capped = m_cappedFPS;
-            TimePoint endTime;
-            do
-            {
-                endTime = Clock::now();
-                lastDuration = endTime - lastEndTime;
-            }
-            while (capped && lastDuration < targetDuration);
-            accumulatedDuration += lastDuration;
-            lastEndTime = endTime;
-
-            // Calculate average fps and send frame stat values.
-            const intmax_t frameCount = ++frameStats.frameCount;
-            frameStats.totalDur += lastDuration;
-            frameStats.targetFPS = targetFPS;
-            frameStats.actualDur = lastDuration;
-            frameStats.targetDur = targetDuration;
-            frameStats.excessDur = accumulatedDuration;
-            const intmax_t fpsNum = frameCount * oneSecond;
-            const intmax_t fpsDen = frameStats.totalDur.count();
-            frameStats.averageFPS = (uint32_t)(fpsNum / fpsDen);
-            OnFrameComplete(frameStats);
-        }
-
-        // Stop the application.
-        ShutDown();
+        RemoveListener(a_listener);
+        m_listeners.push_back(a_listener);
     }
-    // Return if shut down was requested, loop if restart was.
-    while (!m_shutDownRequested && m_restartRequested);
 }
 
 //--------------------------------------------------------------
-//! Run the update loop at the target fps, spawning a new thread.
-//! @param[in] a_targetFPS The target fps (optional, default=60).
-//! @return The thread which was spawned to run the update loop.
+//! Remove a listener. Must not be called while running, except
+//! from within StartUp/ShutDown (and not from the listener).
+//! @param[in] a_listener The listener to remove.
 //--------------------------------------------------------------
-inline std::thread UpdateLoop::RunInThread(uint32_t a_targetFPS)
+inline void UpdateLoop::RemoveListener(Listener* a_listener)
 {
-    std::thread runThread([this, a_targetFPS]()
+    for (auto it = m_listeners.begin(); it != m_listeners.end(); ++it)
     {
-        bool expected = false;
-        if (m_runningInThread.compare_exchange_strong(expected,
-                                                      true))
+        if (*it == a_listener)
         {
-            Run(a_targetFPS);
-            m_runningInThread.store(false,
-                                    std::memory_order_release);
+            m_listeners.erase(it);
+            return;
         }
-        else
-        {
-            printf("UpdateLoop already running in thread.\n");
-        }
-    });
-    return runThread;
-}
-
-//--------------------------------------------------------------
-//! Set the target fps. If the update loop is not yet running it
-//! will be overridden by the target fps sent to UpdateLoop::Run.
-//! @param[in] a_targetFPS The target fps to run the update loop.
-//--------------------------------------------------------------
-inline void UpdateLoop::SetTargetFPS(uint32_t a_targetFPS)
-{
-    // Must always target at least one frame per second.
-    m_targetFPS = a_targetFPS ? a_targetFPS : 1;
-}
-
-//--------------------------------------------------------------
-//! Set whether the update loop is run capped to the target fps.
-//! @param[in] a_cappedFPS Should the update loop be run capped?
-//--------------------------------------------------------------
-inline void UpdateLoop::SetCappedFPS(bool a_cappedFPS)
-{
-    m_cappedFPS = a_cappedFPS;
-}
-
-//--------------------------------------------------------------
-//! Get the target fps that the update loop has been set to run.
-//! @return Target fps that the update loop has been set to run.
-//--------------------------------------------------------------
-inline uint32_t UpdateLoop::GetTargetFPS() const
-{
-    return m_targetFPS;
-}
-
-//--------------------------------------------------------------
-//! Get whether the update loop is run capped to the target fps.
-//! @return True if update loop is run capped to the target fps.
-//--------------------------------------------------------------
-inline bool UpdateLoop::GetCappedFPS() const
-{
-    return m_cappedFPS;
-}
-
-//--------------------------------------------------------------
-//! Request termination of the update loop.
-//--------------------------------------------------------------
-inline void UpdateLoop::RequestShutDown()
-{
-    m_shutDownRequested = true;
-}
-
-//--------------------------------------------------------------
-//! Request a restart of the update loop.
-//--------------------------------------------------------------
-inline void UpdateLoop::RequestRestart()
-{
-    m_restartRequested = true;
+    }
 }
 
 //--------------------------------------------------------------
@@ -333,4 +177,77 @@ inline void UpdateLoop::OnFrameComplete(const FrameStats&)
 {
 }
 
+//--------------------------------------------------------------
+//! Called each time an error (exception) thrown from a phase is
+//! contained, to decide what the update loop does after it. At most
+//! one error is printed each DEFAULT_FRAME_ERROR_PRINT_INTERVAL_MS,
+//! along with the count of those since the last printed, so a loop
+//! that keeps failing does not flood the output; all are counted.
+//! @param[in] a_frameError The error, and where it was thrown from.
+//! @return The action to take, by default that which has been set.
+//--------------------------------------------------------------
+inline FrameErrorAction UpdateLoop::OnFrameError(
+    const FrameError& a_frameError)
+{
+    const TimePoint now = Clock::now();
+    const std::chrono::milliseconds interval(
+        DEFAULT_FRAME_ERROR_PRINT_INTERVAL_MS);
+    if (m_lastErrorPrintTime == TimePoint() ||
+        now - m_lastErrorPrintTime >= interval)
+    {
+        if (m_unprintedErrorCount)
+        {
+            printf("UpdateLoop: %llu more errors since the last printed\n",
+                   (unsigned long long)m_unprintedErrorCount);
+        }
+        printf("UpdateLoop: error in %s phase of frame %llu: %s\n",
+               GetUpdatePhaseName(a_frameError.phase),
+               (unsigned long long)a_frameError.frameIndex,
+               a_frameError.what);
+        m_lastErrorPrintTime = now;
+        m_unprintedErrorCount = 0;
+    }
+    else
+    {
+        ++m_unprintedErrorCount;
+    }
+    return GetFrameErrorAction();
+}
+
+//--------------------------------------------------------------
+inline void UpdateLoop::OnPhaseBegin(UpdatePhase a_phase)
+{
+    for (Listener* listener : m_listeners)
+    {
+        listener->OnPhaseBegin(a_phase);
+    }
+}
+
+//--------------------------------------------------------------
+inline void UpdateLoop::OnPhaseEnded(UpdatePhase a_phase)
+{
+    for (Listener* listener : m_listeners)
+    {
+        listener->OnPhaseEnded(a_phase);
+    }
+}
+
+//--------------------------------------------------------------
+//! Called on the thread running the loop before the given phase.
+//! @param[in] a_phase The phase of the loop that is beginning.
+//--------------------------------------------------------------
+inline void UpdateLoop::Listener::OnPhaseBegin(UpdatePhase a_phase)
+{
+    (void)a_phase;
+}
+
+//--------------------------------------------------------------
+//! Called on the thread running the loop after the given phase.
+//! @param[in] a_phase The phase of the loop that has just ended.
+//--------------------------------------------------------------
+inline void UpdateLoop::Listener::OnPhaseEnded(UpdatePhase a_phase)
+{
+    (void)a_phase;
+}
+
 } // namespace Simple
@@ -0,0 +1,523 @@
+//--------------------------------------------------------------
+// Copyright (c) David Bosnich <david.bosnich.public@gmail.com>
+//
+// This code is licensed under the MIT License, a copy of which
+// can be found in the license.txt file included at the root of
+// this distribution, or at https://opensource.org/licenses/MIT
+//--------------------------------------------------------------
+
+#pragma once
+
+#include "update_loop.h"
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <pthread.h>
+#include <signal.h>
+#include <unistd.h>
+#if defined(__GLIBC__) || defined(__APPLE__)
+#include <execinfo.h>
+#define SIMPLE_WATCHDOG_STACKS_SUPPORTED 1
+#endif
+#endif
+
+//! @file
+
+//--------------------------------------------------------------
+//! Signal sent to the thread running the loop to capture its stack
+//! when it is hung. Must not be used by the application for other
+//! purposes (its handler is only replaced while capturing).
+//--------------------------------------------------------------
+#ifdef SIMPLE_WATCHDOG_STACKS_SUPPORTED
+#ifndef DEFAULT_WATCHDOG_STACK_SIGNAL
+#define DEFAULT_WATCHDOG_STACK_SIGNAL SIGUSR2
+#endif//DEFAULT_WATCHDOG_STACK_SIGNAL
+#endif
+
+//--------------------------------------------------------------
+namespace Simple
+{
+
+//--------------------------------------------------------------
+//! Watches an update loop (that it is added to as a listener) from
+//! a separate thread, to detect frames that hang (eg. deadlocks) or
+//! run away (eg. infinite loops) in any Update* method, which would
+//! otherwise stop the loop silently (as shut down requests are only
+//! observed once a frame ends).
+//!
+//! The loop writes a heartbeat (frame index and phase) with one
+//! relaxed store at each phase boundary. If it does not change for
+//! the hang threshold, the watchdog reports the hang: the frame
+//! index, the last phase, and the stack of the thread running the
+//! loop (captured by signalling it, where supported). It can also
+//! write a liveness file each check for external supervisors, and
+//! abort the process once the hang has been reported.
+//!
+//! The watchdog thread runs from StartUp until ShutDown has ended.
+//! The threshold must be longer than the slowest frame expected
+//! (including StartUp/ShutDown, and the wait at low target fps).
+//--------------------------------------------------------------
+class Watchdog : public UpdateLoop::Listener
+{
+public:
+    using Duration = std::chrono::steady_clock::duration;
+
+    struct HangReport
+    {
+        uint64_t frameIndex = 0;
+        UpdatePhase phase = UpdatePhase::StartUp;
+        bool phaseEnded = false;    //!< Hung after, not in, the phase.
+        Duration stalledFor = Duration::zero();
+        std::vector<std::string> stack; //!< Of the loop thread.
+    };
+
+    using HangFunc = std::function<void(const HangReport&)>;
+
+    explicit Watchdog(std::chrono::milliseconds a_hangThreshold =
+                          std::chrono::milliseconds(2000),
+                      std::chrono::milliseconds a_checkInterval =
+                          std::chrono::milliseconds(50));
+    ~Watchdog() override;
+
+    Watchdog(const Watchdog&) = delete;
+    Watchdog& operator=(const Watchdog&) = delete;
+
+    void SetHangFunc(HangFunc a_hangFunc);
+    void SetLivenessFile(const std::string& a_path);
+    void SetCaptureStack(bool a_captureStack);
+    void SetAbortOnHang(bool a_abortOnHang);
+
+    bool IsWatching() const;
+    bool IsHung() const;
+    uint64_t GetHangCount() const;
+
+    void OnPhaseBegin(UpdatePhase a_phase) override;
+    void OnPhaseEnded(UpdatePhase a_phase) override;
+
+private:
+    struct StackCapture
+    {
+        void* frames[64];
+        int frameCount = 0;
+        std::atomic<bool> done = { false };
+        std::mutex mutex;
+    };
+
+    static StackCapture& GetStackCapture();
+    static void OnStackSignal(int a_signal);
+
+    void Start();
+    void Stop();
+    void Beat(UpdatePhase a_phase, bool a_ended);
+    void WatchMain();
+    void ReportHang(uint64_t a_heartbeat, Duration a_stalledFor);
+    void WriteLivenessFile(const char* a_state,
+                           uint64_t a_heartbeat,
+                           Duration a_stalledFor) const;
+    std::vector<std::string> CaptureStack();
+
+    const Duration m_hangThreshold;
+    const Duration m_checkInterval;
+    HangFunc m_hangFunc;
+    std::string m_livenessPath;
+    bool m_captureStack = true;
+    bool m_abortOnHang = false;
+
+    std::atomic<uint64_t> m_heartbeat = { 0 };
+    uint64_t m_frameIndex = 0;
+    std::atomic<uint64_t> m_hangCount = { 0 };
+    std::atomic<bool> m_hung = { false };
+
+    std::thread m_thread;
+    std::mutex m_mutex;
+    std::condition_variable m_condition;
+    bool m_stop = false;
+#ifdef SIMPLE_WATCHDOG_STACKS_SUPPORTED
+    pthread_t m_loopThread;
+#endif
+};
+
+//--------------------------------------------------------------
+//! Constructor.
+//! @param[in] a_hangThreshold Time without a heartbeat for a hang.
+//! @param[in] a_checkInterval Time between checks of the heartbeat.
+//--------------------------------------------------------------
+inline Watchdog::Watchdog(std::chrono::milliseconds a_hangThreshold,
+                          std::chrono::milliseconds a_checkInterval)
+    : m_hangThreshold(a_hangThreshold)
+    , m_checkInterval(a_checkInterval)
+{
+}
+
+//--------------------------------------------------------------
+//! Destructor. Stops watching if still running.
+//--------------------------------------------------------------
+inline Watchdog::~Watchdog()
+{
+    Stop();
+}
+
+//--------------------------------------------------------------
+//! Set a function to call (from the watchdog thread) with a report
+//! of each hang, instead of printing it. Must not be called while
+//! watching.
+//! @param[in] a_hangFunc The function to call with each hang report.
+//--------------------------------------------------------------
+inline void Watchdog::SetHangFunc(HangFunc a_hangFunc)
+{
+    m_hangFunc = a_hangFunc;
+}
+
+//--------------------------------------------------------------
+//! Set the path of a liveness file to write (replacing atomically)
+//! after each check, with the pid, state (alive, hung or stopped),
+//! frame index, phase, time stalled and count of hangs. Must not be
+//! called while watching.
+//! @param[in] a_path The path of the file (or empty for none).
+//--------------------------------------------------------------
+inline void Watchdog::SetLivenessFile(const std::string& a_path)
+{
+    m_livenessPath = a_path;
+}
+
+//--------------------------------------------------------------
+//! Set whether to capture the stack of the loop thread when hung
+//! (true by default; only supported on linux/glibc and macOS).
+//! Must not be called while watching.
+//! @param[in] a_captureStack Whether to capture the stack.
+//--------------------------------------------------------------
+inline void Watchdog::SetCaptureStack(bool a_captureStack)
+{
+    m_captureStack = a_captureStack;
+}
+
+//--------------------------------------------------------------
+//! Set whether to abort the process once a hang has been reported
+//! (false by default). Must not be called while watching.
+//! @param[in] a_abortOnHang Whether to abort when hung.
+//--------------------------------------------------------------
+inline void Watchdog::SetAbortOnHang(bool a_abortOnHang)
+{
+    m_abortOnHang = a_abortOnHang;
+}
+
+//--------------------------------------------------------------
+//! Check whether the watchdog thread is running.
+//! @return True if the watchdog thread is running.
+//--------------------------------------------------------------
+inline bool Watchdog::IsWatching() const
+{
+    return m_thread.joinable();
+}
+
+//--------------------------------------------------------------
+//! Check whether the loop is currently hung (ie. it was reported
+//! as hung and the heartbeat has not changed since).
+//! @return True if the loop is currently hung.
+//--------------------------------------------------------------
+inline bool Watchdog::IsHung() const
+{
+    return m_hung.load(std::memory_order_acquire);
+}
+
+//--------------------------------------------------------------
+//! Get the count of hangs reported.
+//! @return The count of hangs reported.
+//--------------------------------------------------------------
+inline uint64_t Watchdog::GetHangCount() const
+{
+    return m_hangCount.load(std::memory_order_acquire);
+}
+
+//--------------------------------------------------------------
+//! Starts watching on start up, and beats the heartbeat.
+//! @param[in] a_phase The phase of the loop that is about to begin.
+//--------------------------------------------------------------
+inline void Watchdog::OnPhaseBegin(UpdatePhase a_phase)
+{
+    if (a_phase == UpdatePhase::StartUp)
+    {
+        Start();
+    }
+    else if (a_phase == UpdatePhase::Start)
+    {
+        ++m_frameIndex;
+    }
+    Beat(a_phase, false);
+}
+
+//--------------------------------------------------------------
+//! Beats the heartbeat, and stops watching after shut down.
+//! @param[in] a_phase The phase of the loop that has just ended.
+//--------------------------------------------------------------
+inline void Watchdog::OnPhaseEnded(UpdatePhase a_phase)
+{
+    Beat(a_phase, true);
+    if (a_phase == UpdatePhase::ShutDown)
+    {
+        Stop();
+    }
+}
+
+//--------------------------------------------------------------
+inline Watchdog::StackCapture& Watchdog::GetStackCapture()
+{
+    static StackCapture s_stackCapture;
+    return s_stackCapture;
+}
+
+//--------------------------------------------------------------
+inline void Watchdog::OnStackSignal(int)
+{
+#ifdef SIMPLE_WATCHDOG_STACKS_SUPPORTED
+    StackCapture& capture = GetStackCapture();
+    capture.frameCount = backtrace(capture.frames, 64);
+    capture.done.store(true, std::memory_order_release);
+#endif
+}
+
+//--------------------------------------------------------------
+inline void Watchdog::Start()
+{
+    Stop();
+#ifdef SIMPLE_WATCHDOG_STACKS_SUPPORTED
+    m_loopThread = pthread_self();
+    if (m_captureStack)
+    {
+        // Load the unwinder now, as it may allocate on first use,
+        // which is not safe to do later from the signal handler.
+        void* frame = nullptr;
+        backtrace(&frame, 1);
+    }
+#endif
+    m_frameIndex = 0;
+    m_hung.store(false, std::memory_order_release);
+    m_stop = false;
+    m_thread = std::thread(&Watchdog::WatchMain, this);
+}
+
+//--------------------------------------------------------------
+inline void Watchdog::Stop()
+{
+    if (!m_thread.joinable())
+    {
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stop = true;
+    }
+    m_condition.notify_all();
+    m_thread.join();
+    WriteLivenessFile("stopped",
+                      m_heartbeat.load(std::memory_order_relaxed),
+                      Duration::zero());
+}
+
+//--------------------------------------------------------------
+inline void Watchdog::Beat(UpdatePhase a_phase, bool a_ended)
+{
+    const uint64_t heartbeat = (m_frameIndex << 4) |
+                               ((uint64_t)a_phase << 1) |
+                               (a_ended ? 1u : 0u);
+    m_heartbeat.store(heartbeat, std::memory_order_relaxed);
+}
+
+//--------------------------------------------------------------
+inline void Watchdog::WatchMain()
+{
+    uint64_t lastHeartbeat = m_heartbeat.load(std::memory_order_relaxed);
+    auto lastChangeTime = std::chrono::steady_clock::now();
+
+    std::unique_lock<std::mutex> lock(m_mutex);
+    while (!m_stop)
+    {
+        m_condition.wait_for(lock, m_checkInterval);
+        if (m_stop)
+        {
+            break;
+        }
+
+        const uint64_t heartbeat = m_heartbeat.load(
+            std::memory_order_relaxed);
+        const auto now = std::chrono::steady_clock::now();
+        if (heartbeat != lastHeartbeat)
+        {
+            lastHeartbeat = heartbeat;
+            lastChangeTime = now;
+            m_hung.store(false, std::memory_order_release);
+        }
+
+        const Duration stalledFor = now - lastChangeTime;
+        if (stalledFor >= m_hangThreshold &&
+            !m_hung.load(std::memory_order_relaxed))
+        {
+            m_hung.store(true, std::memory_order_release);
+            m_hangCount.fetch_add(1, std::memory_order_acq_rel);
+            lock.unlock();
+            ReportHang(heartbeat, stalledFor);
+            lock.lock();
+        }
+        WriteLivenessFile(m_hung.load(std::memory_order_relaxed) ?
+                          "hung" : "alive", heartbeat, stalledFor);
+    }
+}
+
+//--------------------------------------------------------------
+inline void Watchdog::ReportHang(uint64_t a_heartbeat,
+                                 Duration a_stalledFor)
+{
+    HangReport report;
+    report.frameIndex = a_heartbeat >> 4;
+    report.phase = (UpdatePhase)((a_heartbeat >> 1) & 7);
+    report.phaseEnded = (a_heartbeat & 1) != 0;
+    report.stalledFor = a_stalledFor;
+    if (m_captureStack)
+    {
+        report.stack = CaptureStack();
+    }
+
+    if (m_hangFunc)
+    {
+        m_hangFunc(report);
+    }
+    else
+    {
+        printf("Watchdog: hung for %lld ms %s phase %s of frame %llu\n",
+               (long long)std::chrono::duration_cast<
+                   std::chrono::milliseconds>(a_stalledFor).count(),
+               report.phaseEnded ? "after" : "in",
+               GetUpdatePhaseName(report.phase),
+               (unsigned long long)report.frameIndex);
+        for (const std::string& frame : report.stack)
+        {
+            printf("    %s\n", frame.c_str());
+        }
+    }
+
+    if (m_abortOnHang)
+    {
+        WriteLivenessFile("hung", a_heartbeat, a_stalledFor);
+        std::abort();
+    }
+}
+
+//--------------------------------------------------------------
+inline void Watchdog::WriteLivenessFile(const char* a_state,
+                                        uint64_t a_heartbeat,
+                                        Duration a_stalledFor) const
+{
+    if (m_livenessPath.empty())
+    {
+        return;
+    }
+
+    // Write to a temporary file then rename it, so readers never
+    // see a partially written file.
+    const std::string tempPath = m_livenessPath + ".tmp";
+    FILE* file = fopen(tempPath.c_str(), "w");
+    if (!file)
+    {
+        printf("Watchdog: cannot write %s\n", tempPath.c_str());
+        return;
+    }
+#if defined(__unix__) || defined(__APPLE__)
+    const long long pid = (long long)getpid();
+#else
+    const long long pid = 0;
+#endif
+    fprintf(file, "pid %lld\nstate %s\nframe %llu\nphase %s\n"
+                  "stalled_ms %lld\nhangs %llu\n",
+            pid,
+            a_state,
+            (unsigned long long)(a_heartbeat >> 4),
+            GetUpdatePhaseName((UpdatePhase)((a_heartbeat >> 1) & 7)),
+            (long long)std::chrono::duration_cast<
+                std::chrono::milliseconds>(a_stalledFor).count(),
+            (unsigned long long)GetHangCount());
+    fclose(file);
+    std::rename(tempPath.c_str(), m_livenessPath.c_str());
+}
+
+//--------------------------------------------------------------
+inline std::vector<std::string> Watchdog::CaptureStack()
+{
+    std::vector<std::string> stack;
+#ifdef SIMPLE_WATCHDOG_STACKS_SUPPORTED
+    StackCapture& capture = GetStackCapture();
+    std::lock_guard<std::mutex> lock(capture.mutex);
+    capture.done.store(false, std::memory_order_relaxed);
+
+    struct sigaction action = {};
+    action.sa_handler = &Watchdog::OnStackSignal;
+    action.sa_flags = SA_RESTART;
+    sigemptyset(&action.sa_mask);
+
+    // Restore the previous action however this returns, ignoring the
+    // signal first to discard it if still pending (eg. after timing
+    // out), so it is never delivered late to the previous action.
+    struct RestoreAction
+    {
+        struct sigaction previous = {};
+        bool installed = false;
+        ~RestoreAction()
+        {
+            if (installed)
+            {
+                struct sigaction ignore = {};
+                ignore.sa_handler = SIG_IGN;
+                sigemptyset(&ignore.sa_mask);
+                sigaction(DEFAULT_WATCHDOG_STACK_SIGNAL, &ignore, nullptr);
+                sigaction(DEFAULT_WATCHDOG_STACK_SIGNAL, &previous, nullptr);
+            }
+        }
+    } restoreAction;
+    restoreAction.installed = sigaction(DEFAULT_WATCHDOG_STACK_SIGNAL,
+                                        &action,
+                                        &restoreAction.previous) == 0;
+    if (!restoreAction.installed ||
+        pthread_kill(m_loopThread, DEFAULT_WATCHDOG_STACK_SIGNAL) != 0)
+    {
+        printf("Watchdog: cannot signal the loop thread\n");
+        return stack;
+    }
+
+    // The handler only runs once the thread is scheduled, so give
+    // up after a while.
+    const auto timeout = std::chrono::steady_clock::now() +
+                         std::chrono::milliseconds(500);
+    while (!capture.done.load(std::memory_order_acquire))
+    {
+        if (std::chrono::steady_clock::now() > timeout)
+        {
+            printf("Watchdog: timed out capturing the loop stack\n");
+            return stack;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+
+    char** symbols = backtrace_symbols(capture.frames, capture.frameCount);
+    if (symbols)
+    {
+        for (int i = 0; i < capture.frameCount; ++i)
+        {
+            stack.push_back(symbols[i]);
+        }
+        free(symbols);
+    }
+#endif
+    return stack;
+}
+
+} // namespace Simple
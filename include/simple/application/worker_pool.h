@@ -0,0 +1,272 @@
+//--------------------------------------------------------------
+// Copyright (c) David Bosnich <david.bosnich.public@gmail.com>
+//
+// This code is licensed under the MIT License, a copy of which
+// can be found in the license.txt file included at the root of
+// this distribution, or at https://opensource.org/licenses/MIT
+//--------------------------------------------------------------
+
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+//! @file
+
+//--------------------------------------------------------------
+namespace Simple
+{
+
+//--------------------------------------------------------------
+//! Fixed pool of worker threads used to run work in parallel from
+//! within a phase of the update loop. The calling thread joins in
+//! the work, and each call returns only once all work is complete.
+//!
+//! Exceptions thrown by the work on any thread are caught, so that
+//! all work still completes and the pool is left ready for reuse,
+//! then the first one caught is rethrown on the calling thread.
+//--------------------------------------------------------------
+class WorkerPool
+{
+public:
+    using IndexFunc = std::function<void(uint32_t a_index)>;
+
+    explicit WorkerPool(uint32_t a_threadCount = 0);
+    ~WorkerPool();
+
+    WorkerPool(const WorkerPool&) = delete;
+    WorkerPool& operator=(const WorkerPool&) = delete;
+
+    uint32_t GetThreadCount() const;
+    static uint32_t GetThreadIndex();
+
+    void ParallelFor(uint32_t a_count, const IndexFunc& a_func);
+
+private:
+    static uint32_t& ThreadIndex();
+
+    void WorkerMain(uint32_t a_threadIndex);
+    void Work(const IndexFunc& a_func, uint32_t a_count);
+
+    std::vector<std::thread> m_threads;
+    std::mutex m_mutex;
+    std::condition_variable m_condition;
+    const IndexFunc* m_func = nullptr;
+    std::exception_ptr m_exception;
+    uint32_t m_count = 0;
+    uint64_t m_generation = 0;
+    bool m_stopping = false;
+    std::atomic<uint32_t> m_nextIndex = { 0 };
+    std::atomic<uint32_t> m_doneCount = { 0 };
+    std::atomic<uint32_t> m_activeWorkers = { 0 };
+    std::atomic_bool m_busy = { false };
+};
+
+//--------------------------------------------------------------
+//! Constructor. Spawns all worker threads.
+//! @param[in] a_threadCount Total threads, including the caller's.
+//!            If zero, it uses the hardware concurrency instead.
+//--------------------------------------------------------------
+inline WorkerPool::WorkerPool(uint32_t a_threadCount)
+{
+    uint32_t threadCount = a_threadCount;
+    if (threadCount == 0)
+    {
+        threadCount = std::thread::hardware_concurrency();
+        threadCount = threadCount ? threadCount : 1;
+    }
+
+    for (uint32_t i = 1; i < threadCount; ++i)
+    {
+        m_threads.emplace_back(&WorkerPool::WorkerMain, this, i);
+    }
+}
+
+//--------------------------------------------------------------
+//! Destructor. Stops and joins all worker threads.
+//--------------------------------------------------------------
+inline WorkerPool::~WorkerPool()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stopping = true;
+    }
+    m_condition.notify_all();
+    for (std::thread& thread : m_threads)
+    {
+        thread.join();
+    }
+}
+
+//--------------------------------------------------------------
+//! Get the total count of threads, including the calling thread.
+//! @return The total count of threads, including calling thread.
+//--------------------------------------------------------------
+inline uint32_t WorkerPool::GetThreadCount() const
+{
+    return (uint32_t)m_threads.size() + 1;
+}
+
+//--------------------------------------------------------------
+//! Get the index of the current thread within its pool, which is
+//! zero for any thread that is not a worker (eg. the loop thread).
+//! @return Index of the current thread, less than GetThreadCount.
+//--------------------------------------------------------------
+inline uint32_t WorkerPool::GetThreadIndex()
+{
+    return ThreadIndex();
+}
+
+//--------------------------------------------------------------
+//! Call a function once for each index in [0, a_count), spread
+//! across all threads, returning once every call has completed.
+//! If the pool is already busy (eg. when called from within the
+//! function), all indices are instead run on the calling thread.
+//! If any call throws, the remaining calls are still made, and the
+//! first exception thrown is rethrown once every call has completed.
+//! @param[in] a_count The count of indices to call the function.
+//! @param[in] a_func The function to call with each index.
+//--------------------------------------------------------------
+inline void WorkerPool::ParallelFor(uint32_t a_count,
+                                    const IndexFunc& a_func)
+{
+    if (a_count == 0)
+    {
+        return;
+    }
+    bool expected = false;
+    if (a_count == 1 || m_threads.empty() ||
+        !m_busy.compare_exchange_strong(expected, true))
+    {
+        std::exception_ptr exception;
+        for (uint32_t i = 0; i < a_count; ++i)
+        {
+            try
+            {
+                a_func(i);
+            }
+            catch (...)
+            {
+                if (!exception)
+                {
+                    exception = std::current_exception();
+                }
+            }
+        }
+        if (exception)
+        {
+            std::rethrow_exception(exception);
+        }
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_func = &a_func;
+        m_count = a_count;
+        m_nextIndex.store(0, std::memory_order_relaxed);
+        m_doneCount.store(0, std::memory_order_relaxed);
+        ++m_generation;
+    }
+    m_condition.notify_all();
+
+    // Join in, then withdraw the job so that any worker still to
+    // wake sees it has gone, and wait for the workers that already
+    // took it to finish their last index before returning (at which
+    // point the function may be destroyed and the indices reset).
+    Work(a_func, a_count);
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_func = nullptr;
+        m_count = 0;
+    }
+    while (m_doneCount.load(std::memory_order_acquire) < a_count ||
+           m_activeWorkers.load(std::memory_order_acquire) != 0)
+    {
+        std::this_thread::yield();
+    }
+
+    std::exception_ptr exception;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        std::swap(exception, m_exception);
+    }
+    m_busy.store(false, std::memory_order_release);
+    if (exception)
+    {
+        std::rethrow_exception(exception);
+    }
+}
+
+//--------------------------------------------------------------
+inline uint32_t& WorkerPool::ThreadIndex()
+{
+    static thread_local uint32_t s_threadIndex = 0;
+    return s_threadIndex;
+}
+
+//--------------------------------------------------------------
+inline void WorkerPool::WorkerMain(uint32_t a_threadIndex)
+{
+    ThreadIndex() = a_threadIndex;
+
+    uint64_t generation = 0;
+    const IndexFunc* func = nullptr;
+    uint32_t count = 0;
+    while (true)
+    {
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_condition.wait(lock, [this, generation]()
+            {
+                return m_stopping || m_generation != generation;
+            });
+            if (m_stopping)
+            {
+                return;
+            }
+            generation = m_generation;
+            if (!m_func)
+            {
+                continue;
+            }
+            func = m_func;
+            count = m_count;
+            m_activeWorkers.fetch_add(1, std::memory_order_acq_rel);
+        }
+
+        Work(*func, count);
+        m_activeWorkers.fetch_sub(1, std::memory_order_acq_rel);
+    }
+}
+
+//--------------------------------------------------------------
+inline void WorkerPool::Work(const IndexFunc& a_func, uint32_t a_count)
+{
+    uint32_t index = m_nextIndex.fetch_add(1, std::memory_order_relaxed);
+    while (index < a_count)
+    {
+        try
+        {
+            a_func(index);
+        }
+        catch (...)
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            if (!m_exception)
+            {
+                m_exception = std::current_exception();
+            }
+        }
+        m_doneCount.fetch_add(1, std::memory_order_release);
+        index = m_nextIndex.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+} // namespace Simple
@@ -0,0 +1,385 @@
+//--------------------------------------------------------------
+// Copyright (c) David Bosnich <david.bosnich.public@gmail.com>
+//
+// This code is licensed under the MIT License, a copy of which
+// can be found in the license.txt file included at the root of
+// this distribution, or at https://opensource.org/licenses/MIT
+//--------------------------------------------------------------
+
+#pragma once
+
+#include "component_store.h"
+#include "worker_pool.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <functional>
+#include <vector>
+
+//! @file
+
+//--------------------------------------------------------------
+namespace Simple
+{
+
+//--------------------------------------------------------------
+//! Batch of many small, independent and homogeneous simulations
+//! (instances, eg. one per match) that are all stepped by a single
+//! update loop, instead of each needing its own loop and thread.
+//!
+//! The state of every instance is held in a ComponentStore (each
+//! instance is one entity), so steps are passed chunks of arrays
+//! of state spanning many instances that they can update using
+//! vectorized kernels (see integration_kernels.h). Each call to
+//! Step (eg. from UpdateFixed) runs every step on each chunk in
+//! turn, spreading the chunks across the threads of a WorkerPool.
+//!
+//! Instances are added or removed between steps, from the thread
+//! calling Step, eg. RemoveIf can remove those that steps flagged
+//! as finished. Throughput is kept as instance steps per second,
+//! which is the count of instances stepped divided by the time it
+//! took to step them.
+//--------------------------------------------------------------
+template<class... Components>
+class WorldBatch
+{
+public:
+    using Store = ComponentStore<Components...>;
+    using Instance = typename Store::Entity;
+    using Duration = std::chrono::steady_clock::duration;
+
+    struct BatchStats
+    {
+        uint64_t stepCount = 0;         //!< Calls to Step.
+        uint64_t instanceSteps = 0;     //!< Instances stepped in total.
+        uint32_t instanceCount = 0;     //!< Instances stepped last Step.
+        uint32_t chunkCount = 0;        //!< Chunks stepped last Step.
+        Duration lastStepDuration = Duration::zero();
+        Duration totalStepDuration = Duration::zero();
+        double lastInstanceStepsPerSecond = 0.0;
+        double instanceStepsPerSecond = 0.0; //!< Over all steps.
+    };
+
+    explicit WorldBatch(WorkerPool* a_workerPool = nullptr,
+                        uint32_t a_chunkCapacity = 1024);
+
+    WorldBatch(const WorldBatch&) = delete;
+    WorldBatch& operator=(const WorldBatch&) = delete;
+
+    Instance Add();
+    bool Remove(Instance a_instance);
+    template<class Component, class Predicate>
+    uint32_t RemoveIf(Predicate a_predicate);
+    bool IsAlive(Instance a_instance) const;
+    void Reserve(uint32_t a_count);
+    void Clear();
+
+    template<class Component>
+    Component* Get(Instance a_instance);
+
+    uint32_t GetCount() const;
+    Store& GetStore();
+
+    template<class... Signature, class Func>
+    void AddStep(Func a_func);
+
+    void Step(float a_fixedTimeSeconds);
+
+    const BatchStats& GetStats() const;
+    void ResetStats();
+
+private:
+    using StepFunc = std::function<void(uint32_t a_chunkIndex,
+                                        float a_fixedTimeSeconds)>;
+
+    bool IsStepping(const char* a_function) const;
+    void StepChunk(uint32_t a_chunkIndex, float a_fixedTimeSeconds);
+
+    Store m_store;
+    WorkerPool* m_workerPool = nullptr;
+    std::vector<StepFunc> m_steps;
+    std::atomic<bool> m_stepping = { false };
+    BatchStats m_stats;
+};
+
+//--------------------------------------------------------------
+//! Constructor.
+//! @param[in] a_workerPool Pool to step chunks in parallel (or null
+//!                         to step them all on the calling thread).
+//! @param[in] a_chunkCapacity The count of instances in each chunk.
+//--------------------------------------------------------------
+template<class... Components>
+inline WorldBatch<Components...>::WorldBatch(WorkerPool* a_workerPool,
+                                             uint32_t a_chunkCapacity)
+    : m_store(a_chunkCapacity)
+    , m_workerPool(a_workerPool)
+{
+}
+
+//--------------------------------------------------------------
+//! Add an instance, with all of its state zero-initialized. Must
+//! not be called while stepping.
+//! @return The instance added, or an invalid one if stepping.
+//--------------------------------------------------------------
+template<class... Components>
+inline typename WorldBatch<Components...>::Instance
+WorldBatch<Components...>::Add()
+{
+    if (IsStepping("Add"))
+    {
+        return Instance();
+    }
+    return m_store.Create();
+}
+
+//--------------------------------------------------------------
+//! Remove an instance. Must not be called while stepping.
+//! @param[in] a_instance The instance to remove.
+//! @return True if the instance was removed.
+//--------------------------------------------------------------
+template<class... Components>
+inline bool WorldBatch<Components...>::Remove(Instance a_instance)
+{
+    return !IsStepping("Remove") && m_store.Destroy(a_instance);
+}
+
+//--------------------------------------------------------------
+//! Remove all instances for which a predicate returns true when
+//! passed their component (eg. set by a step once a match ends).
+//! Must not be called while stepping.
+//! eg. RemoveIf<MatchState>([](const MatchState& a_s) {
+//!         return a_s.finished; });
+//! @param[in] a_predicate The function to call for each instance.
+//! @return The count of instances removed.
+//--------------------------------------------------------------
+template<class... Components>
+template<class Component, class Predicate>
+inline uint32_t WorldBatch<Components...>::RemoveIf(
+    Predicate a_predicate)
+{
+    if (IsStepping("RemoveIf"))
+    {
+        return 0;
+    }
+
+    // Iterate in reverse, as destroying an instance moves the last
+    // one into its place, which will then have already been seen.
+    uint32_t removedCount = 0;
+    for (uint32_t i = m_store.GetCount(); i-- > 0;)
+    {
+        const Instance instance = m_store.GetEntity(i);
+        const Component* component = m_store.template
+                                     Get<Component>(instance);
+        if (a_predicate(*component))
+        {
+            m_store.Destroy(instance);
+            ++removedCount;
+        }
+    }
+    return removedCount;
+}
+
+//--------------------------------------------------------------
+//! Check whether an instance has been added and not yet removed.
+//! @param[in] a_instance The instance to check.
+//! @return True if the instance is alive.
+//--------------------------------------------------------------
+template<class... Components>
+inline bool WorldBatch<Components...>::IsAlive(Instance a_instance) const
+{
+    return m_store.IsAlive(a_instance);
+}
+
+//--------------------------------------------------------------
+//! Reserve chunks for a count of instances, so adding that many
+//! does not need to allocate.
+//! @param[in] a_count The count of instances to reserve for.
+//--------------------------------------------------------------
+template<class... Components>
+inline void WorldBatch<Components...>::Reserve(uint32_t a_count)
+{
+    m_store.Reserve(a_count);
+}
+
+//--------------------------------------------------------------
+//! Remove all instances. Must not be called while stepping.
+//--------------------------------------------------------------
+template<class... Components>
+inline void WorldBatch<Components...>::Clear()
+{
+    if (!IsStepping("Clear"))
+    {
+        m_store.Clear();
+    }
+}
+
+//--------------------------------------------------------------
+//! Get a component of the state of an instance. The pointer is
+//! invalidated when any instance is added or removed.
+//! @param[in] a_instance The instance to get the component of.
+//! @return The component, or null if the instance is not alive.
+//--------------------------------------------------------------
+template<class... Components>
+template<class Component>
+inline Component* WorldBatch<Components...>::Get(Instance a_instance)
+{
+    return m_store.template Get<Component>(a_instance);
+}
+
+//--------------------------------------------------------------
+//! Get the count of instances.
+//! @return The count of instances.
+//--------------------------------------------------------------
+template<class... Components>
+inline uint32_t WorldBatch<Components...>::GetCount() const
+{
+    return m_store.GetCount();
+}
+
+//--------------------------------------------------------------
+//! Get the store holding the state of all instances.
+//! @return The store holding the state of all instances.
+//--------------------------------------------------------------
+template<class... Components>
+inline typename WorldBatch<Components...>::Store&
+WorldBatch<Components...>::GetStore()
+{
+    return m_store;
+}
+
+//--------------------------------------------------------------
+//! Add a step, called for each chunk (in the order steps were added)
+//! with the fixed delta time, the count of instances in the chunk,
+//! and an array of each component in a signature. Steps are called
+//! from multiple threads (one chunk each), so must only touch the
+//! arrays they are passed (and not add or remove any instances).
+//! Must not be called while stepping.
+//! eg. AddStep<PositionX, VelocityX>([](float a_dt, uint32_t a_count,
+//!                                     PositionX* a_p, VelocityX* a_v) {});
+//! @param[in] a_func The function to call for each chunk.
+//--------------------------------------------------------------
+template<class... Components>
+template<class... Signature, class Func>
+inline void WorldBatch<Components...>::AddStep(Func a_func)
+{
+    if (IsStepping("AddStep"))
+    {
+        return;
+    }
+    Store& store = m_store;
+    m_steps.push_back([&store, a_func](uint32_t a_chunkIndex,
+                                       float a_fixedTimeSeconds)
+    {
+        store.template ForChunk<Signature...>(a_chunkIndex,
+            [&a_func, a_fixedTimeSeconds](uint32_t a_count,
+                                          Signature*... a_arrays)
+        {
+            a_func(a_fixedTimeSeconds, a_count, a_arrays...);
+        });
+    });
+}
+
+//--------------------------------------------------------------
+//! Step all instances by running every step on each chunk.
+//! @param[in] a_fixedTimeSeconds The fixed delta time.
+//--------------------------------------------------------------
+template<class... Components>
+inline void WorldBatch<Components...>::Step(float a_fixedTimeSeconds)
+{
+    const uint32_t instanceCount = m_store.GetCount();
+    const uint32_t chunkCount = m_store.GetChunkCount();
+    const auto startTime = std::chrono::steady_clock::now();
+
+    // Clear the stepping flag however the step exits, so the batch
+    // can still be modified after a step throws (eg. if the error is
+    // contained by the loop, which then carries on to the next one).
+    struct SteppingGuard
+    {
+        std::atomic<bool>& stepping;
+        ~SteppingGuard() { stepping.store(false, std::memory_order_relaxed); }
+    };
+    m_stepping.store(true, std::memory_order_relaxed);
+    const SteppingGuard steppingGuard{ m_stepping };
+    if (m_workerPool && chunkCount > 1)
+    {
+        m_workerPool->ParallelFor(chunkCount,
+                                  [this, a_fixedTimeSeconds](uint32_t a_i)
+        {
+            StepChunk(a_i, a_fixedTimeSeconds);
+        });
+    }
+    else
+    {
+        for (uint32_t i = 0; i < chunkCount; ++i)
+        {
+            StepChunk(i, a_fixedTimeSeconds);
+        }
+    }
+
+    const Duration duration = std::chrono::steady_clock::now() -
+                              startTime;
+
+    const double seconds = std::chrono::duration<double>(duration)
+                           .count();
+    ++m_stats.stepCount;
+    m_stats.instanceSteps += instanceCount;
+    m_stats.instanceCount = instanceCount;
+    m_stats.chunkCount = chunkCount;
+    m_stats.lastStepDuration = duration;
+    m_stats.totalStepDuration += duration;
+    m_stats.lastInstanceStepsPerSecond = seconds > 0.0 ?
+        (double)instanceCount / seconds : 0.0;
+    const double totalSeconds = std::chrono::duration<double>(
+        m_stats.totalStepDuration).count();
+    m_stats.instanceStepsPerSecond = totalSeconds > 0.0 ?
+        (double)m_stats.instanceSteps / totalSeconds : 0.0;
+}
+
+//--------------------------------------------------------------
+//! Get the stats of all steps since constructed (or last reset).
+//! @return The stats of all steps.
+//--------------------------------------------------------------
+template<class... Components>
+inline const typename WorldBatch<Components...>::BatchStats&
+WorldBatch<Components...>::GetStats() const
+{
+    return m_stats;
+}
+
+//--------------------------------------------------------------
+//! Reset the stats of all steps.
+//--------------------------------------------------------------
+template<class... Components>
+inline void WorldBatch<Components...>::ResetStats()
+{
+    m_stats = BatchStats();
+}
+
+//--------------------------------------------------------------
+template<class... Components>
+inline bool WorldBatch<Components...>::IsStepping(
+    const char* a_function) const
+{
+    if (m_stepping.load(std::memory_order_relaxed))
+    {
+        printf("WorldBatch::%s: cannot be called while stepping\n",
+               a_function);
+        return true;
+    }
+    return false;
+}
+
+//--------------------------------------------------------------
+template<class... Components>
+inline void WorldBatch<Components...>::StepChunk(uint32_t a_chunkIndex,
+                                                 float a_fixedTimeSeconds)
+{
+    for (const StepFunc& step : m_steps)
+    {
+        step(a_chunkIndex, a_fixedTimeSeconds);
+    }
+}
+
+} // namespace Simple
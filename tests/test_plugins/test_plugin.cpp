@@ -0,0 +1,109 @@
+//--------------------------------------------------------------
+// Copyright (c) David Bosnich <david.bosnich.public@gmail.com>
+//
+// This code is licensed under the MIT License, a copy of which
+// can be found in the license.txt file included at the root of
+// this distribution, or at https://opensource.org/licenses/MIT
+//--------------------------------------------------------------
+
+#include "test_plugin_state.h"
+
+#include <simple/application/plugin_host.h>
+
+#include <cstring>
+
+using namespace Simple;
+
+// Versions 1 and 2 have their own state layouts, version 2 migrating
+// from version 1. Version 3 is incompatible with all previous states.
+#if TEST_PLUGIN_VERSION == 1
+using State = TestPluginStateV1;
+#else
+using State = TestPluginStateV2;
+#endif
+
+//--------------------------------------------------------------
+static void* Create()
+{
+    return new State();
+}
+
+//--------------------------------------------------------------
+static void Destroy(void* a_state)
+{
+    delete static_cast<State*>(a_state);
+}
+
+//--------------------------------------------------------------
+static size_t Save(const void* a_state, void* o_buffer, size_t a_capacity)
+{
+    if (a_capacity >= sizeof(State))
+    {
+        memcpy(o_buffer, a_state, sizeof(State));
+    }
+    return sizeof(State);
+}
+
+//--------------------------------------------------------------
+static void* Load(const void* a_buffer, size_t a_size, uint32_t a_version)
+{
+#if TEST_PLUGIN_VERSION == 1
+    if (a_version == 1 && a_size == sizeof(TestPluginStateV1))
+    {
+        State* state = new State();
+        memcpy(state, a_buffer, sizeof(State));
+        return state;
+    }
+#elif TEST_PLUGIN_VERSION == 2
+    if (a_version == 1 && a_size == sizeof(TestPluginStateV1))
+    {
+        TestPluginStateV1 previous;
+        memcpy(&previous, a_buffer, sizeof(previous));
+        State* state = new State();
+        state->fixedCount = previous.fixedCount;
+        state->migratedCount = 1;
+        return state;
+    }
+    if (a_version == 2 && a_size == sizeof(TestPluginStateV2))
+    {
+        State* state = new State();
+        memcpy(state, a_buffer, sizeof(State));
+        ++state->migratedCount;
+        return state;
+    }
+#else
+    (void)a_buffer;
+    (void)a_size;
+    (void)a_version;
+#endif
+    return nullptr;
+}
+
+//--------------------------------------------------------------
+static void UpdateFixed(void* a_state, float a_fixedTimeSeconds)
+{
+    State* state = static_cast<State*>(a_state);
+    ++state->fixedCount;
+#if TEST_PLUGIN_VERSION == 1
+    (void)a_fixedTimeSeconds;
+#else
+    state->fixedTimeSeconds += a_fixedTimeSeconds;
+#endif
+}
+
+//--------------------------------------------------------------
+SIMPLE_PLUGIN_EXPORT const PluginApi* SimpleGetPluginApi()
+{
+    static const PluginApi s_api = {
+        SIMPLE_PLUGIN_ABI_VERSION,
+        TEST_PLUGIN_VERSION,
+        &Create,
+        &Destroy,
+        &Save,
+        &Load,
+        nullptr,
+        &UpdateFixed,
+        nullptr
+    };
+    return &s_api;
+}
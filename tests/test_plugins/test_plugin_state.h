@@ -0,0 +1,31 @@
+//--------------------------------------------------------------
+// Copyright (c) David Bosnich <david.bosnich.public@gmail.com>
+//
+// This code is licensed under the MIT License, a copy of which
+// can be found in the license.txt file included at the root of
+// this distribution, or at https://opensource.org/licenses/MIT
+//--------------------------------------------------------------
+
+#pragma once
+
+#include <cstdint>
+
+//--------------------------------------------------------------
+// State of version 1 of the test plugin.
+//--------------------------------------------------------------
+struct TestPluginStateV1
+{
+    uint32_t version = 1;
+    uint32_t fixedCount = 0;
+};
+
+//--------------------------------------------------------------
+// State of version 2 of the test plugin (migrated from version 1).
+//--------------------------------------------------------------
+struct TestPluginStateV2
+{
+    uint32_t version = 2;
+    uint32_t fixedCount = 0;
+    uint32_t migratedCount = 0;
+    float fixedTimeSeconds = 0.0f;
+};
@@ -729,3 +729,256 @@ TEST_CASE("Test Application Thread", "[application][thread]")
     runThread3.join();
     runThread2.join();
 }
+
+//--------------------------------------------------------------
+// Throws from a phase of each frame in a range (of all frames), and
+// shuts down once a count of frames since the last start up is run.
+//--------------------------------------------------------------
+class ErrorTestApplication : public Simple::Application
+{
+public:
+    ErrorTestApplication(Simple::UpdatePhase a_throwPhase,
+                         uint32_t a_throwFrom,
+                         uint32_t a_throwTo,
+                         uint32_t a_numFrames)
+        : m_throwPhase(a_throwPhase)
+        , m_throwFrom(a_throwFrom)
+        , m_throwTo(a_throwTo)
+        , m_numFrames(a_numFrames)
+    {
+        SetErrorBackoff(std::chrono::milliseconds(0),
+                        std::chrono::milliseconds(0));
+    }
+
+    uint32_t m_phaseCounts[5] = {};
+    std::vector<Simple::FrameError> m_frameErrors;
+
+protected:
+    void StartUp() override
+    {
+        m_frameCount = 0;
+        Call(Simple::UpdatePhase::StartUp);
+    }
+    void ShutDown() override
+    {
+        Call(Simple::UpdatePhase::ShutDown);
+    }
+    void UpdateStart(float) override
+    {
+        ++m_frameCount;
+        ++m_totalFrameCount;
+        Call(Simple::UpdatePhase::Start);
+    }
+    void UpdateFixed(float) override
+    {
+        Call(Simple::UpdatePhase::Fixed);
+    }
+    void UpdateEnded(float) override
+    {
+        Call(Simple::UpdatePhase::Ended);
+        if (m_frameCount >= m_numFrames)
+        {
+            RequestShutDown();
+        }
+    }
+    Simple::FrameErrorAction OnFrameError(
+        const Simple::FrameError& a_frameError) override
+    {
+        m_frameErrors.push_back(a_frameError);
+        return Simple::Application::OnFrameError(a_frameError);
+    }
+
+private:
+    void Call(Simple::UpdatePhase a_phase)
+    {
+        ++m_phaseCounts[(size_t)a_phase];
+        const uint32_t startUpCount =
+            m_phaseCounts[(size_t)Simple::UpdatePhase::StartUp];
+        const uint32_t index = a_phase == Simple::UpdatePhase::StartUp ?
+                               startUpCount : m_totalFrameCount;
+        if (a_phase == m_throwPhase &&
+            index >= m_throwFrom && index < m_throwTo)
+        {
+            throw std::runtime_error("test error");
+        }
+    }
+
+    const Simple::UpdatePhase m_throwPhase;
+    const uint32_t m_throwFrom;
+    const uint32_t m_throwTo;
+    const uint32_t m_numFrames;
+    uint32_t m_frameCount = 0;
+    uint32_t m_totalFrameCount = 0;
+};
+
+//--------------------------------------------------------------
+TEST_CASE("Test Application Error Rethrow", "[application][error]")
+{
+    // By default errors shut down the loop, then are rethrown.
+    ErrorTestApplication application(Simple::UpdatePhase::Fixed, 3, 4, 10);
+    REQUIRE(application.GetFrameErrorAction() ==
+            Simple::FrameErrorAction::Rethrow);
+    REQUIRE_THROWS_WITH(application.Run(1000), "test error");
+    REQUIRE(application.m_phaseCounts[(size_t)Simple::UpdatePhase::Ended]
+            == 2);
+    REQUIRE(application.m_phaseCounts[(size_t)Simple::UpdatePhase::ShutDown]
+            == 1);
+    REQUIRE(application.GetErrorCount(Simple::UpdatePhase::Fixed) == 1);
+    REQUIRE(application.GetErrorCount() == 1);
+    REQUIRE(application.m_frameErrors.size() == 1);
+    REQUIRE(application.m_frameErrors[0].phase ==
+            Simple::UpdatePhase::Fixed);
+    REQUIRE(application.m_frameErrors[0].frameIndex == 2);
+    REQUIRE(application.m_frameErrors[0].consecutiveCount == 1);
+    REQUIRE(std::string(application.m_frameErrors[0].what) == "test error");
+}
+
+//--------------------------------------------------------------
+TEST_CASE("Test Application Error Actions", "[application][error]")
+{
+    using Simple::FrameErrorAction;
+    using Simple::UpdatePhase;
+
+    // Continue with the rest of each frame.
+    ErrorTestApplication continued(UpdatePhase::Start, 3, 6, 10);
+    continued.SetFrameErrorAction(FrameErrorAction::Continue);
+    continued.Run(1000);
+    REQUIRE(continued.m_phaseCounts[(size_t)UpdatePhase::Ended] == 10);
+    REQUIRE(continued.GetErrorCount(UpdatePhase::Start) == 3);
+    REQUIRE(continued.m_frameErrors.size() == 3);
+    REQUIRE(continued.m_frameErrors[2].frameIndex == 4);
+    REQUIRE(continued.m_frameErrors[2].consecutiveCount == 3);
+
+    // Skip the rest of each frame.
+    ErrorTestApplication skipped(UpdatePhase::Start, 3, 6, 10);
+    skipped.SetFrameErrorAction(FrameErrorAction::SkipFrame);
+    skipped.Run(1000);
+    REQUIRE(skipped.m_phaseCounts[(size_t)UpdatePhase::Start] == 10);
+    REQUIRE(skipped.m_phaseCounts[(size_t)UpdatePhase::Ended] == 7);
+    REQUIRE(skipped.m_phaseCounts[(size_t)UpdatePhase::ShutDown] == 1);
+
+    // Restart, then run all frames again.
+    ErrorTestApplication restarted(UpdatePhase::Ended, 5, 6, 8);
+    restarted.SetFrameErrorAction(FrameErrorAction::Restart);
+    restarted.Run(1000);
+    REQUIRE(restarted.m_phaseCounts[(size_t)UpdatePhase::StartUp] == 2);
+    REQUIRE(restarted.m_phaseCounts[(size_t)UpdatePhase::ShutDown] == 2);
+    REQUIRE(restarted.m_phaseCounts[(size_t)UpdatePhase::Ended] == 13);
+    REQUIRE(restarted.GetErrorCount(UpdatePhase::Ended) == 1);
+
+    // Shut down without rethrowing.
+    ErrorTestApplication shutDown(UpdatePhase::Fixed, 2, 3, 10);
+    shutDown.SetFrameErrorAction(FrameErrorAction::ShutDown);
+    REQUIRE_NOTHROW(shutDown.Run(1000));
+    REQUIRE(shutDown.m_phaseCounts[(size_t)UpdatePhase::Ended] == 1);
+    REQUIRE(shutDown.m_phaseCounts[(size_t)UpdatePhase::ShutDown] == 1);
+
+    // Errors thrown from start up or shut down are also contained.
+    ErrorTestApplication startUp(UpdatePhase::StartUp, 1, 3, 2);
+    startUp.SetFrameErrorAction(FrameErrorAction::Restart);
+    startUp.Run(1000);
+    REQUIRE(startUp.m_phaseCounts[(size_t)UpdatePhase::StartUp] == 3);
+    REQUIRE(startUp.m_phaseCounts[(size_t)UpdatePhase::Start] == 2);
+    REQUIRE(startUp.GetErrorCount(UpdatePhase::StartUp) == 2);
+    REQUIRE(startUp.m_frameErrors[1].consecutiveCount == 2);
+}
+
+//--------------------------------------------------------------
+// Throws from the begin hook of a phase, the given time it begins.
+//--------------------------------------------------------------
+class ErrorTestListener : public Simple::UpdateLoop::Listener
+{
+public:
+    ErrorTestListener(Simple::UpdatePhase a_phase, uint32_t a_throwAt)
+        : m_phase(a_phase), m_throwAt(a_throwAt) {}
+
+    uint32_t m_begunCount = 0;
+    uint32_t m_endedCount = 0;
+
+    void OnPhaseBegin(Simple::UpdatePhase a_phase) override
+    {
+        if (a_phase == m_phase && ++m_begunCount == m_throwAt)
+        {
+            throw std::runtime_error("listener error");
+        }
+    }
+    void OnPhaseEnded(Simple::UpdatePhase a_phase) override
+    {
+        m_endedCount += (a_phase == m_phase);
+    }
+
+private:
+    const Simple::UpdatePhase m_phase;
+    const uint32_t m_throwAt;
+};
+
+//--------------------------------------------------------------
+// Throws from OnFrameComplete for one frame.
+//--------------------------------------------------------------
+class CompleteErrorTestApplication : public ErrorTestApplication
+{
+public:
+    explicit CompleteErrorTestApplication(uint64_t a_throwAt)
+        : ErrorTestApplication(Simple::UpdatePhase::Fixed, 0, 0, 10)
+        , m_throwAt(a_throwAt) {}
+
+protected:
+    void OnFrameComplete(const FrameStats& a_frameStats) override
+    {
+        if (a_frameStats.frameCount == m_throwAt)
+        {
+            throw std::runtime_error("complete error");
+        }
+    }
+
+private:
+    const uint64_t m_throwAt;
+};
+
+//--------------------------------------------------------------
+TEST_CASE("Test Application Error Hooks", "[application][error]")
+{
+    using Simple::UpdatePhase;
+
+    // Errors thrown from listeners are contained under their phase,
+    // which is skipped, but the listeners' end hooks are still called.
+    ErrorTestApplication application(UpdatePhase::Fixed, 0, 0, 10);
+    ErrorTestListener listener(UpdatePhase::Fixed, 3);
+    application.AddListener(&listener);
+    REQUIRE_THROWS_WITH(application.Run(1000), "listener error");
+    REQUIRE(application.m_phaseCounts[(size_t)UpdatePhase::ShutDown] == 1);
+    REQUIRE(application.m_phaseCounts[(size_t)UpdatePhase::Fixed] ==
+            listener.m_begunCount - 1);
+    REQUIRE(listener.m_endedCount == listener.m_begunCount);
+    REQUIRE(application.GetErrorCount(UpdatePhase::Fixed) == 1);
+    REQUIRE(application.m_frameErrors.size() == 1);
+    REQUIRE(application.m_frameErrors[0].phase == UpdatePhase::Fixed);
+    application.RemoveListener(&listener);
+
+    // And those thrown from OnFrameComplete as part of the Ended phase.
+    CompleteErrorTestApplication completed(4);
+    completed.SetFrameErrorAction(Simple::FrameErrorAction::Continue);
+    REQUIRE_NOTHROW(completed.Run(1000));
+    REQUIRE(completed.m_phaseCounts[(size_t)UpdatePhase::Ended] == 10);
+    REQUIRE(completed.GetErrorCount(UpdatePhase::Ended) == 1);
+    REQUIRE(completed.GetErrorCount() == 1);
+    REQUIRE(completed.m_frameErrors[0].frameIndex == 3);
+    REQUIRE(std::string(completed.m_frameErrors[0].what) ==
+            "complete error");
+}
+
+//--------------------------------------------------------------
+TEST_CASE("Test Application Error Backoff", "[application][error]")
+{
+    // Waits 0 + 10 + 20 + 20 (the maximum) after consecutive errors.
+    ErrorTestApplication application(Simple::UpdatePhase::Fixed, 1, 5, 6);
+    application.SetFrameErrorAction(Simple::FrameErrorAction::Continue);
+    application.SetErrorBackoff(std::chrono::milliseconds(10),
+                                std::chrono::milliseconds(20));
+    const auto begin = std::chrono::steady_clock::now();
+    application.Run(1000);
+    const auto duration = std::chrono::steady_clock::now() - begin;
+    REQUIRE(duration >= std::chrono::milliseconds(50));
+    REQUIRE(application.GetErrorCount() == 4);
+    REQUIRE(application.m_frameErrors[3].consecutiveCount == 4);
+}
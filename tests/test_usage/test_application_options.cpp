@@ -0,0 +1,155 @@
+//--------------------------------------------------------------
+// Copyright (c) David Bosnich <david.bosnich.public@gmail.com>
+//
+// This code is licensed under the MIT License, a copy of which
+// can be found in the license.txt file included at the root of
+// this distribution, or at https://opensource.org/licenses/MIT
+//--------------------------------------------------------------
+
+#include <simple/application/application.h>
+#include <catch2/catch.hpp>
+
+//--------------------------------------------------------------
+TEST_CASE("Test Options Standard", "[options][standard]")
+{
+    const char* args[] = { "app", "--fps=144", "--uncapped",
+                           "--threads", "6", "--wait-strategy=sleep",
+                           "input.txt", "--trace=out.trace",
+                           "--stats-interval=2.5", "--pin-cpu=3" };
+    Simple::ApplicationOptions options;
+    REQUIRE(options.Parse(10, (char**)args));
+
+    // Strings point into the arguments, rather than being copied.
+    const Simple::ApplicationOptions::Standard& standard =
+        options.GetStandard();
+    REQUIRE(standard.fps == 144);
+    REQUIRE(standard.uncapped);
+    REQUIRE(standard.threads == 6);
+    REQUIRE(standard.pinCpu == 3);
+    REQUIRE(standard.waitStrategy ==
+            Simple::LoopPolicy::WaitStrategy::Sleep);
+    REQUIRE(standard.trace == args[7] + 8);
+    REQUIRE(standard.statsInterval == 2.5f);
+    REQUIRE(options.IsSet("threads"));
+    REQUIRE(options.IsSet("pin-cpu"));
+    REQUIRE_FALSE(options.IsSet("thread"));
+    REQUIRE_FALSE(options.IsHelpRequested());
+}
+
+//--------------------------------------------------------------
+TEST_CASE("Test Options Custom", "[options][custom]")
+{
+    static const char* const s_modes[] = { "fast", "safe" };
+    bool verbose = false;
+    int32_t offset = 0;
+    uint8_t mode = 0;
+    const char* name = "default";
+
+    Simple::ApplicationOptions options;
+    REQUIRE(options.Add("verbose", &verbose, "Print more."));
+    REQUIRE(options.Add("offset", &offset, "Signed offset."));
+    REQUIRE(options.AddChoice("mode", &mode, s_modes, 2, "The mode."));
+    REQUIRE(options.Add("name", &name, "The name."));
+    REQUIRE_FALSE(options.Add("fps", &offset, "Already added."));
+
+    const char* args[] = { "app", "--verbose=false", "--offset=-7",
+                           "--mode", "safe", "--name=x" };
+    REQUIRE(options.Parse(6, (char**)args));
+    REQUIRE_FALSE(verbose);
+    REQUIRE(offset == -7);
+    REQUIRE(mode == 1);
+    REQUIRE(strcmp(name, "x") == 0);
+    REQUIRE_FALSE(options.IsSet("fps"));
+
+    // Invalid values are rejected, and leave the value unchanged.
+    const char* badInt[] = { "app", "--offset=7x" };
+    REQUIRE_FALSE(options.Parse(2, (char**)badInt));
+    REQUIRE(offset == -7);
+    const char* badUInt[] = { "app", "--fps=-60" };
+    REQUIRE_FALSE(options.Parse(2, (char**)badUInt));
+    REQUIRE(options.GetStandard().fps == 0);
+    const char* zeroFps[] = { "app", "--fps=0" };
+    REQUIRE_FALSE(options.Parse(2, (char**)zeroFps));
+    REQUIRE_FALSE(options.IsSet("fps"));
+    const char* badPinCpu[] = { "app", "--pin-cpu=-1" };
+    REQUIRE_FALSE(options.Parse(2, (char**)badPinCpu));
+    REQUIRE_FALSE(options.IsSet("pin-cpu"));
+    const char* badFloats[] = { "nan", "inf", "-infinity", "1e40" };
+    for (const char* badFloat : badFloats)
+    {
+        const char* badFloatArgs[] = { "app", "--stats-interval",
+                                       badFloat };
+        REQUIRE_FALSE(options.Parse(3, (char**)badFloatArgs));
+        REQUIRE(options.GetStandard().statsInterval == 0.0f);
+    }
+    const char* badChoice[] = { "app", "--mode=slow" };
+    REQUIRE_FALSE(options.Parse(2, (char**)badChoice));
+    REQUIRE(mode == 1);
+    const char* unknown[] = { "app", "--unknown" };
+    REQUIRE_FALSE(options.Parse(2, (char**)unknown));
+    const char* missing[] = { "app", "--threads" };
+    REQUIRE_FALSE(options.Parse(2, (char**)missing));
+    const char* help[] = { "app", "--help" };
+    REQUIRE_FALSE(options.Parse(2, (char**)help));
+    REQUIRE(options.IsHelpRequested());
+}
+
+//--------------------------------------------------------------
+class OptionsTestApplication : public Simple::Application
+{
+public:
+    OptionsTestApplication(int a_argc, char* a_argv[])
+        : Application(a_argc, a_argv)
+    {
+        GetOptions().Add("frames", &m_frames, "Frames to run.");
+    }
+
+    uint32_t m_frames = 1;
+    uint32_t m_framesRun = 0;
+    uint32_t m_targetFPS = 0;
+    bool m_cappedFPS = true;
+    Simple::LoopPolicy::WaitStrategy m_waitStrategy =
+        Simple::LoopPolicy::WaitStrategy::Spin;
+
+protected:
+    void StartUp() override {}
+    void ShutDown() override {}
+    void UpdateStart(float) override {}
+    void UpdateFixed(float) override {}
+
+    void UpdateEnded(float) override
+    {
+        m_targetFPS = GetTargetFPS();
+        m_cappedFPS = GetCappedFPS();
+        m_waitStrategy = GetWaitStrategy();
+        if (++m_framesRun == m_frames)
+        {
+            RequestShutDown();
+        }
+    }
+};
+
+//--------------------------------------------------------------
+TEST_CASE("Test Options Application", "[options][application]")
+{
+    const char* args[] = { "app", "--fps=200", "--frames=4",
+                           "--wait-strategy=sleep" };
+    OptionsTestApplication application(4, (char**)args);
+    REQUIRE(application.RunWithOptions() == 0);
+    REQUIRE(application.m_framesRun == 4);
+    REQUIRE(application.m_targetFPS == 200);
+    REQUIRE(application.m_cappedFPS);
+    REQUIRE(application.m_waitStrategy ==
+            Simple::LoopPolicy::WaitStrategy::Sleep);
+
+    const char* uncapped[] = { "app", "--uncapped" };
+    OptionsTestApplication uncappedApplication(2, (char**)uncapped);
+    REQUIRE(uncappedApplication.RunWithOptions() == 0);
+    REQUIRE(uncappedApplication.m_targetFPS == DEFAULT_TARGET_FPS);
+    REQUIRE_FALSE(uncappedApplication.m_cappedFPS);
+
+    const char* invalid[] = { "app", "--frames=none" };
+    OptionsTestApplication invalidApplication(2, (char**)invalid);
+    REQUIRE(invalidApplication.RunWithOptions() != 0);
+    REQUIRE(invalidApplication.m_framesRun == 0);
+}
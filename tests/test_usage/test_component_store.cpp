@@ -0,0 +1,201 @@
+//--------------------------------------------------------------
+// Copyright (c) David Bosnich <david.bosnich.public@gmail.com>
+//
+// This code is licensed under the MIT License, a copy of which
+// can be found in the license.txt file included at the root of
+// this distribution, or at https://opensource.org/licenses/MIT
+//--------------------------------------------------------------
+
+#include <simple/application/component_store.h>
+#include <catch2/catch.hpp>
+
+//--------------------------------------------------------------
+struct Position { float x, y, z; };
+struct Velocity { float x, y, z; };
+struct Health { uint32_t value; };
+
+using Store = Simple::ComponentStore<Position, Velocity, Health>;
+
+//--------------------------------------------------------------
+TEST_CASE("Test Component Store Entities", "[component_store][entities]")
+{
+    Store store(10);
+    REQUIRE(store.GetChunkCapacity() == 16);
+
+    std::vector<Store::Entity> entities;
+    for (uint32_t i = 0; i < 40; ++i)
+    {
+        entities.push_back(store.Create());
+        REQUIRE(store.Get<Health>(entities.back())->value == 0);
+        store.Get<Health>(entities.back())->value = i;
+    }
+    REQUIRE(store.GetCount() == 40);
+    REQUIRE(store.GetChunkCount() == 3);
+
+    // Destroying moves the last entity into the hole.
+    REQUIRE(store.Destroy(entities[3]));
+    REQUIRE(!store.Destroy(entities[3]));
+    REQUIRE(!store.IsAlive(entities[3]));
+    REQUIRE(store.Get<Health>(entities[3]) == nullptr);
+    REQUIRE(store.Get<Health>(entities[39])->value == 39);
+    REQUIRE(store.GetCount() == 39);
+
+    // Emptying the last chunk returns it to the pool.
+    for (uint32_t i = 32; i < 40; ++i)
+    {
+        REQUIRE(store.Destroy(entities[i]));
+    }
+    REQUIRE(store.GetChunkCount() == 2);
+
+    // Reused slots get a new generation, old handles stay dead.
+    const Store::Entity reused = store.Create();
+    REQUIRE(reused.index == entities[39].index);
+    REQUIRE(reused.generation != entities[39].generation);
+    REQUIRE(!store.IsAlive(entities[39]));
+    REQUIRE(store.IsAlive(reused));
+    for (uint32_t i = 0; i < 32; ++i)
+    {
+        if (i != 3)
+        {
+            REQUIRE(store.Get<Health>(entities[i])->value == i);
+        }
+    }
+
+    store.Clear();
+    REQUIRE(store.GetCount() == 0);
+    REQUIRE(store.GetChunkCount() == 0);
+    REQUIRE(!store.IsAlive(reused));
+
+    // Slots reused after clearing still get a new generation.
+    const Store::Entity cleared = store.Create();
+    REQUIRE(cleared.index == entities[0].index);
+    REQUIRE(cleared.generation != entities[0].generation);
+    REQUIRE(!store.IsAlive(entities[0]));
+    REQUIRE(store.IsAlive(cleared));
+}
+
+//--------------------------------------------------------------
+TEST_CASE("Test Component Store Chunks", "[component_store][chunks]")
+{
+    Store store(64);
+    store.Reserve(1000);
+    for (uint32_t i = 0; i < 1000; ++i)
+    {
+        const Store::Entity entity = store.Create();
+        store.Get<Position>(entity)->x = (float)i;
+        store.Get<Velocity>(entity)->x = 1.0f;
+    }
+
+    // Each chunk holds aligned arrays of only the components used.
+    uint32_t total = 0;
+    uint32_t misaligned = 0;
+    store.ForEachChunk<Velocity, Position>(
+        [&](uint32_t a_count, Velocity* a_velocity, Position* a_position)
+    {
+        misaligned += ((uintptr_t)a_velocity % 64 != 0);
+        misaligned += ((uintptr_t)a_position % 64 != 0);
+        for (uint32_t i = 0; i < a_count; ++i)
+        {
+            a_position[i].x += a_velocity[i].x;
+        }
+        total += a_count;
+    });
+    REQUIRE(total == 1000);
+    REQUIRE(misaligned == 0);
+
+    Simple::WorkerPool workerPool(4);
+    std::atomic<uint32_t> parallelTotal = { 0 };
+    store.ParallelForEachChunk<Position>(workerPool,
+        [&](uint32_t a_count, Position* a_position)
+    {
+        for (uint32_t i = 0; i < a_count; ++i)
+        {
+            a_position[i].x += 1.0f;
+        }
+        parallelTotal += a_count;
+    });
+    REQUIRE(parallelTotal == 1000);
+
+    double sum = 0.0;
+    store.ForEachChunk<Position>([&sum](uint32_t a_count,
+                                        const Position* a_position)
+    {
+        for (uint32_t i = 0; i < a_count; ++i)
+        {
+            sum += a_position[i].x;
+        }
+    });
+    REQUIRE(sum == Approx(999.0 * 1000.0 / 2.0 + 2000.0));
+
+    // Entities can be found by their position in iteration order.
+    uint32_t lastCount = 0;
+    store.ForChunk<Position>(store.GetChunkCount() - 1,
+        [&lastCount](uint32_t a_count, Position*) { lastCount = a_count; });
+    REQUIRE(lastCount == 1000 - 15 * 64);
+    const Store::Entity last = store.GetEntity(999);
+    REQUIRE(store.IsAlive(last));
+    REQUIRE(store.Get<Position>(last)->x == 999.0f + 2.0f);
+    REQUIRE(!store.IsAlive(store.GetEntity(1000)));
+}
+
+//--------------------------------------------------------------
+struct BenchmarkObject
+{
+    Position position;
+    Velocity velocity;
+    float cold[16]; // Data not needed by the update (eg. name).
+};
+struct BenchmarkCold { float cold[16]; };
+
+//--------------------------------------------------------------
+TEST_CASE("Benchmark Component Store", "[.][benchmark][component_store]")
+{
+    constexpr uint32_t entityCount = 1000000;
+    constexpr float dt = 1.0f / 60.0f;
+
+    std::vector<BenchmarkObject> objects(entityCount);
+    Simple::ComponentStore<Position, Velocity, BenchmarkCold> store;
+    store.Reserve(entityCount);
+    for (uint32_t i = 0; i < entityCount; ++i)
+    {
+        objects[i].velocity = { 1.0f, 2.0f, 3.0f };
+        *store.Get<Velocity>(store.Create()) = { 1.0f, 2.0f, 3.0f };
+    }
+    Simple::WorkerPool workerPool;
+
+    BENCHMARK("AoS 1M entities")
+    {
+        for (BenchmarkObject& object : objects)
+        {
+            object.position.x += object.velocity.x * dt;
+            object.position.y += object.velocity.y * dt;
+            object.position.z += object.velocity.z * dt;
+        }
+        return objects[0].position.x;
+    };
+
+    auto integrate = [dt](uint32_t a_count,
+                          Position* a_position,
+                          const Velocity* a_velocity)
+    {
+        for (uint32_t i = 0; i < a_count; ++i)
+        {
+            a_position[i].x += a_velocity[i].x * dt;
+            a_position[i].y += a_velocity[i].y * dt;
+            a_position[i].z += a_velocity[i].z * dt;
+        }
+    };
+
+    BENCHMARK("SoA 1M entities")
+    {
+        store.ForEachChunk<Position, Velocity>(integrate);
+        return store.GetCount();
+    };
+
+    BENCHMARK("SoA 1M entities (parallel)")
+    {
+        store.ParallelForEachChunk<Position, Velocity>(workerPool,
+                                                       integrate);
+        return store.GetCount();
+    };
+}
@@ -0,0 +1,184 @@
+//--------------------------------------------------------------
+// Copyright (c) David Bosnich <david.bosnich.public@gmail.com>
+//
+// This code is licensed under the MIT License, a copy of which
+// can be found in the license.txt file included at the root of
+// this distribution, or at https://opensource.org/licenses/MIT
+//--------------------------------------------------------------
+
+#include <simple/application/application.h>
+#include <simple/application/config_watcher.h>
+#include <catch2/catch.hpp>
+
+#if SIMPLE_CONFIG_WATCHER_SUPPORTED
+//--------------------------------------------------------------
+TEST_CASE("Test Config Parse", "[config_watcher][parse]")
+{
+    const std::vector<std::string> appKeys = { "difficulty" };
+    std::string error;
+
+    Simple::Config config;
+    REQUIRE(config.Parse("# Tuning\n"
+                         "fps = 90\n"
+                         "\n"
+                         "  capped=false  \r\n"
+                         "wait_strategy = sleep\n"
+                         "max_catch_up = 4\n"
+                         "stats_interval = 0.5\n"
+                         "difficulty = hard", appKeys, error));
+    REQUIRE(config.fps == 90);
+    REQUIRE(config.capped == 0);
+    REQUIRE(config.waitStrategy ==
+            (int8_t)Simple::LoopPolicy::WaitStrategy::Sleep);
+    REQUIRE(config.maxCatchUp == 4);
+    REQUIRE(config.statsInterval == 0.5f);
+    REQUIRE(config.GetEntries().size() == 6);
+    REQUIRE(*config.Find("difficulty") == "hard");
+    REQUIRE(config.Find("missing") == nullptr);
+
+    // Keys not present are left as not present.
+    Simple::Config partial;
+    REQUIRE(partial.Parse("capped = true", appKeys, error));
+    REQUIRE(partial.fps == 0);
+    REQUIRE(partial.capped == 1);
+    REQUIRE(partial.waitStrategy < 0);
+    REQUIRE(partial.statsInterval < 0.0f);
+
+    Simple::Config invalid;
+    REQUIRE_FALSE(invalid.Parse("fps = 0", appKeys, error));
+    REQUIRE(error.find("line 1") == 0);
+    REQUIRE_FALSE(invalid.Parse("\nfps 60", appKeys, error));
+    REQUIRE(error.find("line 2") == 0);
+    REQUIRE_FALSE(invalid.Parse("speed = 2", appKeys, error));
+    REQUIRE(error.find("unknown key") != std::string::npos);
+    REQUIRE_FALSE(invalid.Parse("capped = yes", appKeys, error));
+}
+
+//--------------------------------------------------------------
+class ConfigTestApplication : public Simple::Application
+{
+public:
+    std::atomic<uint32_t> m_startUpCount = { 0 };
+
+protected:
+    void StartUp() override { ++m_startUpCount; }
+    void ShutDown() override {}
+    void UpdateStart(float) override {}
+    void UpdateFixed(float) override {}
+    void UpdateEnded(float) override {}
+};
+
+//--------------------------------------------------------------
+void WriteConfigFile(const char* a_path, const char* a_text)
+{
+    std::ofstream file(a_path);
+    file << a_text;
+}
+
+//--------------------------------------------------------------
+template<class Condition>
+bool WaitForConfig(Condition a_condition)
+{
+    const auto timeout = std::chrono::steady_clock::now() +
+                         std::chrono::seconds(5);
+    while (!a_condition())
+    {
+        if (std::chrono::steady_clock::now() > timeout)
+        {
+            return false;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    return true;
+}
+
+//--------------------------------------------------------------
+TEST_CASE("Test Config Watcher Reload", "[config_watcher][reload]")
+{
+    const char* path = "test_config_watcher.cfg";
+    WriteConfigFile(path, "fps = 200\nwait_strategy = sleep\n");
+
+    ConfigTestApplication application;
+    Simple::ConfigWatcher watcher(application);
+    watcher.AddKey("difficulty");
+    std::string difficulty;
+    watcher.SetValidateFunc([](const Simple::Config& a_config,
+                               std::string& o_error)
+    {
+        const std::string* value = a_config.Find("difficulty");
+        if (value && *value != "easy" && *value != "hard")
+        {
+            o_error = "unknown difficulty";
+            return false;
+        }
+        return true;
+    });
+    watcher.SetReloadFunc([&difficulty](const Simple::Config& a_config)
+    {
+        const std::string* value = a_config.Find("difficulty");
+        difficulty = value ? *value : "";
+    });
+    REQUIRE(watcher.Start(path));
+    REQUIRE(watcher.IsWatching());
+
+    // The initial config is applied on the first frame.
+    std::thread runThread = application.RunInThread(240);
+    REQUIRE(WaitForConfig([&watcher]()
+    {
+        return watcher.GetAppliedCount() == 1;
+    }));
+    REQUIRE(application.GetTargetFPS() == 200);
+    REQUIRE(application.GetWaitStrategy() ==
+            Simple::LoopPolicy::WaitStrategy::Sleep);
+    REQUIRE(watcher.GetStatsInterval() < 0.0f);
+
+    // Changes are applied without restarting.
+    WriteConfigFile(path, "fps = 120\nmax_catch_up = 3\n"
+                          "stats_interval = 0.25\n"
+                          "difficulty = hard\n");
+    REQUIRE(WaitForConfig([&watcher]()
+    {
+        return watcher.GetAppliedCount() == 2;
+    }));
+    REQUIRE(application.GetTargetFPS() == 120);
+    REQUIRE(application.GetMaxCatchUp() == 3);
+    REQUIRE(watcher.GetStatsInterval() == 0.25f);
+
+    // Invalid configs are rejected, keeping the last valid one.
+    WriteConfigFile(path, "fps = 30\ndifficulty = impossible\n");
+    REQUIRE(WaitForConfig([&watcher]()
+    {
+        return watcher.GetRejectedCount() == 1;
+    }));
+    WriteConfigFile(path, "fps = -30\n");
+    REQUIRE(WaitForConfig([&watcher]()
+    {
+        return watcher.GetRejectedCount() == 2;
+    }));
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    REQUIRE(application.GetTargetFPS() == 120);
+
+    application.RequestShutDown();
+    runThread.join();
+    watcher.Stop();
+    REQUIRE_FALSE(watcher.IsWatching());
+    REQUIRE(application.m_startUpCount == 1);
+    REQUIRE(difficulty == "hard");
+    REQUIRE(watcher.GetConfig()->fps == 120);
+
+    // Every reload is recorded, in order.
+    const std::vector<Simple::ConfigWatcher::ReloadEvent> timeline =
+        watcher.GetTimeline();
+    REQUIRE(timeline.size() == 4);
+    REQUIRE(timeline[0].applied);
+    REQUIRE(timeline[0].frameIndex == 0);
+    REQUIRE(timeline[1].applied);
+    REQUIRE(timeline[1].frameIndex > timeline[0].frameIndex);
+    REQUIRE(timeline[1].latency < std::chrono::seconds(1));
+    REQUIRE_FALSE(timeline[2].applied);
+    REQUIRE(timeline[2].error == "unknown difficulty");
+    REQUIRE_FALSE(timeline[3].applied);
+    REQUIRE(timeline[3].error.find("invalid value") != std::string::npos);
+    std::remove(path);
+}
+#endif//SIMPLE_CONFIG_WATCHER_SUPPORTED
@@ -0,0 +1,187 @@
+//--------------------------------------------------------------
+// Copyright (c) David Bosnich <david.bosnich.public@gmail.com>
+//
+// This code is licensed under the MIT License, a copy of which
+// can be found in the license.txt file included at the root of
+// this distribution, or at https://opensource.org/licenses/MIT
+//--------------------------------------------------------------
+
+#include <simple/application/application.h>
+#include <simple/application/control_server.h>
+#include <catch2/catch.hpp>
+
+#if SIMPLE_CONTROL_SERVER_SUPPORTED
+//--------------------------------------------------------------
+class ControlClient
+{
+public:
+    explicit ControlClient(const char* a_path)
+    {
+        sockaddr_un address = {};
+        address.sun_family = AF_UNIX;
+        strcpy(address.sun_path, a_path);
+        m_fd = socket(AF_UNIX, SOCK_STREAM, 0);
+        if (connect(m_fd, (const sockaddr*)&address, sizeof(address)) != 0)
+        {
+            close(m_fd);
+            m_fd = -1;
+        }
+    }
+
+    ~ControlClient()
+    {
+        if (m_fd >= 0)
+        {
+            close(m_fd);
+        }
+    }
+
+    bool IsConnected() const
+    {
+        return m_fd >= 0;
+    }
+
+    std::string Send(const std::string& a_line)
+    {
+        const std::string line = a_line + "\n";
+        if (write(m_fd, line.data(), line.size()) != (ssize_t)line.size())
+        {
+            return "";
+        }
+        std::string reply;
+        char c = 0;
+        while (read(m_fd, &c, 1) == 1 && c != '\n')
+        {
+            reply += c;
+        }
+        return reply;
+    }
+
+private:
+    int m_fd = -1;
+};
+
+//--------------------------------------------------------------
+class ControlTestApplication : public Simple::Application
+{
+public:
+    std::atomic<uint32_t> m_startUpCount = { 0 };
+
+protected:
+    void StartUp() override { ++m_startUpCount; }
+    void ShutDown() override {}
+    void UpdateStart(float) override {}
+    void UpdateFixed(float) override {}
+    void UpdateEnded(float) override {}
+};
+
+//--------------------------------------------------------------
+template<class Condition>
+bool WaitForControl(Condition a_condition)
+{
+    const auto timeout = std::chrono::steady_clock::now() +
+                         std::chrono::seconds(5);
+    while (!a_condition())
+    {
+        if (std::chrono::steady_clock::now() > timeout)
+        {
+            return false;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    return true;
+}
+
+//--------------------------------------------------------------
+TEST_CASE("Test Control Server Commands", "[control_server][commands]")
+{
+    const char* path = "test_control_server.sock";
+    ControlTestApplication application;
+    Simple::ControlServer server(application);
+    REQUIRE(server.AddCommand("echo", "<text> Reply with the text.",
+                              [](const char* a_args, std::string& o_reply)
+    {
+        o_reply = std::string("ok ") + a_args;
+    }));
+    REQUIRE(server.AddCommand("fail", "Throw an error.",
+                              [](const char*, std::string&)
+    {
+        throw std::runtime_error("failed");
+    }));
+    REQUIRE_FALSE(server.AddCommand("fps", "", nullptr));
+    REQUIRE(server.Start(path));
+    REQUIRE(server.IsRunning());
+    REQUIRE(server.GetPath() == path);
+
+    std::thread runThread = application.RunInThread(240);
+    REQUIRE(WaitForControl([&server]()
+    {
+        return server.GetSnapshot().frameCount >= 3;
+    }));
+
+    ControlClient client(path);
+    REQUIRE(client.IsConnected());
+    REQUIRE(client.Send("fps 120") == "ok");
+    REQUIRE(application.GetTargetFPS() == 120);
+    REQUIRE(client.Send("fps 0").find("error") == 0);
+    REQUIRE(client.Send("cap off") == "ok");
+    REQUIRE_FALSE(application.GetCappedFPS());
+    REQUIRE(client.Send("cap maybe").find("error") == 0);
+    REQUIRE(client.Send("cap on") == "ok");
+    REQUIRE(client.Send("echo hello world") == "ok hello world");
+    REQUIRE(client.Send("bogus").find("error unknown") == 0);
+    REQUIRE(client.Send("fail") == "error failed");
+    REQUIRE(client.Send("help").find("| echo <text>") !=
+            std::string::npos);
+
+    // Stats come from the snapshot the loop publishes each frame.
+    const std::string stats = client.Send("stats");
+    REQUIRE(stats.find("ok frames ") == 0);
+    REQUIRE(stats.find("target_fps 120 capped 1") != std::string::npos);
+
+    // A second client can connect at the same time.
+    ControlClient other(path);
+    REQUIRE(other.Send("restart") == "ok");
+    REQUIRE(WaitForControl([&application]()
+    {
+        return application.m_startUpCount == 2;
+    }));
+    REQUIRE(client.Send("shutdown") == "ok");
+    runThread.join();
+    REQUIRE(server.GetCommandCount() == 12);
+
+    server.Stop();
+    REQUIRE_FALSE(server.IsRunning());
+    REQUIRE_FALSE(ControlClient(path).IsConnected());
+}
+
+//--------------------------------------------------------------
+TEST_CASE("Test Control Server Path", "[control_server][path]")
+{
+    // Any other kind of file at the path is never replaced.
+    const char* path = "test_control_server_path.txt";
+    FILE* file = fopen(path, "w");
+    REQUIRE(file);
+    fclose(file);
+
+    ControlTestApplication application;
+    Simple::ControlServer server(application);
+    REQUIRE_FALSE(server.Start(path));
+    REQUIRE_FALSE(server.IsRunning());
+    struct stat status = {};
+    REQUIRE(lstat(path, &status) == 0);
+    REQUIRE(S_ISREG(status.st_mode));
+    unlink(path);
+
+    // A socket left at the path (eg. by a crash) is replaced.
+    sockaddr_un address = {};
+    address.sun_family = AF_UNIX;
+    strcpy(address.sun_path, path);
+    const int staleFd = socket(AF_UNIX, SOCK_STREAM, 0);
+    REQUIRE(bind(staleFd, (const sockaddr*)&address, sizeof(address)) == 0);
+    close(staleFd);
+    REQUIRE(server.Start(path));
+    REQUIRE(ControlClient(path).IsConnected());
+    server.Stop();
+}
+#endif//SIMPLE_CONTROL_SERVER_SUPPORTED
@@ -0,0 +1,277 @@
+//--------------------------------------------------------------
+// Copyright (c) David Bosnich <david.bosnich.public@gmail.com>
+//
+// This code is licensed under the MIT License, a copy of which
+// can be found in the license.txt file included at the root of
+// this distribution, or at https://opensource.org/licenses/MIT
+//--------------------------------------------------------------
+
+#include <simple/application/deterministic.h>
+#include <catch2/catch.hpp>
+
+#include <cstring>
+#include <memory>
+#include <random>
+
+//--------------------------------------------------------------
+namespace
+{
+    // Values of very different magnitudes, so the sum depends on
+    // the order in which they are added.
+    std::vector<float> MakeValues(uint32_t a_count)
+    {
+        std::vector<float> values(a_count);
+        Simple::RandomStream random(1234, 0, 0);
+        for (float& value : values)
+        {
+            value = (random.NextFloat() - 0.5f) *
+                    (float)(1u << random.NextBelow(24));
+        }
+        return values;
+    }
+
+    float SumRange(const std::vector<float>& a_values,
+                   const Simple::ChunkRange& a_range)
+    {
+        float sum = 0.0f;
+        for (uint32_t i = a_range.begin; i < a_range.end; ++i)
+        {
+            sum += a_values[i];
+        }
+        return sum;
+    }
+
+    float Add(float a_lhs, float a_rhs)
+    {
+        return a_lhs + a_rhs;
+    }
+}
+
+//--------------------------------------------------------------
+TEST_CASE("Test Deterministic Chunks", "[deterministic][chunks]")
+{
+    REQUIRE(Simple::GetChunkCount(0, 10) == 0);
+    REQUIRE(Simple::GetChunkCount(10, 10) == 1);
+    REQUIRE(Simple::GetChunkCount(11, 10) == 2);
+    REQUIRE(Simple::GetChunkCount(5, 0) == 5);
+
+    const Simple::ChunkRange last = Simple::GetChunkRange(1, 11, 10);
+    REQUIRE(last.index == 1);
+    REQUIRE(last.begin == 10);
+    REQUIRE(last.end == 11);
+
+    // Every element is in exactly one chunk, whatever the threads.
+    for (uint32_t threadCount = 1; threadCount <= 4; ++threadCount)
+    {
+        Simple::WorkerPool workerPool(threadCount);
+        std::vector<uint32_t> visits(1000);
+        Simple::DeterministicFor(&workerPool, 1000, 64,
+            [&visits](const Simple::ChunkRange& a_range)
+        {
+            for (uint32_t i = a_range.begin; i < a_range.end; ++i)
+            {
+                visits[i] += a_range.index + 1;
+            }
+        });
+        for (uint32_t i = 0; i < 1000; ++i)
+        {
+            REQUIRE(visits[i] == i / 64 + 1);
+        }
+    }
+}
+
+//--------------------------------------------------------------
+TEST_CASE("Test Deterministic Reduce", "[deterministic][reduce]")
+{
+    const std::vector<float> values = MakeValues(100000);
+    auto map = [&values](const Simple::ChunkRange& a_range)
+    {
+        return SumRange(values, a_range);
+    };
+    const float expected = Simple::DeterministicReduce(
+        nullptr, 100000, 1000, 0.0f, map, Add);
+
+    // The chunk order sum is not the sequential sum...
+    const float sequential = SumRange(values,
+        Simple::GetChunkRange(0, 100000, 100000));
+    REQUIRE(expected == Approx(sequential).epsilon(0.01));
+
+    // ...but is bit exact across any count of threads.
+    for (uint32_t threadCount = 1; threadCount <= 8; ++threadCount)
+    {
+        Simple::WorkerPool workerPool(threadCount);
+        for (int run = 0; run < 3; ++run)
+        {
+            const float sum = Simple::DeterministicReduce(
+                &workerPool, 100000, 1000, 0.0f, map, Add);
+            REQUIRE(memcmp(&sum, &expected, sizeof(float)) == 0);
+        }
+    }
+}
+
+//--------------------------------------------------------------
+TEST_CASE("Test Deterministic Random", "[deterministic][random]")
+{
+    // Known answers for Philox4x32-10 (from the Random123 library).
+    uint32_t result[4];
+    const uint32_t zeroCounter[4] = { 0, 0, 0, 0 };
+    const uint32_t zeroKey[2] = { 0, 0 };
+    Simple::RandomStream::Philox(zeroCounter, zeroKey, result);
+    REQUIRE(result[0] == 0x6627e8d5u);
+    REQUIRE(result[1] == 0xe169c58du);
+    REQUIRE(result[2] == 0xbc57ac4cu);
+    REQUIRE(result[3] == 0x9b00dbd8u);
+
+    const uint32_t piCounter[4] = { 0x243f6a88u, 0x85a308d3u,
+                                    0x13198a2eu, 0x03707344u };
+    const uint32_t piKey[2] = { 0xa4093822u, 0x299f31d0u };
+    Simple::RandomStream::Philox(piCounter, piKey, result);
+    REQUIRE(result[0] == 0xd16cfe09u);
+    REQUIRE(result[1] == 0x94fdccebu);
+    REQUIRE(result[2] == 0x5001e420u);
+    REQUIRE(result[3] == 0x24126ea1u);
+
+    // Streams are a pure function of seed, id, step and substream.
+    Simple::RandomStream a(7, 1, 100), b(7, 1, 100);
+    Simple::RandomStream otherId(7, 2, 100), otherStep(7, 1, 101);
+    Simple::RandomStream otherSeed(8, 1, 100), otherSub(7, 1, 100, 1);
+    uint32_t matches = 0;
+    for (int i = 0; i < 100; ++i)
+    {
+        const uint32_t value = a.NextUInt32();
+        REQUIRE(value == b.NextUInt32());
+        matches += (value == otherId.NextUInt32());
+        matches += (value == otherStep.NextUInt32());
+        matches += (value == otherSeed.NextUInt32());
+        matches += (value == otherSub.NextUInt32());
+    }
+    REQUIRE(matches == 0);
+
+    for (int i = 0; i < 1000; ++i)
+    {
+        const float value = a.NextFloat();
+        REQUIRE(value >= 0.0f);
+        REQUIRE(value < 1.0f);
+        REQUIRE(a.NextBelow(10) < 10);
+    }
+}
+
+//--------------------------------------------------------------
+TEST_CASE("Test Deterministic Parallel Step", "[deterministic][step]")
+{
+    // A step that moves particles by random amounts, with a stream
+    // per chunk, and sums their positions: bit exact for any pool.
+    constexpr uint32_t Count = 50000;
+    constexpr uint32_t SystemId = 3;
+    auto step = [](Simple::WorkerPool* a_workerPool,
+                   std::vector<float>& io_positions,
+                   uint64_t a_stepIndex)
+    {
+        Simple::DeterministicFor(a_workerPool, Count, 512,
+            [&](const Simple::ChunkRange& a_range)
+        {
+            Simple::RandomStream random(42, SystemId, a_stepIndex,
+                                        a_range.index);
+            for (uint32_t i = a_range.begin; i < a_range.end; ++i)
+            {
+                io_positions[i] += random.NextFloat() - 0.5f;
+            }
+        });
+        return Simple::DeterministicReduce(a_workerPool, Count, 512,
+            0.0f, [&](const Simple::ChunkRange& a_range)
+        {
+            return SumRange(io_positions, a_range);
+        }, Add);
+    };
+
+    std::vector<float> expectedPositions(Count);
+    std::vector<float> expectedSums;
+    for (uint64_t i = 0; i < 10; ++i)
+    {
+        expectedSums.push_back(step(nullptr, expectedPositions, i));
+    }
+
+    for (uint32_t threadCount = 1; threadCount <= 8; threadCount *= 2)
+    {
+        Simple::WorkerPool workerPool(threadCount);
+        std::vector<float> positions(Count);
+        for (uint64_t i = 0; i < 10; ++i)
+        {
+            const float sum = step(&workerPool, positions, i);
+            REQUIRE(memcmp(&sum, &expectedSums[i], sizeof(float)) == 0);
+        }
+        REQUIRE(memcmp(positions.data(), expectedPositions.data(),
+                       Count * sizeof(float)) == 0);
+    }
+}
+
+//--------------------------------------------------------------
+TEST_CASE("Benchmark Deterministic", "[.][benchmark][deterministic]")
+{
+    constexpr uint32_t Count = 1u << 22;
+    const std::vector<float> values = MakeValues(Count);
+    Simple::WorkerPool workerPool;
+
+    // Non-deterministic: partial sums per thread, so the elements
+    // each partial includes depend on which thread ran which chunk.
+    BENCHMARK("Thread partials reduce (non-deterministic)")
+    {
+        const uint32_t threadCount = workerPool.GetThreadCount();
+        std::unique_ptr<float[]> partials(new float[threadCount * 16]());
+        const uint32_t chunkCount = Simple::GetChunkCount(Count);
+        workerPool.ParallelFor(chunkCount, [&](uint32_t a_chunk)
+        {
+            const Simple::ChunkRange range =
+                Simple::GetChunkRange(a_chunk, Count);
+            const uint32_t thread = Simple::WorkerPool::GetThreadIndex();
+            partials[thread * 16] += SumRange(values, range);
+        });
+        float sum = 0.0f;
+        for (uint32_t i = 0; i < threadCount; ++i)
+        {
+            sum += partials[i * 16];
+        }
+        return sum;
+    };
+
+    BENCHMARK("Chunk ordered reduce (deterministic)")
+    {
+        return Simple::DeterministicReduce(&workerPool, Count,
+            DEFAULT_DETERMINISTIC_CHUNK_SIZE, 0.0f,
+            [&values](const Simple::ChunkRange& a_range)
+        {
+            return SumRange(values, a_range);
+        }, Add);
+    };
+
+    // Shared generator, which must be used in a fixed order.
+    std::mt19937 sharedRandom(42);
+    BENCHMARK("Shared mt19937 (sequential)")
+    {
+        float sum = 0.0f;
+        std::uniform_real_distribution<float> distribution(0.0f, 1.0f);
+        for (uint32_t i = 0; i < Count; ++i)
+        {
+            sum += distribution(sharedRandom);
+        }
+        return sum;
+    };
+
+    uint64_t stepIndex = 0;
+    BENCHMARK("RandomStream per chunk (deterministic, parallel)")
+    {
+        ++stepIndex;
+        return Simple::DeterministicReduce(&workerPool, Count,
+            DEFAULT_DETERMINISTIC_CHUNK_SIZE, 0.0f,
+            [stepIndex](const Simple::ChunkRange& a_range)
+        {
+            Simple::RandomStream random(42, 0, stepIndex, a_range.index);
+            float sum = 0.0f;
+            for (uint32_t i = a_range.begin; i < a_range.end; ++i)
+            {
+                sum += random.NextFloat();
+            }
+            return sum;
+        }, Add);
+    };
+}
@@ -0,0 +1,234 @@
+//--------------------------------------------------------------
+// Copyright (c) David Bosnich <david.bosnich.public@gmail.com>
+//
+// This code is licensed under the MIT License, a copy of which
+// can be found in the license.txt file included at the root of
+// this distribution, or at https://opensource.org/licenses/MIT
+//--------------------------------------------------------------
+
+#include <simple/application/application.h>
+#include <simple/application/event_bus.h>
+#include <catch2/catch.hpp>
+
+//--------------------------------------------------------------
+struct DamageEvent
+{
+    uint32_t target;
+    float amount;
+};
+
+//--------------------------------------------------------------
+struct SpawnEvent
+{
+    uint32_t id;
+};
+
+//--------------------------------------------------------------
+class EventApplication : public Simple::Application
+{
+public:
+    EventApplication(Simple::EventBus& a_eventBus, uint32_t a_frames)
+        : m_eventBus(a_eventBus), m_numFrames(a_frames)
+    {
+        AddListener(&m_eventBus);
+        m_eventBus.Subscribe<SpawnEvent>([this](const SpawnEvent& a_e)
+        {
+            m_received.push_back(a_e.id);
+            m_receivedFrames.push_back(m_frame);
+        });
+        m_eventBus.Subscribe<DamageEvent>([this](const DamageEvent& a_e)
+        {
+            m_received.push_back(a_e.target + 100);
+            m_receivedFrames.push_back(m_frame);
+        });
+    }
+
+    std::vector<uint32_t> m_received;
+    std::vector<uint32_t> m_receivedFrames;
+
+protected:
+    void StartUp() override {}
+    void ShutDown() override {}
+
+    void UpdateStart(float) override
+    {
+        // Interleave types; dispatch should sort them by type.
+        m_eventBus.Publish(DamageEvent{ m_frame, 1.0f });
+        m_eventBus.Publish(SpawnEvent{ m_frame });
+    }
+
+    void UpdateFixed(float) override
+    {
+        m_eventBus.Publish(DamageEvent{ m_frame + 10, 2.0f });
+    }
+
+    void UpdateEnded(float) override
+    {
+        if (++m_frame == m_numFrames)
+        {
+            RequestShutDown();
+        }
+    }
+
+private:
+    Simple::EventBus& m_eventBus;
+    const uint32_t m_numFrames;
+    uint32_t m_frame = 0;
+};
+
+//--------------------------------------------------------------
+TEST_CASE("Test Event Bus Next Start", "[event_bus][next_start]")
+{
+    Simple::EventBus eventBus(Simple::EventBus::DispatchPoint::NextStart);
+    EventApplication application(eventBus, 3);
+    application.Run(240);
+
+    // Events raised in frame N are handled at the start of N + 1,
+    // and those raised in the last frame are never dispatched.
+    const std::vector<uint32_t> expected = { 0, 100, 110, 1, 101, 111 };
+    const std::vector<uint32_t> frames = { 1, 1, 1, 2, 2, 2 };
+    REQUIRE(application.m_received == expected);
+    REQUIRE(application.m_receivedFrames == frames);
+
+    const Simple::EventBus::Stats stats = eventBus.GetStats();
+    REQUIRE(stats.dispatched == 6);
+    REQUIRE(stats.published == 9);
+    REQUIRE(stats.dropped == 0);
+    REQUIRE(stats.lastDispatchCount == 3);
+}
+
+//--------------------------------------------------------------
+TEST_CASE("Test Event Bus After Fixed", "[event_bus][after_fixed]")
+{
+    Simple::EventBus eventBus(Simple::EventBus::DispatchPoint::AfterFixed);
+    EventApplication application(eventBus, 2);
+    application.Run(240);
+
+    const std::vector<uint32_t> expected = { 0, 100, 110, 1, 101, 111 };
+    const std::vector<uint32_t> frames = { 0, 0, 0, 1, 1, 1 };
+    REQUIRE(application.m_received == expected);
+    REQUIRE(application.m_receivedFrames == frames);
+}
+
+//--------------------------------------------------------------
+TEST_CASE("Test Event Bus Threads", "[event_bus][threads]")
+{
+    constexpr uint32_t numThreads = 4;
+    constexpr uint32_t numEvents = 1000;
+    Simple::EventBus eventBus(Simple::EventBus::DispatchPoint::Manual,
+                              numEvents * 32, numThreads);
+
+    uint64_t spawnSum = 0;
+    uint32_t spawnCount = 0;
+    uint32_t damageCount = 0;
+    eventBus.Subscribe<SpawnEvent>([&](const SpawnEvent& a_event)
+    {
+        REQUIRE(damageCount == 0); // Sorted by type.
+        spawnSum += a_event.id;
+        ++spawnCount;
+    });
+    eventBus.Subscribe<DamageEvent>([&](const DamageEvent&)
+    {
+        ++damageCount;
+    });
+
+    std::atomic<uint32_t> failedCount = { 0 };
+    std::vector<std::thread> threads;
+    for (uint32_t t = 0; t < numThreads; ++t)
+    {
+        threads.emplace_back([&eventBus, &failedCount]()
+        {
+            for (uint32_t i = 0; i < numEvents; ++i)
+            {
+                failedCount += !eventBus.Publish(DamageEvent{ i, 0 });
+                failedCount += !eventBus.Publish(SpawnEvent{ i });
+            }
+        });
+    }
+    for (std::thread& thread : threads)
+    {
+        thread.join();
+    }
+    eventBus.Dispatch();
+    REQUIRE(failedCount == 0);
+
+    REQUIRE(spawnCount == numEvents * numThreads);
+    REQUIRE(damageCount == numEvents * numThreads);
+    REQUIRE(spawnSum == (uint64_t)numThreads *
+                        ((numEvents * (numEvents - 1)) / 2));
+    REQUIRE(eventBus.GetStats().dropped == 0);
+}
+
+//--------------------------------------------------------------
+TEST_CASE("Test Event Bus Full", "[event_bus][full]")
+{
+    Simple::EventBus eventBus(Simple::EventBus::DispatchPoint::Manual,
+                              64, 1);
+    uint32_t count = 0;
+    eventBus.Subscribe<SpawnEvent>([&count](const SpawnEvent&)
+    {
+        ++count;
+    });
+
+    // Each record is an 8 byte header plus a 4 byte payload.
+    uint32_t published = 0;
+    while (eventBus.Publish(SpawnEvent{ published }))
+    {
+        ++published;
+    }
+    REQUIRE(published == 5);
+    eventBus.Dispatch();
+    REQUIRE(count == published);
+
+    // The other (now current) buffer is empty again.
+    REQUIRE(eventBus.Publish(SpawnEvent{ 0 }));
+}
+
+//--------------------------------------------------------------
+TEST_CASE("Test Event Bus Thread Exit", "[event_bus][thread_exit]")
+{
+    // Buffers of threads that exit are released once dispatched, so
+    // more threads than the maximum can publish over time.
+    Simple::EventBus eventBus(Simple::EventBus::DispatchPoint::Manual,
+                              1024, 2);
+    uint32_t count = 0;
+    eventBus.Subscribe<SpawnEvent>([&count](const SpawnEvent&)
+    {
+        ++count;
+    });
+
+    for (uint32_t i = 0; i < 10; ++i)
+    {
+        std::atomic<uint32_t> failedCount = { 0 };
+        std::thread first([&]()
+        {
+            failedCount += !eventBus.Publish(SpawnEvent{ i });
+        });
+        std::thread second([&]()
+        {
+            failedCount += !eventBus.Publish(SpawnEvent{ i });
+        });
+        first.join();
+        second.join();
+        REQUIRE(failedCount == 0);
+        eventBus.Dispatch();
+    }
+    REQUIRE(count == 20);
+    REQUIRE(eventBus.GetStats().dropped == 0);
+}
+
+//--------------------------------------------------------------
+TEST_CASE("Test Event Bus Unhandled", "[event_bus][unhandled]")
+{
+    // Events without any subscribers are still counted as published.
+    Simple::EventBus eventBus(Simple::EventBus::DispatchPoint::Manual);
+    eventBus.Subscribe<SpawnEvent>([](const SpawnEvent&) {});
+    REQUIRE(eventBus.Publish(SpawnEvent{ 0 }));
+    REQUIRE(eventBus.Publish(DamageEvent{ 0, 1.0f }));
+    eventBus.Dispatch();
+
+    const Simple::EventBus::Stats stats = eventBus.GetStats();
+    REQUIRE(stats.dispatched == 1);
+    REQUIRE(stats.unhandled == 1);
+    REQUIRE(stats.published == 2);
+}
@@ -0,0 +1,145 @@
+//--------------------------------------------------------------
+// Copyright (c) David Bosnich <david.bosnich.public@gmail.com>
+//
+// This code is licensed under the MIT License, a copy of which
+// can be found in the license.txt file included at the root of
+// this distribution, or at https://opensource.org/licenses/MIT
+//--------------------------------------------------------------
+
+#include <simple/application/application.h>
+#include <simple/application/frame_cache.h>
+#include <catch2/catch.hpp>
+
+using Cache = Simple::FrameCache<uint32_t, float>;
+
+//--------------------------------------------------------------
+TEST_CASE("Test Frame Cache Lookups", "[frame_cache][lookups]")
+{
+    Cache cache(100, Cache::Scope::Manual);
+    REQUIRE(cache.GetCapacity() == 128);
+    REQUIRE(cache.Find(1) == nullptr);
+    REQUIRE(cache.Insert(1, 10.0f));
+    REQUIRE(*cache.Find(1) == 10.0f);
+    REQUIRE(cache.Insert(1, 11.0f));
+    REQUIRE(*cache.Find(1) == 11.0f);
+    REQUIRE(cache.GetSize() == 1);
+
+    uint32_t computeCount = 0;
+    auto compute = [&computeCount]() { ++computeCount; return 2.0f; };
+    REQUIRE(cache.GetOrCompute(2, compute) == 2.0f);
+    REQUIRE(cache.GetOrCompute(2, compute) == 2.0f);
+    REQUIRE(computeCount == 1);
+    REQUIRE(cache.GetFrameStats().hits == 3);
+    REQUIRE(cache.GetFrameStats().misses == 2);
+
+    // Invalidating empties every slot without touching them.
+    const uint32_t epoch = cache.GetEpoch();
+    cache.Invalidate();
+    REQUIRE(cache.GetEpoch() == epoch + 1);
+    REQUIRE(cache.GetSize() == 0);
+    REQUIRE(cache.Find(1) == nullptr);
+    REQUIRE(cache.GetOrCompute(2, compute) == 2.0f);
+    REQUIRE(computeCount == 2);
+
+    // Colliding keys are probed past, and the cache fills to 3/4.
+    cache.Invalidate();
+    for (uint32_t i = 0; i < 96; ++i)
+    {
+        REQUIRE(cache.Insert(i * 128, (float)i));
+    }
+    REQUIRE(!cache.Insert(1, 1.0f));
+    REQUIRE(cache.GetFrameStats().dropped == 1);
+    REQUIRE(cache.GetOrCompute(1, compute) == 2.0f);
+    REQUIRE(cache.GetFrameStats().dropped == 2);
+    for (uint32_t i = 0; i < 96; ++i)
+    {
+        REQUIRE(*cache.Find(i * 128) == (float)i);
+    }
+    REQUIRE(cache.GetFrameStats().size == 96);
+}
+
+//--------------------------------------------------------------
+class CacheTestApplication : public Simple::Application
+{
+public:
+    CacheTestApplication()
+        : m_frameCache(1024, Cache::Scope::Frame)
+        , m_fixedCache(1024, Cache::Scope::NextFixed)
+    {
+        AddListener(&m_frameCache);
+        AddListener(&m_fixedCache);
+    }
+
+    Cache m_frameCache;
+    Cache m_fixedCache;
+    uint32_t m_computeCount = 0;
+    uint32_t m_fixedComputeCount = 0;
+    uint32_t m_frames = 0;
+    float m_lastHitRate = 0.0f;
+
+protected:
+    void StartUp() override {}
+    void ShutDown() override {}
+
+    // Each of the three phases looks up the same 10 keys, so the
+    // values are only computed in the first phase of each frame.
+    void UpdateStart(float) override { Lookup(); }
+    void UpdateFixed(float) override { Lookup(); LookupFixed(); }
+    void UpdateEnded(float) override
+    {
+        Lookup();
+        LookupFixed();
+        if (++m_frames == 5)
+        {
+            RequestShutDown();
+        }
+    }
+
+    void OnFrameComplete(const FrameStats&) override
+    {
+        m_lastHitRate = m_frameCache.GetLastFrameStats().hitRate;
+    }
+
+private:
+    void Lookup()
+    {
+        for (uint32_t i = 0; i < 10; ++i)
+        {
+            m_frameCache.GetOrCompute(i, [this, i]()
+            {
+                ++m_computeCount;
+                return (float)i;
+            });
+        }
+    }
+
+    void LookupFixed()
+    {
+        m_fixedCache.GetOrCompute(0, [this]()
+        {
+            ++m_fixedComputeCount;
+            return 0.0f;
+        });
+    }
+};
+
+//--------------------------------------------------------------
+TEST_CASE("Test Frame Cache Application", "[frame_cache][application]")
+{
+    CacheTestApplication application;
+    application.Run(240);
+
+    // Capped, so one fixed update per frame.
+    REQUIRE(application.m_computeCount == 5 * 10);
+    REQUIRE(application.m_lastHitRate == Approx(20.0f / 30.0f));
+
+    const Cache::Stats& totalStats = application.m_frameCache.GetTotalStats();
+    REQUIRE(totalStats.hits == 5 * 20);
+    REQUIRE(totalStats.misses == 5 * 10);
+    REQUIRE(totalStats.size == 10);
+    REQUIRE(totalStats.hitRate == Approx(2.0f / 3.0f));
+
+    // Values computed in the fixed update survive until the next.
+    REQUIRE(application.m_fixedComputeCount == 5);
+    REQUIRE(application.m_fixedCache.GetTotalStats().hits == 5);
+}
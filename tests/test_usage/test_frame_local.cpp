@@ -0,0 +1,152 @@
+//--------------------------------------------------------------
+// Copyright (c) David Bosnich <david.bosnich.public@gmail.com>
+//
+// This code is licensed under the MIT License, a copy of which
+// can be found in the license.txt file included at the root of
+// this distribution, or at https://opensource.org/licenses/MIT
+//--------------------------------------------------------------
+
+#include <simple/application/application.h>
+#include <simple/application/frame_local.h>
+#include <simple/application/worker_pool.h>
+#include <catch2/catch.hpp>
+
+#include <algorithm>
+
+//--------------------------------------------------------------
+void AddCount(uint64_t& io_result, const uint64_t& a_local)
+{
+    io_result += a_local;
+}
+
+//--------------------------------------------------------------
+TEST_CASE("Test Frame Local Slots", "[frame_local][slots]")
+{
+    Simple::FrameLocal<uint64_t> counts(AddCount,
+                                        Simple::UpdatePhase::Fixed, 0, 2);
+    uint64_t* local = counts.GetLocal();
+    REQUIRE(local != nullptr);
+    REQUIRE(counts.GetLocal() == local);
+    REQUIRE(counts.GetThreadCount() == 1);
+    *local += 5;
+
+    // Each thread gets its own cache line, until none are left
+    // (both threads are alive at once, so their ids are distinct).
+    std::atomic<uint64_t*> otherLocal = { nullptr };
+    std::atomic<bool> thirdDone = { false };
+    uint64_t* thirdLocal = local;
+    std::thread other([&]()
+    {
+        uint64_t* value = counts.GetLocal();
+        *value += 7;
+        otherLocal = value;
+        while (!thirdDone)
+        {
+            std::this_thread::yield();
+        }
+    });
+    while (!otherLocal)
+    {
+        std::this_thread::yield();
+    }
+    std::thread third([&]() { thirdLocal = counts.GetLocal(); });
+    third.join();
+    thirdDone = true;
+    other.join();
+    REQUIRE(otherLocal != nullptr);
+    REQUIRE(thirdLocal == nullptr);
+    REQUIRE((uintptr_t)local % 64 == (uintptr_t)otherLocal.load() % 64);
+    REQUIRE((uintptr_t)otherLocal.load() - (uintptr_t)local >= 64);
+    REQUIRE(counts.GetThreadCount() == 2);
+    REQUIRE(counts.GetFailedCount() == 1);
+
+    // Merging resets each thread's value, and releases the slots of
+    // threads that have exited (only after merging their values).
+    REQUIRE(counts.Merge() == 12);
+    REQUIRE(counts.GetResult() == 12);
+    REQUIRE(*local == 0);
+    REQUIRE(counts.GetMergeCount() == 1);
+    REQUIRE(counts.GetThreadCount() == 1);
+    REQUIRE(counts.Merge() == 0);
+
+    // So another thread can claim it.
+    uint64_t* fourthLocal = nullptr;
+    std::thread fourth([&]()
+    {
+        fourthLocal = counts.GetLocal();
+        *fourthLocal += 3;
+    });
+    fourth.join();
+    REQUIRE(fourthLocal == otherLocal.load());
+    REQUIRE(counts.GetThreadCount() == 2);
+    REQUIRE(counts.GetFailedCount() == 1);
+    REQUIRE(counts.Merge() == 3);
+    REQUIRE(counts.GetThreadCount() == 1);
+}
+
+//--------------------------------------------------------------
+class LocalTestApplication : public Simple::Application
+{
+public:
+    LocalTestApplication()
+        : m_workerPool(4)
+        , m_counts(AddCount)
+        , m_found([](std::vector<uint32_t>& io_result,
+                     const std::vector<uint32_t>& a_local)
+          {
+              io_result.insert(io_result.end(), a_local.begin(),
+                               a_local.end());
+          }, Simple::UpdatePhase::Fixed)
+    {
+        AddListener(&m_counts);
+        AddListener(&m_found);
+    }
+
+    uint32_t m_wrongCount = 0;
+    uint32_t m_frames = 0;
+
+protected:
+    void StartUp() override {}
+    void ShutDown() override {}
+    void UpdateStart(float) override {}
+
+    void UpdateFixed(float) override
+    {
+        // Every worker counts and collects into its own slot.
+        m_workerPool.ParallelFor(1000, [this](uint32_t a_index)
+        {
+            ++*m_counts.GetLocal();
+            if (a_index % 100 == 0)
+            {
+                m_found.GetLocal()->push_back(a_index);
+            }
+        });
+    }
+
+    void UpdateEnded(float) override
+    {
+        // Merged after UpdateFixed, before UpdateEnded begins.
+        std::vector<uint32_t> found = m_found.GetResult();
+        std::sort(found.begin(), found.end());
+        m_wrongCount += (m_counts.GetResult() != 1000);
+        m_wrongCount += (found.size() != 10 || found[9] != 900);
+        if (++m_frames == 5)
+        {
+            RequestShutDown();
+        }
+    }
+
+private:
+    Simple::WorkerPool m_workerPool;
+    Simple::FrameLocal<uint64_t> m_counts;
+    Simple::FrameLocal<std::vector<uint32_t>> m_found;
+};
+
+//--------------------------------------------------------------
+TEST_CASE("Test Frame Local Application", "[frame_local][application]")
+{
+    LocalTestApplication application;
+    application.Run(240);
+    REQUIRE(application.m_frames == 5);
+    REQUIRE(application.m_wrongCount == 0);
+}
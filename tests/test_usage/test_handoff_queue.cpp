@@ -0,0 +1,238 @@
+//--------------------------------------------------------------
+// Copyright (c) David Bosnich <david.bosnich.public@gmail.com>
+//
+// This code is licensed under the MIT License, a copy of which
+// can be found in the license.txt file included at the root of
+// this distribution, or at https://opensource.org/licenses/MIT
+//--------------------------------------------------------------
+
+#include <simple/application/application.h>
+#include <simple/application/handoff_queue.h>
+#include <catch2/catch.hpp>
+
+using IntQueue = Simple::HandoffQueue<uint32_t>;
+
+//--------------------------------------------------------------
+TEST_CASE("Test Handoff Queue Drop", "[handoff_queue][drop]")
+{
+    IntQueue queue(3, IntQueue::Overflow::Drop);
+    REQUIRE(queue.GetCapacity() == 4);
+
+    for (uint32_t i = 0; i < 6; ++i)
+    {
+        REQUIRE(queue.Push(i) == (i < 4));
+    }
+    REQUIRE(queue.GetDepth() == 4);
+
+    uint32_t value = 0;
+    for (uint32_t i = 0; i < 4; ++i)
+    {
+        REQUIRE(queue.Pop(value));
+        REQUIRE(value == i);
+    }
+    REQUIRE(!queue.Pop(value));
+
+    const IntQueue::Stats stats = queue.GetStats();
+    REQUIRE(stats.depth == 0);
+    REQUIRE(stats.maxDepth == 4);
+    REQUIRE(stats.pushed == 4);
+    REQUIRE(stats.popped == 4);
+    REQUIRE(stats.dropped == 2);
+    REQUIRE(stats.latencyMax >= stats.latencyAvg);
+}
+
+//--------------------------------------------------------------
+TEST_CASE("Test Handoff Queue Max Depth", "[handoff_queue][depth]")
+{
+    // A consumer that keeps up never lets the queue build up.
+    IntQueue queue(8, IntQueue::Overflow::Drop);
+    uint32_t value = 0;
+    for (uint32_t i = 0; i < 100; ++i)
+    {
+        REQUIRE(queue.Push(i));
+        REQUIRE(queue.Pop(value));
+    }
+    REQUIRE(queue.GetStats().maxDepth == 1);
+
+    REQUIRE(queue.Push(0));
+    REQUIRE(queue.Push(1));
+    REQUIRE(queue.Push(2));
+    REQUIRE(queue.GetStats().maxDepth == 3);
+}
+
+//--------------------------------------------------------------
+TEST_CASE("Test Handoff Queue Coalesce", "[handoff_queue][coalesce]")
+{
+    IntQueue queue(2, IntQueue::Overflow::Coalesce);
+    queue.SetCoalesce([](uint32_t& io_pending, const uint32_t& a_value)
+    {
+        io_pending += a_value;
+    });
+
+    // 1 and 2 are queued, 3 + 4 + 5 are coalesced while full.
+    for (uint32_t i = 1; i <= 5; ++i)
+    {
+        REQUIRE(queue.Push(i) == (i < 3));
+    }
+    REQUIRE(queue.GetStats().coalesced == 3);
+
+    uint32_t value = 0;
+    REQUIRE(queue.Pop(value));
+    REQUIRE(value == 1);
+    REQUIRE(queue.Flush());
+    REQUIRE(queue.Pop(value));
+    REQUIRE(value == 2);
+    REQUIRE(queue.Pop(value));
+    REQUIRE(value == 12);
+    REQUIRE(!queue.Pop(value));
+    REQUIRE(queue.GetStats().dropped == 0);
+}
+
+//--------------------------------------------------------------
+TEST_CASE("Test Handoff Queue Block", "[handoff_queue][block]")
+{
+    IntQueue queue(1, IntQueue::Overflow::Block);
+    REQUIRE(queue.Push(0));
+
+    std::thread consumer([&queue]()
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        uint32_t value = 0;
+        REQUIRE(queue.Pop(value));
+        REQUIRE(value == 0);
+    });
+    REQUIRE(queue.Push(1));
+    consumer.join();
+    REQUIRE(queue.GetStats().blocked == 1);
+
+    // Closing the queue releases a blocked producer.
+    std::thread closer([&queue]()
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        queue.Close();
+    });
+    REQUIRE(!queue.Push(2));
+    closer.join();
+    REQUIRE(queue.IsClosed());
+    REQUIRE(queue.GetStats().dropped == 1);
+}
+
+//--------------------------------------------------------------
+TEST_CASE("Test Handoff Queue Load Shedding", "[handoff_queue][shedding]")
+{
+    IntQueue queue(3, IntQueue::Overflow::Drop);
+    uint32_t shedCount = 0;
+    uint64_t shedDropped = 0;
+    queue.SetLoadShedding(2, [&](const IntQueue::Stats& a_stats)
+    {
+        ++shedCount;
+        shedDropped = a_stats.dropped;
+    });
+
+    // Shed after every second push in a row that finds it full.
+    for (uint32_t i = 0; i < 8; ++i)
+    {
+        REQUIRE(queue.Push(i) == (i < 4));
+    }
+    REQUIRE(shedCount == 2);
+    REQUIRE(shedDropped == 4);
+    REQUIRE(queue.GetStats().shedCount == 2);
+
+    // Any push that succeeds restarts the count.
+    uint32_t value = 0;
+    REQUIRE(!queue.Push(8));
+    REQUIRE(queue.Pop(value));
+    REQUIRE(queue.Push(9));
+    REQUIRE(!queue.Push(10));
+    REQUIRE(shedCount == 2);
+    REQUIRE(!queue.Push(11));
+    REQUIRE(shedCount == 3);
+
+    // Pushes once closed are rejected, but not dropped or shed.
+    const IntQueue::Stats before = queue.GetStats();
+    queue.Close();
+    for (uint32_t i = 0; i < 8; ++i)
+    {
+        REQUIRE(!queue.Push(i));
+    }
+    const IntQueue::Stats after = queue.GetStats();
+    REQUIRE(shedCount == 3);
+    REQUIRE(after.shedCount == before.shedCount);
+    REQUIRE(after.dropped == before.dropped);
+    REQUIRE(after.pushed == before.pushed);
+}
+
+//--------------------------------------------------------------
+class HandoffApplication : public Simple::Application
+{
+public:
+    HandoffApplication(IntQueue& a_queue, bool a_producer)
+        : m_queue(a_queue), m_producer(a_producer) {}
+
+    IntQueue::Stats m_lastStats;
+    uint32_t m_received = 0;
+    uint32_t m_overDepthCount = 0;
+
+protected:
+    void StartUp() override {}
+    void ShutDown() override {}
+    void UpdateStart(float) override {}
+    void UpdateEnded(float) override {}
+
+    void UpdateFixed(float) override
+    {
+        if (m_producer)
+        {
+            m_queue.Push(m_sent++);
+            if (m_queue.IsClosed())
+            {
+                RequestShutDown();
+            }
+        }
+        else
+        {
+            uint32_t value = 0;
+            while (m_queue.Pop(value))
+            {
+                ++m_received;
+            }
+            if (m_received >= 20)
+            {
+                m_queue.Close();
+                RequestShutDown();
+            }
+        }
+    }
+
+    void OnFrameComplete(const FrameStats&) override
+    {
+        // Both loops can observe the queue between them.
+        m_lastStats = m_queue.GetStats();
+        m_overDepthCount += (m_lastStats.depth > m_lastStats.capacity);
+    }
+
+private:
+    IntQueue& m_queue;
+    const bool m_producer;
+    uint32_t m_sent = 0;
+};
+
+//--------------------------------------------------------------
+TEST_CASE("Test Handoff Queue Loops", "[handoff_queue][loops]")
+{
+    IntQueue queue(8, IntQueue::Overflow::Drop);
+    HandoffApplication producer(queue, true);
+    HandoffApplication consumer(queue, false);
+
+    // Only checks that hold however the two loops are scheduled.
+    std::thread producerThread = producer.RunInThread(1000);
+    std::thread consumerThread = consumer.RunInThread(20);
+    consumerThread.join();
+    producerThread.join();
+
+    REQUIRE(consumer.m_received >= 20);
+    REQUIRE(producer.m_lastStats.maxDepth <= 8);
+    REQUIRE(producer.m_overDepthCount == 0);
+    REQUIRE(consumer.m_overDepthCount == 0);
+    REQUIRE(consumer.m_lastStats.popped == consumer.m_received);
+}
@@ -0,0 +1,251 @@
+//--------------------------------------------------------------
+// Copyright (c) David Bosnich <david.bosnich.public@gmail.com>
+//
+// This code is licensed under the MIT License, a copy of which
+// can be found in the license.txt file included at the root of
+// this distribution, or at https://opensource.org/licenses/MIT
+//--------------------------------------------------------------
+
+#include <simple/application/integration_kernels.h>
+#include <catch2/catch.hpp>
+
+#include <chrono>
+#include <cstdio>
+#include <vector>
+
+using namespace Simple::Kernels;
+
+//--------------------------------------------------------------
+namespace
+{
+    // Not a multiple of any vector width, so the tails are tested.
+    constexpr size_t TestCount = 16 * 4 + 13;
+    constexpr float TestTime = 1.0f / 60.0f;
+
+    const ISA AllISAs[] = { ISA::Scalar, ISA::SSE, ISA::AVX2, ISA::AVX512 };
+
+    std::vector<float> MakeValues(size_t a_count, float a_scale)
+    {
+        std::vector<float> values(a_count);
+        for (size_t i = 0; i < a_count; ++i)
+        {
+            values[i] = a_scale * (float)((int)(i % 23) - 11);
+        }
+        return values;
+    }
+
+    void RequireApprox(const std::vector<float>& a_actual,
+                       const std::vector<float>& a_expected)
+    {
+        REQUIRE(a_actual.size() == a_expected.size());
+        for (size_t i = 0; i < a_actual.size(); ++i)
+        {
+            REQUIRE(a_actual[i] == Approx(a_expected[i]).margin(1e-6));
+        }
+    }
+}
+
+//--------------------------------------------------------------
+TEST_CASE("Test Integration Kernels ISA", "[integration_kernels][isa]")
+{
+    const ISA best = GetBestISA();
+    REQUIRE(GetISA() == best);
+    REQUIRE(IsSupported(ISA::Scalar));
+    REQUIRE(IsSupported(best));
+
+    for (ISA isa : AllISAs)
+    {
+        REQUIRE(SetISA(isa) == IsSupported(isa));
+    }
+    REQUIRE(std::string(GetISAName(ISA::AVX2)) == "AVX2");
+
+    REQUIRE(SetISA(best));
+    REQUIRE(GetISA() == best);
+}
+
+//--------------------------------------------------------------
+TEST_CASE("Test Integration Kernels Match Scalar", "[integration_kernels][match]")
+{
+    const ISA best = GetISA();
+    for (ISA isa : AllISAs)
+    {
+        if (!SetISA(isa))
+        {
+            continue;
+        }
+        INFO("ISA: " << GetISAName(isa));
+        const std::vector<float> velocities = MakeValues(TestCount, 2.0f);
+        const std::vector<float> targets = MakeValues(TestCount, -3.0f);
+
+        // Euler.
+        std::vector<float> positions = MakeValues(TestCount, 1.0f);
+        std::vector<float> expected = positions;
+        Euler(positions.data(), velocities.data(), TestCount, TestTime);
+        ScalarKernels::Euler(expected.data(), velocities.data(),
+                             TestCount, TestTime);
+        RequireApprox(positions, expected);
+
+        // Semi-implicit Euler.
+        std::vector<float> speeds = velocities;
+        std::vector<float> expectedSpeeds = velocities;
+        expected = positions;
+        SemiImplicitEuler(positions.data(), speeds.data(),
+                          targets.data(), TestCount, TestTime);
+        ScalarKernels::SemiImplicitEuler(expected.data(),
+                                         expectedSpeeds.data(),
+                                         targets.data(),
+                                         TestCount, TestTime);
+        RequireApprox(positions, expected);
+        RequireApprox(speeds, expectedSpeeds);
+
+        // Damped springs, over several steps.
+        for (int step = 0; step < 10; ++step)
+        {
+            DampedSpring(positions.data(), speeds.data(),
+                         targets.data(), TestCount,
+                         20.0f, 2.0f, TestTime);
+            ScalarKernels::DampedSpring(expected.data(),
+                                        expectedSpeeds.data(),
+                                        targets.data(), TestCount,
+                                        20.0f, 2.0f, TestTime);
+        }
+        RequireApprox(positions, expected);
+        RequireApprox(speeds, expectedSpeeds);
+
+        // Clamped accumulation.
+        std::vector<float> values = MakeValues(TestCount, 0.01f);
+        std::vector<float> expectedValues = values;
+        for (int step = 0; step < 10; ++step)
+        {
+            ClampedAccumulate(values.data(), velocities.data(),
+                              TestCount, -0.05f, 0.1f, TestTime);
+            ScalarKernels::ClampedAccumulate(expectedValues.data(),
+                                             velocities.data(),
+                                             TestCount, -0.05f,
+                                             0.1f, TestTime);
+        }
+        RequireApprox(values, expectedValues);
+        for (float value : values)
+        {
+            REQUIRE(value >= -0.05f);
+            REQUIRE(value <= 0.1f);
+        }
+    }
+    REQUIRE(SetISA(best));
+}
+
+//--------------------------------------------------------------
+TEST_CASE("Test Integration Kernels Timers", "[integration_kernels][timers]")
+{
+    const ISA best = GetISA();
+    for (ISA isa : AllISAs)
+    {
+        if (!SetISA(isa))
+        {
+            continue;
+        }
+        INFO("ISA: " << GetISAName(isa));
+
+        // Timer i expires on step i (timer 0 is already inactive).
+        std::vector<float> timers(TestCount);
+        for (size_t i = 0; i < TestCount; ++i)
+        {
+            timers[i] = (float)i - 0.5f;
+        }
+        timers[0] = 0.0f;
+
+        std::vector<uint8_t> expired(TestCount, 2);
+        size_t totalExpired = 0;
+        for (size_t step = 1; step < TestCount; ++step)
+        {
+            const size_t count = CountdownTimers(timers.data(),
+                                                 expired.data(),
+                                                 TestCount, 1.0f);
+            REQUIRE(count == 1);
+            REQUIRE(expired[step] == 1);
+            REQUIRE(expired[step - 1] == 0);
+            REQUIRE(timers[step] == 0.0f);
+            totalExpired += count;
+        }
+        REQUIRE(totalExpired == TestCount - 1);
+
+        // All stopped at zero, and none expire again.
+        REQUIRE(CountdownTimers(timers.data(), expired.data(),
+                                TestCount, 1.0f) == 0);
+        for (size_t i = 0; i < TestCount; ++i)
+        {
+            REQUIRE(timers[i] == 0.0f);
+            REQUIRE(expired[i] == 0);
+        }
+    }
+    REQUIRE(SetISA(best));
+}
+
+//--------------------------------------------------------------
+template<class Kernel>
+double ElementsPerNanosecond(size_t a_count, const Kernel& a_kernel)
+{
+    constexpr int Iterations = 100;
+    a_kernel(); // Warm up.
+    const auto startTime = std::chrono::steady_clock::now();
+    for (int i = 0; i < Iterations; ++i)
+    {
+        a_kernel();
+    }
+    const auto duration = std::chrono::steady_clock::now() - startTime;
+    const auto nanoseconds = std::chrono::duration_cast<
+        std::chrono::nanoseconds>(duration).count();
+    return (double)(a_count * Iterations) /
+           (double)(nanoseconds > 0 ? nanoseconds : 1);
+}
+
+//--------------------------------------------------------------
+TEST_CASE("Benchmark Integration Kernels", "[.][benchmark][integration_kernels]")
+{
+    // Fits in L2 so the kernels are not bound by memory bandwidth.
+    constexpr size_t Count = 16 * 1024;
+    std::vector<float> positions = MakeValues(Count, 1.0f);
+    std::vector<float> velocities = MakeValues(Count, 2.0f);
+    std::vector<float> targets = MakeValues(Count, 3.0f);
+    std::vector<float> timers(Count, 1000.0f);
+    std::vector<uint8_t> expired(Count);
+    float* p = positions.data();
+    float* v = velocities.data();
+    const float* t = targets.data();
+
+    const ISA best = GetISA();
+    printf("%-8s %10s %10s %10s %10s %10s  (elements/ns)\n", "ISA",
+           "Euler", "SemiEuler", "Spring", "Timers", "Clamped");
+    for (ISA isa : AllISAs)
+    {
+        if (!SetISA(isa))
+        {
+            continue;
+        }
+        const double euler = ElementsPerNanosecond(Count, [&]()
+        {
+            Euler(p, v, Count, TestTime);
+        });
+        const double semiEuler = ElementsPerNanosecond(Count, [&]()
+        {
+            SemiImplicitEuler(p, v, t, Count, TestTime);
+        });
+        const double spring = ElementsPerNanosecond(Count, [&]()
+        {
+            DampedSpring(p, v, t, Count, 20.0f, 2.0f, TestTime);
+        });
+        const double countdown = ElementsPerNanosecond(Count, [&]()
+        {
+            CountdownTimers(timers.data(), expired.data(),
+                            Count, TestTime);
+        });
+        const double clamped = ElementsPerNanosecond(Count, [&]()
+        {
+            ClampedAccumulate(p, t, Count, -1.0f, 1.0f, TestTime);
+        });
+        printf("%-8s %10.2f %10.2f %10.2f %10.2f %10.2f\n",
+               GetISAName(isa), euler, semiEuler, spring,
+               countdown, clamped);
+    }
+    REQUIRE(SetISA(best));
+}
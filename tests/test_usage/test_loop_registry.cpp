@@ -0,0 +1,229 @@
+//--------------------------------------------------------------
+// Copyright (c) David Bosnich <david.bosnich.public@gmail.com>
+//
+// This code is licensed under the MIT License, a copy of which
+// can be found in the license.txt file included at the root of
+// this distribution, or at https://opensource.org/licenses/MIT
+//--------------------------------------------------------------
+
+#include <simple/application/application.h>
+#include <simple/application/loop_registry.h>
+#include <catch2/catch.hpp>
+
+#include <atomic>
+#include <thread>
+
+//--------------------------------------------------------------
+// Sleeps for a set time each frame, so some loops are slower.
+//--------------------------------------------------------------
+class RegistryTestApplication : public Simple::Application
+{
+public:
+    explicit RegistryTestApplication(uint32_t a_sleepMs)
+        : m_sleepMs(a_sleepMs)
+    {
+    }
+
+    std::atomic<uint32_t> m_startUpCount = { 0 };
+
+protected:
+    void StartUp() override { ++m_startUpCount; }
+    void ShutDown() override {}
+    void UpdateStart(float) override {}
+    void UpdateFixed(float) override
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(m_sleepMs));
+    }
+    void UpdateEnded(float) override {}
+
+private:
+    const uint32_t m_sleepMs;
+};
+
+//--------------------------------------------------------------
+template<class Condition>
+bool WaitForRegistry(Condition a_condition)
+{
+    const auto timeout = std::chrono::steady_clock::now() +
+                         std::chrono::seconds(5);
+    while (!a_condition())
+    {
+        if (std::chrono::steady_clock::now() > timeout)
+        {
+            return false;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    return true;
+}
+
+//--------------------------------------------------------------
+TEST_CASE("Test Loop Registry", "[loop_registry]")
+{
+    Simple::LoopRegistry& registry = Simple::LoopRegistry::Get();
+    RegistryTestApplication fast(0);
+    RegistryTestApplication slow(3);
+    Simple::LoopRegistration fastRegistration(fast, "fast");
+    Simple::LoopRegistration slowRegistration(slow, "slow");
+    REQUIRE(fastRegistration.GetName() == "fast");
+    REQUIRE_FALSE(fastRegistration.IsRegistered());
+    REQUIRE(registry.GetLoopCount() == 0);
+
+    // Loops only join the registry while they are running.
+    std::thread fastThread = fast.RunInThread(500);
+    std::thread slowThread = slow.RunInThread(100);
+    Simple::LoopInfo fastInfo;
+    Simple::LoopInfo slowInfo;
+    REQUIRE(WaitForRegistry([&]()
+    {
+        return registry.GetLoop("fast", fastInfo) &&
+               registry.GetLoop("slow", slowInfo) &&
+               fastInfo.frameCount > DEFAULT_LOOP_REGISTRY_SAMPLE_FRAMES &&
+               slowInfo.frameCount > DEFAULT_LOOP_REGISTRY_SAMPLE_FRAMES;
+    }));
+    REQUIRE(fastRegistration.IsRegistered());
+    REQUIRE(registry.GetLoopCount() == 2);
+    REQUIRE_FALSE(registry.GetLoop("missing", fastInfo));
+
+    std::vector<Simple::LoopInfo> loops;
+    registry.GetLoops(loops);
+    REQUIRE(loops.size() == 2);
+
+    REQUIRE(registry.GetLoop("slow", slowInfo));
+    REQUIRE(slowInfo.name == "slow");
+    REQUIRE(slowInfo.state == Simple::LoopState::Running);
+    REQUIRE(slowInfo.targetFPS == 100);
+    REQUIRE(slowInfo.p99FrameNs >= 3000000);
+    REQUIRE(slowInfo.lastFrameNs >= 3000000);
+    REQUIRE(registry.GetLoop("fast", fastInfo));
+    REQUIRE(fastInfo.targetFPS == 500);
+    REQUIRE(fastInfo.threadId != slowInfo.threadId);
+
+    // The slowest loop is reported as the worst in the process.
+    const Simple::LoopAggregate aggregate = registry.GetAggregate();
+    REQUIRE(aggregate.loopCount == 2);
+    REQUIRE(aggregate.worstLoopName == "slow");
+    REQUIRE(aggregate.worstP99FrameNs >= slowInfo.p99FrameNs);
+    REQUIRE(aggregate.totalCpuNs >= slowInfo.cpuNs);
+
+    // And leave the registry once they have shut down.
+    fast.RequestShutDown();
+    slow.RequestShutDown();
+    fastThread.join();
+    slowThread.join();
+    REQUIRE_FALSE(fastRegistration.IsRegistered());
+    REQUIRE(registry.GetLoopCount() == 0);
+    REQUIRE(registry.GetAggregate().loopCount == 0);
+    registry.GetLoops(loops);
+    REQUIRE(loops.empty());
+
+    // Then join again if they are run again.
+    std::thread againThread = fast.RunInThread(500);
+    REQUIRE(WaitForRegistry([&]()
+    {
+        return registry.GetLoop("fast", fastInfo) &&
+               fastInfo.state == Simple::LoopState::Running;
+    }));
+    REQUIRE(registry.GetLoopCount() == 1);
+    fast.RequestShutDown();
+    againThread.join();
+    REQUIRE(registry.GetLoopCount() == 0);
+}
+
+//--------------------------------------------------------------
+TEST_CASE("Test Loop Registry Restart", "[loop_registry][restart]")
+{
+    // Restarting keeps the stats of the run so far, so the count of
+    // frames keeps growing instead of starting again from zero.
+    Simple::LoopRegistry& registry = Simple::LoopRegistry::Get();
+    RegistryTestApplication application(0);
+    Simple::LoopRegistration registration(application, "restarted");
+    std::thread thread = application.RunInThread(500);
+    Simple::LoopInfo info;
+    REQUIRE(WaitForRegistry([&]()
+    {
+        return registry.GetLoop("restarted", info) && info.frameCount >= 100;
+    }));
+    const uint64_t frameCount = info.frameCount;
+
+    application.RequestRestart();
+    REQUIRE(WaitForRegistry([&]()
+    {
+        return application.m_startUpCount == 2;
+    }));
+    REQUIRE(registry.GetLoop("restarted", info));
+    REQUIRE(info.frameCount >= frameCount);
+    REQUIRE(registry.GetLoopCount() == 1);
+    application.RequestShutDown();
+    thread.join();
+    REQUIRE(registry.GetLoopCount() == 0);
+
+    // But running the loop again starts from zero.
+    thread = application.RunInThread(500);
+    REQUIRE(WaitForRegistry([&]()
+    {
+        return registry.GetLoop("restarted", info) &&
+               info.state == Simple::LoopState::Running;
+    }));
+    REQUIRE(info.frameCount < frameCount);
+    application.RequestShutDown();
+    thread.join();
+}
+
+#if SIMPLE_CONTROL_SERVER_SUPPORTED
+//--------------------------------------------------------------
+static std::string SendToRegistry(const char* a_path, const char* a_line)
+{
+    sockaddr_un address = {};
+    address.sun_family = AF_UNIX;
+    strcpy(address.sun_path, a_path);
+    const int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    std::string reply;
+    if (connect(fd, (const sockaddr*)&address, sizeof(address)) == 0)
+    {
+        const std::string line = std::string(a_line) + "\n";
+        if (write(fd, line.data(), line.size()) == (ssize_t)line.size())
+        {
+            char c = 0;
+            while (read(fd, &c, 1) == 1 && c != '\n')
+            {
+                reply += c;
+            }
+        }
+    }
+    close(fd);
+    return reply;
+}
+
+//--------------------------------------------------------------
+TEST_CASE("Test Loop Registry Commands", "[loop_registry][commands]")
+{
+    const char* path = "test_loop_registry.sock";
+    RegistryTestApplication application(0);
+    Simple::LoopRegistration registration(application, "main");
+    Simple::ControlServer server(application);
+    Simple::LoopRegistry::AddCommands(server);
+    REQUIRE(server.Start(path));
+
+    std::thread thread = application.RunInThread(500);
+    Simple::LoopInfo info;
+    REQUIRE(WaitForRegistry([&]()
+    {
+        return Simple::LoopRegistry::Get().GetLoop("main", info) &&
+               info.frameCount > DEFAULT_LOOP_REGISTRY_SAMPLE_FRAMES;
+    }));
+
+    const std::string loops = SendToRegistry(path, "loops");
+    REQUIRE(loops.find("ok count 1 ") == 0);
+    REQUIRE(loops.find(" worst main") != std::string::npos);
+    const std::string loop = SendToRegistry(path, "loop main");
+    REQUIRE(loop.find("ok name main ") == 0);
+    REQUIRE(loop.find(" state running ") != std::string::npos);
+    REQUIRE(loop.find(" target_fps 500 ") != std::string::npos);
+    REQUIRE(SendToRegistry(path, "loop missing").find("error") == 0);
+
+    application.RequestShutDown();
+    thread.join();
+    server.Stop();
+}
+#endif//SIMPLE_CONTROL_SERVER_SUPPORTED
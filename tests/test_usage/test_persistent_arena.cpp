@@ -0,0 +1,258 @@
+//--------------------------------------------------------------
+// Copyright (c) David Bosnich <david.bosnich.public@gmail.com>
+//
+// This code is licensed under the MIT License, a copy of which
+// can be found in the license.txt file included at the root of
+// this distribution, or at https://opensource.org/licenses/MIT
+//--------------------------------------------------------------
+
+#include <simple/application/application.h>
+#include <simple/application/persistent_arena.h>
+#include <catch2/catch.hpp>
+
+#include <fstream>
+#include <vector>
+
+//--------------------------------------------------------------
+TEST_CASE("Test Offset Pointer", "[persistent_arena][offset_ptr]")
+{
+    struct Node
+    {
+        uint32_t value;
+        Simple::OffsetPtr<Node> next;
+    };
+
+    // Pointers stay valid when the memory holding them is moved.
+    Node nodes[2] = {};
+    nodes[0].value = 1;
+    nodes[0].next = &nodes[1];
+    nodes[1].value = 2;
+    REQUIRE(nodes[0].next.Get() == &nodes[1]);
+    REQUIRE_FALSE(nodes[1].next);
+    REQUIRE(nodes[1].next.Get() == nullptr);
+
+    Node moved[2];
+    memcpy(static_cast<void*>(moved), nodes, sizeof(nodes));
+    REQUIRE(moved[0].next.Get() == &moved[1]);
+    REQUIRE(moved[0].next->value == 2);
+    REQUIRE((*moved[0].next).value == 2);
+
+    // Copies point to the same object (not the same offset).
+    Simple::OffsetPtr<Node> copy = moved[0].next;
+    REQUIRE(copy.Get() == &moved[1]);
+    copy = nullptr;
+    REQUIRE_FALSE(copy);
+}
+
+#if SIMPLE_PERSISTENT_ARENA_SUPPORTED
+//--------------------------------------------------------------
+struct ArenaTestEntry
+{
+    uint64_t key;
+    uint64_t value;
+};
+
+//--------------------------------------------------------------
+struct ArenaTestIndex
+{
+    uint32_t count = 0;
+    Simple::OffsetPtr<ArenaTestEntry> entries;
+};
+
+//--------------------------------------------------------------
+ArenaTestIndex* BuildArenaTestIndex(Simple::PersistentArena& a_arena,
+                                    uint32_t a_count)
+{
+    ArenaTestIndex* index = a_arena.New<ArenaTestIndex>();
+    ArenaTestEntry* entries = static_cast<ArenaTestEntry*>(
+        a_arena.Allocate(sizeof(ArenaTestEntry) * a_count,
+                         alignof(ArenaTestEntry)));
+    for (uint32_t i = 0; i < a_count; ++i)
+    {
+        entries[i] = { i * 7ull, i * 13ull };
+    }
+    index->count = a_count;
+    index->entries = entries;
+    a_arena.SetRoot(index);
+    return index;
+}
+
+//--------------------------------------------------------------
+class ArenaTestApplication : public Simple::Application
+{
+public:
+    ArenaTestApplication() : m_arena(*this) {}
+
+    Simple::PersistentArena m_arena;
+
+protected:
+    void StartUp() override {}
+    void ShutDown() override {}
+    void UpdateStart(float) override {}
+    void UpdateFixed(float) override
+    {
+        ArenaTestIndex* index = m_arena.GetRoot<ArenaTestIndex>();
+        ++index->entries[0].value;
+        m_arena.MarkChanged(&index->entries[0], sizeof(ArenaTestEntry));
+        if (index->entries[0].value >= 10)
+        {
+            RequestShutDown();
+        }
+    }
+    void UpdateEnded(float) override {}
+};
+
+//--------------------------------------------------------------
+TEST_CASE("Test Persistent Arena Attach", "[persistent_arena][attach]")
+{
+    const char* path = "test_persistent_arena.bin";
+    std::remove(path);
+
+    ArenaTestApplication application;
+    Simple::PersistentArena& arena = application.m_arena;
+    REQUIRE(arena.GetRoot<ArenaTestIndex>() == nullptr);
+    REQUIRE(arena.Allocate(16) == nullptr);
+
+    // A new file is not attached to, so is built.
+    REQUIRE(arena.Open(path, 1024 * 1024, 1));
+    REQUIRE(arena.IsOpen());
+    REQUIRE_FALSE(arena.IsAttached());
+    REQUIRE(arena.GetCapacity() == 1024 * 1024);
+    REQUIRE(arena.GetUsed() == 0);
+    REQUIRE(arena.GetRoot<ArenaTestIndex>() == nullptr);
+    BuildArenaTestIndex(arena, 1000);
+    REQUIRE(arena.GetUsed() >= sizeof(ArenaTestEntry) * 1000);
+    REQUIRE(arena.Allocate(2 * 1024 * 1024) == nullptr);
+    arena.Close();
+    REQUIRE_FALSE(arena.IsOpen());
+
+    // Then attached to (without rebuilding) when opened again, and
+    // changed each frame, being checkpointed when the loop shuts down.
+    REQUIRE(arena.Open(path, 1024 * 1024, 1));
+    REQUIRE(arena.IsAttached());
+    REQUIRE(arena.GetAttachDuration() < std::chrono::seconds(1));
+    arena.SetCheckpointInterval(3);
+    const uint64_t checkpointCount = arena.GetCheckpointCount();
+    application.Run(1000);
+    REQUIRE(arena.GetCheckpointCount() > checkpointCount + 1);
+    arena.Close();
+
+    REQUIRE(arena.Open(path, 1024 * 1024, 1));
+    REQUIRE(arena.IsAttached());
+    const ArenaTestIndex* index = arena.GetRoot<ArenaTestIndex>();
+    REQUIRE(index != nullptr);
+    REQUIRE(index->count == 1000);
+    REQUIRE(index->entries[0].value == 10);
+    REQUIRE(index->entries[999].key == 999 * 7);
+    REQUIRE(index->entries[999].value == 999 * 13);
+
+    // Allocations continue after the attached contents.
+    const size_t used = arena.GetUsed();
+    REQUIRE(arena.New<ArenaTestEntry>() != nullptr);
+    REQUIRE(arena.GetUsed() > used);
+    arena.Close();
+
+    // Contents of another layout version are rejected.
+    REQUIRE(arena.Open(path, 1024 * 1024, 2));
+    REQUIRE_FALSE(arena.IsAttached());
+    REQUIRE(arena.GetUsed() == 0);
+    REQUIRE(arena.GetRoot<ArenaTestIndex>() == nullptr);
+    arena.Close();
+    std::remove(path);
+}
+
+//--------------------------------------------------------------
+TEST_CASE("Test Persistent Arena Reject", "[persistent_arena][reject]")
+{
+    const char* path = "test_persistent_arena_reject.bin";
+    std::remove(path);
+
+    ArenaTestApplication application;
+    Simple::PersistentArena& arena = application.m_arena;
+    REQUIRE(arena.Open(path, 64 * 1024, 1));
+    BuildArenaTestIndex(arena, 100);
+    arena.Close();
+
+    // Contents changed after the last checkpoint are rejected.
+    {
+        std::fstream file(path, std::ios::in | std::ios::out |
+                                std::ios::binary);
+        file.seekp(128);
+        file.put('x');
+    }
+    REQUIRE(arena.Open(path, 64 * 1024, 1));
+    REQUIRE_FALSE(arena.IsAttached());
+    BuildArenaTestIndex(arena, 100);
+    arena.Close();
+
+    // As are contents changed without being marked as changed, since
+    // checkpoints only rehash the chunks allocated from or marked.
+    REQUIRE(arena.Open(path, 64 * 1024, 1));
+    REQUIRE(arena.IsAttached());
+    arena.GetRoot<ArenaTestIndex>()->entries[50].value = 0;
+    arena.Close();
+    REQUIRE(arena.Open(path, 64 * 1024, 1));
+    REQUIRE_FALSE(arena.IsAttached());
+    BuildArenaTestIndex(arena, 100);
+    arena.Close();
+
+    // As are contents of another capacity.
+    REQUIRE(arena.Open(path, 32 * 1024, 1));
+    REQUIRE_FALSE(arena.IsAttached());
+    arena.Reset();
+    arena.Close();
+    std::remove(path);
+}
+
+//--------------------------------------------------------------
+TEST_CASE("Benchmark Persistent Arena", "[.][benchmark][persistent_arena]")
+{
+    constexpr uint32_t entryCount = 4000000;
+    constexpr size_t capacity = sizeof(ArenaTestEntry) * entryCount + 4096;
+    const char* path = "benchmark_persistent_arena.bin";
+    std::remove(path);
+
+    ArenaTestApplication application;
+    Simple::PersistentArena& arena = application.m_arena;
+    REQUIRE(arena.Open(path, capacity, 1));
+    BuildArenaTestIndex(arena, entryCount);
+    arena.Close();
+
+    BENCHMARK("Cold rebuild 4M entries")
+    {
+        std::vector<ArenaTestEntry> entries(entryCount);
+        for (uint32_t i = 0; i < entryCount; ++i)
+        {
+            entries[entryCount - i - 1] = { i * 7ull, i * 13ull };
+        }
+        std::sort(entries.begin(), entries.end(),
+                  [](const ArenaTestEntry& a_lhs, const ArenaTestEntry& a_rhs)
+        {
+            return a_lhs.key < a_rhs.key;
+        });
+        return entries.back().value;
+    };
+
+    BENCHMARK("Attach and verify 4M entries")
+    {
+        arena.Open(path, capacity, 1);
+        const uint64_t value =
+            arena.GetRoot<ArenaTestIndex>()->entries[entryCount - 1].value;
+        arena.Close();
+        return value;
+    };
+
+    arena.Open(path, capacity, 1);
+    ArenaTestIndex* index = arena.GetRoot<ArenaTestIndex>();
+    BENCHMARK("Checkpoint 4M entries with one changed")
+    {
+        ++index->entries[entryCount / 2].value;
+        arena.MarkChanged(&index->entries[entryCount / 2],
+                          sizeof(ArenaTestEntry));
+        arena.Checkpoint();
+        return arena.GetCheckpointDuration();
+    };
+    arena.Close();
+    std::remove(path);
+}
+#endif//SIMPLE_PERSISTENT_ARENA_SUPPORTED
@@ -0,0 +1,159 @@
+//--------------------------------------------------------------
+// Copyright (c) David Bosnich <david.bosnich.public@gmail.com>
+//
+// This code is licensed under the MIT License, a copy of which
+// can be found in the license.txt file included at the root of
+// this distribution, or at https://opensource.org/licenses/MIT
+//--------------------------------------------------------------
+
+#include <simple/application/application.h>
+#include <simple/application/plugin_host.h>
+#include <test_plugins/test_plugin_state.h>
+#include <catch2/catch.hpp>
+
+#include <fstream>
+#include <thread>
+
+#if SIMPLE_PLUGIN_HOST_SUPPORTED && defined(TEST_PLUGIN_V1_PATH)
+//--------------------------------------------------------------
+class PluginTestApplication : public Simple::Application
+{
+public:
+    PluginTestApplication() : m_host(*this) {}
+
+    Simple::PluginHost m_host;
+    std::atomic<uint32_t> m_startUpCount = { 0 };
+    std::atomic<uint32_t> m_stateVersion = { 0 };
+    std::atomic<uint32_t> m_fixedCount = { 0 };
+
+protected:
+    void StartUp() override { ++m_startUpCount; }
+    void ShutDown() override {}
+    void UpdateStart(float a_deltaTimeSeconds) override
+    {
+        m_host.UpdateStart(a_deltaTimeSeconds);
+    }
+    void UpdateFixed(float a_fixedTimeSeconds) override
+    {
+        m_host.UpdateFixed(a_fixedTimeSeconds);
+
+        // The fixed count is laid out the same in each state version.
+        const TestPluginStateV1* state =
+            static_cast<const TestPluginStateV1*>(m_host.GetState());
+        m_stateVersion = state->version;
+        m_fixedCount = state->fixedCount;
+    }
+    void UpdateEnded(float a_deltaTimeSeconds) override
+    {
+        m_host.UpdateEnded(a_deltaTimeSeconds);
+    }
+};
+
+//--------------------------------------------------------------
+void CopyPluginFile(const char* a_from, const char* a_to)
+{
+    std::ifstream from(a_from, std::ios::binary);
+    std::ofstream to(a_to, std::ios::binary | std::ios::trunc);
+    to << from.rdbuf();
+}
+
+//--------------------------------------------------------------
+template<class Condition>
+bool WaitForPlugin(Condition a_condition)
+{
+    const auto timeout = std::chrono::steady_clock::now() +
+                         std::chrono::seconds(5);
+    while (!a_condition())
+    {
+        if (std::chrono::steady_clock::now() > timeout)
+        {
+            return false;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    return true;
+}
+
+//--------------------------------------------------------------
+TEST_CASE("Test Plugin Host Reload", "[plugin_host][reload]")
+{
+    const char* path = "test_plugin_host.so";
+    CopyPluginFile(TEST_PLUGIN_V1_PATH, path);
+
+    PluginTestApplication application;
+    Simple::PluginHost& host = application.m_host;
+    REQUIRE_FALSE(host.Reload());
+    REQUIRE(host.Load(path));
+    REQUIRE(host.IsLoaded());
+    REQUIRE(host.GetPath() == path);
+    REQUIRE(host.GetStateVersion() == 1);
+
+    std::thread runThread = application.RunInThread(240);
+    REQUIRE(WaitForPlugin([&application]()
+    {
+        return application.m_fixedCount >= 5;
+    }));
+
+    // Replace the plugin in place, migrating its state between frames.
+    CopyPluginFile(TEST_PLUGIN_V2_PATH, path);
+    const uint32_t fixedCountBefore = application.m_fixedCount;
+    host.RequestReload();
+    REQUIRE(WaitForPlugin([&application]()
+    {
+        return application.m_stateVersion == 2;
+    }));
+    REQUIRE(application.m_fixedCount >= fixedCountBefore);
+    REQUIRE(WaitForPlugin([&application, fixedCountBefore]()
+    {
+        return application.m_fixedCount >= fixedCountBefore + 5;
+    }));
+
+    application.RequestShutDown();
+    runThread.join();
+    REQUIRE(application.m_startUpCount == 1);
+    REQUIRE(host.GetStateVersion() == 2);
+    REQUIRE(host.GetStats().reloadCount == 1);
+    REQUIRE(host.GetStats().failedCount == 0);
+    REQUIRE(host.GetStats().lastPause >
+            Simple::PluginHost::Clock::duration::zero());
+    REQUIRE(host.GetStats().lastPause < std::chrono::seconds(1));
+
+    const TestPluginStateV2 migrated =
+        *static_cast<const TestPluginStateV2*>(host.GetState());
+    REQUIRE(migrated.migratedCount == 1);
+    REQUIRE(migrated.fixedCount == application.m_fixedCount);
+    REQUIRE(migrated.fixedTimeSeconds > 0.0f);
+
+    // Reloading the same version migrates its own state.
+    REQUIRE(host.Reload());
+    REQUIRE(static_cast<const TestPluginStateV2*>(host.GetState())
+                ->migratedCount == 2);
+
+    // Versions that cannot migrate the state are rolled back.
+    CopyPluginFile(TEST_PLUGIN_V3_PATH, path);
+    const void* state = host.GetState();
+    REQUIRE_FALSE(host.Reload());
+    REQUIRE(host.GetStateVersion() == 2);
+    REQUIRE(host.GetState() == state);
+
+    // As are files that cannot be opened, or are not plugins.
+    std::ofstream(path, std::ios::trunc) << "not a plugin";
+    REQUIRE_FALSE(host.Reload());
+    std::remove(path);
+    REQUIRE_FALSE(host.Reload());
+    REQUIRE(host.GetState() == state);
+    REQUIRE(host.GetStats().reloadCount == 5);
+    REQUIRE(host.GetStats().failedCount == 3);
+    REQUIRE(host.GetStats().maxPause >= host.GetStats().lastPause);
+
+    // The rolled back version keeps running.
+    host.UpdateFixed(0.5f);
+    REQUIRE(static_cast<const TestPluginStateV2*>(host.GetState())
+                ->fixedCount == migrated.fixedCount + 1);
+
+    host.Unload();
+    REQUIRE_FALSE(host.IsLoaded());
+    REQUIRE(host.GetState() == nullptr);
+    REQUIRE_FALSE(host.Load(path));
+}
+#endif//SIMPLE_PLUGIN_HOST_SUPPORTED
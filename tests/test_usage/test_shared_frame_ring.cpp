@@ -0,0 +1,299 @@
+//--------------------------------------------------------------
+// Copyright (c) David Bosnich <david.bosnich.public@gmail.com>
+//
+// This code is licensed under the MIT License, a copy of which
+// can be found in the license.txt file included at the root of
+// this distribution, or at https://opensource.org/licenses/MIT
+//--------------------------------------------------------------
+
+#include <simple/application/application.h>
+#include <simple/application/shared_frame_ring.h>
+#include <catch2/catch.hpp>
+
+//--------------------------------------------------------------
+class RingApplication : public Simple::Application
+{
+public:
+    RingApplication(Simple::FrameRingWriter& a_writer,
+                    uint32_t a_numFrames)
+        : m_writer(a_writer), m_numFrames(a_numFrames) {}
+
+protected:
+    void StartUp() override {}
+    void ShutDown() override {}
+
+    void UpdateStart(float) override
+    {
+        m_frameStartTime = Clock::now();
+    }
+
+    void UpdateFixed(float) override
+    {
+        ++m_fixedCount;
+    }
+
+    void UpdateEnded(float) override
+    {
+        // Write the frame output directly into the ring slot.
+        uint32_t* output = static_cast<uint32_t*>(
+            m_writer.BeginWrite());
+        REQUIRE(output != nullptr);
+        output[0] = m_fixedCount;
+        output[1] = m_frameIndex;
+        m_writer.EndWrite(m_frameIndex,
+                          ToNs(m_frameStartTime),
+                          ToNs(Clock::now()),
+                          sizeof(uint32_t) * 2);
+
+        if (++m_frameIndex == m_numFrames)
+        {
+            RequestShutDown();
+        }
+    }
+
+private:
+    static int64_t ToNs(const TimePoint& a_timePoint)
+    {
+        using namespace std::chrono;
+        const auto sinceEpoch = a_timePoint.time_since_epoch();
+        return duration_cast<nanoseconds>(sinceEpoch).count();
+    }
+
+    Simple::FrameRingWriter& m_writer;
+    const uint32_t m_numFrames;
+    uint32_t m_frameIndex = 0;
+    uint32_t m_fixedCount = 0;
+    TimePoint m_frameStartTime;
+};
+
+//--------------------------------------------------------------
+class PublisherApplication : public Simple::Application
+{
+public:
+    PublisherApplication(Simple::FrameRingWriter& a_writer,
+                         uint32_t a_numFrames)
+        : m_publisher(*this, a_writer), m_numFrames(a_numFrames) {}
+
+protected:
+    void StartUp() override {}
+    void ShutDown() override {}
+    void UpdateStart(float) override {}
+    void UpdateFixed(float) override {}
+
+    void UpdateEnded(float) override
+    {
+        // Write output into every other frame, the rest only have stats.
+        const uint64_t frameIndex = m_publisher.GetFrameIndex();
+        if (frameIndex % 2 == 0)
+        {
+            uint64_t* output = static_cast<uint64_t*>(
+                m_publisher.GetFrameData());
+            REQUIRE(output != nullptr);
+            output[0] = frameIndex * 10;
+            m_publisher.SetFrameSize(sizeof(uint64_t));
+        }
+        if (frameIndex + 1 == m_numFrames)
+        {
+            RequestShutDown();
+        }
+    }
+
+private:
+    Simple::FrameRingPublisher m_publisher;
+    const uint32_t m_numFrames;
+};
+
+//--------------------------------------------------------------
+TEST_CASE("Test Frame Ring Read", "[frame_ring][read]")
+{
+    constexpr uint32_t slotCount = 4;
+    constexpr uint32_t slotSize = 16;
+    const size_t bytes = Simple::FrameRingWriter::RequiredBytes(
+        slotCount, slotSize);
+    alignas(64) char memory[1024];
+    REQUIRE(bytes <= sizeof(memory));
+
+    Simple::FrameRingWriter writer;
+    REQUIRE(writer.Initialize(memory, bytes,
+                              slotCount, slotSize));
+    REQUIRE(writer.GetSlotSize() == slotSize);
+
+    Simple::FrameRingReader reader;
+    REQUIRE(reader.Attach(memory, bytes));
+
+    Simple::FrameView frameView;
+    REQUIRE(reader.TryRead(frameView) ==
+            Simple::FrameRingReader::Result::Empty);
+
+    for (uint32_t i = 0; i < 3; ++i)
+    {
+        REQUIRE(writer.Publish(i, i * 10, (i * 10) + 5,
+                               &i, sizeof(i)));
+    }
+    REQUIRE(writer.GetPublishedCount() == 3);
+    REQUIRE(reader.GetLagCount() == 3);
+
+    for (uint32_t i = 0; i < 3; ++i)
+    {
+        REQUIRE(reader.TryRead(frameView) ==
+                Simple::FrameRingReader::Result::Read);
+        REQUIRE(frameView.frameIndex == i);
+        REQUIRE(frameView.startTimeNs == i * 10);
+        REQUIRE(frameView.endTimeNs == (i * 10) + 5);
+        REQUIRE(frameView.size == sizeof(i));
+        REQUIRE(*static_cast<const uint32_t*>(frameView.data) == i);
+        REQUIRE(reader.IsValid(frameView));
+    }
+    REQUIRE(reader.TryRead(frameView) ==
+            Simple::FrameRingReader::Result::Empty);
+    REQUIRE(reader.GetLostCount() == 0);
+
+    // Too large for a slot.
+    char tooLarge[slotSize + 1] = {};
+    REQUIRE(!writer.Publish(3, 0, 0, tooLarge, sizeof(tooLarge)));
+}
+
+//--------------------------------------------------------------
+TEST_CASE("Test Frame Ring Overrun", "[frame_ring][overrun]")
+{
+    constexpr uint32_t slotCount = 4;
+    constexpr uint32_t slotSize = 8;
+    const size_t bytes = Simple::FrameRingWriter::RequiredBytes(
+        slotCount, slotSize);
+    alignas(64) char memory[1024];
+    REQUIRE(bytes <= sizeof(memory));
+
+    Simple::FrameRingWriter writer;
+    REQUIRE(writer.Initialize(memory, bytes,
+                              slotCount, slotSize));
+    Simple::FrameRingReader reader;
+    REQUIRE(reader.Attach(memory, bytes));
+
+    // Read one frame, then hold the view while the writer laps.
+    Simple::FrameView heldView;
+    uint64_t frameIndex = 0;
+    writer.Publish(frameIndex, 0, 0, &frameIndex, sizeof(frameIndex));
+    REQUIRE(reader.TryRead(heldView) ==
+            Simple::FrameRingReader::Result::Read);
+    for (frameIndex = 1; frameIndex < 10; ++frameIndex)
+    {
+        writer.Publish(frameIndex, 0, 0,
+                       &frameIndex, sizeof(frameIndex));
+    }
+    REQUIRE(!reader.IsValid(heldView));
+
+    // The slow reader loses frames but is never blocking writes.
+    Simple::FrameView frameView;
+    REQUIRE(reader.TryRead(frameView) ==
+            Simple::FrameRingReader::Result::Overrun);
+    REQUIRE(reader.GetLostCount() == 5);
+    for (uint64_t expected = 6; expected < 10; ++expected)
+    {
+        REQUIRE(reader.TryRead(frameView) ==
+                Simple::FrameRingReader::Result::Read);
+        REQUIRE(frameView.frameIndex == expected);
+    }
+    REQUIRE(reader.TryRead(frameView) ==
+            Simple::FrameRingReader::Result::Empty);
+}
+
+//--------------------------------------------------------------
+TEST_CASE("Test Frame Ring Publisher", "[frame_ring][publisher]")
+{
+    constexpr uint32_t slotCount = 8;
+    constexpr uint32_t slotSize = 16;
+    const size_t bytes = Simple::FrameRingWriter::RequiredBytes(
+        slotCount, slotSize);
+    alignas(64) char memory[1024];
+    REQUIRE(bytes <= sizeof(memory));
+
+    Simple::FrameRingWriter writer;
+    REQUIRE(writer.Initialize(memory, bytes, slotCount, slotSize));
+    Simple::FrameRingReader reader;
+    REQUIRE(reader.Attach(memory, bytes));
+
+    // Every frame is published by the listener, timed by the loop.
+    constexpr uint32_t numFrames = 6;
+    PublisherApplication application(writer, numFrames);
+    application.Run(240);
+    REQUIRE(writer.GetPublishedCount() == numFrames);
+
+    Simple::FrameView frameView;
+    int64_t previousStartNs = 0;
+    for (uint32_t i = 0; i < numFrames; ++i)
+    {
+        REQUIRE(reader.TryRead(frameView) ==
+                Simple::FrameRingReader::Result::Read);
+        REQUIRE(frameView.frameIndex == i);
+        REQUIRE(frameView.startTimeNs > previousStartNs);
+        REQUIRE(frameView.endTimeNs >= frameView.startTimeNs);
+        previousStartNs = frameView.startTimeNs;
+        if (i % 2 == 0)
+        {
+            REQUIRE(frameView.size == sizeof(uint64_t));
+            REQUIRE(*static_cast<const uint64_t*>(frameView.data) ==
+                    i * 10);
+        }
+        else
+        {
+            REQUIRE(frameView.size == 0);
+        }
+        REQUIRE(reader.IsValid(frameView));
+    }
+    REQUIRE(reader.TryRead(frameView) ==
+            Simple::FrameRingReader::Result::Empty);
+}
+
+#if SIMPLE_SHARED_MEMORY_SUPPORTED
+//--------------------------------------------------------------
+TEST_CASE("Test Frame Ring Shared", "[frame_ring][shared]")
+{
+    char name[64];
+    snprintf(name, sizeof(name), "/simple_frame_ring_%d",
+             (int)getpid());
+
+    constexpr uint32_t slotCount = 8;
+    constexpr uint32_t slotSize = 64;
+    const size_t bytes = Simple::FrameRingWriter::RequiredBytes(
+        slotCount, slotSize);
+
+    Simple::SharedMemory writerMemory;
+    REQUIRE(writerMemory.Create(name, bytes));
+    REQUIRE(writerMemory.GetSize() == bytes);
+    Simple::FrameRingWriter writer;
+    REQUIRE(writer.Initialize(writerMemory.GetData(), bytes,
+                              slotCount, slotSize));
+
+    // Map a second (read-only) view as a consumer process would.
+    Simple::SharedMemory readerMemory;
+    REQUIRE(readerMemory.Open(name));
+    Simple::FrameRingReader reader;
+    REQUIRE(reader.Attach(readerMemory.GetData(),
+                          readerMemory.GetSize()));
+
+    constexpr uint32_t numFrames = 5;
+    RingApplication ringApplication(writer, numFrames);
+    ringApplication.Run(240);
+    REQUIRE(writer.GetPublishedCount() == numFrames);
+
+    Simple::FrameView frameView;
+    for (uint32_t i = 0; i < numFrames; ++i)
+    {
+        REQUIRE(reader.TryRead(frameView) ==
+                Simple::FrameRingReader::Result::Read);
+        const uint32_t* output =
+            static_cast<const uint32_t*>(frameView.data);
+        REQUIRE(frameView.frameIndex == i);
+        REQUIRE(frameView.size == sizeof(uint32_t) * 2);
+        REQUIRE(frameView.endTimeNs >= frameView.startTimeNs);
+        REQUIRE(output[0] == i + 1);
+        REQUIRE(output[1] == i);
+    }
+    REQUIRE(reader.TryRead(frameView) ==
+            Simple::FrameRingReader::Result::Empty);
+
+    writerMemory.Close();
+    Simple::SharedMemory missingMemory;
+    REQUIRE(!missingMemory.Open(name));
+}
+#endif//SIMPLE_SHARED_MEMORY_SUPPORTED
@@ -0,0 +1,258 @@
+//--------------------------------------------------------------
+// Copyright (c) David Bosnich <david.bosnich.public@gmail.com>
+//
+// This code is licensed under the MIT License, a copy of which
+// can be found in the license.txt file included at the root of
+// this distribution, or at https://opensource.org/licenses/MIT
+//--------------------------------------------------------------
+
+#include <simple/application/application.h>
+#include <simple/application/shutdown_coordinator.h>
+#include <catch2/catch.hpp>
+
+#include <atomic>
+#include <thread>
+
+//--------------------------------------------------------------
+// Moves items from an input count to an output count each frame
+// (or produces them if it has no input), and records the order in
+// which each loop shuts down.
+//--------------------------------------------------------------
+class StageTestApplication : public Simple::Application
+{
+public:
+    StageTestApplication(std::atomic<int>* a_input,
+                         std::atomic<int>* a_output,
+                         std::atomic<uint32_t>& a_shutDownSequence)
+        : m_input(a_input)
+        , m_output(a_output)
+        , m_shutDownSequence(a_shutDownSequence)
+    {
+    }
+
+    std::atomic<uint32_t> m_shutDownOrder = { 0 };
+    std::atomic_bool m_stuck = { false };
+
+protected:
+    void StartUp() override {}
+    void ShutDown() override { m_shutDownOrder = ++m_shutDownSequence; }
+    void UpdateStart(float) override {}
+    void UpdateFixed(float) override
+    {
+        // Only move one item each frame, so there is work to drain.
+        if (!m_input)
+        {
+            ++*m_output;
+        }
+        else if (*m_input > 0)
+        {
+            --*m_input;
+            if (m_output)
+            {
+                ++*m_output;
+            }
+        }
+        while (m_stuck)
+        {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+    }
+    void UpdateEnded(float) override {}
+
+private:
+    std::atomic<int>* m_input;
+    std::atomic<int>* m_output;
+    std::atomic<uint32_t>& m_shutDownSequence;
+};
+
+//--------------------------------------------------------------
+template<class Condition>
+bool WaitForStage(Condition a_condition)
+{
+    const auto timeout = std::chrono::steady_clock::now() +
+                         std::chrono::seconds(5);
+    while (!a_condition())
+    {
+        if (std::chrono::steady_clock::now() > timeout)
+        {
+            return false;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    return true;
+}
+
+//--------------------------------------------------------------
+TEST_CASE("Test Shutdown Coordinator Order", "[shutdown_coordinator][order]")
+{
+    std::atomic<uint32_t> shutDownSequence = { 0 };
+    std::atomic<int> produced = { 0 };
+    std::atomic<int> consumed = { 0 };
+    StageTestApplication producer(nullptr, &produced, shutDownSequence);
+    StageTestApplication consumer(&produced, &consumed, shutDownSequence);
+    StageTestApplication sink(&consumed, nullptr, shutDownSequence);
+
+    Simple::ShutdownCoordinator coordinator;
+    REQUIRE(coordinator.AddLoop(sink, "sink",
+                                [&consumed]() { return consumed == 0; }));
+    REQUIRE(coordinator.AddLoop(consumer, "consumer",
+                                [&produced]() { return produced == 0; }));
+    REQUIRE(coordinator.AddLoop(producer, "producer"));
+    REQUIRE_FALSE(coordinator.AddLoop(producer, "producer"));
+    REQUIRE(coordinator.AddDependency("consumer", "producer"));
+    REQUIRE(coordinator.AddDependency("sink", "consumer"));
+    REQUIRE_FALSE(coordinator.AddDependency("producer", "sink"));
+    REQUIRE_FALSE(coordinator.AddDependency("sink", "missing"));
+    REQUIRE_FALSE(coordinator.AddDependency("sink", "sink"));
+
+    // The producer runs faster than the others, so work builds up.
+    std::thread producerThread = producer.RunInThread(1000);
+    std::thread consumerThread = consumer.RunInThread(200);
+    std::thread sinkThread = sink.RunInThread(200);
+    REQUIRE(WaitForStage([&]()
+    {
+        return producer.IsRunning() && consumer.IsRunning() &&
+               sink.IsRunning() && produced > 5;
+    }));
+
+    REQUIRE(coordinator.ShutDown());
+    producerThread.join();
+    consumerThread.join();
+    sinkThread.join();
+    REQUIRE_FALSE(producer.IsRunning());
+
+    // Stopped in order, having drained all of the work produced.
+    REQUIRE(producer.m_shutDownOrder == 1);
+    REQUIRE(consumer.m_shutDownOrder == 2);
+    REQUIRE(sink.m_shutDownOrder == 3);
+    REQUIRE(produced == 0);
+    REQUIRE(consumed == 0);
+
+    const Simple::ShutdownCoordinator::Report& report =
+        coordinator.GetReport();
+    REQUIRE_FALSE(report.forced);
+    REQUIRE(report.stages.size() == 3);
+    REQUIRE(report.loops.size() == 3);
+    REQUIRE(report.loops[0].name == "sink");
+    REQUIRE(report.loops[0].stage == 2);
+    REQUIRE(report.loops[1].stage == 1);
+    REQUIRE(report.loops[2].stage == 0);
+    REQUIRE(report.loops[0].drained);
+    REQUIRE(report.loops[0].stopped);
+    REQUIRE(report.stages[1].drainDuration > std::chrono::milliseconds(0));
+    REQUIRE(report.totalDuration >= report.stages[0].stopDuration +
+                                    report.stages[1].drainDuration);
+}
+
+//--------------------------------------------------------------
+TEST_CASE("Test Shutdown Coordinator Deadline",
+          "[shutdown_coordinator][deadline]")
+{
+    std::atomic<uint32_t> shutDownSequence = { 0 };
+    std::atomic<int> produced = { 0 };
+    std::atomic<int> producedIndependently = { 0 };
+    StageTestApplication stuck(nullptr, &produced, shutDownSequence);
+    StageTestApplication independent(nullptr, &producedIndependently,
+                                     shutDownSequence);
+    stuck.m_stuck = true;
+
+    // Loops that do not stop in time are forced, and the others still
+    // stop (loops without dependencies are all in the first stage).
+    bool forced = false;
+    Simple::ShutdownCoordinator coordinator;
+    coordinator.SetStageDeadline(std::chrono::milliseconds(50));
+    REQUIRE(coordinator.AddLoop(stuck, "stuck", nullptr, [&]()
+    {
+        forced = true;
+        stuck.m_stuck = false;
+    }));
+    REQUIRE(coordinator.AddLoop(independent, "independent",
+                                []() { return true; }));
+
+    std::thread stuckThread = stuck.RunInThread(200);
+    std::thread independentThread = independent.RunInThread(200);
+    REQUIRE(WaitForStage([&]()
+    {
+        return stuck.IsRunning() && independent.IsRunning();
+    }));
+
+    const auto begin = std::chrono::steady_clock::now();
+    REQUIRE_FALSE(coordinator.ShutDown());
+    REQUIRE(std::chrono::steady_clock::now() - begin <
+            std::chrono::seconds(1));
+    stuckThread.join();
+    independentThread.join();
+
+    const Simple::ShutdownCoordinator::Report& report =
+        coordinator.GetReport();
+    REQUIRE(forced);
+    REQUIRE(report.forced);
+    REQUIRE(report.stages.size() == 1);
+    REQUIRE(report.stages[0].forced);
+    REQUIRE(report.stages[0].stopDuration >= std::chrono::milliseconds(40));
+    REQUIRE(report.loops[0].drained);
+    REQUIRE_FALSE(report.loops[0].stopped);
+    REQUIRE(report.loops[1].stopped);
+    REQUIRE(independent.m_shutDownOrder == 1);
+}
+
+//--------------------------------------------------------------
+TEST_CASE("Test Shutdown Coordinator Stop Deadline",
+          "[shutdown_coordinator][deadline]")
+{
+    std::atomic<uint32_t> shutDownSequence = { 0 };
+    std::atomic<int> produced = { 0 };
+    StageTestApplication undrained(nullptr, &produced, shutDownSequence);
+
+    // A loop that never drains still has the deadline again to stop.
+    Simple::ShutdownCoordinator coordinator;
+    coordinator.SetStageDeadline(std::chrono::milliseconds(50));
+    REQUIRE(coordinator.AddLoop(undrained, "undrained",
+                                []() { return false; }));
+
+    std::thread undrainedThread = undrained.RunInThread(200);
+    REQUIRE(WaitForStage([&]() { return undrained.IsRunning(); }));
+    REQUIRE_FALSE(coordinator.ShutDown());
+    undrainedThread.join();
+
+    const Simple::ShutdownCoordinator::Report& report =
+        coordinator.GetReport();
+    REQUIRE(report.forced);
+    REQUIRE(report.stages[0].drainDuration >= std::chrono::milliseconds(50));
+    REQUIRE(report.stages[0].stopDuration < std::chrono::milliseconds(50));
+    REQUIRE_FALSE(report.loops[0].drained);
+    REQUIRE(report.loops[0].stopped);
+    REQUIRE(undrained.m_shutDownOrder == 1);
+}
+
+//--------------------------------------------------------------
+TEST_CASE("Test Shutdown Coordinator Not Started",
+          "[shutdown_coordinator][started]")
+{
+    std::atomic<uint32_t> shutDownSequence = { 0 };
+    std::atomic<int> produced = { 0 };
+    StageTestApplication late(nullptr, &produced, shutDownSequence);
+
+    // A loop that only starts running once shutting down has begun
+    // is waited on rather than reported as stopped, then shut down.
+    Simple::ShutdownCoordinator coordinator;
+    REQUIRE(coordinator.AddLoop(late, "late"));
+    REQUIRE(late.GetRunCount() == 0);
+    std::thread lateThread([&late]()
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        late.Run(200);
+    });
+    REQUIRE(coordinator.ShutDown());
+    lateThread.join();
+    REQUIRE(late.GetRunCount() == 1);
+    REQUIRE_FALSE(late.IsRunning());
+
+    const Simple::ShutdownCoordinator::Report& report =
+        coordinator.GetReport();
+    REQUIRE_FALSE(report.forced);
+    REQUIRE(report.loops[0].started);
+    REQUIRE(report.loops[0].stopped);
+    REQUIRE(report.stages[0].stopDuration >= std::chrono::milliseconds(10));
+    REQUIRE(late.m_shutDownOrder == 1);
+}
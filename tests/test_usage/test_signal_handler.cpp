@@ -0,0 +1,154 @@
+//--------------------------------------------------------------
+// Copyright (c) David Bosnich <david.bosnich.public@gmail.com>
+//
+// This code is licensed under the MIT License, a copy of which
+// can be found in the license.txt file included at the root of
+// this distribution, or at https://opensource.org/licenses/MIT
+//--------------------------------------------------------------
+
+#include <simple/application/application.h>
+#include <simple/application/signal_handler.h>
+#include <catch2/catch.hpp>
+
+#if SIMPLE_SIGNALFD_SUPPORTED
+#include <sys/resource.h>
+
+//--------------------------------------------------------------
+class SignalTestApplication : public Simple::Application
+{
+public:
+    SignalTestApplication()
+        : m_signalHandler(*this)
+    {
+        m_signalHandler.SetReloadFunc([this]() { ++m_reloadCount; });
+        m_signalHandler.SetDumpStatsFunc([this]() { ++m_dumpCount; });
+    }
+
+    Simple::SignalHandler m_signalHandler;
+    uint32_t m_startUpCount = 0;
+    uint32_t m_shutDownCount = 0;
+    uint32_t m_reloadCount = 0;
+    uint32_t m_dumpCount = 0;
+    uint32_t m_frames = 0;
+    bool m_timedOut = false;
+
+protected:
+    void StartUp() override
+    {
+        // Reload (instead of restart) on SIGHUP after the restart.
+        if (++m_startUpCount == 2)
+        {
+            m_signalHandler.SetAction(SIGHUP, Simple::SignalAction::Reload);
+        }
+    }
+
+    void ShutDown() override
+    {
+        ++m_shutDownCount;
+    }
+
+    void UpdateStart(float) override {}
+    void UpdateFixed(float) override {}
+
+    void UpdateEnded(float) override
+    {
+        // Send each signal once the last one has been acted on.
+        if (m_step == 0 ||
+            (m_step == 1 && m_dumpCount == 1) ||
+            (m_step == 2 && m_startUpCount == 2) ||
+            (m_step == 3 && m_reloadCount == 1))
+        {
+            const int signals[] = { SIGUSR1, SIGHUP, SIGHUP, SIGTERM };
+            kill(getpid(), signals[m_step++]);
+        }
+        if (++m_frames == 2000)
+        {
+            m_timedOut = true;
+            RequestShutDown();
+        }
+    }
+
+private:
+    uint32_t m_step = 0;
+};
+
+//--------------------------------------------------------------
+TEST_CASE("Test Signal Handler Actions", "[signal_handler][actions]")
+{
+    SignalTestApplication application;
+    REQUIRE(application.m_signalHandler.IsHandling());
+    REQUIRE(application.m_signalHandler.GetAction(SIGINT) ==
+            Simple::SignalAction::ShutDown);
+    REQUIRE(application.m_signalHandler.GetAction(SIGHUP) ==
+            Simple::SignalAction::Restart);
+    REQUIRE_FALSE(application.m_signalHandler.SetAction(
+        SIGUSR2, Simple::SignalAction::ShutDown));
+
+    application.Run(240);
+    REQUIRE_FALSE(application.m_timedOut);
+    REQUIRE(application.m_dumpCount == 1);
+    REQUIRE(application.m_startUpCount == 2);
+    REQUIRE(application.m_reloadCount == 1);
+    REQUIRE(application.m_shutDownCount == 2);
+
+    // Each signal was acted on within (at most) two frames.
+    const Simple::SignalHandler::Stats& stats =
+        application.m_signalHandler.GetStats();
+    REQUIRE(application.m_signalHandler.GetReceivedCount() == 4);
+    REQUIRE(stats.handledCount == 4);
+    REQUIRE(stats.maxLatency > Simple::SignalHandler::Duration::zero());
+    REQUIRE(stats.maxLatency < std::chrono::milliseconds(500));
+    REQUIRE(stats.totalLatency >= stats.maxLatency);
+}
+
+//--------------------------------------------------------------
+TEST_CASE("Test Signal Handler Before Run", "[signal_handler][before_run]")
+{
+    // A shut down signal received before the loop runs is not lost
+    // when Run clears requests, so the loop shuts down at once.
+    SignalTestApplication application;
+    REQUIRE(application.m_signalHandler.IsHandling());
+    kill(getpid(), SIGTERM);
+    const auto timeout = std::chrono::steady_clock::now() +
+                         std::chrono::seconds(5);
+    while (application.m_signalHandler.GetReceivedCount() == 0 &&
+           std::chrono::steady_clock::now() < timeout)
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    REQUIRE(application.m_signalHandler.GetReceivedCount() == 1);
+
+    application.Run(240);
+    REQUIRE(application.m_startUpCount == 1);
+    REQUIRE(application.m_shutDownCount == 1);
+    REQUIRE(application.m_frames == 0);
+    REQUIRE(application.m_signalHandler.GetStats().handledCount == 1);
+}
+
+//--------------------------------------------------------------
+TEST_CASE("Test Signal Handler Failure", "[signal_handler][failure]")
+{
+    sigset_t before;
+    pthread_sigmask(SIG_SETMASK, nullptr, &before);
+    REQUIRE_FALSE(sigismember(&before, SIGTERM));
+
+    // Limit open files to those already open, so no fd can be made.
+    rlimit limit;
+    REQUIRE(getrlimit(RLIMIT_NOFILE, &limit) == 0);
+    const int lowestFree = dup(STDIN_FILENO);
+    REQUIRE(lowestFree >= 0);
+    close(lowestFree);
+    rlimit lowered = limit;
+    lowered.rlim_cur = (rlim_t)lowestFree;
+    REQUIRE(setrlimit(RLIMIT_NOFILE, &lowered) == 0);
+
+    // Failing to start leaves the signals unblocked, not lost.
+    SignalTestApplication application;
+    REQUIRE(setrlimit(RLIMIT_NOFILE, &limit) == 0);
+    REQUIRE_FALSE(application.m_signalHandler.IsHandling());
+    sigset_t after;
+    pthread_sigmask(SIG_SETMASK, nullptr, &after);
+    REQUIRE_FALSE(sigismember(&after, SIGTERM));
+    REQUIRE_FALSE(sigismember(&after, SIGINT));
+}
+#endif//SIMPLE_SIGNALFD_SUPPORTED
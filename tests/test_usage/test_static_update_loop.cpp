@@ -0,0 +1,412 @@
+//--------------------------------------------------------------
+// Copyright (c) David Bosnich <david.bosnich.public@gmail.com>
+//
+// This code is licensed under the MIT License, a copy of which
+// can be found in the license.txt file included at the root of
+// this distribution, or at https://opensource.org/licenses/MIT
+//--------------------------------------------------------------
+
+#include <simple/application/application.h>
+#include <simple/application/static_update_loop.h>
+#include <catch2/catch.hpp>
+
+//--------------------------------------------------------------
+class StaticTestLoop : public Simple::StaticUpdateLoop<StaticTestLoop>
+{
+public:
+    StaticTestLoop(uint32_t a_numFrames, uint32_t a_numRestarts)
+        : m_numFrames(a_numFrames), m_numRestarts(a_numRestarts) {}
+
+    uint32_t m_startUpCount = 0;
+    uint32_t m_shutDownCount = 0;
+    uint32_t m_updateStartCount = 0;
+    uint32_t m_updateFixedCount = 0;
+    uint32_t m_updateEndedCount = 0;
+    uint64_t m_lastFrameCount = 0;
+
+private:
+    friend class Simple::StaticUpdateLoop<StaticTestLoop>;
+
+    void StartUp()
+    {
+        ++m_startUpCount;
+        m_framesThisRun = 0;
+    }
+
+    void ShutDown()
+    {
+        ++m_shutDownCount;
+    }
+
+    void UpdateStart(float a_deltaTimeSeconds)
+    {
+        REQUIRE(a_deltaTimeSeconds <= 1.0f / (float)GetTargetFPS());
+        ++m_updateStartCount;
+    }
+
+    void UpdateFixed(float a_fixedTimeSeconds)
+    {
+        REQUIRE(a_fixedTimeSeconds == 1.0f / (float)GetTargetFPS());
+        ++m_updateFixedCount;
+    }
+
+    void UpdateEnded(float)
+    {
+        ++m_updateEndedCount;
+        if (++m_framesThisRun < m_numFrames)
+        {
+            return;
+        }
+        if (m_startUpCount <= m_numRestarts)
+        {
+            RequestRestart();
+        }
+        else
+        {
+            RequestShutDown();
+        }
+    }
+
+    void OnFrameComplete(const FrameStats& a_frameStats)
+    {
+        REQUIRE(a_frameStats.frameCount == m_framesThisRun);
+        REQUIRE(a_frameStats.targetFPS == GetTargetFPS());
+        m_lastFrameCount = a_frameStats.frameCount;
+    }
+
+    const uint32_t m_numFrames;
+    const uint32_t m_numRestarts;
+    uint32_t m_framesThisRun = 0;
+};
+
+//--------------------------------------------------------------
+TEST_CASE("Test Static Update Loop Frames", "[static_update_loop][frames]")
+{
+    StaticTestLoop loop(10, 0);
+    loop.Run(240);
+    REQUIRE(loop.m_startUpCount == 1);
+    REQUIRE(loop.m_shutDownCount == 1);
+    REQUIRE(loop.m_updateStartCount == 10);
+    REQUIRE(loop.m_updateFixedCount == 10);
+    REQUIRE(loop.m_updateEndedCount == 10);
+    REQUIRE(loop.m_lastFrameCount == 10);
+}
+
+//--------------------------------------------------------------
+TEST_CASE("Test Static Update Loop Restart", "[static_update_loop][restart]")
+{
+    StaticTestLoop loop(5, 2);
+    loop.Run(240);
+    REQUIRE(loop.m_startUpCount == 3);
+    REQUIRE(loop.m_shutDownCount == 3);
+    REQUIRE(loop.m_updateFixedCount == 15);
+    REQUIRE(loop.m_lastFrameCount == 5);
+}
+
+//--------------------------------------------------------------
+TEST_CASE("Test Static Update Loop Uncapped", "[static_update_loop][uncapped]")
+{
+    StaticTestLoop loop(100, 0);
+    loop.SetCappedFPS(false);
+    REQUIRE(!loop.GetCappedFPS());
+    loop.Run(60);
+    REQUIRE(loop.m_updateStartCount == 100);
+    REQUIRE(loop.m_updateEndedCount == 100);
+    REQUIRE(loop.m_updateFixedCount >= 1);
+    REQUIRE(loop.m_updateFixedCount <= 100);
+}
+
+//--------------------------------------------------------------
+class StaticFixedLoop
+    : public Simple::StaticUpdateLoop<StaticFixedLoop,
+          Simple::LoopPolicy::Clock<std::chrono::high_resolution_clock>>
+{
+public:
+    // Only the fixed update is declared (public, so no friend).
+    void UpdateFixed(float)
+    {
+        ++m_updateFixedCount;
+    }
+
+    std::atomic<uint32_t> m_updateFixedCount = { 0 };
+};
+
+//--------------------------------------------------------------
+TEST_CASE("Test Static Update Loop Thread", "[static_update_loop][thread]")
+{
+    static_assert(std::is_same<StaticFixedLoop::Clock,
+                               std::chrono::high_resolution_clock>::value,
+                  "Clock policy not selected");
+
+    StaticFixedLoop loop;
+    std::thread thread = loop.RunInThread(1000);
+    while (loop.m_updateFixedCount < 10)
+    {
+        std::this_thread::yield();
+    }
+    loop.RequestShutDown();
+    thread.join();
+    REQUIRE(loop.m_updateFixedCount >= 10);
+}
+
+//--------------------------------------------------------------
+template<class... Policies>
+class PolicyTestLoop
+    : public Simple::StaticUpdateLoop<PolicyTestLoop<Policies...>,
+                                      Policies...>
+{
+public:
+    using Base = Simple::StaticUpdateLoop<PolicyTestLoop<Policies...>,
+                                          Policies...>;
+    using FrameStats = typename Base::FrameStats;
+
+    void OnPhaseBegin(Simple::UpdatePhase a_phase)
+    {
+        m_phases.push_back((char)('0' + (int)a_phase));
+    }
+
+    void UpdateEnded(float)
+    {
+        if (++m_frames == 3)
+        {
+            this->RequestShutDown();
+        }
+    }
+
+    void OnFrameComplete(const FrameStats& a_frameStats)
+    {
+        m_lastAverageFPS = a_frameStats.averageFPS;
+        ++m_frameCompleteCount;
+    }
+
+    std::string m_phases;
+    uint32_t m_frames = 0;
+    uint32_t m_lastAverageFPS = 0;
+    uint32_t m_frameCompleteCount = 0;
+};
+
+//--------------------------------------------------------------
+TEST_CASE("Test Static Update Loop Policies", "[static_update_loop][policies]")
+{
+    using namespace Simple::LoopPolicy;
+
+    // Rate fixed at compile time, so the target fps is constant.
+    using FixedLoop = PolicyTestLoop<NoStats, FixedRate<200>, SleepWait>;
+    static_assert(FixedLoop::GetTargetFPS() == 200, "Not fixed rate");
+    static_assert(FixedLoop::GetCappedFPS(), "Not capped");
+    static_assert(std::is_same<FixedLoop::WaitPolicy, SleepWait>::value,
+                  "Wait policy not selected");
+
+    FixedLoop fixedLoop;
+    const auto startTime = std::chrono::steady_clock::now();
+    fixedLoop.Run(1); // Ignored.
+    const auto runTime = std::chrono::steady_clock::now() - startTime;
+    REQUIRE(runTime >= std::chrono::milliseconds(14));
+
+    // Phase hooks are called in order, stats are never collected.
+    REQUIRE(fixedLoop.m_phases == "0123123123" "4");
+    REQUIRE(fixedLoop.m_frameCompleteCount == 0);
+
+    // Basic stats are collected, without the average fps.
+    PolicyTestLoop<BasicStats> basicLoop;
+    basicLoop.Run(240);
+    REQUIRE(basicLoop.m_frameCompleteCount == 3);
+    REQUIRE(basicLoop.m_lastAverageFPS == 0);
+
+    // Full stats are collected by default.
+    PolicyTestLoop<> fullLoop;
+    fullLoop.SetTargetFPS(120);
+    fullLoop.Run(240);
+    REQUIRE(fullLoop.GetTargetFPS() == 240);
+    REQUIRE(fullLoop.m_frameCompleteCount == 3);
+    REQUIRE(fullLoop.m_lastAverageFPS > 0);
+}
+
+//--------------------------------------------------------------
+class ErrorPolicyTestLoop
+    : public Simple::StaticUpdateLoop<ErrorPolicyTestLoop,
+                                      Simple::LoopPolicy::ContainErrors>
+{
+public:
+    void UpdateFixed(float)
+    {
+        if (++m_frames % 2 == 0)
+        {
+            throw std::runtime_error("even frame");
+        }
+    }
+
+    void UpdateEnded(float)
+    {
+        ++m_endedCount;
+        if (m_frames >= 6)
+        {
+            RequestShutDown();
+        }
+    }
+
+    Simple::FrameErrorAction OnFrameError(const Simple::FrameError&)
+    {
+        return m_frames < 6 ? Simple::FrameErrorAction::SkipFrame
+                            : Simple::FrameErrorAction::ShutDown;
+    }
+
+    uint32_t m_frames = 0;
+    uint32_t m_endedCount = 0;
+};
+
+//--------------------------------------------------------------
+TEST_CASE("Test Static Update Loop Error Policy", "[static_update_loop][error]")
+{
+    // Errors propagate out of Run unless the policy contains them.
+    using namespace Simple::LoopPolicy;
+    static_assert(std::is_same<PolicyTestLoop<>::ErrorPolicy,
+                               PropagateErrors>::value,
+                  "Errors contained by default");
+
+    // Actions are returned by the derived class's OnFrameError.
+    ErrorPolicyTestLoop containLoop;
+    containLoop.SetErrorBackoff(std::chrono::milliseconds(0),
+                                std::chrono::milliseconds(0));
+    REQUIRE_NOTHROW(containLoop.Run(1000));
+    REQUIRE(containLoop.m_frames == 6);
+    REQUIRE(containLoop.m_endedCount == 3);
+    REQUIRE(containLoop.GetErrorCount(Simple::UpdatePhase::Fixed) == 3);
+}
+
+//--------------------------------------------------------------
+class BackoffTestLoop
+    : public Simple::StaticUpdateLoop<BackoffTestLoop,
+                                      Simple::LoopPolicy::ContainErrors>
+{
+public:
+    void UpdateFixed(float)
+    {
+        throw std::runtime_error("every frame");
+    }
+};
+
+//--------------------------------------------------------------
+TEST_CASE("Test Static Update Loop Error Backoff", "[static_update_loop][error]")
+{
+    // A shut down requested while waiting after consecutive errors
+    // is seen promptly, instead of once the whole backoff elapses.
+    BackoffTestLoop backoffLoop;
+    backoffLoop.SetFrameErrorAction(Simple::FrameErrorAction::Continue);
+    backoffLoop.SetErrorBackoff(std::chrono::milliseconds(1000),
+                                std::chrono::milliseconds(1000));
+    std::thread thread = backoffLoop.RunInThread(1000);
+    while (backoffLoop.GetErrorCount() < 2)
+    {
+        std::this_thread::yield();
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+
+    const auto startTime = std::chrono::steady_clock::now();
+    backoffLoop.RequestShutDown();
+    thread.join();
+    const auto joinTime = std::chrono::steady_clock::now() - startTime;
+    REQUIRE(joinTime < std::chrono::milliseconds(500));
+    REQUIRE(backoffLoop.GetErrorCount() == 2);
+}
+
+//--------------------------------------------------------------
+constexpr uint32_t BenchmarkFrames = 10000;
+
+//--------------------------------------------------------------
+class VirtualBenchmarkLoop : public Simple::Application
+{
+public:
+    uint64_t m_sum = 0;
+
+protected:
+    void StartUp() override { SetCappedFPS(false); m_frames = 0; }
+    void ShutDown() override {}
+    void UpdateStart(float) override { ++m_sum; }
+    void UpdateFixed(float) override { ++m_sum; }
+    void UpdateEnded(float) override
+    {
+        if (++m_frames == BenchmarkFrames)
+        {
+            RequestShutDown();
+        }
+    }
+
+private:
+    uint32_t m_frames = 0;
+};
+
+//--------------------------------------------------------------
+class StaticBenchmarkLoop
+    : public Simple::StaticUpdateLoop<StaticBenchmarkLoop>
+{
+public:
+    uint64_t m_sum = 0;
+
+    void StartUp() { SetCappedFPS(false); m_frames = 0; }
+    void UpdateStart(float) { ++m_sum; }
+    void UpdateFixed(float) { ++m_sum; }
+    void UpdateEnded(float)
+    {
+        if (++m_frames == BenchmarkFrames)
+        {
+            RequestShutDown();
+        }
+    }
+
+private:
+    uint32_t m_frames = 0;
+};
+
+//--------------------------------------------------------------
+class FixedBenchmarkLoop
+    : public Simple::StaticUpdateLoop<FixedBenchmarkLoop,
+          Simple::LoopPolicy::FixedRate<1000000, false>,
+          Simple::LoopPolicy::NoStats>
+{
+public:
+    uint64_t m_sum = 0;
+
+    void StartUp() { m_frames = 0; }
+    void UpdateStart(float) { ++m_sum; }
+    void UpdateFixed(float) { ++m_sum; }
+    void UpdateEnded(float)
+    {
+        if (++m_frames == BenchmarkFrames)
+        {
+            RequestShutDown();
+        }
+    }
+
+private:
+    uint32_t m_frames = 0;
+};
+
+//--------------------------------------------------------------
+TEST_CASE("Benchmark Static Update Loop", "[.][benchmark][static_update_loop]")
+{
+    // Uncapped at a high target rate so the loop runs flat out,
+    // measuring the dispatch overhead of each loop per frame.
+    BENCHMARK("Virtual UpdateLoop 10000 frames")
+    {
+        VirtualBenchmarkLoop loop;
+        loop.Run(1000000);
+        return loop.m_sum;
+    };
+
+    BENCHMARK("StaticUpdateLoop 10000 frames")
+    {
+        StaticBenchmarkLoop loop;
+        loop.Run(1000000);
+        return loop.m_sum;
+    };
+
+    // Fully specialized: constant durations, no stats, no atomics
+    // other than the shut down/restart requests checked per frame.
+    BENCHMARK("FixedRate NoStats StaticUpdateLoop 10000 frames")
+    {
+        FixedBenchmarkLoop loop;
+        loop.Run();
+        return loop.m_sum;
+    };
+}
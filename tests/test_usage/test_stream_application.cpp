@@ -0,0 +1,199 @@
+//--------------------------------------------------------------
+// Copyright (c) David Bosnich <david.bosnich.public@gmail.com>
+//
+// This code is licensed under the MIT License, a copy of which
+// can be found in the license.txt file included at the root of
+// this distribution, or at https://opensource.org/licenses/MIT
+//--------------------------------------------------------------
+
+#include <simple/application/stream_application.h>
+#include <catch2/catch.hpp>
+#include <string>
+
+#if SIMPLE_RECORD_STREAM_SUPPORTED
+
+//--------------------------------------------------------------
+class TestStreamApplication : public Simple::StreamApplication
+{
+public:
+    uint32_t m_recordsTotal = 0;
+    uint32_t m_recordsMax = 0;
+    uint64_t m_recordsSum = 0;
+    uint32_t m_batchCount = 0;
+    uint32_t m_spinMicrosPerRecord = 0;
+    StreamStats m_lastStats;
+
+protected:
+    void StartUp() override {}
+    void ShutDown() override {}
+
+    void UpdateStart(float) override {}
+    void UpdateEnded(float) override {}
+
+    void UpdateBatch(const Simple::StreamBatch& a_batch,
+                     float a_fixedTimeSeconds) override
+    {
+        REQUIRE(a_fixedTimeSeconds > 0.0f);
+        REQUIRE(a_batch.recordCount > 0);
+        REQUIRE(a_batch.recordCount <= GetBatchRecordLimit());
+
+        for (uint32_t i = 0; i < a_batch.recordCount; ++i)
+        {
+            size_t size = 0;
+            const char* record = a_batch.GetRecord(i, size);
+            const std::string value(record, size);
+            REQUIRE(value == std::to_string(m_recordsTotal));
+            m_recordsSum += std::stoul(value);
+            ++m_recordsTotal;
+        }
+        m_recordsMax = std::max(m_recordsMax, a_batch.recordCount);
+        ++m_batchCount;
+
+        // Simulate processing cost proportional to batch size.
+        const TimePoint spinStart = Clock::now();
+        const Duration spinFor = std::chrono::microseconds(
+            m_spinMicrosPerRecord * a_batch.recordCount);
+        while ((Clock::now() - spinStart) < spinFor);
+    }
+
+    void OnStreamComplete(const StreamStats& a_stats) override
+    {
+        REQUIRE(a_stats.totalRecords >= m_lastStats.totalRecords);
+        REQUIRE(a_stats.totalBytes >= a_stats.batchBytes);
+        m_lastStats = a_stats;
+    }
+};
+
+//--------------------------------------------------------------
+inline std::string MakeRecords(uint32_t a_count)
+{
+    std::string records;
+    for (uint32_t i = 0; i < a_count; ++i)
+    {
+        records += std::to_string(i);
+        records += '\n';
+    }
+    return records;
+}
+
+//--------------------------------------------------------------
+inline std::string WriteTempFile(const std::string& a_contents)
+{
+    char path[] = "/tmp/simple_stream_XXXXXX";
+    const int fd = mkstemp(path);
+    REQUIRE(fd >= 0);
+    REQUIRE(write(fd, a_contents.data(), a_contents.size()) ==
+            (ssize_t)a_contents.size());
+    close(fd);
+    return path;
+}
+
+//--------------------------------------------------------------
+TEST_CASE("Test Stream Mapped File", "[stream][mapped]")
+{
+    constexpr uint32_t numRecords = 1000;
+    const std::string records = MakeRecords(numRecords);
+    const std::string path = WriteTempFile(records);
+
+    TestStreamApplication application;
+    application.SetBatchLimits(64, 1024);
+    REQUIRE(application.GetStream().Open(path.c_str()));
+    REQUIRE(application.GetStream().IsMapped());
+    application.SetCappedFPS(false);
+    application.Run(1000);
+    unlink(path.c_str());
+
+    REQUIRE(application.GetStream().IsEnded());
+    REQUIRE(application.m_recordsTotal == numRecords);
+    REQUIRE(application.m_recordsMax <= 64);
+    REQUIRE(application.m_lastStats.totalRecords == numRecords);
+    REQUIRE(application.m_lastStats.totalBytes == records.size());
+    REQUIRE(application.m_lastStats.recordsPerSecond > 0);
+    REQUIRE(application.m_lastStats.bytesPerSecond > 0);
+}
+
+//--------------------------------------------------------------
+TEST_CASE("Test Stream Pipe", "[stream][pipe]")
+{
+    constexpr uint32_t numRecords = 500;
+    const std::string records = MakeRecords(numRecords) + "500";
+
+    int fds[2] = {};
+    REQUIRE(pipe(fds) == 0);
+    std::thread writeThread([&records, &fds]()
+    {
+        // Write in small pieces, splitting records across reads.
+        size_t written = 0;
+        while (written < records.size())
+        {
+            const size_t size = std::min<size_t>(7, records.size() -
+                                                    written);
+            REQUIRE(write(fds[1], records.data() + written, size) ==
+                    (ssize_t)size);
+            written += size;
+            std::this_thread::yield();
+        }
+        close(fds[1]);
+    });
+
+    TestStreamApplication application;
+    application.SetBatchLimits(32, 128);
+    REQUIRE(application.GetStream().Open(fds[0]));
+    REQUIRE(!application.GetStream().IsMapped());
+    application.Run(1000);
+    writeThread.join();
+    close(fds[0]);
+
+    // The last record had no delimiter, but was still delivered.
+    REQUIRE(application.m_recordsTotal == numRecords + 1);
+    REQUIRE(application.m_recordsMax <= 32);
+    REQUIRE(application.m_lastStats.totalBytes == records.size());
+}
+
+//--------------------------------------------------------------
+TEST_CASE("Test Stream Fixed Size", "[stream][fixed_size]")
+{
+    const std::string path = WriteTempFile("0001020304050607080");
+
+    Simple::RecordStream stream;
+    stream.SetRecordSize(2);
+    REQUIRE(stream.Open(path.c_str()));
+    unlink(path.c_str());
+
+    Simple::StreamBatch batch;
+    REQUIRE(stream.Pull(4, batch));
+    REQUIRE(batch.recordCount == 4);
+    size_t size = 0;
+    const char* record = batch.GetRecord(3, size);
+    REQUIRE(std::string(record, size) == "03");
+    REQUIRE(stream.Pull(100, batch));
+    REQUIRE(batch.recordCount == 6);
+    record = batch.GetRecord(5, size);
+    REQUIRE(std::string(record, size) == "0");
+    REQUIRE(stream.IsEnded());
+    REQUIRE(!stream.Pull(100, batch));
+    REQUIRE(batch.recordCount == 0);
+}
+
+//--------------------------------------------------------------
+TEST_CASE("Test Stream Adaptive", "[stream][adaptive]")
+{
+    constexpr uint32_t numRecords = 3000;
+    const std::string path = WriteTempFile(MakeRecords(numRecords));
+
+    // Each record costs ~50us, so ~2ms batches hold ~40 records.
+    TestStreamApplication application;
+    application.m_spinMicrosPerRecord = 50;
+    application.SetBatchLimits(1000, 64 * 1024);
+    application.SetTargetBatchDuration(std::chrono::milliseconds(2));
+    REQUIRE(application.GetStream().Open(path.c_str()));
+    application.SetCappedFPS(false);
+    application.Run(1000);
+    unlink(path.c_str());
+
+    REQUIRE(application.m_recordsTotal == numRecords);
+    REQUIRE(application.GetBatchRecordLimit() < 1000);
+    REQUIRE(application.GetBatchRecordLimit() > 4);
+}
+
+#endif//SIMPLE_RECORD_STREAM_SUPPORTED
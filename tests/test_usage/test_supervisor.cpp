@@ -0,0 +1,163 @@
+//--------------------------------------------------------------
+// Copyright (c) David Bosnich <david.bosnich.public@gmail.com>
+//
+// This code is licensed under the MIT License, a copy of which
+// can be found in the license.txt file included at the root of
+// this distribution, or at https://opensource.org/licenses/MIT
+//--------------------------------------------------------------
+
+#include <simple/application/application.h>
+#include <simple/application/supervisor.h>
+#include <catch2/catch.hpp>
+
+#include <stdexcept>
+
+#if SIMPLE_SUPERVISOR_SUPPORTED
+//--------------------------------------------------------------
+// Crashes (in the child) when the fixed count reaches a given value,
+// unless it has been restored, and shuts down when it reaches another.
+// Crashes either by being killed, or by throwing an error from Run.
+//--------------------------------------------------------------
+class SupervisedTestApplication : public Simple::Application
+{
+public:
+    struct State
+    {
+        uint32_t fixedCount = 0;
+        uint32_t restoreCount = 0;
+    };
+
+    SupervisedTestApplication(uint32_t a_crashAt,
+                              uint32_t a_shutDownAt,
+                              bool a_throw = false)
+        : m_supervisor(*this)
+        , m_crashAt(a_crashAt)
+        , m_shutDownAt(a_shutDownAt)
+        , m_throw(a_throw)
+    {
+        m_supervisor.SetSaveFunc([this](void* o_buffer, size_t a_capacity)
+        {
+            if (a_capacity >= sizeof(State))
+            {
+                memcpy(o_buffer, &m_state, sizeof(State));
+            }
+            return sizeof(State);
+        });
+        m_supervisor.SetRestoreFunc([this](const void* a_buffer,
+                                           size_t a_size, uint64_t)
+        {
+            if (a_size == sizeof(State))
+            {
+                memcpy(&m_state, a_buffer, sizeof(State));
+                ++m_state.restoreCount;
+            }
+        });
+    }
+
+    Simple::Supervisor m_supervisor;
+    State m_state;
+
+protected:
+    void StartUp() override { m_state = State(); }
+    void ShutDown() override {}
+    void UpdateStart(float) override {}
+    void UpdateFixed(float) override
+    {
+        ++m_state.fixedCount;
+        if (m_state.fixedCount == m_crashAt && m_state.restoreCount == 0)
+        {
+            if (m_throw)
+            {
+                throw std::runtime_error("test crash");
+            }
+            raise(SIGKILL);
+        }
+        if (m_state.fixedCount >= m_shutDownAt)
+        {
+            RequestShutDown();
+        }
+    }
+    void UpdateEnded(float) override {}
+
+private:
+    const uint32_t m_crashAt;
+    const uint32_t m_shutDownAt;
+    const bool m_throw;
+};
+
+//--------------------------------------------------------------
+TEST_CASE("Test Supervisor Recovery", "[supervisor][recovery]")
+{
+    SupervisedTestApplication application(25, 50);
+    Simple::Supervisor& supervisor = application.m_supervisor;
+    supervisor.SetCheckpointInterval(10);
+    REQUIRE(supervisor.Run(1000) == 0);
+    REQUIRE_FALSE(supervisor.IsChild());
+
+    // The replacement resumed from the last checkpoint (of frame 20)
+    // before the crash, and handed its final state to the parent.
+    SupervisedTestApplication::State state;
+    uint64_t frameIndex = 0;
+    REQUIRE(supervisor.GetCheckpoint(&state, sizeof(state), &frameIndex) ==
+            sizeof(state));
+    REQUIRE(state.fixedCount == 50);
+    REQUIRE(state.restoreCount == 1);
+    REQUIRE(frameIndex >= 50);
+    REQUIRE(application.m_state.fixedCount == 0);
+
+    const Simple::Supervisor::Stats stats = supervisor.GetStats();
+    REQUIRE(stats.crashCount == 1);
+    REQUIRE(stats.restartCount == 1);
+    REQUIRE(stats.lastSignal == SIGKILL);
+    REQUIRE(stats.checkpointCount >= 5);
+    REQUIRE(stats.lastRecovery > Simple::Supervisor::Clock::duration::zero());
+    REQUIRE(stats.lastRecovery < std::chrono::seconds(1));
+    REQUIRE(stats.maxRecovery == stats.lastRecovery);
+}
+
+//--------------------------------------------------------------
+TEST_CASE("Test Supervisor Error", "[supervisor][error]")
+{
+    // Errors rethrown from the loop never unwind out of the child,
+    // which exits as if it crashed, so it is restored and restarted.
+    SupervisedTestApplication application(25, 50, true);
+    Simple::Supervisor& supervisor = application.m_supervisor;
+    supervisor.SetCheckpointInterval(10);
+    REQUIRE(supervisor.Run(1000) == 0);
+    REQUIRE_FALSE(supervisor.IsChild());
+
+    SupervisedTestApplication::State state;
+    REQUIRE(supervisor.GetCheckpoint(&state, sizeof(state)) ==
+            sizeof(state));
+    REQUIRE(state.fixedCount == 50);
+    REQUIRE(state.restoreCount == 1);
+
+    const Simple::Supervisor::Stats stats = supervisor.GetStats();
+    REQUIRE(stats.crashCount == 1);
+    REQUIRE(stats.restartCount == 1);
+    REQUIRE(stats.lastSignal == 0);
+}
+
+//--------------------------------------------------------------
+TEST_CASE("Test Supervisor Give Up", "[supervisor][give_up]")
+{
+    // Without a restore function, each replacement crashes again.
+    SupervisedTestApplication application(3, 50);
+    Simple::Supervisor& supervisor = application.m_supervisor;
+    supervisor.SetRestoreFunc(nullptr);
+    supervisor.SetCheckpointInterval(1);
+    supervisor.SetMaxRestarts(2);
+    REQUIRE(supervisor.Run(1000) == 128 + SIGKILL);
+
+    const Simple::Supervisor::Stats stats = supervisor.GetStats();
+    REQUIRE(stats.crashCount == 3);
+    REQUIRE(stats.restartCount == 2);
+    REQUIRE(stats.maxRecovery >= stats.lastRecovery);
+
+    SupervisedTestApplication::State state;
+    REQUIRE(supervisor.GetCheckpoint(&state, sizeof(state)) ==
+            sizeof(state));
+    REQUIRE(state.fixedCount == 2);
+    REQUIRE(state.restoreCount == 0);
+}
+#endif//SIMPLE_SUPERVISOR_SUPPORTED
@@ -0,0 +1,368 @@
+//--------------------------------------------------------------
+// Copyright (c) David Bosnich <david.bosnich.public@gmail.com>
+//
+// This code is licensed under the MIT License, a copy of which
+// can be found in the license.txt file included at the root of
+// this distribution, or at https://opensource.org/licenses/MIT
+//--------------------------------------------------------------
+
+#include <simple/application/application.h>
+#include <simple/application/system_registry.h>
+#include <catch2/catch.hpp>
+
+#include <stdexcept>
+
+using Simple::SystemRegistry;
+using Simple::UpdatePhase;
+
+//--------------------------------------------------------------
+TEST_CASE("Test System Registry Graph", "[system_registry][graph]")
+{
+    SystemRegistry registry;
+    const auto input = registry.AddResource("input");
+    const auto bodies = registry.AddResource("bodies");
+    const auto audio = registry.AddResource("audio");
+
+    auto nop = [](float) {};
+    const auto read = registry.AddSystem("read", UpdatePhase::Fixed,
+                                         {}, { input }, nop);
+    const auto move = registry.AddSystem("move", UpdatePhase::Fixed,
+                                         { input }, { bodies }, nop);
+    const auto sound = registry.AddSystem("sound", UpdatePhase::Fixed,
+                                          { input }, { audio }, nop);
+    const auto draw = registry.AddSystem("draw", UpdatePhase::Ended,
+                                         { bodies }, {}, nop);
+    const auto mix = registry.AddSystem("mix", UpdatePhase::Fixed,
+                                        { audio }, { audio }, nop);
+
+    using Ids = std::vector<SystemRegistry::SystemId>;
+    REQUIRE(registry.GetDependencies(read).empty());
+    REQUIRE(registry.GetDependencies(move) == Ids{ read });
+    REQUIRE(registry.GetDependencies(sound) == Ids{ read });
+    REQUIRE(registry.GetDependencies(mix) == Ids{ sound });
+
+    // Systems in different phases never depend on each other.
+    REQUIRE(registry.GetDependencies(draw).empty());
+    REQUIRE(registry.GetSystemCount() == 5);
+    REQUIRE(std::string(registry.GetSystemName(mix)) == "mix");
+    REQUIRE(std::string(registry.GetResourceName(audio)) == "audio");
+
+    // Invalid phases and resources are rejected.
+    const auto invalid = SystemRegistry::SystemId(SystemRegistry::InvalidId);
+    REQUIRE(registry.AddSystem("a", UpdatePhase::StartUp,
+                               {}, {}, nop) == invalid);
+    REQUIRE(registry.AddSystem("b", UpdatePhase::Fixed,
+                               { 7 }, {}, nop) == invalid);
+    REQUIRE(registry.GetSystemCount() == 5);
+}
+
+//--------------------------------------------------------------
+TEST_CASE("Test System Registry Parallel", "[system_registry][parallel]")
+{
+    Simple::WorkerPool workerPool(4);
+    SystemRegistry registry(&workerPool);
+    const auto shared = registry.AddResource("shared");
+
+    // Independent systems overlap, while a writer of the shared
+    // resource must wait for every reader registered before it.
+    std::atomic<uint32_t> active = { 0 };
+    std::atomic<uint32_t> maxActive = { 0 };
+    std::atomic<uint32_t> readsDone = { 0 };
+    std::atomic<uint32_t> failedCount = { 0 };
+    auto reader = [&](float)
+    {
+        const uint32_t nowActive = ++active;
+        uint32_t expected = maxActive;
+        while (nowActive > expected &&
+               !maxActive.compare_exchange_weak(expected, nowActive)) {}
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        ++readsDone;
+        --active;
+    };
+    for (uint32_t i = 0; i < 4; ++i)
+    {
+        registry.AddSystem("reader", UpdatePhase::Fixed,
+                           { shared }, {}, reader);
+    }
+    const auto writer = registry.AddSystem("writer", UpdatePhase::Fixed,
+                                           {}, { shared },
+                                           [&](float)
+    {
+        failedCount += (readsDone != 4 || active != 0);
+    });
+
+    registry.Update(UpdatePhase::Fixed, 1.0f / 60.0f);
+    REQUIRE(failedCount == 0);
+    REQUIRE(readsDone == 4);
+    REQUIRE(maxActive > 1);
+
+    const SystemRegistry::PhaseStats& stats =
+        registry.GetPhaseStats(UpdatePhase::Fixed);
+    REQUIRE(stats.updateCount == 1);
+    REQUIRE(stats.systemCount == 5);
+    REQUIRE(stats.workDur >= stats.criticalDur);
+    REQUIRE(registry.GetSystemStats(writer).runCount == 1);
+    REQUIRE(registry.GetSystemStats(writer).onCriticalPath);
+    REQUIRE(registry.GetCriticalPath(UpdatePhase::Fixed).size() == 2);
+    REQUIRE(registry.GetCriticalPath(UpdatePhase::Fixed).back() == writer);
+}
+
+//--------------------------------------------------------------
+TEST_CASE("Test System Registry Exception", "[system_registry][exception]")
+{
+    Simple::WorkerPool workerPool(4);
+    SystemRegistry registry(&workerPool);
+    const auto shared = registry.AddResource("shared");
+
+    // A throwing system stops its dependents from running, but the
+    // update still completes and rethrows on the calling thread.
+    std::atomic<bool> fail = { true };
+    std::atomic<uint32_t> readCount = { 0 };
+    std::atomic<uint32_t> writeCount = { 0 };
+    auto reader = [&](float)
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        ++readCount;
+    };
+    registry.AddSystem("reader", UpdatePhase::Fixed, { shared }, {}, reader);
+    registry.AddSystem("thrower", UpdatePhase::Fixed, { shared }, {},
+                       [&](float)
+    {
+        if (fail)
+        {
+            throw std::runtime_error("system");
+        }
+    });
+    registry.AddSystem("reader", UpdatePhase::Fixed, { shared }, {}, reader);
+    registry.AddSystem("writer", UpdatePhase::Fixed, {}, { shared },
+                       [&](float) { ++writeCount; });
+
+    REQUIRE_THROWS_WITH(registry.Update(UpdatePhase::Fixed, 1.0f), "system");
+    REQUIRE(writeCount == 0);
+
+    // And the registry and pool can be updated again afterwards.
+    fail = false;
+    registry.Update(UpdatePhase::Fixed, 1.0f);
+    REQUIRE(writeCount == 1);
+    REQUIRE(readCount >= 2);
+}
+
+//--------------------------------------------------------------
+TEST_CASE("Test System Registry Critical Path", "[system_registry][critical]")
+{
+    Simple::WorkerPool workerPool(2);
+    SystemRegistry registry(&workerPool);
+    const auto a = registry.AddResource("a");
+    const auto b = registry.AddResource("b");
+
+    auto sleepFor = [](uint32_t a_ms)
+    {
+        return [a_ms](float)
+        {
+            std::this_thread::sleep_for(std::chrono::milliseconds(a_ms));
+        };
+    };
+    const auto slow = registry.AddSystem("slow", UpdatePhase::Start,
+                                         {}, { a }, sleepFor(20));
+    const auto fast = registry.AddSystem("fast", UpdatePhase::Start,
+                                         {}, { b }, sleepFor(1));
+    const auto next = registry.AddSystem("next", UpdatePhase::Start,
+                                         { a }, {}, sleepFor(5));
+    registry.Update(UpdatePhase::Start, 0.0f);
+
+    using Ids = std::vector<SystemRegistry::SystemId>;
+    REQUIRE(registry.GetCriticalPath(UpdatePhase::Start) == Ids{ slow, next });
+    REQUIRE(registry.GetSystemStats(slow).onCriticalPath);
+    REQUIRE(!registry.GetSystemStats(fast).onCriticalPath);
+    REQUIRE(registry.GetSystemStats(next).lastStart >=
+            registry.GetSystemStats(slow).lastDur);
+
+    const SystemRegistry::PhaseStats& stats =
+        registry.GetPhaseStats(UpdatePhase::Start);
+    REQUIRE(stats.criticalDur >= std::chrono::milliseconds(25));
+    REQUIRE(stats.wallDur >= stats.criticalDur);
+}
+
+//--------------------------------------------------------------
+class SystemApplication : public Simple::Application
+{
+public:
+    SystemApplication(SystemRegistry& a_registry, uint32_t a_frames)
+        : m_registry(a_registry), m_numFrames(a_frames) {}
+
+protected:
+    void StartUp() override {}
+    void ShutDown() override {}
+
+    void UpdateStart(float a_deltaTimeSeconds) override
+    {
+        m_registry.Update(UpdatePhase::Start, a_deltaTimeSeconds);
+    }
+
+    void UpdateFixed(float a_fixedTimeSeconds) override
+    {
+        m_registry.Update(UpdatePhase::Fixed, a_fixedTimeSeconds);
+    }
+
+    void UpdateEnded(float a_deltaTimeSeconds) override
+    {
+        m_registry.Update(UpdatePhase::Ended, a_deltaTimeSeconds);
+        if (++m_frame == m_numFrames)
+        {
+            RequestShutDown();
+        }
+    }
+
+private:
+    SystemRegistry& m_registry;
+    const uint32_t m_numFrames;
+    uint32_t m_frame = 0;
+};
+
+//--------------------------------------------------------------
+TEST_CASE("Test System Registry Application", "[system_registry][application]")
+{
+    SystemRegistry registry;
+    const auto state = registry.AddResource("state");
+
+    std::vector<char> order;
+    registry.AddSystem("start", UpdatePhase::Start, {}, { state },
+                       [&order](float) { order.push_back('s'); });
+    registry.AddSystem("fixed", UpdatePhase::Fixed, {}, { state },
+                       [&order](float a_seconds)
+    {
+        REQUIRE(a_seconds == Approx(1.0f / 240.0f));
+        order.push_back('f');
+    });
+    registry.AddSystem("ended", UpdatePhase::Ended, { state }, {},
+                       [&order](float) { order.push_back('e'); });
+
+    SystemApplication application(registry, 3);
+    application.Run(240);
+
+    const std::vector<char> expected = { 's', 'f', 'e',
+                                         's', 'f', 'e',
+                                         's', 'f', 'e' };
+    REQUIRE(order == expected);
+    REQUIRE(registry.GetPhaseStats(UpdatePhase::Ended).updateCount == 3);
+}
+
+//--------------------------------------------------------------
+TEST_CASE("Test System Registry Loop Error", "[system_registry][error]")
+{
+    // Errors thrown from systems running on worker threads are also
+    // contained by the loop, which keeps running the later frames.
+    Simple::WorkerPool workerPool(4);
+    SystemRegistry registry(&workerPool);
+    const auto state = registry.AddResource("state");
+
+    std::atomic<uint32_t> fixedCount = { 0 };
+    std::atomic<uint32_t> readCount = { 0 };
+    registry.AddSystem("fixed", UpdatePhase::Fixed, {}, {},
+                       [&fixedCount](float)
+    {
+        if (++fixedCount % 2 == 0)
+        {
+            throw std::runtime_error("system error");
+        }
+    });
+    for (uint32_t i = 0; i < 3; ++i)
+    {
+        registry.AddSystem("read", UpdatePhase::Fixed, { state }, {},
+                           [&readCount](float) { ++readCount; });
+    }
+
+    SystemApplication application(registry, 10);
+    application.SetFrameErrorAction(Simple::FrameErrorAction::SkipFrame);
+    application.SetErrorBackoff(std::chrono::milliseconds(0),
+                                std::chrono::milliseconds(0));
+    REQUIRE_NOTHROW(application.Run(1000));
+    REQUIRE(application.GetErrorCount(UpdatePhase::Fixed) > 0);
+    REQUIRE(application.GetErrorCount(UpdatePhase::Fixed) ==
+            fixedCount / 2);
+    REQUIRE(registry.GetPhaseStats(UpdatePhase::Ended).updateCount == 10);
+}
+
+//--------------------------------------------------------------
+TEST_CASE("Test System Registry Skip Unchanged", "[system_registry][skip]")
+{
+    SystemRegistry registry;
+    const auto input = registry.AddResource("input");
+    const auto output = registry.AddResource("output");
+
+    bool changeInput = false;
+    uint32_t produced = 0;
+    uint32_t consumed = 0;
+    registry.AddSystem("produce", UpdatePhase::Fixed, {}, { input },
+                       [&](float)
+    {
+        if (changeInput)
+        {
+            ++produced;
+            registry.MarkChanged(input);
+        }
+    });
+    const auto consume = registry.AddSystem("consume",
+                                            UpdatePhase::Fixed,
+                                            { input }, { output },
+                                            [&](float)
+    {
+        ++consumed;
+    });
+    registry.SetSkipWhenUnchanged(consume, true);
+
+    // Always runs the first time, then only after input changes.
+    for (uint32_t i = 0; i < 10; ++i)
+    {
+        changeInput = (i % 5 == 4);
+        registry.Update(UpdatePhase::Fixed, 0.0f);
+    }
+    REQUIRE(produced == 2);
+    REQUIRE(consumed == 3);
+    REQUIRE(registry.GetVersion(input) == 2);
+    REQUIRE(registry.GetVersion(output) == 0);
+
+    const SystemRegistry::SystemStats& stats =
+        registry.GetSystemStats(consume);
+    REQUIRE(stats.runCount == 3);
+    REQUIRE(stats.skipCount == 7);
+    REQUIRE(stats.skipRate == Approx(0.7f));
+
+    const SystemRegistry::PhaseStats& phaseStats =
+        registry.GetPhaseStats(UpdatePhase::Fixed);
+    REQUIRE(phaseStats.skipCount == 0);
+    REQUIRE(phaseStats.totalRunCount == 13);
+    REQUIRE(phaseStats.totalSkipCount == 7);
+    REQUIRE(phaseStats.skipRate == Approx(0.35f));
+}
+
+//--------------------------------------------------------------
+TEST_CASE("Test System Registry Verify Skips", "[system_registry][verify]")
+{
+    SystemRegistry registry;
+    REQUIRE(!registry.GetVerifySkips());
+    registry.SetVerifySkips(true);
+
+    const auto input = registry.AddResource("input");
+    const auto output = registry.AddResource("output");
+
+    // This system wrongly changes its output without any input.
+    uint32_t calls = 0;
+    const auto bad = registry.AddSystem("bad", UpdatePhase::Fixed,
+                                        { input }, { output },
+                                        [&](float)
+    {
+        ++calls;
+        registry.MarkChanged(output);
+    });
+    registry.SetSkipWhenUnchanged(bad, true);
+
+    for (uint32_t i = 0; i < 3; ++i)
+    {
+        registry.Update(UpdatePhase::Fixed, 0.0f);
+    }
+    REQUIRE(calls == 3);
+    REQUIRE(registry.GetSystemStats(bad).runCount == 1);
+    REQUIRE(registry.GetSystemStats(bad).skipCount == 2);
+    REQUIRE(registry.GetSystemStats(bad).verifyFailCount == 2);
+}
@@ -0,0 +1,199 @@
+//--------------------------------------------------------------
+// Copyright (c) David Bosnich <david.bosnich.public@gmail.com>
+//
+// This code is licensed under the MIT License, a copy of which
+// can be found in the license.txt file included at the root of
+// this distribution, or at https://opensource.org/licenses/MIT
+//--------------------------------------------------------------
+
+#include <simple/application/application.h>
+#include <simple/application/watchdog.h>
+#include <catch2/catch.hpp>
+
+#include <fstream>
+#include <sstream>
+
+//--------------------------------------------------------------
+std::string ReadWatchdogFile(const std::string& a_path)
+{
+    std::ifstream file(a_path);
+    std::stringstream contents;
+    contents << file.rdbuf();
+    return contents.str();
+}
+
+//--------------------------------------------------------------
+class WatchdogTestApplication : public Simple::Application
+{
+public:
+    explicit WatchdogTestApplication(uint64_t a_hangFrame)
+        : m_watchdog(std::chrono::milliseconds(100),
+                     std::chrono::milliseconds(10))
+        , m_hangFrame(a_hangFrame)
+    {
+        m_watchdog.SetLivenessFile(m_livenessPath);
+        m_watchdog.SetHangFunc([this](const Simple::Watchdog::HangReport&
+                                      a_report)
+        {
+            std::lock_guard<std::mutex> lock(m_reportsMutex);
+            m_reports.push_back(a_report);
+        });
+        AddListener(&m_watchdog);
+    }
+
+    std::vector<Simple::Watchdog::HangReport> GetReports()
+    {
+        std::lock_guard<std::mutex> lock(m_reportsMutex);
+        return m_reports;
+    }
+
+    Simple::Watchdog m_watchdog;
+    const std::string m_livenessPath = "test_watchdog_liveness.txt";
+    const uint64_t m_hangFrame;
+    uint64_t m_frames = 0;
+    bool m_wasWatching = false;
+    std::string m_hungContents;
+    std::string m_aliveContents;
+
+protected:
+    void StartUp() override {}
+    void ShutDown() override {}
+
+    void UpdateStart(float) override
+    {
+        ++m_frames;
+        m_wasWatching = m_watchdog.IsWatching();
+    }
+
+    void UpdateFixed(float) override
+    {
+        if (m_frames != m_hangFrame || !m_hungContents.empty())
+        {
+            return;
+        }
+
+        // Hang (with a timeout) until the watchdog has reported it,
+        // then wait for the liveness file to be written again.
+        const auto timeout = std::chrono::steady_clock::now() +
+                             std::chrono::seconds(5);
+        while (m_watchdog.GetHangCount() == 0 &&
+               std::chrono::steady_clock::now() < timeout)
+        {
+            std::this_thread::sleep_for(std::chrono::milliseconds(5));
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        m_hungContents = ReadWatchdogFile(m_livenessPath);
+    }
+
+    void UpdateEnded(float) override
+    {
+        if (m_frames == m_hangFrame + 30)
+        {
+            m_aliveContents = ReadWatchdogFile(m_livenessPath);
+        }
+        if (m_frames == m_hangFrame + 40)
+        {
+            RequestShutDown();
+        }
+    }
+
+private:
+    std::mutex m_reportsMutex;
+    std::vector<Simple::Watchdog::HangReport> m_reports;
+};
+
+//--------------------------------------------------------------
+TEST_CASE("Test Watchdog Hang", "[watchdog][hang]")
+{
+    WatchdogTestApplication application(10);
+    application.Run(240);
+    REQUIRE(application.m_wasWatching);
+    REQUIRE_FALSE(application.m_watchdog.IsWatching());
+    REQUIRE_FALSE(application.m_watchdog.IsHung());
+    REQUIRE(application.m_watchdog.GetHangCount() == 1);
+
+    // Reported once, with the frame and phase it hung in.
+    const std::vector<Simple::Watchdog::HangReport> reports =
+        application.GetReports();
+    REQUIRE(reports.size() == 1);
+    REQUIRE(reports[0].frameIndex == 10);
+    REQUIRE(reports[0].phase == Simple::UpdatePhase::Fixed);
+    REQUIRE_FALSE(reports[0].phaseEnded);
+    REQUIRE(reports[0].stalledFor >= std::chrono::milliseconds(100));
+#ifdef SIMPLE_WATCHDOG_STACKS_SUPPORTED
+    REQUIRE_FALSE(reports[0].stack.empty());
+#endif
+
+    // The liveness file follows the state of the loop.
+    REQUIRE(application.m_hungContents.find("state hung") !=
+            std::string::npos);
+    REQUIRE(application.m_hungContents.find("frame 10\n") !=
+            std::string::npos);
+    REQUIRE(application.m_hungContents.find("phase Fixed") !=
+            std::string::npos);
+    REQUIRE(application.m_aliveContents.find("state alive") !=
+            std::string::npos);
+    REQUIRE(application.m_aliveContents.find("hangs 1") !=
+            std::string::npos);
+    const std::string stopped = ReadWatchdogFile(
+        application.m_livenessPath);
+    REQUIRE(stopped.find("state stopped") != std::string::npos);
+    std::remove(application.m_livenessPath.c_str());
+}
+
+//--------------------------------------------------------------
+TEST_CASE("Test Watchdog Healthy", "[watchdog][healthy]")
+{
+    // Never hangs, so nothing is reported.
+    WatchdogTestApplication application(0);
+    application.Run(240);
+    REQUIRE(application.m_frames == 40);
+    REQUIRE(application.m_watchdog.GetHangCount() == 0);
+    REQUIRE(application.GetReports().empty());
+    std::remove(application.m_livenessPath.c_str());
+}
+
+#ifdef SIMPLE_WATCHDOG_STACKS_SUPPORTED
+//--------------------------------------------------------------
+static std::atomic<uint32_t> s_previousStackSignalCount = { 0 };
+static void OnPreviousStackSignal(int)
+{
+    ++s_previousStackSignalCount;
+}
+
+//--------------------------------------------------------------
+TEST_CASE("Test Watchdog Stack Timeout", "[watchdog][stack]")
+{
+    // The loop thread blocks the signal, so capturing its stack times
+    // out, after which the previous action is restored (and the signal
+    // left pending is discarded, rather than delivered to it later).
+    struct sigaction action = {};
+    struct sigaction original = {};
+    action.sa_handler = &OnPreviousStackSignal;
+    sigemptyset(&action.sa_mask);
+    REQUIRE(sigaction(DEFAULT_WATCHDOG_STACK_SIGNAL, &action,
+                      &original) == 0);
+    sigset_t signals;
+    sigset_t originalMask;
+    sigemptyset(&signals);
+    sigaddset(&signals, DEFAULT_WATCHDOG_STACK_SIGNAL);
+    pthread_sigmask(SIG_BLOCK, &signals, &originalMask);
+
+    WatchdogTestApplication application(10);
+    application.Run(240);
+    const std::vector<Simple::Watchdog::HangReport> reports =
+        application.GetReports();
+    REQUIRE(reports.size() == 1);
+    REQUIRE(reports[0].stack.empty());
+
+    struct sigaction current = {};
+    REQUIRE(sigaction(DEFAULT_WATCHDOG_STACK_SIGNAL, nullptr,
+                      &current) == 0);
+    REQUIRE(current.sa_handler == &OnPreviousStackSignal);
+    pthread_sigmask(SIG_SETMASK, &originalMask, nullptr);
+    REQUIRE(s_previousStackSignalCount == 0);
+
+    sigaction(DEFAULT_WATCHDOG_STACK_SIGNAL, &original, nullptr);
+    std::remove(application.m_livenessPath.c_str());
+}
+#endif//SIMPLE_WATCHDOG_STACKS_SUPPORTED
@@ -0,0 +1,170 @@
+//--------------------------------------------------------------
+// Copyright (c) David Bosnich <david.bosnich.public@gmail.com>
+//
+// This code is licensed under the MIT License, a copy of which
+// can be found in the license.txt file included at the root of
+// this distribution, or at https://opensource.org/licenses/MIT
+//--------------------------------------------------------------
+
+#include <simple/application/worker_pool.h>
+#include <catch2/catch.hpp>
+
+#include <stdexcept>
+#include <string>
+
+//--------------------------------------------------------------
+TEST_CASE("Test Worker Pool Parallel For", "[worker_pool][parallel_for]")
+{
+    Simple::WorkerPool workerPool(4);
+    REQUIRE(workerPool.GetThreadCount() == 4);
+    REQUIRE(Simple::WorkerPool::GetThreadIndex() == 0);
+
+    constexpr uint32_t count = 1000;
+    std::vector<uint32_t> calls(count, 0);
+    std::atomic<uint32_t> badIndexCount = { 0 };
+    for (uint32_t repeat = 0; repeat < 10; ++repeat)
+    {
+        workerPool.ParallelFor(count, [&](uint32_t a_index)
+        {
+            const uint32_t threadIndex =
+                Simple::WorkerPool::GetThreadIndex();
+            badIndexCount += (threadIndex >= 4);
+            ++calls[a_index];
+        });
+    }
+    REQUIRE(badIndexCount == 0);
+    for (uint32_t i = 0; i < count; ++i)
+    {
+        REQUIRE(calls[i] == 10);
+    }
+}
+
+//--------------------------------------------------------------
+TEST_CASE("Test Worker Pool Single Thread", "[worker_pool][single]")
+{
+    Simple::WorkerPool workerPool(1);
+    REQUIRE(workerPool.GetThreadCount() == 1);
+
+    uint32_t sum = 0;
+    workerPool.ParallelFor(10, [&sum](uint32_t a_index)
+    {
+        sum += a_index;
+    });
+    REQUIRE(sum == 45);
+}
+
+//--------------------------------------------------------------
+TEST_CASE("Test Worker Pool Nested", "[worker_pool][nested]")
+{
+    // Nested calls (eg. from systems) run on the calling thread.
+    Simple::WorkerPool workerPool(4);
+    std::atomic<uint32_t> count = { 0 };
+    workerPool.ParallelFor(8, [&](uint32_t)
+    {
+        workerPool.ParallelFor(8, [&count](uint32_t)
+        {
+            ++count;
+        });
+    });
+    REQUIRE(count == 64);
+}
+
+//--------------------------------------------------------------
+TEST_CASE("Test Worker Pool Exception", "[worker_pool][exception]")
+{
+    // Exceptions thrown on any thread are rethrown on the caller,
+    // after every index has been called, leaving the pool reusable.
+    Simple::WorkerPool workerPool(4);
+    std::atomic<uint32_t> count = { 0 };
+    for (uint32_t repeat = 0; repeat < 10; ++repeat)
+    {
+        REQUIRE_THROWS_WITH(workerPool.ParallelFor(100, [&](uint32_t a_index)
+        {
+            ++count;
+            if (a_index % 10 == repeat)
+            {
+                throw std::runtime_error("index");
+            }
+        }), "index");
+    }
+    REQUIRE(count == 1000);
+
+    uint32_t sum = 0;
+    std::mutex mutex;
+    workerPool.ParallelFor(10, [&](uint32_t a_index)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        sum += a_index;
+    });
+    REQUIRE(sum == 45);
+}
+
+//--------------------------------------------------------------
+TEST_CASE("Test Worker Pool Nested Exception", "[worker_pool][exception]")
+{
+    // Nested calls (run on the calling thread), and calls with only
+    // one thread, also make the remaining calls before rethrowing.
+    Simple::WorkerPool workerPool(4);
+    std::atomic<uint32_t> count = { 0 };
+    std::atomic<uint32_t> caught = { 0 };
+    workerPool.ParallelFor(8, [&](uint32_t)
+    {
+        try
+        {
+            workerPool.ParallelFor(8, [&count](uint32_t a_index)
+            {
+                ++count;
+                if (a_index == 0)
+                {
+                    throw std::runtime_error("nested");
+                }
+            });
+        }
+        catch (const std::runtime_error&)
+        {
+            ++caught;
+        }
+    });
+    REQUIRE(count == 64);
+    REQUIRE(caught == 8);
+
+    Simple::WorkerPool singlePool(1);
+    uint32_t singleCount = 0;
+    REQUIRE_THROWS_WITH(singlePool.ParallelFor(10, [&](uint32_t a_index)
+    {
+        ++singleCount;
+        if (a_index % 3 == 0)
+        {
+            throw std::runtime_error(std::to_string(a_index));
+        }
+    }), "0");
+    REQUIRE(singleCount == 10);
+}
+
+//--------------------------------------------------------------
+TEST_CASE("Test Worker Pool Back To Back", "[worker_pool][back_to_back]")
+{
+    // Workers that wake late must never run a job that has already
+    // returned, so each short-lived function (and the state it owns)
+    // is only ever called with its own indices, while it is alive.
+    Simple::WorkerPool workerPool(4);
+    std::atomic<uint32_t> staleCount = { 0 };
+    for (uint32_t repeat = 0; repeat < 20000; ++repeat)
+    {
+        const uint32_t count = 2 + (repeat % 3);
+        std::vector<uint32_t> calls(count, 0);
+        std::atomic_bool alive = { true };
+        workerPool.ParallelFor(count, [&, repeat](uint32_t a_index)
+        {
+            staleCount += !alive.load() || (a_index >= count) ||
+                          (calls.size() != 2 + (repeat % 3));
+            ++calls[a_index % calls.size()];
+        });
+        alive = false;
+        for (uint32_t i = 0; i < count; ++i)
+        {
+            REQUIRE(calls[i] == 1);
+        }
+    }
+    REQUIRE(staleCount == 0);
+}
@@ -0,0 +1,282 @@
+//--------------------------------------------------------------
+// Copyright (c) David Bosnich <david.bosnich.public@gmail.com>
+//
+// This code is licensed under the MIT License, a copy of which
+// can be found in the license.txt file included at the root of
+// this distribution, or at https://opensource.org/licenses/MIT
+//--------------------------------------------------------------
+
+#include <simple/application/application.h>
+#include <simple/application/integration_kernels.h>
+#include <simple/application/world_batch.h>
+#include <catch2/catch.hpp>
+
+#include <cstdio>
+#include <stdexcept>
+
+//--------------------------------------------------------------
+// State of each match (one instance), one float per array so the
+// integration kernels can step the arrays of many matches at once.
+struct BallPosition { float value; };
+struct BallVelocity { float value; };
+struct BallTarget { float value; };
+struct MatchTimer { float seconds; };
+struct MatchEnded { uint8_t value; };
+
+using Matches = Simple::WorldBatch<BallPosition, BallVelocity,
+                                   BallTarget, MatchTimer, MatchEnded>;
+
+//--------------------------------------------------------------
+void AddMatchSteps(Matches& a_matches)
+{
+    a_matches.AddStep<BallPosition, BallVelocity, BallTarget>(
+        [](float a_dt, uint32_t a_count, BallPosition* a_position,
+           BallVelocity* a_velocity, BallTarget* a_target)
+    {
+        Simple::Kernels::DampedSpring((float*)a_position,
+                                      (float*)a_velocity,
+                                      (const float*)a_target,
+                                      a_count, 20.0f, 2.0f, a_dt);
+    });
+    a_matches.AddStep<MatchTimer, MatchEnded>(
+        [](float a_dt, uint32_t a_count, MatchTimer* a_timer,
+           MatchEnded* a_ended)
+    {
+        Simple::Kernels::CountdownTimers((float*)a_timer,
+                                         (uint8_t*)a_ended,
+                                         a_count, a_dt);
+    });
+}
+
+//--------------------------------------------------------------
+Matches::Instance AddMatch(Matches& a_matches, float a_seconds)
+{
+    const Matches::Instance match = a_matches.Add();
+    a_matches.Get<BallTarget>(match)->value = 1.0f;
+    a_matches.Get<MatchTimer>(match)->seconds = a_seconds;
+    return match;
+}
+
+//--------------------------------------------------------------
+TEST_CASE("Test World Batch Instances", "[world_batch][instances]")
+{
+    Matches matches(nullptr, 16);
+    std::vector<Matches::Instance> instances;
+    for (uint32_t i = 0; i < 40; ++i)
+    {
+        instances.push_back(AddMatch(matches, (float)i));
+    }
+    REQUIRE(matches.GetCount() == 40);
+    REQUIRE(matches.GetStore().GetChunkCount() == 3);
+
+    REQUIRE(matches.Remove(instances[5]));
+    REQUIRE(!matches.Remove(instances[5]));
+    REQUIRE(!matches.IsAlive(instances[5]));
+    REQUIRE(matches.Get<MatchTimer>(instances[5]) == nullptr);
+    REQUIRE(matches.GetCount() == 39);
+
+    // Remove all matches with timers under 10 seconds.
+    const uint32_t removed = matches.RemoveIf<MatchTimer>(
+        [](const MatchTimer& a_timer) { return a_timer.seconds < 10.0f; });
+    REQUIRE(removed == 9);
+    REQUIRE(matches.GetCount() == 30);
+    for (uint32_t i = 10; i < 40; ++i)
+    {
+        REQUIRE(matches.Get<MatchTimer>(instances[i])->seconds == (float)i);
+    }
+
+    matches.Clear();
+    REQUIRE(matches.GetCount() == 0);
+    REQUIRE(!matches.IsAlive(instances[39]));
+
+    // Handles to cleared matches never refer to new matches.
+    const Matches::Instance added = AddMatch(matches, 0.0f);
+    REQUIRE(matches.IsAlive(added));
+    REQUIRE(added.index == instances[0].index);
+    REQUIRE(!matches.IsAlive(instances[0]));
+    REQUIRE(!matches.IsAlive(instances[39]));
+}
+
+//--------------------------------------------------------------
+TEST_CASE("Test World Batch Step", "[world_batch][step]")
+{
+    Simple::WorkerPool workerPool(4);
+    Matches matches(&workerPool, 64);
+    AddMatchSteps(matches);
+
+    // Matches end after 1 to 10 steps of 0.5 seconds.
+    std::vector<Matches::Instance> instances;
+    for (uint32_t i = 0; i < 1000; ++i)
+    {
+        instances.push_back(AddMatch(matches, 0.5f * (float)(i % 10 + 1)));
+    }
+
+    uint32_t endedCount = 0;
+    for (uint32_t step = 0; step < 10; ++step)
+    {
+        matches.Step(0.5f);
+        endedCount += matches.RemoveIf<MatchEnded>(
+            [](const MatchEnded& a_ended) { return a_ended.value != 0; });
+        REQUIRE(endedCount == 100 * (step + 1));
+        REQUIRE(matches.GetCount() == 1000 - endedCount);
+    }
+
+    const Matches::BatchStats& stats = matches.GetStats();
+    REQUIRE(stats.stepCount == 10);
+    REQUIRE(stats.instanceSteps == 1000 + 900 + 800 + 700 + 600 +
+                                   500 + 400 + 300 + 200 + 100);
+    REQUIRE(stats.instanceCount == 100);
+    REQUIRE(stats.chunkCount == 2);
+    REQUIRE(stats.instanceStepsPerSecond > 0.0);
+    REQUIRE(stats.totalStepDuration >= stats.lastStepDuration);
+
+    matches.ResetStats();
+    REQUIRE(matches.GetStats().stepCount == 0);
+    REQUIRE(matches.GetStats().instanceSteps == 0);
+}
+
+//--------------------------------------------------------------
+TEST_CASE("Test World Batch Stepping", "[world_batch][stepping]")
+{
+    Matches matches;
+    Matches* batch = &matches;
+    const Matches::Instance match = AddMatch(matches, 1.0f);
+
+    // Instances cannot be added or removed by steps.
+    Matches::Instance added;
+    bool removed = true;
+    matches.AddStep<MatchTimer>([&](float, uint32_t, MatchTimer*)
+    {
+        added = batch->Add();
+        removed = batch->Remove(match);
+    });
+    matches.Step(0.1f);
+    REQUIRE(!matches.IsAlive(added));
+    REQUIRE(!removed);
+    REQUIRE(matches.IsAlive(match));
+    REQUIRE(matches.GetCount() == 1);
+}
+
+//--------------------------------------------------------------
+TEST_CASE("Test World Batch Step Throws", "[world_batch][stepping]")
+{
+    // A step that throws (eg. contained by the loop, which carries on)
+    // must not leave the batch stuck rejecting changes as if stepping.
+    Simple::WorkerPool workerPool(4);
+    Simple::WorkerPool* pools[] = { nullptr, &workerPool };
+    for (Simple::WorkerPool* pool : pools)
+    {
+        Matches matches(pool, 16);
+        std::vector<Matches::Instance> instances;
+        for (uint32_t i = 0; i < 40; ++i)
+        {
+            instances.push_back(AddMatch(matches, 1.0f));
+        }
+
+        std::atomic<bool> throwOnce = { true };
+        matches.AddStep<MatchTimer>([&](float, uint32_t, MatchTimer*)
+        {
+            if (throwOnce.exchange(false))
+            {
+                throw std::runtime_error("step");
+            }
+        });
+        REQUIRE_THROWS_WITH(matches.Step(0.1f), "step");
+
+        const Matches::Instance added = AddMatch(matches, 1.0f);
+        REQUIRE(matches.IsAlive(added));
+        REQUIRE(matches.Remove(instances[0]));
+        REQUIRE(!matches.IsAlive(instances[0]));
+        REQUIRE(matches.GetCount() == 40);
+
+        matches.Step(0.1f);
+        REQUIRE(matches.GetStats().stepCount == 1);
+    }
+}
+
+//--------------------------------------------------------------
+class BatchTestApplication : public Simple::Application
+{
+public:
+    BatchTestApplication() : m_matches(&m_workerPool, 256) {}
+
+    uint32_t m_endedCount = 0;
+    uint32_t m_addedCount = 0;
+
+protected:
+    void StartUp() override
+    {
+        AddMatchSteps(m_matches);
+    }
+
+    void ShutDown() override
+    {
+        m_matches.Clear();
+    }
+
+    void UpdateStart(float) override
+    {
+        // Matches start (and end) between frames.
+        for (uint32_t i = 0; i < 100; ++i, ++m_addedCount)
+        {
+            AddMatch(m_matches, (float)(m_addedCount % 5 + 1) / 240.0f);
+        }
+    }
+
+    void UpdateFixed(float a_fixedTimeSeconds) override
+    {
+        m_matches.Step(a_fixedTimeSeconds);
+    }
+
+    void UpdateEnded(float) override
+    {
+        m_endedCount += m_matches.RemoveIf<MatchEnded>(
+            [](const MatchEnded& a_ended) { return a_ended.value != 0; });
+        if (m_matches.GetStats().stepCount == 20)
+        {
+            RequestShutDown();
+        }
+    }
+
+private:
+    Simple::WorkerPool m_workerPool;
+    Matches m_matches;
+};
+
+//--------------------------------------------------------------
+TEST_CASE("Test World Batch Application", "[world_batch][application]")
+{
+    BatchTestApplication application;
+    application.Run(240);
+    REQUIRE(application.m_endedCount > 0);
+    REQUIRE(application.m_endedCount <= application.m_addedCount);
+}
+
+//--------------------------------------------------------------
+TEST_CASE("Benchmark World Batch", "[.][benchmark][world_batch]")
+{
+    constexpr uint32_t MatchCount = 100000;
+    constexpr uint32_t StepCount = 100;
+
+    Simple::WorkerPool workerPool;
+    Simple::WorkerPool* pools[] = { nullptr, &workerPool };
+    for (Simple::WorkerPool* pool : pools)
+    {
+        Matches matches(pool, 1024);
+        AddMatchSteps(matches);
+        matches.Reserve(MatchCount);
+        for (uint32_t i = 0; i < MatchCount; ++i)
+        {
+            AddMatch(matches, 1000.0f);
+        }
+        for (uint32_t i = 0; i < StepCount; ++i)
+        {
+            matches.Step(1.0f / 60.0f);
+        }
+        printf("%u matches, %u threads (%s): %.1f million "
+               "instance steps/second\n", MatchCount,
+               pool ? pool->GetThreadCount() : 1,
+               Simple::Kernels::GetISAName(Simple::Kernels::GetISA()),
+               matches.GetStats().instanceStepsPerSecond / 1000000.0);
+    }
+}